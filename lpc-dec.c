@@ -23,13 +23,35 @@
 *   Header Files                                                                                                                 *
 *********************************************************************************************************************************/
 
+#define _GNU_SOURCE /* For the POSIX and Linux specific APIs, the rest is plain C99. */
 #include <getopt.h>
 #include <inttypes.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <netdb.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <linux/futex.h>
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+# include <immintrin.h>
+#endif
 
 
 /*********************************************************************************************************************************
@@ -71,18 +93,606 @@
 #define LPC_DEC_CYC_DIR_IS_READ(a_Lad)          (((a_Lad) & 0x2) == LPC_DEC_CYC_DIR_READ)
 /** @} */
 
+/** Maximum number of index/data register pairs which can be decoded at the same time. */
+#define LPC_DEC_IDX_DATA_PAIRS_MAX              16
+/** Number of I/O ports addressable on the LPC bus. */
+#define LPC_DEC_IO_PORT_COUNT                   65536
+
+/** Maximum number of Super I/O configuration ports which can be decoded at the same time. */
+#define LPC_DEC_SIO_DEC_MAX                     4
+/** @name Super I/O configuration space layout.
+ * @{ */
+/** Logical device number select register. */
+#define LPC_DEC_SIO_REG_LDN                     0x07
+/** ITE configuration control register, bit 1 exits the configuration mode. */
+#define LPC_DEC_SIO_REG_ITE_CFG_CTRL            0x02
+/** First register which is specific to the selected logical device. */
+#define LPC_DEC_SIO_REG_LDN_FIRST               0x30
+/** Number of logical device specific registers. */
+#define LPC_DEC_SIO_LDN_REG_COUNT               (256 - LPC_DEC_SIO_REG_LDN_FIRST)
+/** Number of selectable logical devices. */
+#define LPC_DEC_SIO_LDN_COUNT                   256
+/** Value written to the index register to leave the configuration mode (non ITE chips). */
+#define LPC_DEC_SIO_EXIT_KEY                    0xaa
+/** @} */
+
+/** @name IPMI KCS interface.
+ * @{ */
+/** Default I/O port of the KCS data register, the status/command register follows. */
+#define LPC_DEC_KCS_PORT_DEFAULT                0xca2
+/** Maximum message size for requests and responses, longer ones get truncated. */
+#define LPC_DEC_KCS_MSG_MAX                     256
+/** Size of the preformatted log line buffer, large enough for two full messages in hex. */
+#define LPC_DEC_KCS_LINE_MAX                    (6 * LPC_DEC_KCS_MSG_MAX + 256)
+/** GET_STATUS/ABORT control code. */
+#define LPC_DEC_KCS_CTRL_GET_STATUS_ABORT       0x60
+/** WRITE_START control code. */
+#define LPC_DEC_KCS_CTRL_WRITE_START            0x61
+/** WRITE_END control code. */
+#define LPC_DEC_KCS_CTRL_WRITE_END              0x62
+/** READ control code, written to the data register. */
+#define LPC_DEC_KCS_CTRL_READ                   0x68
+/** Extracts the state from the status register. */
+#define LPC_DEC_KCS_STS_STATE_GET(a_bSts)       (((a_bSts) >> 6) & 0x3)
+/** IDLE_STATE. */
+#define LPC_DEC_KCS_STS_STATE_IDLE              0
+/** READ_STATE. */
+#define LPC_DEC_KCS_STS_STATE_READ              1
+/** WRITE_STATE. */
+#define LPC_DEC_KCS_STS_STATE_WRITE             2
+/** ERROR_STATE. */
+#define LPC_DEC_KCS_STS_STATE_ERROR             3
+/** @} */
+
+/** @name Time-travel value index file format.
+ * @{ */
+/** Magic identifying a value index file. */
+#define LPC_DEC_VAL_IDX_MAGIC                   "LPCVIDX1"
+/** Current version of the value index file format. */
+#define LPC_DEC_VAL_IDX_VERSION                 1
+/** Builds the lookup key for the given cycle type and address. */
+#define LPC_DEC_VAL_IDX_KEY(a_bTyp, a_u32Addr)  (((uint64_t)(a_bTyp) << 32) | (a_u32Addr))
+/** @} */
+
+/** @name Columnar cycle store file format.
+ * @{ */
+/** Magic identifying a cycle store file. */
+#define LPC_DEC_STORE_MAGIC                     "LPCCSTO1"
+/** Current version of the cycle store file format. */
+#define LPC_DEC_STORE_VERSION                   1
+/** Default number of cycles per chunk. */
+#define LPC_DEC_STORE_CHUNK_CYCLES_DEF          16384
+/** Maximum number of cycles per chunk, dictionary indices are 16bit. */
+#define LPC_DEC_STORE_CHUNK_CYCLES_MAX          65536
+/** Size of the per chunk address bloom filter in bytes. */
+#define LPC_DEC_STORE_BLOOM_BYTES               256
+/** Type/direction column: cycle type mask. */
+#define LPC_DEC_STORE_TYPDIR_TYP_MASK           0x3
+/** Type/direction column: write flag. */
+#define LPC_DEC_STORE_TYPDIR_WRITE              0x4
+/** Type/direction column: abort flag. */
+#define LPC_DEC_STORE_TYPDIR_ABORT              0x8
+/** Maximum size of a sequence number delta in the varint column, 64 bits in 7 bit groups. */
+#define LPC_DEC_STORE_VARINT_MAX                10
+/** Returns the bit in the chunk type/direction summary for the given type and direction. */
+#define LPC_DEC_STORE_TYPDIR_BIT(a_bTyp, a_fWrite) (1 << (((a_bTyp) << 1) | (a_fWrite)))
+/** @} */
+
+/** @name Capture diffing.
+ * @{ */
+/** Number of cycles forming an anchor candidate. */
+#define LPC_DEC_DIFF_ANCHOR_CYCLES              8
+/** Maximum number of anchor candidates sampled per alignment step, limits the hash table size. */
+#define LPC_DEC_DIFF_ANCHOR_SAMPLES_MAX         (1024 * 1024)
+/** Multiplier for the polynomial rolling hash. */
+#define LPC_DEC_DIFF_ROLLING_HASH_MUL           UINT64_C(0x100000001b3)
+/** Maximum size of the LCS table for aligning a span without anchors, larger spans are reported as replaced. */
+#define LPC_DEC_DIFF_LCS_CELLS_MAX              (4 * 1024 * 1024)
+/** Maximum recursion depth of the anchor search. */
+#define LPC_DEC_DIFF_DEPTH_MAX                  64
+/** @} */
+
+/** @name Cycle sequence search.
+ * @{ */
+/** Maximum number of cycle tokens in a single pattern. */
+#define LPC_DEC_FIND_TOKENS_MAX                 64
+/** Token field value matching anything. */
+#define LPC_DEC_FIND_ANY                        0xff
+/** Maximum number of lazily built automaton states before the state cache is flushed. */
+#define LPC_DEC_FIND_STATES_MAX                 (64 * 1024)
+/** Maximum number of pool entries used by the automaton states before the state cache is flushed. */
+#define LPC_DEC_FIND_POOL_MAX                   (16 * 1024 * 1024)
+/** Maximum number of cached cycle classifications before the cache is flushed. */
+#define LPC_DEC_FIND_CYCLE_CACHE_MAX            (1024 * 1024)
+/** @} */
+
+/** @name Triggered extraction.
+ * @{ */
+/** Default number of cycles dumped before a trigger. */
+#define LPC_DEC_TRIGGER_PRE_DEF                 16
+/** Default number of cycles dumped after a trigger. */
+#define LPC_DEC_TRIGGER_POST_DEF                16
+/** Maximum number of cycles dumped before a trigger, bounds the ring buffer. */
+#define LPC_DEC_TRIGGER_PRE_MAX                 (16 * 1024 * 1024)
+/** @} */
+
+/** @name Clock tick decode engine.
+ * @{ */
+/** Maximum number of clock ticks extracted and decoded at once. */
+#define LPC_DEC_TICKS_MAX                       8192
+/** Padding after the last tick so address gathers and scans may read past it. */
+#define LPC_DEC_TICKS_PAD                       16
+/** Tick bits holding LAD[3:0]. */
+#define LPC_DEC_TICK_LAD_MASK                   0x0f
+/** Tick bit set when LFRAME# is deasserted (high). */
+#define LPC_DEC_TICK_LFRAME                     0x10
+/** Lookup table bit holding the clock level of a sample, never stored in a tick. */
+#define LPC_DEC_TICK_LUT_CLK                    0x80
+/** @} */
+
+/** @name Sequence number check.
+ * @{ */
+/** Number of records extracted and checked at once, small enough to keep the sequence numbers in the L1 cache. */
+#define LPC_DEC_SEQ_CHECK_RECS                  512
+#if defined(__GNUC__) && defined(__x86_64__)
+/** Flag whether the check has an AVX2 variant selected at runtime. */
+# define LPC_DEC_SEQ_CHECK_AVX2
+#endif
+/** @} */
+
+/** @name LCLK statistics.
+ * @{ */
+/** Number of LCLK period histogram bins, one per sample with the last one taking all longer periods. */
+#define LPC_DEC_CLK_HIST_BINS                   256
+/** @} */
+
+/** @name State machine dispatch.
+ *
+ * GCC and Clang jump straight to the handler of the current state through a label table (labels as values),
+ * everything else and builds with LPC_DEC_NO_THREADED_DISPATCH defined use a switch. The handlers are written
+ * once and end with LPC_DEC_STATE_NEXT(). In the threaded variant that fetches the next tick and jumps to the
+ * handler of the next state from the end of each handler, so every handler has its own indirect branch for the
+ * predictor. In the switch variant it is a continue.
+ * @{ */
+#if defined(__GNUC__) && !defined(LPC_DEC_NO_THREADED_DISPATCH)
+/** Flag whether the state handlers are dispatched through a label table. */
+# define LPC_DEC_STATE_THREADED
+/** Jumps to the handler of the given state. */
+# define LPC_DEC_STATE_DISPATCH(a_enmState)     goto *s_apvStateHandlers[a_enmState]
+/** Starts the handler of the given state. */
+# define LPC_DEC_STATE_CASE(a_enmState)         a_enmState##_Handler:
+/** Starts the handler for invalid states. */
+# define LPC_DEC_STATE_DEFAULT()                LPCDECSTATE_INVALID_Handler:
+/** Ends the handlers. */
+# define LPC_DEC_STATE_DISPATCH_END()
+/** Marks the handling of an asserted LFRAME#. */
+# define LPC_DEC_STATE_LFRAME_ASSERTED()        LpcDecStateLFrameAsserted:
+# ifdef __clang__
+/** Attributes of the function holding the handlers. */
+#  define LPC_DEC_STATE_FN_ATTR
+# else
+/* GCC merges the identical handler tails back into a single indirect jump otherwise. */
+#  define LPC_DEC_STATE_FN_ATTR                 __attribute__((optimize("no-crossjumping")))
+# endif
+/** Ends a handler, continuing with the next tick. */
+# define LPC_DEC_STATE_NEXT() \
+    do \
+    { \
+        if (++idxTick == cTicks) \
+            return; \
+        bTick = pbTicks[idxTick]; \
+        bLad  = bTick & LPC_DEC_TICK_LAD_MASK; \
+        pLpcDec->uSeqNoSample = pauSeqNo[idxTick]; \
+        if (!(bTick & LPC_DEC_TICK_LFRAME)) \
+            goto LpcDecStateLFrameAsserted; \
+        goto *s_apvStateHandlers[enmState]; \
+    } while (0)
+#else
+# define LPC_DEC_STATE_DISPATCH(a_enmState)     switch (a_enmState) {
+# define LPC_DEC_STATE_CASE(a_enmState)         case a_enmState:
+# define LPC_DEC_STATE_DEFAULT()                default:
+# define LPC_DEC_STATE_DISPATCH_END()           }
+# define LPC_DEC_STATE_LFRAME_ASSERTED()
+# define LPC_DEC_STATE_NEXT()                   continue
+# define LPC_DEC_STATE_FN_ATTR
+#endif
+/** @} */
+
+/** @name Batch decoding.
+ * @{ */
+/** Size of a capture record in bytes (64-bit sequence number + sample). */
+#define LPC_DEC_RECORD_SIZE                     9
+/** Default number of bytes per chunk large captures are split into. */
+#define LPC_DEC_BATCH_CHUNK_SIZE_DEF            (64 * 1024 * 1024)
+/** Number of records read at once. */
+#define LPC_DEC_BATCH_READ_RECORDS              (256 * 1024)
+/** Number of records read at once past the end of a chunk. */
+#define LPC_DEC_BATCH_OVERRUN_RECORDS           1024
+/** Default number of concurrent reads per device. */
+#define LPC_DEC_BATCH_IO_PER_DEV_DEF            2
+/** Maximum number of worker threads. */
+#define LPC_DEC_BATCH_WORKERS_MAX               256
+/** @} */
+
+/** @name Socket input.
+ * @{ */
+/** Size of a single receive buffer. */
+#define LPC_DEC_SOCK_BUF_SIZE                   (256 * 1024)
+/** Number of receive buffers, bounds the amount of data buffered for the decoder. */
+#define LPC_DEC_SOCK_BUF_COUNT                  64
+/** Requested socket receive buffer size. */
+#define LPC_DEC_SOCK_RCVBUF_SIZE                (4 * 1024 * 1024)
+/** Default interval of the input lag reports in milliseconds. */
+#define LPC_DEC_SOCK_STATS_INTERVAL_DEF         1000
+/** Number of records the replay command sends at once. */
+#define LPC_DEC_REPLAY_CHUNK_RECORDS            4096
+/** @} */
+
+/** @name Shared-memory ring input.
+ * @{ */
+/** Magic identifying an initialized ring segment. */
+#define LPC_DEC_SHM_MAGIC                       "LPCSHMR1"
+/** Current version of the ring segment layout. */
+#define LPC_DEC_SHM_VERSION                     1
+/** Directory the ring segments are created in. */
+#define LPC_DEC_SHM_DIR                         "/dev/shm/"
+/** Number of records in the ring created by the replay command. */
+#define LPC_DEC_SHM_RING_RECORDS_DEF            (4 * 1024 * 1024)
+/** Number of records the consumer decodes before handing the space back to the producer. */
+#define LPC_DEC_SHM_RELEASE_RECORDS             16384
+/** Timeout of a single futex wait in milliseconds, bounds the delay of a missed wakeup. */
+#define LPC_DEC_SHM_WAIT_TIMEOUT_MS             100
+/** @} */
+
+/** @name Output sinks.
+ * @{ */
+/** Maximum number of output sinks. */
+#define LPC_DEC_SINKS_MAX                       16
+/** Number of cycles per batch handed to the sinks. */
+#define LPC_DEC_SINK_BATCH_CYCLES               4096
+/** Number of batches a sink may lag behind the decoder before the decoder has to wait for it. */
+#define LPC_DEC_SINK_QUEUE_DEPTH                16
+/** Magic at the start of the binary cycle dump, followed by LPC_DEC_SINK_BIN_REC_SIZE byte records. */
+#define LPC_DEC_SINK_BIN_MAGIC                  "LPCCYCB3"
+/** Size of a binary cycle dump record, the fields are little endian without any padding in between:
+ *      0  uint64_t  sequence number of the sample the cycle started with
+ *      8  uint32_t  address
+ *     12  uint8_t   cycle type (LPC_DEC_CYC_TYPE_XXX)
+ *     13  uint8_t   1 for writes, 0 for reads
+ *     14  uint8_t   data
+ *     15  uint8_t   1 if the cycle was aborted, 0 otherwise
+ *     16  uint32_t  the states the decoder went through (LPCDECCYCLE::u32States) */
+#define LPC_DEC_SINK_BIN_REC_SIZE               20
+/** Number of I/O ports listed in the stats output. */
+#define LPC_DEC_SINK_STATS_TOP_PORTS            16
+/** @} */
+
+/** @name Output sharding.
+ * @{ */
+/** Maximum number of address ranges to shard by. */
+#define LPC_DEC_SHARD_RANGES_MAX                15
+/** Maximum length of an address range name including the terminator. */
+#define LPC_DEC_SHARD_RANGE_NAME_MAX            32
+/** Maximum number of shards, every cycle type and direction for every range and the rest. */
+#define LPC_DEC_SHARDS_MAX                      (4 * 2 * (LPC_DEC_SHARD_RANGES_MAX + 1))
+/** Size of the write buffer of every shard, the sink thread flushes it once full. */
+#define LPC_DEC_SHARD_BUF_SIZE                  (128 * 1024)
+/** Maximum length of a shard path. */
+#define LPC_DEC_SHARD_PATH_MAX                  4096
+/** @} */
+
+/** @name SQLite output.
+ * @{ */
+/** Name of the SQLite library loaded on demand. */
+#define LPC_DEC_SQLITE_LIB                      "libsqlite3.so.0"
+/** SQLITE_OK. */
+#define LPC_DEC_SQLITE_OK                       0
+/** SQLITE_DONE. */
+#define LPC_DEC_SQLITE_DONE                     101
+/** Number of rows inserted per transaction. */
+#define LPC_DEC_SQLITE_TXN_ROWS                 (1024 * 1024)
+/** @} */
+
+/** @name Compressed output.
+ * @{ */
+/** Name of the zstd library loaded on demand. */
+#define LPC_DEC_ZSTD_LIB                        "libzstd.so.1"
+/** Default compression level. */
+#define LPC_DEC_ZSTD_LEVEL_DEF                  3
+/** Maximum compression level. */
+#define LPC_DEC_ZSTD_LEVEL_MAX                  22
+/** Compression level from which on zstd compresses with multiple threads. */
+#define LPC_DEC_ZSTD_LEVEL_MT                   10
+/** Maximum number of zstd compression threads. */
+#define LPC_DEC_ZSTD_WORKERS_MAX                8
+/** Size of a formatted output block handed to the compression thread. */
+#define LPC_DEC_ZSTD_BLOCK_SIZE                 (1024 * 1024)
+/** Number of output blocks, bounds the amount of output queued for compression. */
+#define LPC_DEC_ZSTD_BLOCKS                     8
+/** ZSTD_c_compressionLevel. */
+#define LPC_DEC_ZSTD_C_COMPRESSION_LEVEL        100
+/** ZSTD_c_nbWorkers. */
+#define LPC_DEC_ZSTD_C_NB_WORKERS               400
+/** ZSTD_e_continue. */
+#define LPC_DEC_ZSTD_E_CONTINUE                 0
+/** ZSTD_e_end. */
+#define LPC_DEC_ZSTD_E_END                      2
+/** @} */
+
+/** @name Packed state chain (LPCDECCYCLE::u32States).
+ * @{ */
+/** Number of bits per state. */
+#define LPC_DEC_STATES_BITS                     3
+/** Mask of a single state. */
+#define LPC_DEC_STATES_MASK                     0x7
+/** Maximum number of states in a chain, host memory firmware reads/writes go through the most states + one for
+ * the inital LFRAME assert wait state. */
+#define LPC_DEC_STATES_MAX                      9
+/** Maximum length of a rendered chain. */
+#define LPC_DEC_STATES_STR_MAX                  256
+/** Places the given state at the given position of the chain. */
+#define LPC_DEC_STATES_AT(a_enmState, a_idx)    ((uint32_t)(a_enmState) << ((a_idx) * LPC_DEC_STATES_BITS))
+/** @} */
+
+/** @name JSON Lines output fragments (indices into g_aJsonlFrags).
+ * @{ */
+#define LPC_DEC_JSONL_FRAG_SEQ                  0
+#define LPC_DEC_JSONL_FRAG_TS                   1
+#define LPC_DEC_JSONL_FRAG_TYPE_FIRST           2
+#define LPC_DEC_JSONL_FRAG_DIR_READ             6
+#define LPC_DEC_JSONL_FRAG_DIR_WRITE            7
+#define LPC_DEC_JSONL_FRAG_ADDR                 8
+#define LPC_DEC_JSONL_FRAG_DATA                 9
+#define LPC_DEC_JSONL_FRAG_ABORT_FALSE          10
+#define LPC_DEC_JSONL_FRAG_ABORT_TRUE           11
+#define LPC_DEC_JSONL_FRAG_SYNC_WAITS           12
+#define LPC_DEC_JSONL_FRAG_STATES               13
+#define LPC_DEC_JSONL_FRAG_STATES_END           14
+#define LPC_DEC_JSONL_FRAG_END                  15
+#define LPC_DEC_JSONL_FRAG_NULL                 16
+/** Maximum length of a JSON Lines cycle object including the newline. */
+#define LPC_DEC_JSONL_LINE_MAX                  512
+/** @} */
+
+/** @name pcapng output.
+ * @{ */
+/** Section Header Block type. */
+#define LPC_DEC_PCAPNG_BLOCK_SHB                UINT32_C(0x0a0d0d0a)
+/** Interface Description Block type. */
+#define LPC_DEC_PCAPNG_BLOCK_IDB                UINT32_C(0x00000001)
+/** Enhanced Packet Block type. */
+#define LPC_DEC_PCAPNG_BLOCK_EPB                UINT32_C(0x00000006)
+/** Byte order magic of the section header. */
+#define LPC_DEC_PCAPNG_BYTE_ORDER_MAGIC         UINT32_C(0x1a2b3c4d)
+/** The link type of the LPC interface (LINKTYPE_USER0). */
+#define LPC_DEC_PCAPNG_LINKTYPE                 147
+/** opt_endofopt. */
+#define LPC_DEC_PCAPNG_OPT_END                  0
+/** shb_userappl. */
+#define LPC_DEC_PCAPNG_OPT_SHB_USERAPPL         4
+/** if_name. */
+#define LPC_DEC_PCAPNG_OPT_IF_NAME              2
+/** if_description. */
+#define LPC_DEC_PCAPNG_OPT_IF_DESCRIPTION       3
+/** if_tsresol. */
+#define LPC_DEC_PCAPNG_OPT_IF_TSRESOL           9
+/** Maximum size of the section header and interface description blocks. */
+#define LPC_DEC_PCAPNG_HDR_MAX                  128
+/** Version of the cycle record carried in the packets, see lpc-dec.lua. */
+#define LPC_DEC_PCAPNG_REC_VERSION              1
+/** Size of the cycle record. */
+#define LPC_DEC_PCAPNG_REC_SIZE                 17
+/** Cycle record flag: write cycle. */
+#define LPC_DEC_PCAPNG_REC_F_WRITE              0x1
+/** Cycle record flag: aborted cycle. */
+#define LPC_DEC_PCAPNG_REC_F_ABORT              0x2
+/** Cycle record SYNC wait count if unknown. */
+#define LPC_DEC_PCAPNG_REC_SYNC_WAITS_UNKNOWN   0xff
+/** Size of an Enhanced Packet Block holding a cycle record. */
+#define LPC_DEC_PCAPNG_EPB_SIZE                 (28 + ((LPC_DEC_PCAPNG_REC_SIZE + 3) & ~3) + 4)
+/** @} */
+
+/** @name Value change dump export.
+ * @{ */
+/** Size of the write buffer. */
+#define LPC_DEC_VCD_BUF_SIZE                    (64 * 1024)
+/** Maximum number of characters written for a single phase transition. */
+#define LPC_DEC_VCD_CHANGE_MAX                  256
+/** @} */
+
+/** @name Arrow IPC file output.
+ * @{ */
+/** Magic at the start and end of an Arrow IPC file, padded to 8 bytes at the start. */
+#define LPC_DEC_ARROW_MAGIC                     "ARROW1\0\0"
+/** Size of the magic at the end of the file. */
+#define LPC_DEC_ARROW_MAGIC_SIZE                6
+/** Continuation marker preceding every message. */
+#define LPC_DEC_ARROW_CONTINUATION              UINT32_C(0xffffffff)
+/** MetadataVersion V5. */
+#define LPC_DEC_ARROW_METADATA_V5               4
+/** MessageHeader union: Schema. */
+#define LPC_DEC_ARROW_HDR_SCHEMA                1
+/** MessageHeader union: RecordBatch. */
+#define LPC_DEC_ARROW_HDR_RECORD_BATCH          3
+/** Type union: Int. */
+#define LPC_DEC_ARROW_TYPE_INT                  2
+/** Type union: Bool. */
+#define LPC_DEC_ARROW_TYPE_BOOL                 6
+/** Number of columns. */
+#define LPC_DEC_ARROW_COLS                      6
+/** Default number of cycles per record batch. */
+#define LPC_DEC_ARROW_BATCH_CYCLES_DEF          65536
+/** Maximum number of cycles per record batch. */
+#define LPC_DEC_ARROW_BATCH_CYCLES_MAX          (16 * 1024 * 1024)
+/** Initial size of the flatbuffer builder buffer. */
+#define LPC_DEC_ARROW_FB_SIZE_INIT              4096
+/** @} */
+
+/** @name Super I/O shadow register flags.
+ * @{ */
+/** The register value was observed through a read. */
+#define LPC_DEC_SIO_REG_F_READ                  0x1
+/** The register was written. */
+#define LPC_DEC_SIO_REG_F_WRITTEN               0x2
+/** @} */
+
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
 
 
 /**
- * File buffered reader.
+ * A receive buffer of the socket input, only holds complete records.
+ */
+typedef struct LPCDECSOCKBUF
+{
+    /** Next buffer in the free or filled list. */
+    struct LPCDECSOCKBUF        *pNext;
+    /** Monotonic timestamp in nanoseconds when the data was received. */
+    uint64_t                    nsRecv;
+    /** Number of bytes in the buffer. */
+    size_t                      cbData;
+    /** Number of bytes consumed by the decoder. */
+    size_t                      offRead;
+    /** Flag whether records were dropped right before this buffer. */
+    uint8_t                     fDiscont;
+    /** The data. */
+    uint8_t                     ab[LPC_DEC_SOCK_BUF_SIZE];
+} LPCDECSOCKBUF;
+/** Pointer to a socket input receive buffer. */
+typedef LPCDECSOCKBUF *PLPCDECSOCKBUF;
+
+
+/**
+ * Stream socket input, a receiver thread fills recycled buffers which the decoder drains.
+ */
+typedef struct LPCDECSOCKIN
+{
+    /** The connected socket. */
+    int                         fdSock;
+    /** The receiver thread. */
+    pthread_t                   hThreadRecv;
+    /** Protects the buffer lists and counters. */
+    pthread_mutex_t             Mtx;
+    /** Signalled when a buffer was filled or the stream ended. */
+    pthread_cond_t              CondFilled;
+    /** Signalled when a buffer was returned to the free list. */
+    pthread_cond_t              CondFree;
+    /** The receive buffers. */
+    PLPCDECSOCKBUF              paBufs;
+    /** List of free buffers. */
+    PLPCDECSOCKBUF              pFreeHead;
+    /** Head of the list of filled buffers (oldest). */
+    PLPCDECSOCKBUF              pFilledHead;
+    /** Tail of the list of filled buffers. */
+    PLPCDECSOCKBUF              pFilledTail;
+    /** The buffer the decoder currently drains, owned by the decoder. */
+    PLPCDECSOCKBUF              pCur;
+    /** Scratch buffer for data received while all buffers are in use and dropping is allowed. */
+    uint8_t                     *pbDrop;
+    /** Partial record carried over to the next receive, owned by the receiver. */
+    uint8_t                     abCarry[LPC_DEC_RECORD_SIZE];
+    /** Number of bytes carried over. */
+    size_t                      cbCarry;
+    /** Flag whether to drop data instead of applying backpressure when the decoder falls behind. */
+    uint8_t                     fLossy;
+    /** Flag whether records were dropped since the last buffer was queued. */
+    uint8_t                     fDropPending;
+    /** Flag whether the stream ended (or failed). */
+    uint8_t                     fEos;
+    /** Flag whether the receiver should stop. */
+    uint8_t                     fShutdown;
+    /** Status code of the receiver, -1 if the peer closed the connection. */
+    int                         rcRecv;
+    /** Number of bytes received. */
+    uint64_t                    cbReceived;
+    /** Number of bytes received but not decoded yet. */
+    uint64_t                    cbBuffered;
+    /** Number of records dropped. */
+    uint64_t                    cRecordsDropped;
+    /** Number of times the receiver had to wait for the decoder. */
+    uint64_t                    cStalls;
+    /** Interval of the lag reports in milliseconds, 0 to disable. */
+    uint32_t                    cMsStats;
+    /** Monotonic timestamp in nanoseconds of the last lag report. */
+    uint64_t                    nsStatsLast;
+} LPCDECSOCKIN;
+/** Pointer to a stream socket input. */
+typedef LPCDECSOCKIN *PLPCDECSOCKIN;
+
+
+/**
+ * Header of a shared-memory ring segment, the record ring follows directly.
+ *
+ * Single producer, single consumer. The offsets count bytes since the start and only ever grow, the position in the
+ * ring is the offset modulo the ring size. The ring size is a multiple of the record size so records never wrap.
+ * The producer and consumer fields live in separate cache lines.
+ */
+typedef struct LPCDECSHMHDR
+{
+    /** Magic identifying the segment, written last by the producer. */
+    char                        achMagic[8];
+    /** Layout version. */
+    uint32_t                    u32Version;
+    /** Size of the header, the ring starts at this offset. */
+    uint32_t                    cbHdr;
+    /** Size of the ring in bytes. */
+    uint64_t                    cbRing;
+    /** Padding. */
+    uint8_t                     abPad0[40];
+    /** Producer: offset up to which records were written. */
+    uint64_t                    offHead;
+    /** Producer: incremented after publishing records or the end of the stream, the consumer waits on it. */
+    uint32_t                    u32DataSeq;
+    /** Producer: flag whether all records were written. */
+    uint32_t                    fEos;
+    /** Producer: flag whether the producer waits for space. */
+    uint32_t                    fProducerWaiting;
+    /** Padding. */
+    uint8_t                     abPad1[44];
+    /** Consumer: offset up to which records were decoded. */
+    uint64_t                    offTail;
+    /** Consumer: incremented after records were decoded, the producer waits on it. */
+    uint32_t                    u32SpaceSeq;
+    /** Consumer: flag whether the consumer waits for data. */
+    uint32_t                    fConsumerWaiting;
+    /** Consumer: process ID of the consumer, 0 until one attached. */
+    uint32_t                    u32ConsumerPid;
+    /** Consumer: flag whether the consumer stopped decoding. */
+    uint32_t                    fConsumerDone;
+    /** Padding. */
+    uint8_t                     abPad2[40];
+} LPCDECSHMHDR;
+/** Pointer to a shared-memory ring segment header. */
+typedef LPCDECSHMHDR *PLPCDECSHMHDR;
+
+
+/** Pointer to a buffered reader. */
+typedef struct LPCDECFILEBUFREAD *PLPCDECFILEBUFREAD;
+
+/**
+ * Callback filling the buffer of a buffered reader from the underlying source.
+ *
+ * @returns Status code, -1 at the end of the stream.
+ * @param   pBufFile                The buffered reader.
+ * @param   pbDst                   Where to store the data.
+ * @param   cbMax                   Maximum number of bytes to store.
+ * @param   pcbRead                 Where to store the number of bytes stored on success, at least one.
+ */
+typedef int (*PFNLPCDECBUFREADFILL)(PLPCDECFILEBUFREAD pBufFile, uint8_t *pbDst, size_t cbMax, size_t *pcbRead);
+
+
+/**
+ * File buffered reader, also used for the socket input.
  */
 typedef struct LPCDECFILEBUFREAD
 {
-    /** The file handle. */
+    /** The callback filling the buffer. */
+    PFNLPCDECBUFREADFILL        pfnFill;
+    /** The file handle, NULL for the socket input. */
     FILE                        *pFile;
+    /** The socket input, NULL for files. */
+    PLPCDECSOCKIN               pSockIn;
     /** Current amount of data in the buffer. */
     size_t                      cbData;
     /** Where to read next from the buffer. */
@@ -91,11 +701,17 @@ typedef struct LPCDECFILEBUFREAD
     uint8_t                     fError;
     /** Eos flag. */
     uint8_t                     fEos;
+    /** Flag whether to wait for more data at the end of the file instead of stopping. */
+    uint8_t                     fFollow;
+    /** Flag whether the writer closed or removed the file, only set when following. */
+    uint8_t                     fWriterDone;
+    /** The inotify instance watching the file for appended data, -1 if not following. */
+    int                         fdInotify;
+    /** Flag whether input was dropped right before the next record, the decoder state must be reset. */
+    uint8_t                     fDiscont;
     /** Buffered data. */
     uint8_t                     abBuf[64 * 1024];
 } LPCDECFILEBUFREAD;
-/** Pointer to a file buffered reader. */
-typedef LPCDECFILEBUFREAD *PLPCDECFILEBUFREAD;
 /** Pointer to a const file buffered reader. */
 typedef const LPCDECFILEBUFREAD *PCLPCDECFILEBUFREAD;
 
@@ -124,6 +740,77 @@ typedef enum LPCDECSTATE
 } LPCDECSTATE;
 
 
+/**
+ * A single decoded LPC cycle.
+ */
+typedef struct LPCDECCYCLE
+{
+    /** Sequence number of the sample the cycle started with. */
+    uint64_t                    uSeqNo;
+    /** The address of the cycle. */
+    uint32_t                    u32Addr;
+    /** Cycle type (LPC_DEC_CYC_TYPE_XXX). */
+    uint8_t                     bTyp;
+    /** Flag whether this is a write cycle. */
+    uint8_t                     fWrite;
+    /** The data transferred. */
+    uint8_t                     bData;
+    /** Flag whether the cycle was aborted. */
+    uint8_t                     fAbort;
+    /** The states the decoder went through (LPCDECSTATE), LPC_DEC_STATES_BITS each starting with the lowest bits,
+     * terminated by LPCDECSTATE_INVALID, 0 if unknown. */
+    uint32_t                    u32States;
+} LPCDECCYCLE;
+/** Pointer to a decoded LPC cycle. */
+typedef LPCDECCYCLE *PLPCDECCYCLE;
+/** Pointer to a const decoded LPC cycle. */
+typedef const LPCDECCYCLE *PCLPCDECCYCLE;
+
+
+/** Pointer to a const LPC decoder state. */
+typedef const struct LPCDEC *PCLPCDEC;
+
+/**
+ * Callback for a completely decoded cycle.
+ *
+ * @returns nothing.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with.
+ * @param   pCycle                  The decoded cycle.
+ * @param   pvUser                  Opaque user data passed during initialization.
+ */
+typedef void (*PFNLPCDECCYCLE)(PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle, void *pvUser);
+
+
+/**
+ * Export of the decoder phases as a value change dump, values only change at phase transitions.
+ */
+typedef struct LPCDECVCD
+{
+    /** The file written to. */
+    FILE                        *pFile;
+    /** Status code, set when writing failed. */
+    int                         rc;
+    /** Time of the last value change block, UINT64_MAX if none was written yet. */
+    uint64_t                    uTimeLast;
+    /** The state last written (LPCDECSTATE). */
+    uint8_t                     bState;
+    /** The cycle type last written. */
+    uint8_t                     bTyp;
+    /** The direction last written. */
+    uint8_t                     fWrite;
+    /** The data last written. */
+    uint8_t                     bData;
+    /** The address last written. */
+    uint32_t                    u32Addr;
+    /** Number of characters buffered. */
+    size_t                      cchBuf;
+    /** The write buffer. */
+    char                        achBuf[LPC_DEC_VCD_BUF_SIZE];
+} LPCDECVCD;
+/** Pointer to a phase export. */
+typedef LPCDECVCD *PLPCDECVCD;
+
+
 /**
  * LPC decoder state.
  */
@@ -144,7 +831,9 @@ typedef struct LPCDEC
     /** The next state to write into. */
     uint32_t                    idxState;
     /** LPC decoder states we've gone through. */
-    LPCDECSTATE                 aenmState[9]; /* Host memory firmware reads/writes go through the most states + one for the inital LFRAME assert wait state. */
+    LPCDECSTATE                 aenmState[LPC_DEC_STATES_MAX];
+    /** The states we've gone through packed for the cycle record (LPCDECCYCLE::u32States). */
+    uint32_t                    u32States;
     /** Sequence number when the cycle started. */
     uint64_t                    uSeqNoCycle;
     /** Last clock value seen. */
@@ -167,624 +856,11808 @@ typedef struct LPCDEC
     uint32_t                    u32Addr;
     /** The data being consturcted during the data phase. */
     uint8_t                     bData;
+    /** Number of SYNC wait states (LAD[3:0] != 0) seen in the current cycle. */
+    uint8_t                     cSyncWaits;
+    /** Sequence number of the sample being processed. */
+    uint64_t                    uSeqNoSample;
+    /** The phase export, NULL if disabled. */
+    PLPCDECVCD                  pVcd;
+    /** Callback for every decoded cycle. */
+    PFNLPCDECCYCLE              pfnCycle;
+    /** Opaque user data for the callback. */
+    void                        *pvUser;
+    /** The stream to write decoder messages (illegal cycles etc.) to. */
+    FILE                        *pOutMsg;
 } LPCDEC;
 /** Pointer to a LPC decoder state. */
 typedef LPCDEC *PLPCDEC;
-/** Pointer to a const LPC decoder state. */
-typedef const LPCDEC *PCLPCDEC;
 
 
-/*********************************************************************************************************************************
-*   Global Variables                                                                                                             *
-*********************************************************************************************************************************/
+/**
+ * Decode engine.
+ */
+typedef enum LPCDECENGINE
+{
+    /** Invalid engine, do not use. */
+    LPCDECENGINE_INVALID = 0,
+    /** Steps the state machine for every clock. */
+    LPCDECENGINE_STATE,
+    /** Extracts the clock ticks first and decodes target cycles at fixed tick offsets. */
+    LPCDECENGINE_TICK,
+    /** 32bit hack. */
+    LPCDECENGINE_32BIT_HACK = 0x7fffffff
+} LPCDECENGINE;
 
-/** Flag whether verbose mode is enabled. */
-static uint8_t g_fVerbose = 0;
 
 /**
- * Available options for lpc-dec.
+ * Streaming accumulator for a single LCLK measurement.
  */
-static struct option g_aOptions[] =
+typedef struct LPCDECCLKACC
 {
-    {"input",   required_argument, 0, 'i'},
-    {"verbose", no_argument,       0, 'v'},
+    /** Number of values added. */
+    uint64_t                    cValues;
+    /** Smallest value. */
+    double                      dMin;
+    /** Largest value. */
+    double                      dMax;
+    /** Running mean. */
+    double                      dMean;
+    /** Running sum of the squared differences from the mean. */
+    double                      dM2;
+} LPCDECCLKACC;
+/** Pointer to a measurement accumulator. */
+typedef LPCDECCLKACC *PLPCDECCLKACC;
+/** Pointer to a const measurement accumulator. */
+typedef const LPCDECCLKACC *PCLPCDECCLKACC;
 
-    {"help",    no_argument,       0, 'H'},
-    {0, 0, 0, 0}
-};
+
+/**
+ * The LCLK measurements of a window or the whole capture.
+ */
+typedef struct LPCDECCLKMEAS
+{
+    /** Period in samples, falling to falling edge. */
+    LPCDECCLKACC                Period;
+    /** Duty cycle, the high part of the period. */
+    LPCDECCLKACC                Duty;
+    /** Cycle-to-cycle jitter in samples, the period minus the previous one. */
+    LPCDECCLKACC                Jitter;
+} LPCDECCLKMEAS;
+/** Pointer to LCLK measurements. */
+typedef LPCDECCLKMEAS *PLPCDECCLKMEAS;
+/** Pointer to const LCLK measurements. */
+typedef const LPCDECCLKMEAS *PCLPCDECCLKMEAS;
 
 
-/*********************************************************************************************************************************
-*   Internal Functions                                                                                                           *
-*********************************************************************************************************************************/
+/**
+ * LCLK period, duty cycle and jitter statistics gathered from the records while decoding.
+ */
+typedef struct LPCDECCLKSTATS
+{
+    /** The stream the per-window statistics are written to. */
+    FILE                        *pOut;
+    /** Window length in samples for the per-window statistics, 0 if only the summary is gathered. */
+    uint64_t                    cWindowSamples;
+    /** Flag whether the clock level is known. */
+    uint8_t                     fClkValid;
+    /** The last clock level, LPC_DEC_TICK_LUT_CLK if high. */
+    uint8_t                     fClkLast;
+    /** Flag whether a rising edge was seen. */
+    uint8_t                     fRise;
+    /** Flag whether a falling edge was seen. */
+    uint8_t                     fFall;
+    /** Flag whether the current window started. */
+    uint8_t                     fWindow;
+    /** Sequence number of the last rising edge. */
+    uint64_t                    uSeqNoRise;
+    /** Sequence number of the last falling edge. */
+    uint64_t                    uSeqNoFall;
+    /** The last period in samples for the jitter, 0 if there is none. */
+    uint64_t                    cPeriodLast;
+    /** Sequence number the current window started at. */
+    uint64_t                    uSeqNoWindow;
+    /** Measurements of the whole capture. */
+    LPCDECCLKMEAS               Total;
+    /** Measurements of the current window. */
+    LPCDECCLKMEAS               Window;
+    /** Period histogram in samples. */
+    uint64_t                    acPeriods[LPC_DEC_CLK_HIST_BINS];
+} LPCDECCLKSTATS;
+/** Pointer to LCLK statistics. */
+typedef LPCDECCLKSTATS *PLPCDECCLKSTATS;
+/** Pointer to const LCLK statistics. */
+typedef const LPCDECCLKSTATS *PCLPCDECCLKSTATS;
 
 
 /**
- * Creates a new buffered file reader from the given filename.
+ * The clock tick decode engine.
  *
- * @returns Status code.
- * @param   ppBufFile               Where to store the pointer to the buffered file reader on success.
- * @param   pszFilename             The file to load.
+ * Every falling LCLK edge becomes a tick byte holding LAD[3:0] and LFRAME#. I/O and memory target cycles have all
+ * phases at fixed offsets from the START tick except for SYNC, so they are decoded straight from the tick array.
+ * Everything else, and cycles not complete within the ticks at hand, go through the per-clock state machine.
  */
-static int lpcDecFileBufReaderCreate(PLPCDECFILEBUFREAD *ppBufFile, const char *pszFilename)
+typedef struct LPCDECTICKS
 {
-    int rc = 0;
-    FILE *pFile = fopen(pszFilename, "rb");
-    if (pFile)
-    {
-        PLPCDECFILEBUFREAD pBufFile = (PLPCDECFILEBUFREAD)calloc(1, sizeof(*pBufFile));
-        if (pBufFile)
-        {
-            pBufFile->pFile  = pFile;
-            pBufFile->cbData = 0;
-            pBufFile->offBuf = 0;
-            pBufFile->fError = 0;
-            pBufFile->fEos   = 0;
-
-            /* Read in the first chunk. */
-            size_t cbRead = fread(&pBufFile->abBuf[0], 1, sizeof(pBufFile->abBuf), pFile);
-            if (cbRead)
-            {
-                pBufFile->cbData = cbRead;
-                *ppBufFile = pBufFile;
-                return 0;
-            }
-            else
-                rc = -1;
-        }
-        else
-            rc = -1;
+    /** Number of ticks extracted. */
+    uint32_t                    cTicks;
+    /** Flag whether target cycles are decoded straight from the ticks, otherwise every tick steps the state machine. */
+    uint8_t                     fFastPath;
+    /** Flag whether to reset the decoder at sequence number anomalies. */
+    uint8_t                     fSeqReset;
+    /** Flag whether uSeqNoLast is valid. */
+    uint8_t                     fSeqNoLast;
+    /** Flag whether the CPU supports AVX2 for the sequence number check. */
+    uint8_t                     fSeqCheckAvx2;
+    /** Largest sequence number increment between records not reported, 0 if the sequence numbers aren't checked. */
+    uint32_t                    uSeqGapMax;
+    /** Sequence number of the last record checked. */
+    uint64_t                    uSeqNoLast;
+    /** Number of sequence number gaps found. */
+    uint64_t                    cSeqGaps;
+    /** Number of sequence numbers found not increasing. */
+    uint64_t                    cSeqNonMono;
+    /** The LCLK statistics fed with the records, NULL if disabled. */
+    PLPCDECCLKSTATS             pClkStats;
+    /** Sample to tick lookup table, with LPC_DEC_TICK_LUT_CLK holding the clock level. */
+    uint8_t                     abLut[256];
+    /** The sequence numbers of the ticks. */
+    uint64_t                    auSeqNo[LPC_DEC_TICKS_MAX];
+    /** The ticks, LAD[3:0] and LPC_DEC_TICK_LFRAME. */
+    uint8_t                     abTicks[LPC_DEC_TICKS_MAX + LPC_DEC_TICKS_PAD];
+    /** The sequence numbers of the records extracted last for the check, preceded by the one of the record before. */
+    uint64_t                    au64SeqNoChk[LPC_DEC_SEQ_CHECK_RECS + 1];
+} LPCDECTICKS;
+/** Pointer to the clock tick decode engine. */
+typedef LPCDECTICKS *PLPCDECTICKS;
+/** Pointer to a const clock tick decode engine. */
+typedef const LPCDECTICKS *PCLPCDECTICKS;
 
-        fclose(pFile);
-    }
-    else
-        rc = errno;
 
-    return rc;
-}
+/** Pointer to a const index/data register pair. */
+typedef const struct LPCDECIDXDATAPAIR *PCLPCDECIDXDATAPAIR;
 
+/**
+ * A semantic record emitted by the index/data pair decoder.
+ */
+typedef struct LPCDECIDXDATAREC
+{
+    /** Sequence number of the cycle causing the record. */
+    uint64_t                    uSeqNo;
+    /** The register pair the record belongs to. */
+    PCLPCDECIDXDATAPAIR         pPair;
+    /** Flag whether the index register was written (bVal holds the raw value written). */
+    uint8_t                     fIdx;
+    /** Flag whether the data register was written, read otherwise. */
+    uint8_t                     fWrite;
+    /** The register index accessed through the data register. */
+    uint8_t                     bIdx;
+    /** The value written or read. */
+    uint8_t                     bVal;
+} LPCDECIDXDATAREC;
+/** Pointer to a const index/data pair record. */
+typedef const LPCDECIDXDATAREC *PCLPCDECIDXDATAREC;
 
 /**
- * Closes the given buffered file reader.
+ * Callback for a record emitted by the index/data pair decoder.
  *
  * @returns nothing.
- * @param   pBufFile                The buffered file reader to close.
+ * @param   pRec                    The record.
+ * @param   pvUser                  Opaque user data.
  */
-static void lpcDecFileBufReaderClose(PLPCDECFILEBUFREAD pBufFile)
+typedef void (*PFNLPCDECIDXDATAREC)(PCLPCDECIDXDATAREC pRec, void *pvUser);
+
+
+/**
+ * Index/data register pair description and shadow state.
+ */
+typedef struct LPCDECIDXDATAPAIR
 {
-    fclose(pBufFile->pFile);
-    free(pBufFile);
-}
+    /** Name of the register file used in the emitted records, e.g. "CMOS". */
+    const char                  *pszName;
+    /** I/O port of the index register. */
+    uint16_t                    u16PortIdx;
+    /** I/O port of the data register. */
+    uint16_t                    u16PortData;
+    /** Mask applied to the value written to the index register (CMOS uses bit 7 for NMI masking). */
+    uint8_t                     bIdxMask;
+    /** Flag whether the index register was written so far. */
+    uint8_t                     fIdxValid;
+    /** The currently selected index. */
+    uint8_t                     bIdx;
+    /** Bitmap of shadow registers which were accessed so far. */
+    uint8_t                     bmShadowValid[256 / 8];
+    /** The shadow register file. */
+    uint8_t                     abShadow[256];
+    /** Callback consuming the records emitted for this pair. */
+    PFNLPCDECIDXDATAREC         pfnRec;
+    /** Opaque user data for the callback. */
+    void                        *pvUser;
+} LPCDECIDXDATAPAIR;
+/** Pointer to an index/data register pair. */
+typedef LPCDECIDXDATAPAIR *PLPCDECIDXDATAPAIR;
 
 
 /**
- * Returns whether the given buffered file reader has run into an error.
- *
- * @returns Flag whether the has run into an error.
- * @param   pBufFile                The buffered file reader to check.
+ * Index/data register pair post-decoder.
  */
-static inline uint8_t lpcDecFileBufReaderHasError(PCLPCDECFILEBUFREAD pBufFile)
+typedef struct LPCDECIDXDATADEC
 {
-    return pBufFile->fError;
-}
+    /** Number of configured register pairs. */
+    uint32_t                    cPairs;
+    /** Default callback for records of newly added pairs. */
+    PFNLPCDECIDXDATAREC         pfnRec;
+    /** Opaque user data for the default callback. */
+    void                        *pvUser;
+    /** The configured register pairs. */
+    LPCDECIDXDATAPAIR           aPairs[LPC_DEC_IDX_DATA_PAIRS_MAX];
+    /** I/O port lookup table, entry is ((pair index + 1) << 1) | fDataPort, 0 if the port is not decoded. */
+    uint8_t                     abPortLookup[LPC_DEC_IO_PORT_COUNT];
+} LPCDECIDXDATADEC;
+/** Pointer to an index/data register pair post-decoder. */
+typedef LPCDECIDXDATADEC *PLPCDECIDXDATADEC;
+/** Pointer to a const index/data register pair post-decoder. */
+typedef const LPCDECIDXDATADEC *PCLPCDECIDXDATADEC;
 
 
 /**
- * Returns whether the given buffered file reader has reached EOS.
- *
- * @returns Flag whether the has reached EOS.
- * @param   pBufFile                The buffered file reader to check.
+ * Predefined index/data register pair.
  */
-static inline uint8_t lpcDecFileBufReaderHasEos(PCLPCDECFILEBUFREAD pBufFile)
+typedef struct LPCDECIDXDATAPRESET
 {
-    return pBufFile->fEos;
-}
+    /** Name of the preset as given on the command line. */
+    const char                  *pszPreset;
+    /** Name of the register file. */
+    const char                  *pszName;
+    /** I/O port of the index register. */
+    uint16_t                    u16PortIdx;
+    /** I/O port of the data register. */
+    uint16_t                    u16PortData;
+    /** Index mask. */
+    uint8_t                     bIdxMask;
+} LPCDECIDXDATAPRESET;
+/** Pointer to a const index/data register pair preset. */
+typedef const LPCDECIDXDATAPRESET *PCLPCDECIDXDATAPRESET;
 
 
 /**
- * Ensures that there is enough data to read.
- *
- * @returns Status code.
- * @param   pBufFile                The buffered file reader.
- * @param   cbData                  Amount of bytes which should be available.
+ * Super I/O configuration mode entry key.
  */
-static int lpcDecFileBufReaderEnsureData(PLPCDECFILEBUFREAD pBufFile, size_t cbData)
+typedef struct LPCDECSIOKEY
 {
-    if (pBufFile->offBuf + cbData <= pBufFile->cbData)
-        return 0;
+    /** Vendors using this key. */
+    const char                  *pszVendor;
+    /** Number of bytes in the key sequence. */
+    uint8_t                     cbKey;
+    /** The key sequence written to the index register. */
+    uint8_t                     abKey[4];
+    /** Flag whether the configuration mode is left through the ITE configuration control register instead of the exit key. */
+    uint8_t                     fExitCfgCtrl;
+} LPCDECSIOKEY;
+/** Pointer to a const Super I/O configuration mode entry key. */
+typedef const LPCDECSIOKEY *PCLPCDECSIOKEY;
 
-    /* Move all the remaining data to the front and fill up the free space. */
-    size_t cbRem = pBufFile->cbData - pBufFile->offBuf;
-    memmove(&pBufFile->abBuf[0], &pBufFile->abBuf[pBufFile->offBuf], cbRem);
 
-    /* Try reading in more data. */
-    size_t cbRead = fread(&pBufFile->abBuf[cbRem], 1, sizeof(pBufFile->abBuf) - cbRem, pBufFile->pFile);
-    pBufFile->cbData = cbRead + cbRem;
-    pBufFile->offBuf = 0;
-    if (!cbRead)
-        pBufFile->fEos = 1;
+/**
+ * Super I/O configuration space reconstruction state.
+ */
+typedef struct LPCDECSIODEC
+{
+    /** The index/data register pair the Super I/O is accessed through. */
+    PCLPCDECIDXDATAPAIR         pPair;
+    /** The stream to write the time indexed configuration log to. */
+    FILE                        *pOut;
+    /** The last four values written to the index register, most recent in the lowest byte. */
+    uint32_t                    u32KeyHist;
+    /** Number of values recorded in the key history (saturates at 4). */
+    uint32_t                    cKeyHist;
+    /** The key used to enter the configuration mode, NULL if not in configuration mode. */
+    PCLPCDECSIOKEY              pKey;
+    /** The key last used to enter the configuration mode, for the final dump. */
+    PCLPCDECSIOKEY              pKeyLast;
+    /** A key which matched while the index writes may still become a longer key, NULL if none. */
+    PCLPCDECSIOKEY              pKeyPending;
+    /** Sequence number of the index write completing the pending key. */
+    uint64_t                    uSeqNoPending;
+    /** Currently selected logical device number. */
+    uint8_t                     bLdn;
+    /** Number of data register accesses while not in the configuration mode. */
+    uint64_t                    cAccessesOutsideCfg;
+    /** Number of times the configuration mode was entered. */
+    uint64_t                    cCfgEntries;
+    /** Global configuration registers. */
+    uint8_t                     abGlobal[LPC_DEC_SIO_REG_LDN_FIRST];
+    /** Global configuration register flags (LPC_DEC_SIO_REG_F_XXX). */
+    uint8_t                     abGlobalFlags[LPC_DEC_SIO_REG_LDN_FIRST];
+    /** Logical device specific configuration registers. */
+    uint8_t                     aabLdn[LPC_DEC_SIO_LDN_COUNT][LPC_DEC_SIO_LDN_REG_COUNT];
+    /** Logical device specific configuration register flags (LPC_DEC_SIO_REG_F_XXX). */
+    uint8_t                     aabLdnFlags[LPC_DEC_SIO_LDN_COUNT][LPC_DEC_SIO_LDN_REG_COUNT];
+} LPCDECSIODEC;
+/** Pointer to a Super I/O configuration space reconstruction state. */
+typedef LPCDECSIODEC *PLPCDECSIODEC;
+/** Pointer to a const Super I/O configuration space reconstruction state. */
+typedef const LPCDECSIODEC *PCLPCDECSIODEC;
 
-    return 0;
-}
+
+/**
+ * KCS transfer phase as seen from the host side.
+ */
+typedef enum LPCDECKCSPHASE
+{
+    /** No transfer in progress. */
+    LPCDECKCSPHASE_IDLE = 0,
+    /** WRITE_START was issued, request bytes are written. */
+    LPCDECKCSPHASE_WRITE,
+    /** WRITE_END was issued, the next data byte is the last request byte. */
+    LPCDECKCSPHASE_WRITE_END,
+    /** The request is complete, response bytes are read. */
+    LPCDECKCSPHASE_READ,
+    /** 32bit hack. */
+    LPCDECKCSPHASE_32BIT_HACK = 0x7fffffff
+} LPCDECKCSPHASE;
 
 
 /**
- * Returns the next byte from the given buffered file reader.
- *
- * @returns Next byte value (0xff on error and error condition needs to get checked using lpcDecFileBufReaderHasError()).
- * @param   pBufFile                The buffered file reader.
+ * A KCS message exchange being reassembled.
  */
-static uint8_t lpcDecFileBufReaderGetU8(PLPCDECFILEBUFREAD pBufFile)
+typedef struct LPCDECKCSMSG
 {
-    /* Ensure that there is no error and there is least one byte to read. */
-    if (   lpcDecFileBufReaderHasError(pBufFile)
-        || lpcDecFileBufReaderEnsureData(pBufFile, sizeof(uint8_t)))
-        return UINT8_MAX;
+    /** Sequence number of the WRITE_START control code. */
+    uint64_t                    uSeqNoStart;
+    /** Sequence number of the last request byte. */
+    uint64_t                    uSeqNoReq;
+    /** Sequence number of the final dummy read ending the transfer. */
+    uint64_t                    uSeqNoEnd;
+    /** Number of request bytes. */
+    uint32_t                    cbReq;
+    /** Number of response bytes. */
+    uint32_t                    cbRsp;
+    /** Flag whether the request or response exceeded the buffer and was truncated. */
+    uint8_t                     fTruncated;
+    /** The request bytes (NetFn/LUN, Cmd, data). */
+    uint8_t                     abReq[LPC_DEC_KCS_MSG_MAX];
+    /** The response bytes (NetFn/LUN, Cmd, completion code, data). */
+    uint8_t                     abRsp[LPC_DEC_KCS_MSG_MAX];
+} LPCDECKCSMSG;
+/** Pointer to a KCS message exchange. */
+typedef LPCDECKCSMSG *PLPCDECKCSMSG;
+/** Pointer to a const KCS message exchange. */
+typedef const LPCDECKCSMSG *PCLPCDECKCSMSG;
 
-    return pBufFile->abBuf[pBufFile->offBuf++];
-}
+
+/**
+ * IPMI KCS interface post-decoder.
+ */
+typedef struct LPCDECKCSDEC
+{
+    /** I/O port of the data register, the status/command register is at the following port. */
+    uint16_t                    u16PortData;
+    /** The stream to log the messages to. */
+    FILE                        *pOut;
+    /** Current transfer phase. */
+    LPCDECKCSPHASE              enmPhase;
+    /** Flag whether the status register was read since the last data register access. */
+    uint8_t                     fStsValid;
+    /** The last value read from the status register. */
+    uint8_t                     bStsLast;
+    /** Number of complete message exchanges. */
+    uint64_t                    cMsgs;
+    /** Number of aborted or failed message exchanges. */
+    uint64_t                    cMsgsAborted;
+    /** Sum of the durations of all complete exchanges in samples. */
+    uint64_t                    cSamplesTotal;
+    /** Shortest exchange in samples. */
+    uint64_t                    cSamplesMin;
+    /** Longest exchange in samples. */
+    uint64_t                    cSamplesMax;
+    /** The message exchange currently being reassembled. */
+    LPCDECKCSMSG                Msg;
+    /** Preallocated buffer for formatting a log line. */
+    char                        achLine[LPC_DEC_KCS_LINE_MAX];
+} LPCDECKCSDEC;
+/** Pointer to an IPMI KCS interface post-decoder. */
+typedef LPCDECKCSDEC *PLPCDECKCSDEC;
+/** Pointer to a const IPMI KCS interface post-decoder. */
+typedef const LPCDECKCSDEC *PCLPCDECKCSDEC;
 
 
 /**
- * Returns the next 64bit unsigned integer from the given buffered file reader.
+ * Value index file header.
  *
- * @returns Next byte value (0xff on error and error condition needs to get checked using lpcDecFileBufReaderHasError()).
- * @param   pBufFile                The buffered file reader.
+ * The file is laid out as follows so it can be memory mapped and searched in place:
+ *     - The header.
+ *     - LPCDECVALIDXADDR entries for every address written, sorted by type and address.
+ *     - The sequence numbers of all writes as uint64_t, grouped by address and sorted by sequence number.
+ *     - The values of all writes as uint8_t, in the same order as the sequence numbers.
  */
-static uint64_t lpcDecFileBufReaderGetU64(PLPCDECFILEBUFREAD pBufFile)
+typedef struct LPCDECVALIDXHDR
 {
-    /* Ensure that there is no error and there is least one byte to read. */
-    if (   lpcDecFileBufReaderHasError(pBufFile)
-        || lpcDecFileBufReaderEnsureData(pBufFile, sizeof(uint64_t)))
-        return UINT64_MAX;
-
-    uint64_t u64Val = *(uint64_t *)&pBufFile->abBuf[pBufFile->offBuf];
-    pBufFile->offBuf += sizeof(uint64_t);
-    return u64Val;
-}
+    /** Magic (LPC_DEC_VAL_IDX_MAGIC). */
+    char                        achMagic[8];
+    /** File format version (LPC_DEC_VAL_IDX_VERSION). */
+    uint32_t                    u32Version;
+    /** Number of address entries. */
+    uint32_t                    cAddrs;
+    /** Total number of writes recorded. */
+    uint64_t                    cEntries;
+    /** Reserved, 0. */
+    uint64_t                    u64Rsvd;
+} LPCDECVALIDXHDR;
+/** Pointer to a const value index file header. */
+typedef const LPCDECVALIDXHDR *PCLPCDECVALIDXHDR;
 
 
 /**
- * Resets the given LPC decoder state to the initial state waiting for LFRAME# to be asserted.
- *
- * @returns nothing.
- * @param   pLpcDec                 The LPC decoder state.
+ * Value index address entry.
  */
-static void lpcDecStateReset(PLPCDEC pLpcDec)
+typedef struct LPCDECVALIDXADDR
 {
-    pLpcDec->idxState                     = 0;
-    pLpcDec->u32Addr                      = 0;
-    pLpcDec->bData                        = 0;
-    pLpcDec->iDataCycle                   = 0;
-    pLpcDec->aenmState[pLpcDec->idxState] = LPCDECSTATE_LFRAME_WAIT_ASSERTED;
-}
+    /** The address written. */
+    uint32_t                    u32Addr;
+    /** The cycle type (LPC_DEC_CYC_TYPE_XXX). */
+    uint8_t                     bTyp;
+    /** Reserved, 0. */
+    uint8_t                     abRsvd[3];
+    /** Index of the first write to this address in the sequence number and value arrays. */
+    uint64_t                    idxFirst;
+    /** Number of writes to this address. */
+    uint64_t                    cEntries;
+} LPCDECVALIDXADDR;
+/** Pointer to a const value index address entry. */
+typedef const LPCDECVALIDXADDR *PCLPCDECVALIDXADDR;
 
 
 /**
- * Initializes the given LPC state instance.
- *
- * @returns Status code.
- * @param   pLpcDec                 The LPC decoder state to initialize.
- * @param   u8BitClk                The bit number of the CLK signal in fed samples.
- * @param   u8BitLFrame             The bit number of the LFRAME# signal in fed samples.
- * @param   u8BitLad0               The bit number of the LAD[0] signal in fed samples.
- * @param   u8BitLad1               The bit number of the LAD[1] signal in fed samples.
- * @param   u8BitLad2               The bit number of the LAD[2] signal in fed samples.
- * @param   u8BitLad3               The bit number of the LAD[3] signal in fed samples.
+ * Write history of a single address while building the value index.
  */
-static int lpcDecStateInit(PLPCDEC pLpcDec, uint8_t u8BitClk, uint8_t u8BitLFrame,
-                           uint8_t u8BitLad0, uint8_t u8BitLad1, uint8_t u8BitLad2, uint8_t u8BitLad3)
+typedef struct LPCDECVALIDXBUILDADDR
 {
-    pLpcDec->u8BitLClk    = u8BitClk;
-    pLpcDec->u8BitLFrame  = u8BitLFrame;
-    pLpcDec->u8BitLad0    = u8BitLad0;
-    pLpcDec->u8BitLad1    = u8BitLad1;
-    pLpcDec->u8BitLad2    = u8BitLad2;
-    pLpcDec->u8BitLad3    = u8BitLad3;
-    pLpcDec->fClkLast     = 0; /* We start with a low clock. */
-    lpcDecStateReset(pLpcDec);
-    return 0;
-}
+    /** The lookup key (LPC_DEC_VAL_IDX_KEY()). */
+    uint64_t                    u64Key;
+    /** Number of writes recorded. */
+    uint64_t                    cEntries;
+    /** Number of writes the arrays have room for, 0 if the slot is free. */
+    uint64_t                    cEntriesMax;
+    /** Sequence numbers of the writes. */
+    uint64_t                    *pau64SeqNo;
+    /** Values of the writes. */
+    uint8_t                     *pabVal;
+} LPCDECVALIDXBUILDADDR;
+/** Pointer to the write history of a single address. */
+typedef LPCDECVALIDXBUILDADDR *PLPCDECVALIDXBUILDADDR;
+/** Pointer to the const write history of a single address. */
+typedef const LPCDECVALIDXBUILDADDR *PCLPCDECVALIDXBUILDADDR;
 
 
 /**
- * Extracts the LAD[3:0] from the given sample and returns them as a nibble in an 8bit unsigned integer.
+ * Value index builder.
  */
-static inline uint8_t lpcDecStateLadExtractFromSample(PCLPCDEC pLpcDec, uint8_t bSample)
+typedef struct LPCDECVALIDXBUILD
 {
-    return   ((bSample & (1 << pLpcDec->u8BitLad0)) >> pLpcDec->u8BitLad0)
-           | ((bSample & (1 << pLpcDec->u8BitLad1)) >> pLpcDec->u8BitLad1) << 1
-           | ((bSample & (1 << pLpcDec->u8BitLad2)) >> pLpcDec->u8BitLad2) << 2
-           | ((bSample & (1 << pLpcDec->u8BitLad3)) >> pLpcDec->u8BitLad3) << 3;
-}
+    /** Number of hash table slots, power of two. */
+    uint32_t                    cSlots;
+    /** Number of slots in use. */
+    uint32_t                    cAddrs;
+    /** Total number of writes recorded. */
+    uint64_t                    cEntries;
+    /** Status code of the first failed allocation, writes after that are dropped. */
+    int                         rcAlloc;
+    /** The open addressing hash table. */
+    PLPCDECVALIDXBUILDADDR      paSlots;
+} LPCDECVALIDXBUILD;
+/** Pointer to a value index builder. */
+typedef LPCDECVALIDXBUILD *PLPCDECVALIDXBUILD;
 
 
 /**
- * Converts the given LPC decoder state enum to a human readable string.
+ * Cycle store file header.
  *
- * @returns String of the given state.
- * @param   enmState                The state to convert.
+ * The header is followed by the chunks, each containing the following columns for its cycles:
+ *     - The address dictionary, uint32_t per distinct address in the chunk.
+ *     - Dictionary index per cycle, uint8_t if the dictionary has at most 256 entries, uint16_t otherwise.
+ *     - Type/direction/abort bitfield per cycle (LPC_DEC_STORE_TYPDIR_XXX), uint8_t.
+ *     - Data per cycle, uint8_t.
+ *     - Sequence number delta to the previous cycle as a LEB128 varint, the first one relative to the
+ *       first sequence number of the chunk.
+ * The chunk directory with one LPCDECSTORECHUNK per chunk is located at the end of the file.
  */
-static const char *lpcDecStateToStr(LPCDECSTATE enmState)
+typedef struct LPCDECSTOREHDR
 {
-    switch (enmState)
-    {
-        case LPCDECSTATE_INVALID:
-            return "<INVALID>";
-        case LPCDECSTATE_LFRAME_WAIT_ASSERTED:
-            return "WAIT_LFRAME_ASSERTED";
-        case LPCDECSTATE_START:
-            return "START";
-        case LPCDECSTATE_ADDR:
-            return "ADDR";
-        case LPCDECSTATE_DATA:
-            return "DATA";
-        case LPCDECSTATE_TAR:
-            return "TAR";
-        case LPCDECSTATE_SYNC:
-            return "SYNC";
-        default:
-            break;
-    }
+    /** Magic (LPC_DEC_STORE_MAGIC). */
+    char                        achMagic[8];
+    /** File format version (LPC_DEC_STORE_VERSION). */
+    uint32_t                    u32Version;
+    /** Maximum number of cycles per chunk. */
+    uint32_t                    cCyclesPerChunk;
+    /** Total number of cycles. */
+    uint64_t                    cCycles;
+    /** Number of chunks. */
+    uint64_t                    cChunks;
+    /** File offset of the chunk directory. */
+    uint64_t                    offDir;
+} LPCDECSTOREHDR;
+/** Pointer to a cycle store file header. */
+typedef LPCDECSTOREHDR *PLPCDECSTOREHDR;
 
-    return "<UNKNOWN>";
-}
+
+/**
+ * Cycle store chunk directory entry, summarizing the chunk so it can be skipped without reading it.
+ */
+typedef struct LPCDECSTORECHUNK
+{
+    /** File offset of the chunk. */
+    uint64_t                    offChunk;
+    /** Sequence number of the first cycle. */
+    uint64_t                    uSeqNoFirst;
+    /** Sequence number of the last cycle. */
+    uint64_t                    uSeqNoLast;
+    /** Size of the chunk in bytes. */
+    uint32_t                    cbChunk;
+    /** Number of cycles in the chunk. */
+    uint32_t                    cCycles;
+    /** Lowest address in the chunk. */
+    uint32_t                    u32AddrMin;
+    /** Highest address in the chunk. */
+    uint32_t                    u32AddrMax;
+    /** Number of entries in the address dictionary. */
+    uint32_t                    cDictAddrs;
+    /** Bitmap of the type/direction combinations present (LPC_DEC_STORE_TYPDIR_BIT()). */
+    uint8_t                     bmTypDir;
+    /** Flag whether the chunk contains aborted cycles. */
+    uint8_t                     fAbort;
+    /** Reserved, 0. */
+    uint8_t                     abRsvd[2];
+    /** Bloom filter over the addresses in the chunk. */
+    uint8_t                     abBloom[LPC_DEC_STORE_BLOOM_BYTES];
+} LPCDECSTORECHUNK;
+/** Pointer to a cycle store chunk directory entry. */
+typedef LPCDECSTORECHUNK *PLPCDECSTORECHUNK;
+/** Pointer to a const cycle store chunk directory entry. */
+typedef const LPCDECSTORECHUNK *PCLPCDECSTORECHUNK;
 
 
 /**
- * Dumps the current state of the LPC decoder.
- *
- * @returns nothing.
- * @param   pLpcDec                 The LPC decoder state.
- * @param   fAbort                  Flag whether an abort was detected.
+ * Cycle store writer.
  */
-static void lpcDecStateDump(PCLPCDEC pLpcDec, uint8_t fAbort)
+typedef struct LPCDECSTOREWRITER
 {
-    const char *pszTyp = "<INVALID>";
-    const char *pszDir = pLpcDec->fWrite ? "Write" : "Read ";
+    /** The store file. */
+    FILE                        *pFile;
+    /** Maximum number of cycles per chunk. */
+    uint32_t                    cCyclesPerChunk;
+    /** Number of cycles in the current chunk. */
+    uint32_t                    cCycles;
+    /** Total number of cycles written. */
+    uint64_t                    cCyclesTotal;
+    /** File offset of the next chunk. */
+    uint64_t                    offChunkNext;
+    /** Status code of the first failure, further cycles are dropped. */
+    int                         rc;
+    /** Sequence numbers of the current chunk. */
+    uint64_t                    *pau64SeqNo;
+    /** Addresses of the current chunk. */
+    uint32_t                    *pau32Addr;
+    /** Type/direction/abort bitfields of the current chunk. */
+    uint8_t                     *pabTypDir;
+    /** Data of the current chunk. */
+    uint8_t                     *pabData;
+    /** Number of hash table slots, power of two and at least twice the chunk size. */
+    uint32_t                    cHashSlots;
+    /** Hash table slots mapping addresses to dictionary indices (UINT32_MAX if free). */
+    uint32_t                    *pau32HashIdx;
+    /** The address dictionary of the current chunk. */
+    uint32_t                    *pau32Dict;
+    /** Dictionary indices of the current chunk. */
+    uint16_t                    *pau16DictIdx;
+    /** Buffer for the encoded chunk. */
+    uint8_t                     *pbChunk;
+    /** The chunk directory. */
+    PLPCDECSTORECHUNK           paChunks;
+    /** Number of chunks written. */
+    uint64_t                    cChunks;
+    /** Number of directory entries allocated. */
+    uint64_t                    cChunksMax;
+} LPCDECSTOREWRITER;
+/** Pointer to a cycle store writer. */
+typedef LPCDECSTOREWRITER *PLPCDECSTOREWRITER;
 
-    switch (pLpcDec->bTyp)
-    {
-        case LPC_DEC_CYC_TYPE_IO:
-            pszTyp = "I/O";
-            break;
-        case LPC_DEC_CYC_TYPE_MEM:
-            pszTyp = "Mem";
-            break;
-        case LPC_DEC_CYC_TYPE_DMA:
-            pszTyp = "DMA";
-            break;
-        case LPC_DEC_CYC_TYPE_RSVD:
-            pszTyp = "RESERVED";
-            break;
-        default:
-            printf("Wait WHAT?\n");
-            break;
-    }
 
-    printf("%" PRIu64 ": %s %s 0x%04x: 0x%02x ", pLpcDec->uSeqNoCycle, pszTyp, pszDir,
-                                                 pLpcDec->u32Addr, pLpcDec->bData);
-    if (g_fVerbose)
-    {
-        /* Walk the encountered state machine chain. */
-        for (uint32_t i = 0; i < pLpcDec->idxState; i++)
-            printf("%s -> ", lpcDecStateToStr(pLpcDec->aenmState[i]));
-        printf("%s", lpcDecStateToStr(pLpcDec->aenmState[pLpcDec->idxState]));
-        if (fAbort)
-            printf(" -> <ABORT>");
-    }
-    else if (fAbort)
-        printf("<ABORT>");
-    printf("\n");
-}
+/**
+ * Cycle store query filter.
+ */
+typedef struct LPCDECSTOREFILTER
+{
+    /** Lowest address to match. */
+    uint32_t                    u32AddrFirst;
+    /** Highest address to match. */
+    uint32_t                    u32AddrLast;
+    /** Bitmap of the type/direction combinations to match (LPC_DEC_STORE_TYPDIR_BIT()). */
+    uint8_t                     bmTypDir;
+    /** First sequence number to match. */
+    uint64_t                    uSeqNoFirst;
+    /** Last sequence number to match. */
+    uint64_t                    uSeqNoLast;
+} LPCDECSTOREFILTER;
+/** Pointer to a const cycle store query filter. */
+typedef const LPCDECSTOREFILTER *PCLPCDECSTOREFILTER;
 
 
 /**
- * Sets a new LPC deocder state.
- *
- * @returns nothing.
- * @param   pLpcDec                 The LPC decoder state.
- * @param   enmState                The new state to set.
+ * One side of a capture diff.
  */
-static void lpcDecStateSet(PLPCDEC pLpcDec, LPCDECSTATE enmState)
+typedef struct LPCDECDIFFSIDE
 {
-    pLpcDec->idxState++;
-    pLpcDec->aenmState[pLpcDec->idxState] = enmState;
-}
+    /** The capture file. */
+    const char                  *pszFilename;
+    /** The decoder thread. */
+    pthread_t                   hThread;
+    /** Status code of the decoding. */
+    int                         rc;
+    /** Number of cycles decoded. */
+    size_t                      cCycles;
+    /** Number of cycles the arrays have room for. */
+    size_t                      cCyclesMax;
+    /** The decoded cycles. */
+    PLPCDECCYCLE                paCycles;
+    /** Normalized cycle tuples (type, direction, address, data, abort) without the sequence number. */
+    uint64_t                    *pau64Key;
+} LPCDECDIFFSIDE;
+/** Pointer to one side of a capture diff. */
+typedef LPCDECDIFFSIDE *PLPCDECDIFFSIDE;
 
 
 /**
- * Advances the LPC deocder state machine to the next state.
- *
- * @returns nothing.
- * @param   pLpcDec                 The LPC decoder state.
+ * Anchor candidate hash table entry.
  */
-static void lpcDecStateSampleAdvance(PLPCDEC pLpcDec)
+typedef struct LPCDECDIFFANCHOR
 {
-    switch (pLpcDec->aenmState[pLpcDec->idxState])
-    {
-        case LPCDECSTATE_LFRAME_WAIT_ASSERTED:
-            /* We are not in any target cycle currently so stop. */
-            break;
-        case LPCDECSTATE_ADDR:
-            if (pLpcDec->fWrite)
-            {
-                lpcDecStateSet(pLpcDec, LPCDECSTATE_DATA);
-                pLpcDec->cDataCycles = 2;
-            }
-            else /* Reads have a turn around before. */
-            {
-                lpcDecStateSet(pLpcDec, LPCDECSTATE_TAR);
-                pLpcDec->cTarCycles = 2;
-            }
-            break;
-        case LPCDECSTATE_DATA:
-            lpcDecStateSet(pLpcDec, LPCDECSTATE_TAR);
-            pLpcDec->cTarCycles = 2;
-            break;
-        case LPCDECSTATE_TAR:
-            if (pLpcDec->fWrite)
-            {
-                if (pLpcDec->aenmState[pLpcDec->idxState - 1] == LPCDECSTATE_DATA)
-                    lpcDecStateSet(pLpcDec, LPCDECSTATE_SYNC);
-                else
-                {
-                    lpcDecStateDump(pLpcDec, 0 /*fAbort*/);
-                    lpcDecStateReset(pLpcDec); /* Second TAR phase in the cycle. */
-                }
-            }
-            else
-            {
-                if (pLpcDec->aenmState[pLpcDec->idxState - 1] == LPCDECSTATE_ADDR)
-                    lpcDecStateSet(pLpcDec, LPCDECSTATE_SYNC);
-                else
-                {
-                    lpcDecStateDump(pLpcDec, 0 /*fAbort*/);
-                    lpcDecStateReset(pLpcDec); /* Second TAR phase in the cycle. */
-                }
-            }
-            break;
-        case LPCDECSTATE_SYNC:
-            if (pLpcDec->fWrite)
-            {
-                lpcDecStateSet(pLpcDec, LPCDECSTATE_TAR);
-                pLpcDec->cTarCycles = 2;
-            }
-            else
-            {
-                lpcDecStateSet(pLpcDec, LPCDECSTATE_DATA);
-                pLpcDec->cDataCycles = 2;
-            }
-            break;
-        default:
-            printf("Unknown state %u\n", pLpcDec->aenmState[pLpcDec->idxState]);
-    }
-}
+    /** The rolling hash of the candidate, 0 if the entry is free (real zero hashes are remapped). */
+    uint64_t                    uHash;
+    /** First position in A. */
+    size_t                      idxA;
+    /** First position in B. */
+    size_t                      idxB;
+    /** Number of occurrences in A. */
+    uint32_t                    cA;
+    /** Number of occurrences in B. */
+    uint32_t                    cB;
+} LPCDECDIFFANCHOR;
+/** Pointer to an anchor candidate hash table entry. */
+typedef LPCDECDIFFANCHOR *PLPCDECDIFFANCHOR;
 
 
 /**
- * Decodes the START phase of the cycle.
- *
- * @returns nothing.
- * @param   pLpcDec                 The LPC decoder state.
- * @param   bLad                    Value of LAD[3:0].
+ * Capture diff state.
  */
-static void lpcDecStateStartDecode(PLPCDEC pLpcDec, uint8_t bLad)
+typedef struct LPCDECDIFF
 {
-    if (pLpcDec->bStartLast == LPC_DEC_START_TARGET_CYCLE)
-    {
-        /* New target cycle, LAD[3:0] contains type and direction. */
-        pLpcDec->bTyp    = LPC_DEC_CYC_TYPE_GET(bLad);
-        pLpcDec->fWrite  = !LPC_DEC_CYC_DIR_IS_READ(bLad);
-        pLpcDec->u32Addr = 0;
-        lpcDecStateSet(pLpcDec, LPCDECSTATE_ADDR);
-        switch (pLpcDec->bTyp)
-        {
-            case LPC_DEC_CYC_TYPE_IO:
-                pLpcDec->cAddrCycles = 4;
-                break;
-            case LPC_DEC_CYC_TYPE_MEM:
-                pLpcDec->cAddrCycles = 8;
-                break;
-            case LPC_DEC_CYC_TYPE_DMA: /** @todo */
-            case LPC_DEC_CYC_TYPE_RSVD:
-            default:
-                printf("Encountered ILLEGAL/unsupported cycle type: %#x\n", pLpcDec->bTyp);
-                lpcDecStateReset(pLpcDec);
-                break;
-        }
-    }
-    else if (pLpcDec->bStartLast == LPC_DEC_START_ABORT)
-        lpcDecStateReset(pLpcDec);
-}
+    /** The two sides, A and B. */
+    LPCDECDIFFSIDE              aSides[2];
+    /** The stream to write the differences to. */
+    FILE                        *pOut;
+    /** Maximum number of cycles to dump per side of a differing span. */
+    uint32_t                    cLinesMax;
+    /** Maximum number of differing spans to dump. */
+    uint64_t                    cHunksMax;
+    /** Flag whether a differing span is pending. */
+    uint8_t                     fHunk;
+    /** Start of the pending differing span in A. */
+    size_t                      idxHunkA;
+    /** Number of cycles in the pending differing span in A. */
+    size_t                      cHunkA;
+    /** Start of the pending differing span in B. */
+    size_t                      idxHunkB;
+    /** Number of cycles in the pending differing span in B. */
+    size_t                      cHunkB;
+    /** Number of differing spans found. */
+    uint64_t                    cHunks;
+    /** Number of cycles only in A. */
+    uint64_t                    cOnlyA;
+    /** Number of cycles only in B. */
+    uint64_t                    cOnlyB;
+    /** Number of spans which were too large to be aligned and are reported as replaced wholesale. */
+    uint64_t                    cUnaligned;
+} LPCDECDIFF;
+/** Pointer to a capture diff state. */
+typedef LPCDECDIFF *PLPCDECDIFF;
 
 
 /**
- * Decodes an address cycle.
- *
- * @returns nothing.
- * @param   pLpcDec                 The LPC decoder state.
- * @param   bLad                    Value of LAD[3:0].
+ * A single cycle token of a search pattern.
  */
-static void lpcDecStateAddrDecode(PLPCDEC pLpcDec, uint8_t bLad)
+typedef struct LPCDECFINDTOKEN
 {
-    pLpcDec->cAddrCycles--;
-    pLpcDec->u32Addr |= bLad << (pLpcDec->cAddrCycles * 4);
+    /** Cycle type or LPC_DEC_FIND_ANY. */
+    uint8_t                     bTyp;
+    /** Direction (LPC_DEC_CYC_DIR_XXX) or LPC_DEC_FIND_ANY. */
+    uint8_t                     bDir;
+    /** Abort flag or LPC_DEC_FIND_ANY. */
+    uint8_t                     bAbort;
+    /** Flag whether the token matches any address. */
+    uint8_t                     fAddrAny;
+    /** Flag whether the token matches any data. */
+    uint8_t                     fDataAny;
+    /** Data to match. */
+    uint8_t                     bData;
+    /** Padding, kept zero so tokens can be compared with memcmp(). */
+    uint8_t                     abPad[2];
+    /** Address to match. */
+    uint32_t                    u32Addr;
+} LPCDECFINDTOKEN;
+/** Pointer to a cycle token. */
+typedef LPCDECFINDTOKEN *PLPCDECFINDTOKEN;
+/** Pointer to a const cycle token. */
+typedef const LPCDECFINDTOKEN *PCLPCDECFINDTOKEN;
 
-    if (!pLpcDec->cAddrCycles)
-        lpcDecStateSampleAdvance(pLpcDec); /* Go to the next state. */
-}
+
+/**
+ * A search pattern.
+ */
+typedef struct LPCDECFINDPATTERN
+{
+    /** The pattern as given. */
+    char                        *pszPattern;
+    /** Index of the first automaton position of the pattern. */
+    uint32_t                    idxPosFirst;
+    /** Number of tokens in the pattern. */
+    uint32_t                    cTokens;
+    /** Number of matches found. */
+    uint64_t                    cMatches;
+} LPCDECFINDPATTERN;
+/** Pointer to a search pattern. */
+typedef LPCDECFINDPATTERN *PLPCDECFINDPATTERN;
+/** Pointer to a const search pattern. */
+typedef const LPCDECFINDPATTERN *PCLPCDECFINDPATTERN;
 
 
 /**
- * Decodes a data cycle.
+ * Callback for a search pattern match.
  *
  * @returns nothing.
- * @param   pLpcDec                 The LPC decoder state.
- * @param   bLad                    Value of LAD[3:0].
+ * @param   pPattern                The pattern which matched.
+ * @param   uSeqNoFirst             Sequence number of the first cycle of the match.
+ * @param   uSeqNoLast              Sequence number of the last cycle of the match.
+ * @param   pvUser                  Opaque user data passed during creation.
+ */
+typedef void (*PFNLPCDECFINDMATCH)(PCLPCDECFINDPATTERN pPattern, uint64_t uSeqNoFirst, uint64_t uSeqNoLast, void *pvUser);
+
+
+/**
+ * A position in the pattern automaton, i.e. the number of tokens of a pattern matched so far.
  */
-static void lpcDecStateDataDecode(PLPCDEC pLpcDec, uint8_t bLad)
+typedef struct LPCDECFINDPOS
 {
-    pLpcDec->bData |= bLad << (pLpcDec->iDataCycle * 4);
-    pLpcDec->iDataCycle++;
+    /** Index of the next token to match, UINT32_MAX if the pattern matched completely. */
+    uint32_t                    idxToken;
+    /** The pattern the position belongs to. */
+    uint32_t                    idxPattern;
+} LPCDECFINDPOS;
+/** Pointer to a pattern automaton position. */
+typedef LPCDECFINDPOS *PLPCDECFINDPOS;
 
-    if (pLpcDec->iDataCycle == pLpcDec->cDataCycles)
-        lpcDecStateSampleAdvance(pLpcDec);
-}
+
+/**
+ * A lazily built automaton state, a set of active positions.
+ */
+typedef struct LPCDECFINDSTATE
+{
+    /** Offset of the sorted active positions in the pool. */
+    uint32_t                    offPos;
+    /** Number of active positions. */
+    uint32_t                    cPos;
+    /** Offset of the indices of the patterns matching in this state in the pool. */
+    uint32_t                    offAccept;
+    /** Number of patterns matching in this state. */
+    uint32_t                    cAccepts;
+} LPCDECFINDSTATE;
+/** Pointer to an automaton state. */
+typedef LPCDECFINDSTATE *PLPCDECFINDSTATE;
+/** Pointer to a const automaton state. */
+typedef const LPCDECFINDSTATE *PCLPCDECFINDSTATE;
 
 
 /**
- * Decodes a TAR cycle.
- *
- * @returns nothing.
- * @param   pLpcDec                 The LPC decoder state.
- * @param   bLad                    Value of LAD[3:0].
+ * Hash table entry of the sequence search caches.
  */
-static void lpcDecStateTarDecode(PLPCDEC pLpcDec, uint8_t bLad)
+typedef struct LPCDECFINDHTABENTRY
 {
-    (void)(bLad);
+    /** The key. */
+    uint64_t                    uKey;
+    /** The value. */
+    uint32_t                    uVal;
+    /** Flag whether the entry is used. */
+    uint32_t                    fUsed;
+} LPCDECFINDHTABENTRY;
+/** Pointer to a hash table entry. */
+typedef LPCDECFINDHTABENTRY *PLPCDECFINDHTABENTRY;
 
-    pLpcDec->cTarCycles--;
-    if (!pLpcDec->cTarCycles)
-        lpcDecStateSampleAdvance(pLpcDec);
-}
+
+/**
+ * Open addressing hash table mapping 64-bit keys to 32-bit values.
+ */
+typedef struct LPCDECFINDHTAB
+{
+    /** The entries. */
+    PLPCDECFINDHTABENTRY        paEntries;
+    /** Number of entries, power of two. */
+    uint32_t                    cEntries;
+    /** Number of entries used. */
+    uint32_t                    cUsed;
+} LPCDECFINDHTAB;
+/** Pointer to a hash table. */
+typedef LPCDECFINDHTAB *PLPCDECFINDHTAB;
+/** Pointer to a const hash table. */
+typedef const LPCDECFINDHTAB *PCLPCDECFINDHTAB;
 
 
 /**
- * Decodes a SYNC cycle.
+ * Multi-pattern cycle sequence search state.
  *
- * @returns nothing.
- * @param   pLpcDec                 The LPC decoder state.
- * @param   bLad                    Value of LAD[3:0].
+ * The patterns are turned into an automaton whose states are sets of pattern positions, built lazily as
+ * the cycles come in. Cycles are mapped to classes, the set of distinct tokens they match, so the automaton
+ * only has to step once per cycle no matter how many patterns there are.
  */
-static void lpcDecStateSyncDecode(PLPCDEC pLpcDec, uint8_t bLad)
+typedef struct LPCDECFIND
 {
-    if (bLad == 0)
-        lpcDecStateSampleAdvance(pLpcDec);
-}
+    /** The stream to write matches and the summary to. */
+    FILE                        *pOut;
+    /** The callback for matches, NULL to write them to the output stream. */
+    PFNLPCDECFINDMATCH          pfnMatch;
+    /** Opaque user data for the callback. */
+    void                        *pvUser;
+    /** Status code, matching stops on the first error. */
+    int                         rc;
+    /** The distinct tokens of all patterns. */
+    PLPCDECFINDTOKEN            paTokens;
+    /** Number of distinct tokens. */
+    uint32_t                    cTokens;
+    /** Number of tokens the array has room for. */
+    uint32_t                    cTokensMax;
+    /** The patterns. */
+    PLPCDECFINDPATTERN          paPatterns;
+    /** Number of patterns. */
+    uint32_t                    cPatterns;
+    /** Number of patterns the array has room for. */
+    uint32_t                    cPatternsMax;
+    /** The automaton positions of all patterns. */
+    PLPCDECFINDPOS              paPos;
+    /** Number of positions. */
+    uint32_t                    cPos;
+    /** Number of positions the array has room for. */
+    uint32_t                    cPosMax;
+    /** Maximum number of tokens of all patterns. */
+    uint32_t                    cTokensPatternMax;
+    /** Number of 64-bit words per class bitmap. */
+    uint32_t                    cWordsClass;
+    /** The class bitmaps, bit set for every token the cycles of a class match. */
+    uint64_t                    *pau64Classes;
+    /** Number of classes. */
+    uint32_t                    cClasses;
+    /** Number of classes the array has room for. */
+    uint32_t                    cClassesMax;
+    /** The automaton states. */
+    PLPCDECFINDSTATE            paStates;
+    /** Number of states. */
+    uint32_t                    cStates;
+    /** Number of states the array has room for. */
+    uint32_t                    cStatesMax;
+    /** Pool for the state positions and accepted patterns. */
+    uint32_t                    *pau32Pool;
+    /** Number of pool entries used. */
+    uint32_t                    cPool;
+    /** Number of pool entries available. */
+    uint32_t                    cPoolMax;
+    /** Scratch space for the positions of a new state. */
+    uint32_t                    *pau32Scratch;
+    /** Interning table mapping the token hash to the token. */
+    LPCDECFINDHTAB              HtabToken;
+    /** Cache mapping the normalized cycle tuple to its class. */
+    LPCDECFINDHTAB              HtabCycle;
+    /** Interning table mapping the class bitmap hash to the class. */
+    LPCDECFINDHTAB              HtabClass;
+    /** Interning table mapping the position set hash to the state. */
+    LPCDECFINDHTAB              HtabState;
+    /** The transitions, the state and class combined into the key. */
+    LPCDECFINDHTAB              HtabTrans;
+    /** The current state. */
+    uint32_t                    idxStateCur;
+    /** Flag whether the automaton was set up. */
+    uint8_t                     fCompiled;
+    /** Number of cycles processed. */
+    uint64_t                    cCycles;
+    /** Sequence numbers of the most recent cycles, indexed by the cycle number modulo the array size. */
+    uint64_t                    au64SeqNo[LPC_DEC_FIND_TOKENS_MAX];
+    /** Number of times the state cache was flushed. */
+    uint32_t                    cFlushes;
+} LPCDECFIND;
+/** Pointer to a multi-pattern cycle sequence search state. */
+typedef LPCDECFIND *PLPCDECFIND;
+/** Pointer to a const multi-pattern cycle sequence search state. */
+typedef const LPCDECFIND *PCLPCDECFIND;
 
 
+/** Pointer to an Arrow IPC file output stream. */
+typedef struct LPCDECARROWOUT *PLPCDECARROWOUT;
+
 /**
- * Processes the given sample with the LPC decoder state given.
- *
- * @returns Status code.
- * @param   pLpcDec                 The LPC decoder state.
- * @param   uSeqNo                  Sequence number of the sample.
- * @param   bSample                 The new sample to process.
+ * Triggered extraction state, only the cycles around a trigger are dumped.
  */
-static int lpcDecStateSampleProcess(PLPCDEC pLpcDec, uint64_t uSeqNo, uint8_t bSample)
+typedef struct LPCDECTRIGGER
 {
-    /* Extract the clock and sample the other signals only on a falling edge. */
-    uint8_t fClk = !!(bSample & (1 << pLpcDec->u8BitLClk));
-    if (fClk == pLpcDec->fClkLast)
-        return 0;
+    /** The stream to write the windows to. */
+    FILE                        *pOut;
+    /** The Arrow output stream to add the windows to instead, NULL for the other formats. */
+    PLPCDECARROWOUT             pArrowOut;
+    /** The stream to write the window markers and the summary to, pOut unless the cycles are binary. */
+    FILE                        *pOutText;
+    /** The trigger patterns. */
+    PLPCDECFIND                 pFind;
+    /** Number of cycles to dump before a trigger. */
+    uint32_t                    cPre;
+    /** Number of cycles to dump after a trigger. */
+    uint32_t                    cPost;
+    /** Ring of the most recent cycles not dumped yet, cPre entries. */
+    PLPCDECCYCLE                paRing;
+    /** Index of the oldest cycle in the ring. */
+    uint32_t                    idxRingFirst;
+    /** Number of cycles in the ring. */
+    uint32_t                    cRing;
+    /** Number of cycles still to dump after the last trigger. */
+    uint32_t                    cPostLeft;
+    /** The pattern which triggered on the current cycle, NULL if none. */
+    PCLPCDECFINDPATTERN         pPatternHit;
+    /** Sequence number of the first cycle of the triggering match. */
+    uint64_t                    uSeqNoHit;
+    /** Number of triggers. */
+    uint64_t                    cTriggers;
+    /** Number of windows dumped, overlapping windows are merged. */
+    uint64_t                    cWindows;
+} LPCDECTRIGGER;
+/** Pointer to a triggered extraction state. */
+typedef LPCDECTRIGGER *PLPCDECTRIGGER;
+/** Pointer to a const triggered extraction state. */
+typedef const LPCDECTRIGGER *PCLPCDECTRIGGER;
 
-    if (   pLpcDec->fClkLast
-        && !fClk)
-    {
-        /* Extract LFrame# and check whether it is asserted. */
-        uint8_t fLFrame = !!(bSample & (1 << pLpcDec->u8BitLFrame));
-        uint8_t bLad = lpcDecStateLadExtractFromSample(pLpcDec, bSample);
 
-        if (!fLFrame)
-        {
-            if (   pLpcDec->aenmState[pLpcDec->idxState] != LPCDECSTATE_LFRAME_WAIT_ASSERTED
-                && pLpcDec->aenmState[pLpcDec->idxState] != LPCDECSTATE_START)
-                lpcDecStateDump(pLpcDec, 1 /*fAbort*/);
-            pLpcDec->bStartLast  = bLad;
-            pLpcDec->uSeqNoCycle = uSeqNo;
-            lpcDecStateReset(pLpcDec);
-            lpcDecStateSet(pLpcDec, LPCDECSTATE_START);
-        }
-        else
-        {
-            /* Act according on the current state. */
-            switch (pLpcDec->aenmState[pLpcDec->idxState])
-            {
-                case LPCDECSTATE_LFRAME_WAIT_ASSERTED:
-                    /* We are not in any target cycle currently so stop. */
-                    break;
-                case LPCDECSTATE_START:
-                    lpcDecStateStartDecode(pLpcDec, bLad);
-                    break;
-                case LPCDECSTATE_ADDR:
-                    lpcDecStateAddrDecode(pLpcDec, bLad);
-                    break;
-                case LPCDECSTATE_DATA:
-                    lpcDecStateDataDecode(pLpcDec, bLad);
-                    break;
-                case LPCDECSTATE_TAR:
-                    lpcDecStateTarDecode(pLpcDec, bLad);
-                    break;
-                case LPCDECSTATE_SYNC:
-                    lpcDecStateSyncDecode(pLpcDec, bLad);
-                    break;
-                default:
-                    printf("Unknown state %u\n", pLpcDec->aenmState[pLpcDec->idxState]);
-            }
-        }
-    }
+/**
+ * A chunk of a capture decoded by the batch command.
+ */
+typedef struct LPCDECBATCHCHUNK
+{
+    /** Index of the first record of the chunk. */
+    uint64_t                    idxRecFirst;
+    /** Number of records in the chunk, decoding continues past it until the last cycle started in it is complete. */
+    uint64_t                    cRecords;
+    /** Sequence number of the first record, cycles starting before it belong to the previous chunk. */
+    uint64_t                    uSeqNoFirst;
+    /** Sequence number of the first record of the next chunk, UINT64_MAX for the last chunk. */
+    uint64_t                    uSeqNoEnd;
+    /** The stream the cycles are dumped into. */
+    FILE                        *pOut;
+    /** The dumped cycles. */
+    char                        *pszOut;
+    /** Size of the dumped cycles. */
+    size_t                      cchOut;
+    /** Number of cycles decoded. */
+    uint64_t                    cCycles;
+    /** Number of aborted cycles. */
+    uint64_t                    cAborts;
+    /** Status code. */
+    int                         rc;
+} LPCDECBATCHCHUNK;
+/** Pointer to a batch chunk. */
+typedef LPCDECBATCHCHUNK *PLPCDECBATCHCHUNK;
 
-    pLpcDec->fClkLast = fClk;
-    return 0;
-}
+
+/**
+ * A capture decoded by the batch command.
+ */
+typedef struct LPCDECBATCHFILE
+{
+    /** The capture file. */
+    const char                  *pszFilename;
+    /** The output file. */
+    char                        *pszOut;
+    /** The file descriptor of the capture. */
+    int                         fd;
+    /** Index of the device the capture resides on. */
+    uint32_t                    idxDev;
+    /** Number of records in the capture. */
+    uint64_t                    cRecords;
+    /** Number of chunks. */
+    uint32_t                    cChunks;
+    /** Number of chunks decoded, protected by the batch mutex. */
+    uint32_t                    cChunksDone;
+    /** The chunks. */
+    PLPCDECBATCHCHUNK           paChunks;
+    /** Status code. */
+    int                         rc;
+    /** Number of cycles decoded. */
+    uint64_t                    cCycles;
+    /** Number of aborted cycles. */
+    uint64_t                    cAborts;
+} LPCDECBATCHFILE;
+/** Pointer to a batch capture. */
+typedef LPCDECBATCHFILE *PLPCDECBATCHFILE;
 
 
-int main(int argc, char *argv[])
+/**
+ * A device the batch captures reside on.
+ */
+typedef struct LPCDECBATCHDEV
 {
-    int ch = 0;
-    int idxOption = 0;
-    const char *pszFilename = NULL;
+    /** The device ID. */
+    dev_t                       idDev;
+    /** Number of reads in flight, protected by the batch mutex. */
+    uint32_t                    cReads;
+} LPCDECBATCHDEV;
+/** Pointer to a batch device. */
+typedef LPCDECBATCHDEV *PLPCDECBATCHDEV;
 
-    while ((ch = getopt_long (argc, argv, "Hvi:", &g_aOptions[0], &idxOption)) != -1)
-    {
-        switch (ch)
-        {
-            case 'h':
-            case 'H':
-                printf("%s: Low Pin Count Bus protocol decoder\n"
-                       "    --input <path/to/saleae/capture>\n"
-                       "    --verbose Dumps more information for each cycle like the state transitions encountered\n",
-                       argv[0]);
-                return 0;
-            case 'v':
-                g_fVerbose = 1;
-                break;
-            case 'i':
-                pszFilename = optarg;
-                break;
 
-            default:
-                fprintf(stderr, "Unrecognised option: -%c\n", optopt);
-                return 1;
-        }
-    }
+/**
+ * A batch work item, one chunk of a capture.
+ */
+typedef struct LPCDECBATCHITEM
+{
+    /** The capture. */
+    uint32_t                    idxFile;
+    /** The chunk of the capture. */
+    uint32_t                    idxChunk;
+} LPCDECBATCHITEM;
+/** Pointer to a batch work item. */
+typedef LPCDECBATCHITEM *PLPCDECBATCHITEM;
 
-    if (!pszFilename)
-    {
-        fprintf(stderr, "A filepath to the capture is required!\n");
-        return 1;
-    }
 
-    PLPCDECFILEBUFREAD pBufFile = NULL;
-    int rc = lpcDecFileBufReaderCreate(&pBufFile, pszFilename);
-    if (!rc)
-    {
-        LPCDEC LpcDec;
-        lpcDecStateInit(&LpcDec, 0, 1, 5, 4, 3, 2); /** @todo Make configurable */
+/**
+ * Batch worker thread with its work queue, the owner takes work from the tail and idle workers steal from the head.
+ */
+typedef struct LPCDECBATCHWORKER
+{
+    /** The owning batch. */
+    struct LPCDECBATCH          *pBatch;
+    /** The worker thread. */
+    pthread_t                   hThread;
+    /** Protects the queue. */
+    pthread_mutex_t             MtxQueue;
+    /** The queued work items. */
+    PLPCDECBATCHITEM            paItems;
+    /** Index of the first queued item. */
+    uint32_t                    idxHead;
+    /** Index after the last queued item. */
+    uint32_t                    idxTail;
+    /** Read buffer. */
+    uint8_t                     *pbBuf;
+    /** Number of items processed. */
+    uint64_t                    cItems;
+    /** Number of items stolen from other workers. */
+    uint64_t                    cSteals;
+} LPCDECBATCHWORKER;
+/** Pointer to a batch worker. */
+typedef LPCDECBATCHWORKER *PLPCDECBATCHWORKER;
 
-        while (   !lpcDecFileBufReaderHasEos(pBufFile)
-               && !rc)
-        {
-            uint64_t uSeqNo = lpcDecFileBufReaderGetU64(pBufFile);
-            uint8_t bVal = lpcDecFileBufReaderGetU8(pBufFile);
-            rc = lpcDecStateSampleProcess(&LpcDec, uSeqNo, bVal);
-        }
 
-        lpcDecFileBufReaderClose(pBufFile);
-    }
-    else
-        fprintf(stderr, "The file '%s' could not be opened\n", pszFilename);
+/**
+ * Batch decoding state.
+ */
+typedef struct LPCDECBATCH
+{
+    /** Protects the device read counters and chunk completion. */
+    pthread_mutex_t             Mtx;
+    /** Signalled when a read slot of a device becomes free. */
+    pthread_cond_t              CondDev;
+    /** The captures. */
+    PLPCDECBATCHFILE            paFiles;
+    /** Number of captures. */
+    uint32_t                    cFiles;
+    /** The devices. */
+    PLPCDECBATCHDEV             paDevs;
+    /** Number of devices. */
+    uint32_t                    cDevs;
+    /** Maximum number of concurrent reads per device. */
+    uint32_t                    cReadsPerDevMax;
+    /** The workers. */
+    PLPCDECBATCHWORKER          paWorkers;
+    /** Number of workers. */
+    uint32_t                    cWorkers;
+} LPCDECBATCH;
+/** Pointer to a batch decoding state. */
+typedef LPCDECBATCH *PLPCDECBATCH;
+
+
+/**
+ * zstd input buffer (ZSTD_inBuffer).
+ */
+typedef struct LPCDECZSTDINBUF
+{
+    /** Start of the input. */
+    const void                  *pv;
+    /** Size of the input. */
+    size_t                      cb;
+    /** Position of the next byte to consume. */
+    size_t                      off;
+} LPCDECZSTDINBUF;
+
+
+/**
+ * zstd output buffer (ZSTD_outBuffer).
+ */
+typedef struct LPCDECZSTDOUTBUF
+{
+    /** Start of the output buffer. */
+    void                        *pv;
+    /** Size of the output buffer. */
+    size_t                      cb;
+    /** Position of the next byte to write. */
+    size_t                      off;
+} LPCDECZSTDOUTBUF;
+
+
+/**
+ * The zstd API used, resolved from the library at runtime so the build doesn't depend on the development package.
+ */
+typedef struct LPCDECZSTDAPI
+{
+    /** ZSTD_createCCtx. */
+    void                        *(*pfnCreateCCtx)(void);
+    /** ZSTD_freeCCtx. */
+    size_t                      (*pfnFreeCCtx)(void *pCCtx);
+    /** ZSTD_CCtx_setParameter. */
+    size_t                      (*pfnCCtxSetParameter)(void *pCCtx, int iParam, int iValue);
+    /** ZSTD_compressStream2. */
+    size_t                      (*pfnCompressStream2)(void *pCCtx, LPCDECZSTDOUTBUF *pOutBuf, LPCDECZSTDINBUF *pInBuf,
+                                                      int iEndOp);
+    /** ZSTD_CStreamOutSize. */
+    size_t                      (*pfnCStreamOutSize)(void);
+    /** ZSTD_isError. */
+    unsigned                    (*pfnIsError)(size_t rcZstd);
+} LPCDECZSTDAPI;
+
+
+/**
+ * The SQLite API used, resolved from the library at runtime like the zstd one.
+ */
+typedef struct LPCDECSQLITEAPI
+{
+    /** sqlite3_open. */
+    int                         (*pfnOpen)(const char *pszFilename, void **ppDb);
+    /** sqlite3_close. */
+    int                         (*pfnClose)(void *pDb);
+    /** sqlite3_exec. */
+    int                         (*pfnExec)(void *pDb, const char *pszSql, void *pfnCallback, void *pvUser,
+                                           char **ppszErrMsg);
+    /** sqlite3_prepare_v2. */
+    int                         (*pfnPrepareV2)(void *pDb, const char *pszSql, int cbSql, void **ppStmt,
+                                                const char **ppszTail);
+    /** sqlite3_bind_int64. */
+    int                         (*pfnBindInt64)(void *pStmt, int iParam, int64_t i64);
+    /** sqlite3_bind_text. */
+    int                         (*pfnBindText)(void *pStmt, int iParam, const char *psz, int cch, void *pfnDtor);
+    /** sqlite3_step. */
+    int                         (*pfnStep)(void *pStmt);
+    /** sqlite3_reset. */
+    int                         (*pfnReset)(void *pStmt);
+    /** sqlite3_finalize. */
+    int                         (*pfnFinalize)(void *pStmt);
+    /** sqlite3_errmsg. */
+    const char                  *(*pfnErrMsg)(void *pDb);
+} LPCDECSQLITEAPI;
+
+
+/**
+ * SQLite database output, bulk loads the cycles and the index/data pair records.
+ */
+typedef struct LPCDECSQLITEOUT
+{
+    /** The database handle. */
+    void                        *pDb;
+    /** Prepared insert into the cycles table. */
+    void                        *pStmtCycle;
+    /** Prepared insert into the idx_data table. */
+    void                        *pStmtIdxData;
+    /** The index/data pair decoder producing the idx_data records, NULL if no pairs are configured. */
+    PLPCDECIDXDATADEC           pIdxDataDec;
+    /** Number of rows inserted in the current transaction. */
+    uint64_t                    cRowsTxn;
+    /** Status code, the first SQLite error is reported. */
+    int                         rc;
+} LPCDECSQLITEOUT;
+/** Pointer to a SQLite database output. */
+typedef LPCDECSQLITEOUT *PLPCDECSQLITEOUT;
+
+
+/**
+ * Compressed output stream, the formatted output is collected in blocks which a worker thread compresses and writes.
+ *
+ * Blocks are compressed in order, block n lives in slot n % LPC_DEC_ZSTD_BLOCKS.
+ */
+typedef struct LPCDECZSTDOUT
+{
+    /** The stream the compressed data is written to. */
+    FILE                        *pDst;
+    /** Flag whether to close the destination stream when done. */
+    uint8_t                     fCloseDst;
+    /** The zstd compression context. */
+    void                        *pCCtx;
+    /** The worker thread. */
+    pthread_t                   hThread;
+    /** Protects the counters below. */
+    pthread_mutex_t             Mtx;
+    /** Signalled when a block was queued or the stream ended. */
+    pthread_cond_t              CondFilled;
+    /** Signalled when a block was compressed. */
+    pthread_cond_t              CondFree;
+    /** Number of blocks queued. */
+    uint64_t                    cBlocksQueued;
+    /** Number of blocks compressed. */
+    uint64_t                    cBlocksDone;
+    /** Flag whether the stream ended. */
+    uint8_t                     fEos;
+    /** Status code of the worker. */
+    int                         rc;
+    /** Number of bytes in the block being filled. */
+    size_t                      cbCur;
+    /** Sizes of the queued blocks. */
+    size_t                      acbBlocks[LPC_DEC_ZSTD_BLOCKS];
+    /** The blocks. */
+    uint8_t                     *pabBlocks;
+    /** The compressed data buffer. */
+    uint8_t                     *pbOut;
+    /** Size of the compressed data buffer. */
+    size_t                      cbOut;
+} LPCDECZSTDOUT;
+/** Pointer to a compressed output stream. */
+typedef LPCDECZSTDOUT *PLPCDECZSTDOUT;
+
+
+/**
+ * Minimal flatbuffer builder writing front to back, referenced objects always follow the reference.
+ */
+typedef struct LPCDECFB
+{
+    /** The buffer. */
+    uint8_t                     *pb;
+    /** Number of bytes used. */
+    uint32_t                    cb;
+    /** Size of the buffer. */
+    uint32_t                    cbMax;
+    /** Status code, set when growing the buffer failed. */
+    int                         rc;
+    /** Position of the vtable of the table being built. */
+    uint32_t                    offVt;
+    /** Position of the table being built. */
+    uint32_t                    offTable;
+} LPCDECFB;
+/** Pointer to a flatbuffer builder. */
+typedef LPCDECFB *PLPCDECFB;
+
+
+/**
+ * Location of a record batch in an Arrow IPC file.
+ */
+typedef struct LPCDECARROWBLOCK
+{
+    /** Offset of the message in the file. */
+    uint64_t                    off;
+    /** Size of the message metadata including the prefix. */
+    uint32_t                    cbMeta;
+    /** Size of the message body. */
+    uint64_t                    cbBody;
+} LPCDECARROWBLOCK;
+/** Pointer to a record batch location. */
+typedef LPCDECARROWBLOCK *PLPCDECARROWBLOCK;
+
+
+/**
+ * Arrow IPC file output stream, takes decoded cycles and writes them column wise in record batches.
+ */
+typedef struct LPCDECARROWOUT
+{
+    /** The stream the file is written to. */
+    FILE                        *pDst;
+    /** Flag whether to write the IPC stream format without the file magic and footer. */
+    uint8_t                     fStream;
+    /** Status code of the writer. */
+    int                         rc;
+    /** Number of bytes written so far. */
+    uint64_t                    offFile;
+    /** Number of cycles per record batch. */
+    uint32_t                    cBatchCycles;
+    /** Number of cycles in the current batch. */
+    uint32_t                    cCycles;
+    /** Column: sequence numbers. */
+    uint64_t                    *pau64Seq;
+    /** Column: cycle types. */
+    uint8_t                     *pabType;
+    /** Column: directions, 1 for writes. */
+    uint8_t                     *pabDir;
+    /** Column: addresses. */
+    uint32_t                    *pau32Addr;
+    /** Column: data. */
+    uint8_t                     *pabData;
+    /** Column: abort bitmap. */
+    uint8_t                     *pbmAbort;
+    /** Number of record batches written. */
+    uint32_t                    cBlocks;
+    /** Number of record batch locations allocated. */
+    uint32_t                    cBlocksMax;
+    /** The record batch locations for the footer. */
+    PLPCDECARROWBLOCK           paBlocks;
+    /** The flatbuffer builder for the messages. */
+    LPCDECFB                    Fb;
+} LPCDECARROWOUT;
+
+
+/**
+ * Format of the dumped cycles.
+ */
+typedef enum LPCDECOUTFMT
+{
+    /** Invalid format, do not use. */
+    LPCDECOUTFMT_INVALID = 0,
+    /** Human readable text. */
+    LPCDECOUTFMT_TEXT,
+    /** One JSON object per line. */
+    LPCDECOUTFMT_JSONL,
+    /** pcapng with one packet per cycle. */
+    LPCDECOUTFMT_PCAPNG,
+    /** Arrow IPC file with one column per cycle field. */
+    LPCDECOUTFMT_ARROW,
+    /** 32bit hack. */
+    LPCDECOUTFMT_32BIT_HACK = 0x7fffffff
+} LPCDECOUTFMT;
+
+
+/**
+ * Output sink type.
+ */
+typedef enum LPCDECSINKTYPE
+{
+    /** Invalid type, do not use. */
+    LPCDECSINKTYPE_INVALID = 0,
+    /** Text log in the format of the standard output. */
+    LPCDECSINKTYPE_TEXT,
+    /** Binary dump of the decoded cycles. */
+    LPCDECSINKTYPE_BIN,
+    /** Summary statistics. */
+    LPCDECSINKTYPE_STATS,
+    /** Columnar cycle store for the query command. */
+    LPCDECSINKTYPE_STORE,
+    /** SQLite database. */
+    LPCDECSINKTYPE_SQLITE,
+    /** Text logs split by the --shard-by keys. */
+    LPCDECSINKTYPE_SHARD,
+    /** 32bit hack. */
+    LPCDECSINKTYPE_32BIT_HACK = 0x7fffffff
+} LPCDECSINKTYPE;
+
+
+/**
+ * An address range cycles can be sharded by.
+ */
+typedef struct LPCDECSHARDRANGE
+{
+    /** The name of the range as used in the shard paths. */
+    char                        szName[LPC_DEC_SHARD_RANGE_NAME_MAX];
+    /** The cycle type the range applies to, LPC_DEC_CYC_TYPE_IO or LPC_DEC_CYC_TYPE_MEM. */
+    uint8_t                     bTyp;
+    /** First address of the range. */
+    uint32_t                    u32AddrFirst;
+    /** Last address of the range (inclusive). */
+    uint32_t                    u32AddrLast;
+} LPCDECSHARDRANGE;
+/** Pointer to a const address range. */
+typedef const LPCDECSHARDRANGE *PCLPCDECSHARDRANGE;
+
+
+/**
+ * How the shard outputs split the cycles.
+ */
+typedef struct LPCDECSHARDCFG
+{
+    /** Flag whether the cycles are split by the cycle type. */
+    uint8_t                     fByType;
+    /** Flag whether the cycles are split by the direction. */
+    uint8_t                     fByDir;
+    /** Flag whether the cycles are split by the address ranges. */
+    uint8_t                     fByRange;
+    /** Number of address ranges. */
+    uint32_t                    cRanges;
+    /** The address ranges, the first matching one wins, cycles outside all of them go to the "other" shard. */
+    LPCDECSHARDRANGE            aRanges[LPC_DEC_SHARD_RANGES_MAX];
+} LPCDECSHARDCFG;
+/** Pointer to a const shard configuration. */
+typedef const LPCDECSHARDCFG *PCLPCDECSHARDCFG;
+
+
+/**
+ * A single shard of a shard output, opened when the first cycle arrives.
+ */
+typedef struct LPCDECSHARD
+{
+    /** The output stream, NULL until the first cycle. */
+    FILE                        *pOut;
+    /** The Arrow output stream writing to pOut, NULL for the other formats. */
+    PLPCDECARROWOUT             pArrowOut;
+    /** The write buffer of the stream. */
+    char                        *pchBuf;
+    /** Number of cycles written. */
+    uint64_t                    cCycles;
+} LPCDECSHARD;
+/** Pointer to a shard. */
+typedef LPCDECSHARD *PLPCDECSHARD;
+
+
+/**
+ * A decoded cycle as handed to the output sinks.
+ */
+typedef struct LPCDECSINKCYCLE
+{
+    /** The cycle. */
+    LPCDECCYCLE                 Cycle;
+    /** Number of SYNC wait states of the cycle. */
+    uint8_t                     cSyncWaits;
+} LPCDECSINKCYCLE;
+/** Pointer to a cycle handed to the output sinks. */
+typedef LPCDECSINKCYCLE *PLPCDECSINKCYCLE;
+/** Pointer to a const cycle handed to the output sinks. */
+typedef const LPCDECSINKCYCLE *PCLPCDECSINKCYCLE;
+
+
+/**
+ * A batch of decoded cycles shared by all output sinks.
+ */
+typedef struct LPCDECSINKBATCH
+{
+    /** Number of sinks which didn't process the batch yet. */
+    uint32_t                    cRefs;
+    /** Number of cycles in the batch. */
+    uint32_t                    cCycles;
+    /** The cycles. */
+    LPCDECSINKCYCLE             aCycles[LPC_DEC_SINK_BATCH_CYCLES];
+} LPCDECSINKBATCH;
+/** Pointer to a batch of decoded cycles. */
+typedef LPCDECSINKBATCH *PLPCDECSINKBATCH;
+/** Pointer to a const batch of decoded cycles. */
+typedef const LPCDECSINKBATCH *PCLPCDECSINKBATCH;
+
+
+/** Pointer to the output sinks. */
+typedef struct LPCDECSINKS *PLPCDECSINKS;
+
+/**
+ * A single output sink.
+ */
+typedef struct LPCDECSINK
+{
+    /** The owning sinks. */
+    PLPCDECSINKS                pSinks;
+    /** The sink type. */
+    LPCDECSINKTYPE              enmType;
+    /** The specification as given on the command line. */
+    const char                  *pszSpec;
+    /** The path of the output, - for the standard output. */
+    const char                  *pszPath;
+    /** The output stream, NULL for the cycle store. */
+    FILE                        *pOut;
+    /** Flag whether the output stream is owned by the sink. */
+    uint8_t                     fCloseOut;
+    /** The Arrow output stream of text sinks in the Arrow format, NULL otherwise. */
+    PLPCDECARROWOUT             pArrowOut;
+    /** Flag whether the Arrow output stream is the one of the main output and closed with it. */
+    uint8_t                     fArrowOutShared;
+    /** Buffer for the pcapng blocks of a batch, only for text sinks in the pcapng format. */
+    uint8_t                     *pbPcapng;
+    /** Buffer for the records of a batch, only for LPCDECSINKTYPE_BIN. */
+    uint8_t                     *pbBin;
+    /** The cycle store writer, only for LPCDECSINKTYPE_STORE. */
+    PLPCDECSTOREWRITER          pStore;
+    /** The SQLite database writer, only for LPCDECSINKTYPE_SQLITE. */
+    PLPCDECSQLITEOUT            pSqlite;
+    /** Number of shards, only for LPCDECSINKTYPE_SHARD. */
+    uint32_t                    cShards;
+    /** The shards, only for LPCDECSINKTYPE_SHARD. */
+    PLPCDECSHARD                paShards;
+    /** The zstd compression level of the shards, 0 for none. */
+    int                         iZstdLevel;
+    /** The worker thread. */
+    pthread_t                   hThread;
+    /** Number of batches processed, protected by the sinks mutex. */
+    uint64_t                    cBatchesDone;
+    /** Number of times the decoder had to wait for this sink. */
+    uint64_t                    cStalls;
+    /** Nanoseconds the decoder waited for this sink. */
+    uint64_t                    nsStalled;
+    /** Status code of the sink. */
+    int                         rc;
+    /** Stats: number of cycles per type and direction. */
+    uint64_t                    acCycles[4][2];
+    /** Stats: number of aborted cycles. */
+    uint64_t                    cAborts;
+    /** Stats: sequence number of the first cycle. */
+    uint64_t                    uSeqNoFirst;
+    /** Stats: sequence number of the last cycle. */
+    uint64_t                    uSeqNoLast;
+    /** Stats: number of accesses per I/O port. */
+    uint64_t                    *pacIoPort;
+} LPCDECSINK;
+/** Pointer to an output sink. */
+typedef LPCDECSINK *PLPCDECSINK;
+/** Pointer to a const output sink. */
+typedef const LPCDECSINK *PCLPCDECSINK;
+
+
+/**
+ * The output sinks consuming the same batches of decoded cycles on their own threads.
+ *
+ * Every sink processes all batches in order, so batch n lives in slot n % (LPC_DEC_SINK_QUEUE_DEPTH + 1)
+ * and a sink's queue is simply the difference between the published and its processed batch count.
+ */
+typedef struct LPCDECSINKS
+{
+    /** Protects the counters below. */
+    pthread_mutex_t             Mtx;
+    /** Signalled when a batch was published or the stream ended. */
+    pthread_cond_t              CondData;
+    /** Signalled when a sink processed a batch. */
+    pthread_cond_t              CondSpace;
+    /** Number of batches published. */
+    uint64_t                    cBatchesPublished;
+    /** Flag whether the stream ended. */
+    uint8_t                     fEos;
+    /** The batch being filled by the decoder. */
+    PLPCDECSINKBATCH            pCur;
+    /** The batch slots. */
+    PLPCDECSINKBATCH            paBatches;
+    /** The LCLK statistics appended to the stats outputs, NULL if disabled. */
+    PCLPCDECCLKSTATS            pClkStats;
+    /** Number of sinks. */
+    uint32_t                    cSinks;
+    /** The sinks. */
+    LPCDECSINK                  aSinks[LPC_DEC_SINKS_MAX];
+} LPCDECSINKS;
+/** Pointer to a const set of output sinks. */
+typedef const LPCDECSINKS *PCLPCDECSINKS;
+
+
+/**
+ * Decoding context, ties the decoded cycles to the output and post-decoders.
+ */
+typedef struct LPCDECCTX
+{
+    /** The stream to write the decoded output to. */
+    FILE                        *pOut;
+    /** The Arrow output stream writing to pOut, NULL for the other formats or if not started. */
+    PLPCDECARROWOUT             pArrowOut;
+    /** The stream to write the post-decoder output to, pOut unless the cycles are binary. */
+    FILE                        *pOutText;
+    /** The index/data pair post-decoder, NULL if disabled. */
+    PLPCDECIDXDATADEC           pIdxDataDec;
+    /** Number of Super I/O configuration space decoders. */
+    uint32_t                    cSioDecs;
+    /** The Super I/O configuration space decoders. */
+    PLPCDECSIODEC               apSioDec[LPC_DEC_SIO_DEC_MAX];
+    /** The IPMI KCS interface post-decoder, NULL if disabled. */
+    PLPCDECKCSDEC               pKcsDec;
+    /** The value index builder, NULL if disabled. */
+    PLPCDECVALIDXBUILD          pValIdx;
+    /** The cycle sequence search, NULL if disabled. */
+    PLPCDECFIND                 pFind;
+    /** The triggered extraction, NULL if every cycle is dumped. */
+    PLPCDECTRIGGER              pTrigger;
+    /** The output sinks, NULL if the cycles are dumped to the output stream. */
+    PLPCDECSINKS                pSinks;
+    /** The LCLK statistics, NULL if disabled. */
+    PLPCDECCLKSTATS             pClkStats;
+} LPCDECCTX;
+/** Pointer to a decoding context. */
+typedef LPCDECCTX *PLPCDECCTX;
+
+
+/*********************************************************************************************************************************
+*   Global Variables                                                                                                             *
+*********************************************************************************************************************************/
+
+/** Flag whether verbose mode is enabled. */
+static uint8_t g_fVerbose = 0;
+/** Sample rate of the capture in Hz, 0 if unknown. */
+static uint64_t g_uSampleRate = 0;
+/** Flag whether the socket input may drop data instead of applying backpressure. */
+static uint8_t g_fInputLossy = 0;
+/** Interval of the socket input lag reports in milliseconds, 0 to disable. */
+static uint32_t g_cMsInputStats = LPC_DEC_SOCK_STATS_INTERVAL_DEF;
+/** Largest sequence number increment between records not reported as an anomaly, 0 disables the check. */
+static uint32_t g_uSeqGapMax = 0;
+/** Flag whether the decoder is reset at sequence number anomalies. */
+static uint8_t g_fSeqReset = 0;
+/** The zstd API, pfnCreateCCtx is NULL until the library was loaded. */
+static LPCDECZSTDAPI g_Zstd;
+/** The SQLite API, pfnOpen is NULL until the library was loaded. */
+static LPCDECSQLITEAPI g_Sqlite;
+/** Format of the dumped cycles. */
+static LPCDECOUTFMT g_enmOutputFmt = LPCDECOUTFMT_TEXT;
+/** Number of cycles per Arrow record batch. */
+static uint32_t g_cArrowBatchCycles = LPC_DEC_ARROW_BATCH_CYCLES_DEF;
+/** Flag whether the Arrow output uses the IPC stream format instead of the file format. */
+static uint8_t g_fArrowStream = 0;
+/** How the shard outputs split the cycles. */
+static LPCDECSHARDCFG g_ShardCfg;
+/** The decode engine for captures, the phase export always steps the state machine. */
+static LPCDECENGINE g_enmEngine = LPCDECENGINE_TICK;
+
+/** Expands to the 16 two digit hex strings starting with the given digit. */
+#define LPC_DEC_HEX_ROW(a_Hi) \
+    a_Hi "0" a_Hi "1" a_Hi "2" a_Hi "3" a_Hi "4" a_Hi "5" a_Hi "6" a_Hi "7" \
+    a_Hi "8" a_Hi "9" a_Hi "a" a_Hi "b" a_Hi "c" a_Hi "d" a_Hi "e" a_Hi "f"
+/** Expands to the 10 two digit decimal strings starting with the given digit. */
+#define LPC_DEC_DEC_ROW(a_Hi) \
+    a_Hi "0" a_Hi "1" a_Hi "2" a_Hi "3" a_Hi "4" a_Hi "5" a_Hi "6" a_Hi "7" a_Hi "8" a_Hi "9"
+
+/** Two lowercase hex digits for every byte value. */
+static const char g_achHexPairs[] =
+    LPC_DEC_HEX_ROW("0") LPC_DEC_HEX_ROW("1") LPC_DEC_HEX_ROW("2") LPC_DEC_HEX_ROW("3")
+    LPC_DEC_HEX_ROW("4") LPC_DEC_HEX_ROW("5") LPC_DEC_HEX_ROW("6") LPC_DEC_HEX_ROW("7")
+    LPC_DEC_HEX_ROW("8") LPC_DEC_HEX_ROW("9") LPC_DEC_HEX_ROW("a") LPC_DEC_HEX_ROW("b")
+    LPC_DEC_HEX_ROW("c") LPC_DEC_HEX_ROW("d") LPC_DEC_HEX_ROW("e") LPC_DEC_HEX_ROW("f");
+
+/** Two decimal digits for every value from 0 to 99. */
+static const char g_achDecPairs[] =
+    LPC_DEC_DEC_ROW("0") LPC_DEC_DEC_ROW("1") LPC_DEC_DEC_ROW("2") LPC_DEC_DEC_ROW("3") LPC_DEC_DEC_ROW("4")
+    LPC_DEC_DEC_ROW("5") LPC_DEC_DEC_ROW("6") LPC_DEC_DEC_ROW("7") LPC_DEC_DEC_ROW("8") LPC_DEC_DEC_ROW("9");
+
+/**
+ * Precomputed JSON Lines fragments, indexed by LPC_DEC_JSONL_FRAG_XXX.
+ */
+static const struct
+{
+    /** The fragment. */
+    const char                  *psz;
+    /** Length of the fragment. */
+    size_t                      cch;
+} g_aJsonlFrags[] =
+{
+#define LPC_DEC_JSONL_FRAG(a_sz) { a_sz, sizeof(a_sz) - 1 }
+    LPC_DEC_JSONL_FRAG("{\"seq\":"),
+    LPC_DEC_JSONL_FRAG(",\"ts\":"),
+    LPC_DEC_JSONL_FRAG(",\"type\":\"io\""),
+    LPC_DEC_JSONL_FRAG(",\"type\":\"mem\""),
+    LPC_DEC_JSONL_FRAG(",\"type\":\"dma\""),
+    LPC_DEC_JSONL_FRAG(",\"type\":\"rsvd\""),
+    LPC_DEC_JSONL_FRAG(",\"dir\":\"r\""),
+    LPC_DEC_JSONL_FRAG(",\"dir\":\"w\""),
+    LPC_DEC_JSONL_FRAG(",\"addr\":\"0x"),
+    LPC_DEC_JSONL_FRAG("\",\"data\":\"0x"),
+    LPC_DEC_JSONL_FRAG("\",\"abort\":false"),
+    LPC_DEC_JSONL_FRAG("\",\"abort\":true"),
+    LPC_DEC_JSONL_FRAG(",\"sync_waits\":"),
+    LPC_DEC_JSONL_FRAG(",\"states\":["),
+    LPC_DEC_JSONL_FRAG("]"),
+    LPC_DEC_JSONL_FRAG("}\n"),
+    LPC_DEC_JSONL_FRAG("null")
+#undef LPC_DEC_JSONL_FRAG
+};
+
+/**
+ * Precomputed state chain fragments, indexed by LPCDECSTATE.
+ */
+static const struct
+{
+    /** The text fragment, the state followed by the separator. */
+    const char                  *pszText;
+    /** Length of the text fragment. */
+    size_t                      cchText;
+    /** The JSON fragment, the quoted state followed by the separator. */
+    const char                  *pszJson;
+    /** Length of the JSON fragment. */
+    size_t                      cchJson;
+} g_aStateFrags[LPC_DEC_STATES_MASK + 1] =
+{
+#define LPC_DEC_STATE_FRAG(a_sz) { a_sz " -> ", sizeof(a_sz " -> ") - 1, "\"" a_sz "\",", sizeof("\"" a_sz "\",") - 1 }
+    LPC_DEC_STATE_FRAG("<INVALID>"),
+    LPC_DEC_STATE_FRAG("WAIT_LFRAME_ASSERTED"),
+    LPC_DEC_STATE_FRAG("START"),
+    LPC_DEC_STATE_FRAG("ADDR"),
+    LPC_DEC_STATE_FRAG("DATA"),
+    LPC_DEC_STATE_FRAG("TAR"),
+    LPC_DEC_STATE_FRAG("SYNC"),
+    LPC_DEC_STATE_FRAG("<UNKNOWN>")
+#undef LPC_DEC_STATE_FRAG
+};
+
+/**
+ * Available options for lpc-dec.
+ */
+static struct option g_aOptions[] =
+{
+    {"input",   required_argument, 0, 'i'},
+    {"verbose", no_argument,       0, 'v'},
+    {"pair",    required_argument, 0, 'p'},
+    {"sio",     required_argument, 0, 's'},
+    {"sio-out", required_argument, 0, 'S'},
+    {"kcs",     required_argument, 0, 'k'},
+    {"kcs-log", required_argument, 0, 'K'},
+    {"sample-rate", required_argument, 0, 'r'},
+    {"value-index", required_argument, 0, 'x'},
+    {"find",    required_argument, 0, 'f'},
+    {"find-log", required_argument, 0, 'F'},
+    {"trigger", required_argument, 0, 't'},
+    {"pre",     required_argument, 0, 'b'},
+    {"post",    required_argument, 0, 'a'},
+    {"follow",  no_argument,       0, 'w'},
+    {"input-lossy", no_argument,   0, 'l'},
+    {"input-stats", required_argument, 0, 'I'},
+    {"output",  required_argument, 0, 'o'},
+    {"output-compress", required_argument, 0, 'z'},
+    {"output-format", required_argument, 0, 'O'},
+    {"export-vcd", required_argument, 0, 'V'},
+    {"shard-by", required_argument, 0, 'B'},
+    {"shard-range", required_argument, 0, 'R'},
+    {"engine",  required_argument, 0, 'E'},
+    {"seq-check", required_argument, 0, 'q'},
+    {"seq-check-reset", no_argument, 0, 'Q'},
+    {"clock-stats", required_argument, 0, 'c'},
+    {"clock-log", required_argument, 0, 'C'},
+
+    {"help",    no_argument,       0, 'H'},
+    {0, 0, 0, 0}
+};
+
+/**
+ * Available options for the query command.
+ */
+static struct option g_aOptionsQuery[] =
+{
+    {"index",   required_argument, 0, 'x'},
+    {"at",      required_argument, 0, 'a'},
+    {"addr",    required_argument, 0, 'A'},
+    {"type",    required_argument, 0, 't'},
+    {"store",   required_argument, 0, 's'},
+    {"dir",     required_argument, 0, 'd'},
+    {"from",    required_argument, 0, 'f'},
+    {"to",      required_argument, 0, 'T'},
+    {"count",   no_argument,       0, 'c'},
+
+    {"help",    no_argument,       0, 'H'},
+    {0, 0, 0, 0}
+};
+
+/**
+ * Available options for the index command.
+ */
+static struct option g_aOptionsIndex[] =
+{
+    {"input",       required_argument, 0, 'i'},
+    {"store",       required_argument, 0, 'o'},
+    {"chunk-size",  required_argument, 0, 'c'},
+
+    {"help",        no_argument,       0, 'H'},
+    {0, 0, 0, 0}
+};
+
+/**
+ * Available options for the diff command.
+ */
+static struct option g_aOptionsDiff[] =
+{
+    {"max-hunks",   required_argument, 0, 'm'},
+    {"max-lines",   required_argument, 0, 'l'},
+
+    {"help",        no_argument,       0, 'H'},
+    {0, 0, 0, 0}
+};
+
+/**
+ * Available options for the batch command.
+ */
+static struct option g_aOptionsBatch[] =
+{
+    {"jobs",        required_argument, 0, 'j'},
+    {"io-per-device", required_argument, 0, 'd'},
+    {"chunk-size",  required_argument, 0, 'c'},
+    {"out-dir",     required_argument, 0, 'o'},
+
+    {"help",        no_argument,       0, 'H'},
+    {0, 0, 0, 0}
+};
+
+/**
+ * Available options for the replay command.
+ */
+static struct option g_aOptionsReplay[] =
+{
+    {"input",       required_argument, 0, 'i'},
+    {"listen",      required_argument, 0, 'l'},
+    {"shm",         required_argument, 0, 'm'},
+    {"sample-rate", required_argument, 0, 'r'},
+
+    {"help",        no_argument,       0, 'H'},
+    {0, 0, 0, 0}
+};
+
+/**
+ * Known index/data register pairs selectable by name.
+ */
+static const LPCDECIDXDATAPRESET g_aIdxDataPresets[] =
+{
+    { "cmos",     "CMOS",     0x70, 0x71, 0x7f },
+    { "cmos-ext", "CMOS-EXT", 0x72, 0x73, 0xff },
+    { "sio-2e",   "SIO-2E",   0x2e, 0x2f, 0xff },
+    { "sio-4e",   "SIO-4E",   0x4e, 0x4f, 0xff }
+};
+
+/**
+ * Known Super I/O configuration mode entry keys, multi byte keys first.
+ */
+static const LPCDECSIOKEY g_aSioKeys[] =
+{
+    { "ITE (0x2e)",               4, { 0x87, 0x01, 0x55, 0x55 }, 1 },
+    { "ITE (0x4e)",               4, { 0x87, 0x01, 0x55, 0xaa }, 1 },
+    { "Nuvoton/Winbond/Fintek",   2, { 0x87, 0x87, 0x00, 0x00 }, 0 },
+    { "SMSC/Microchip",           1, { 0x55, 0x00, 0x00, 0x00 }, 0 }
+};
+
+/**
+ * IPMI network function names indexed by the request NetFn divided by 2.
+ */
+static const char *g_apszIpmiNetFn[] =
+{
+    "Chassis",
+    "Bridge",
+    "Sensor/Event",
+    "App",
+    "Firmware",
+    "Storage",
+    "Transport"
+};
+
+
+/*********************************************************************************************************************************
+*   Internal Functions                                                                                                           *
+*********************************************************************************************************************************/
+
+
+/**
+ * Returns the current monotonic timestamp in nanoseconds.
+ *
+ * @returns Timestamp in nanoseconds.
+ */
+static inline uint64_t lpcDecNanoTs(void)
+{
+    struct timespec Ts;
+    clock_gettime(CLOCK_MONOTONIC, &Ts);
+    return (uint64_t)Ts.tv_sec * UINT64_C(1000000000) + (uint64_t)Ts.tv_nsec;
+}
+
+
+/**
+ * Converts the given sequence number into nanoseconds since the start of the capture.
+ *
+ * Every output decides on its own how to present the sequence numbers without a sample rate.
+ *
+ * @returns Nanoseconds.
+ * @param   uSeqNo                  The sequence number, g_uSampleRate must not be 0.
+ */
+static inline uint64_t lpcDecSeqNoToNs(uint64_t uSeqNo)
+{
+    /* Split into whole seconds and the rest so the product doesn't overflow for long captures. */
+    return   uSeqNo / g_uSampleRate * UINT64_C(1000000000)
+           + (uSeqNo % g_uSampleRate) * UINT64_C(1000000000) / g_uSampleRate;
+}
+
+
+/**
+ * Returns whether the given input specification refers to a socket rather than a file.
+ *
+ * @returns Flag whether the input is a socket address.
+ * @param   pszInput                The input specification.
+ */
+static uint8_t lpcDecSockAddrIsSock(const char *pszInput)
+{
+    return    !strncmp(pszInput, "unix:", sizeof("unix:") - 1)
+           || !strncmp(pszInput, "tcp:", sizeof("tcp:") - 1);
+}
+
+
+/**
+ * Parses the given socket address of the form unix:<path> or tcp:<host>:<port>.
+ *
+ * @returns Status code.
+ * @param   pszAddr                 The address to parse.
+ * @param   fPassive                Flag whether the address is used for listening, an empty host binds to all
+ *                                  interfaces then.
+ * @param   pAddr                   Where to store the address.
+ * @param   pcbAddr                 Where to store the size of the address.
+ */
+static int lpcDecSockAddrParse(const char *pszAddr, uint8_t fPassive, struct sockaddr_storage *pAddr, socklen_t *pcbAddr)
+{
+    memset(pAddr, 0, sizeof(*pAddr));
+
+    if (!strncmp(pszAddr, "unix:", sizeof("unix:") - 1))
+    {
+        struct sockaddr_un *pAddrUn = (struct sockaddr_un *)pAddr;
+        const char *pszPath = pszAddr + sizeof("unix:") - 1;
+        size_t cchPath = strlen(pszPath);
+        if (   !cchPath
+            || cchPath >= sizeof(pAddrUn->sun_path))
+            return EINVAL;
+
+        pAddrUn->sun_family = AF_UNIX;
+        memcpy(&pAddrUn->sun_path[0], pszPath, cchPath + 1);
+        *pcbAddr = (socklen_t)sizeof(*pAddrUn);
+        return 0;
+    }
+
+    if (strncmp(pszAddr, "tcp:", sizeof("tcp:") - 1))
+        return EINVAL;
+
+    /* The port follows the last colon, IPv6 hosts can be given in brackets. */
+    char szHost[256];
+    const char *pszHost = pszAddr + sizeof("tcp:") - 1;
+    const char *pszPort = strrchr(pszHost, ':');
+    if (   !pszPort
+        || pszPort[1] == '\0'
+        || (size_t)(pszPort - pszHost) >= sizeof(szHost))
+        return EINVAL;
+
+    size_t cchHost = (size_t)(pszPort - pszHost);
+    if (   cchHost >= 2
+        && pszHost[0] == '['
+        && pszHost[cchHost - 1] == ']')
+    {
+        pszHost++;
+        cchHost -= 2;
+    }
+    memcpy(&szHost[0], pszHost, cchHost);
+    szHost[cchHost] = '\0';
+
+    struct addrinfo Hints;
+    struct addrinfo *pRes = NULL;
+    memset(&Hints, 0, sizeof(Hints));
+    Hints.ai_family   = AF_UNSPEC;
+    Hints.ai_socktype = SOCK_STREAM;
+    Hints.ai_flags    = fPassive ? AI_PASSIVE : 0;
+    if (getaddrinfo(cchHost ? &szHost[0] : NULL, pszPort + 1, &Hints, &pRes))
+        return EINVAL;
+
+    int rc = 0;
+    if (pRes->ai_addrlen <= sizeof(*pAddr))
+    {
+        memcpy(pAddr, pRes->ai_addr, pRes->ai_addrlen);
+        *pcbAddr = pRes->ai_addrlen;
+    }
+    else
+        rc = EINVAL;
+
+    freeaddrinfo(pRes);
+    return rc;
+}
+
+
+/**
+ * Receiver thread of the socket input, fills free buffers with complete records.
+ *
+ * @returns NULL.
+ * @param   pvUser                  The socket input.
+ */
+static void *lpcDecSockInRecvWorker(void *pvUser)
+{
+    PLPCDECSOCKIN pSockIn = (PLPCDECSOCKIN)pvUser;
+    int rc = 0;
+
+    for (;;)
+    {
+        /*
+         * Grab a free buffer, if the decoder fell behind wait for it (the socket fills up and the producer gets
+         * throttled by the flow control) or receive into the scratch buffer and drop the data.
+         */
+        pthread_mutex_lock(&pSockIn->Mtx);
+        if (   !pSockIn->pFreeHead
+            && !pSockIn->fLossy
+            && !pSockIn->fShutdown)
+        {
+            pSockIn->cStalls++;
+            while (   !pSockIn->pFreeHead
+                   && !pSockIn->fShutdown)
+                pthread_cond_wait(&pSockIn->CondFree, &pSockIn->Mtx);
+        }
+        PLPCDECSOCKBUF pBuf = pSockIn->pFreeHead;
+        if (pBuf)
+            pSockIn->pFreeHead = pBuf->pNext;
+        uint8_t fShutdown = pSockIn->fShutdown;
+        pthread_mutex_unlock(&pSockIn->Mtx);
+        if (fShutdown)
+            break;
+
+        /* The partial record from the last receive goes first so buffers only ever hold complete records. */
+        uint8_t *pbDst = pBuf ? &pBuf->ab[0] : pSockIn->pbDrop;
+        memcpy(pbDst, &pSockIn->abCarry[0], pSockIn->cbCarry);
+
+        ssize_t cbRecv;
+        do
+            cbRecv = recv(pSockIn->fdSock, pbDst + pSockIn->cbCarry, LPC_DEC_SOCK_BUF_SIZE - pSockIn->cbCarry, 0);
+        while (cbRecv < 0 && errno == EINTR);
+
+        size_t cbTotal = pSockIn->cbCarry + (cbRecv > 0 ? (size_t)cbRecv : 0);
+        size_t cbRecs  = cbTotal - cbTotal % LPC_DEC_RECORD_SIZE;
+        pSockIn->cbCarry = cbTotal - cbRecs;
+        memcpy(&pSockIn->abCarry[0], pbDst + cbRecs, pSockIn->cbCarry);
+
+        pthread_mutex_lock(&pSockIn->Mtx);
+        if (cbRecv > 0)
+            pSockIn->cbReceived += (uint64_t)cbRecv;
+        if (   pBuf
+            && cbRecs
+            && cbRecv > 0)
+        {
+            pBuf->pNext   = NULL;
+            pBuf->nsRecv  = lpcDecNanoTs();
+            pBuf->cbData  = cbRecs;
+            pBuf->offRead = 0;
+            pBuf->fDiscont = pSockIn->fDropPending;
+            pSockIn->fDropPending = 0;
+            if (pSockIn->pFilledTail)
+                pSockIn->pFilledTail->pNext = pBuf;
+            else
+                pSockIn->pFilledHead = pBuf;
+            pSockIn->pFilledTail = pBuf;
+            pSockIn->cbBuffered += cbRecs;
+            pthread_cond_signal(&pSockIn->CondFilled);
+        }
+        else if (pBuf)
+        {
+            pBuf->pNext = pSockIn->pFreeHead;
+            pSockIn->pFreeHead = pBuf;
+        }
+        else if (cbRecs)
+        {
+            pSockIn->cRecordsDropped += cbRecs / LPC_DEC_RECORD_SIZE;
+            pSockIn->fDropPending = 1;
+        }
+        pthread_mutex_unlock(&pSockIn->Mtx);
+
+        if (cbRecv <= 0)
+        {
+            /* A truncated trailing record is ignored like for files. */
+            rc = cbRecv == 0 ? -1 : errno;
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&pSockIn->Mtx);
+    pSockIn->fEos   = 1;
+    pSockIn->rcRecv = rc ? rc : -1;
+    pthread_cond_broadcast(&pSockIn->CondFilled);
+    pthread_mutex_unlock(&pSockIn->Mtx);
+    return NULL;
+}
+
+
+/**
+ * Prints the decoder lag and drop counters of the given socket input.
+ *
+ * @returns nothing.
+ * @param   pSockIn                 The socket input.
+ * @param   nsLag                   Age of the data currently decoded in nanoseconds.
+ */
+static void lpcDecSockInStatsReport(PLPCDECSOCKIN pSockIn, uint64_t nsLag)
+{
+    pthread_mutex_lock(&pSockIn->Mtx);
+    uint64_t cbReceived      = pSockIn->cbReceived;
+    uint64_t cbBuffered      = pSockIn->cbBuffered;
+    uint64_t cRecordsDropped = pSockIn->cRecordsDropped;
+    uint64_t cStalls         = pSockIn->cStalls;
+    pthread_mutex_unlock(&pSockIn->Mtx);
+
+    fprintf(stderr, "input: %" PRIu64 " bytes received, %" PRIu64 " bytes buffered, %.3f ms lag, "
+            "%" PRIu64 " records dropped, %" PRIu64 " receiver stalls\n",
+            cbReceived, cbBuffered, (double)nsLag / 1000000.0, cRecordsDropped, cStalls);
+}
+
+
+/**
+ * Fills the buffer of the given buffered reader from the socket input - PFNLPCDECBUFREADFILL.
+ */
+static int lpcDecSockInFill(PLPCDECFILEBUFREAD pBufFile, uint8_t *pbDst, size_t cbMax, size_t *pcbRead)
+{
+    PLPCDECSOCKIN pSockIn = pBufFile->pSockIn;
+    PLPCDECSOCKBUF pCur = pSockIn->pCur;
+    int rc = 0;
+
+    pthread_mutex_lock(&pSockIn->Mtx);
+    if (   pCur
+        && pCur->offRead == pCur->cbData)
+    {
+        /* Recycle the drained buffer. */
+        pCur->pNext = pSockIn->pFreeHead;
+        pSockIn->pFreeHead = pCur;
+        pthread_cond_signal(&pSockIn->CondFree);
+        pCur = NULL;
+    }
+    if (!pCur)
+    {
+        if (   !pSockIn->pFilledHead
+            && !pSockIn->fEos)
+            fflush(NULL); /* Get everything decoded so far out before going to sleep. */
+        while (   !pSockIn->pFilledHead
+               && !pSockIn->fEos)
+            pthread_cond_wait(&pSockIn->CondFilled, &pSockIn->Mtx);
+
+        pCur = pSockIn->pFilledHead;
+        if (pCur)
+        {
+            pSockIn->pFilledHead = pCur->pNext;
+            if (!pSockIn->pFilledHead)
+                pSockIn->pFilledTail = NULL;
+        }
+        else
+            rc = pSockIn->rcRecv;
+    }
+
+    size_t cbCopy = 0;
+    if (pCur)
+    {
+        cbCopy = pCur->cbData - pCur->offRead;
+        if (cbCopy > cbMax)
+            cbCopy = cbMax;
+        pSockIn->cbBuffered -= cbCopy;
+    }
+    pthread_mutex_unlock(&pSockIn->Mtx);
+
+    pSockIn->pCur = pCur;
+    if (!pCur)
+        return rc;
+
+    /* Buffers start at a record boundary, so the reader is at one as well when a buffer is started. */
+    if (   !pCur->offRead
+        && pCur->fDiscont)
+        pBufFile->fDiscont = 1;
+
+    memcpy(pbDst, &pCur->ab[pCur->offRead], cbCopy);
+    pCur->offRead += cbCopy;
+    *pcbRead = cbCopy;
+
+    if (pSockIn->cMsStats)
+    {
+        uint64_t nsNow = lpcDecNanoTs();
+        if (nsNow - pSockIn->nsStatsLast >= (uint64_t)pSockIn->cMsStats * 1000000)
+        {
+            lpcDecSockInStatsReport(pSockIn, nsNow - pCur->nsRecv);
+            pSockIn->nsStatsLast = nsNow;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * Destroys the given socket input, stopping the receiver.
+ *
+ * @returns nothing.
+ * @param   pSockIn                 The socket input to destroy.
+ */
+static void lpcDecSockInDestroy(PLPCDECSOCKIN pSockIn)
+{
+    pthread_mutex_lock(&pSockIn->Mtx);
+    pSockIn->fShutdown = 1;
+    pthread_cond_broadcast(&pSockIn->CondFree);
+    pthread_mutex_unlock(&pSockIn->Mtx);
+
+    /* Wakes up the receiver if it is blocked in recv(). */
+    shutdown(pSockIn->fdSock, SHUT_RDWR);
+    pthread_join(pSockIn->hThreadRecv, NULL);
+
+    if (pSockIn->cMsStats)
+        lpcDecSockInStatsReport(pSockIn, 0);
+
+    close(pSockIn->fdSock);
+    pthread_cond_destroy(&pSockIn->CondFree);
+    pthread_cond_destroy(&pSockIn->CondFilled);
+    pthread_mutex_destroy(&pSockIn->Mtx);
+    free(pSockIn->pbDrop);
+    free(pSockIn->paBufs);
+    free(pSockIn);
+}
+
+
+/**
+ * Creates a new buffered reader connected to the given socket address.
+ *
+ * @returns Status code.
+ * @param   ppBufFile               Where to store the pointer to the buffered reader on success.
+ * @param   pszAddr                 The address to connect to, unix:<path> or tcp:<host>:<port>.
+ * @param   fLossy                  Flag whether to drop data instead of throttling the producer when the decoder
+ *                                  falls behind.
+ * @param   cMsStats                Interval of the lag reports in milliseconds, 0 to disable.
+ */
+static int lpcDecSockBufReaderCreate(PLPCDECFILEBUFREAD *ppBufFile, const char *pszAddr, uint8_t fLossy, uint32_t cMsStats)
+{
+    struct sockaddr_storage Addr;
+    socklen_t cbAddr = 0;
+    int rc = lpcDecSockAddrParse(pszAddr, 0 /*fPassive*/, &Addr, &cbAddr);
+    if (rc)
+        return rc;
+
+    int fdSock = socket(Addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fdSock < 0)
+        return errno;
+
+    if (connect(fdSock, (struct sockaddr *)&Addr, cbAddr) < 0)
+    {
+        rc = errno;
+        close(fdSock);
+        return rc;
+    }
+
+    /* A large socket buffer absorbs bursts while the decoder is busy, failing to set it is not fatal. */
+    int cbRcvBuf = LPC_DEC_SOCK_RCVBUF_SIZE;
+    setsockopt(fdSock, SOL_SOCKET, SO_RCVBUF, &cbRcvBuf, sizeof(cbRcvBuf));
+
+    PLPCDECFILEBUFREAD pBufFile = (PLPCDECFILEBUFREAD)calloc(1, sizeof(*pBufFile));
+    PLPCDECSOCKIN pSockIn = (PLPCDECSOCKIN)calloc(1, sizeof(*pSockIn));
+    PLPCDECSOCKBUF paBufs = (PLPCDECSOCKBUF)calloc(LPC_DEC_SOCK_BUF_COUNT, sizeof(*paBufs));
+    uint8_t *pbDrop = fLossy ? (uint8_t *)malloc(LPC_DEC_SOCK_BUF_SIZE) : NULL;
+    if (   pBufFile
+        && pSockIn
+        && paBufs
+        && (pbDrop || !fLossy))
+    {
+        pSockIn->fdSock      = fdSock;
+        pSockIn->paBufs      = paBufs;
+        pSockIn->pbDrop      = pbDrop;
+        pSockIn->fLossy      = fLossy;
+        pSockIn->cMsStats    = cMsStats;
+        pSockIn->nsStatsLast = lpcDecNanoTs();
+        for (uint32_t i = 0; i < LPC_DEC_SOCK_BUF_COUNT; i++)
+        {
+            paBufs[i].pNext = pSockIn->pFreeHead;
+            pSockIn->pFreeHead = &paBufs[i];
+        }
+        pthread_mutex_init(&pSockIn->Mtx, NULL);
+        pthread_cond_init(&pSockIn->CondFilled, NULL);
+        pthread_cond_init(&pSockIn->CondFree, NULL);
+
+        rc = pthread_create(&pSockIn->hThreadRecv, NULL, lpcDecSockInRecvWorker, pSockIn);
+        if (!rc)
+        {
+            pBufFile->pfnFill   = lpcDecSockInFill;
+            pBufFile->pFile     = NULL;
+            pBufFile->pSockIn   = pSockIn;
+            pBufFile->fdInotify = -1;
+            *ppBufFile = pBufFile;
+            return 0;
+        }
+
+        pthread_cond_destroy(&pSockIn->CondFree);
+        pthread_cond_destroy(&pSockIn->CondFilled);
+        pthread_mutex_destroy(&pSockIn->Mtx);
+    }
+    else
+        rc = ENOMEM;
+
+    free(pbDrop);
+    free(paBufs);
+    free(pSockIn);
+    free(pBufFile);
+    close(fdSock);
+    return rc;
+}
+
+
+/**
+ * Waits on the given futex in a shared-memory segment as long as it has the given value.
+ *
+ * @returns nothing.
+ * @param   pu32Futex               The futex word.
+ * @param   u32Expected             The value to wait for a change from.
+ */
+static void lpcDecShmFutexWait(uint32_t *pu32Futex, uint32_t u32Expected)
+{
+    struct timespec TsTimeout;
+    TsTimeout.tv_sec  = LPC_DEC_SHM_WAIT_TIMEOUT_MS / 1000;
+    TsTimeout.tv_nsec = (LPC_DEC_SHM_WAIT_TIMEOUT_MS % 1000) * 1000000L;
+    syscall(SYS_futex, pu32Futex, FUTEX_WAIT, u32Expected, &TsTimeout, NULL, 0);
+}
+
+
+/**
+ * Increments the given futex in a shared-memory segment, waking up the other side if it waits.
+ *
+ * @returns nothing.
+ * @param   pu32Futex               The futex word.
+ * @param   pfWaiting               The flag the other side sets while waiting.
+ */
+static void lpcDecShmFutexSignal(uint32_t *pu32Futex, uint32_t *pfWaiting)
+{
+    __atomic_add_fetch(pu32Futex, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(pfWaiting, __ATOMIC_SEQ_CST))
+        syscall(SYS_futex, pu32Futex, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+
+/**
+ * Returns whether the consumer of the given shared-memory ring stopped decoding or exited without saying so.
+ *
+ * @returns Flag whether the consumer is gone, a producer waiting for it would wait forever.
+ * @param   pHdr                    The ring segment header.
+ */
+static uint8_t lpcDecShmConsumerIsGone(PLPCDECSHMHDR pHdr)
+{
+    if (__atomic_load_n(&pHdr->fConsumerDone, __ATOMIC_SEQ_CST))
+        return 1;
+
+    pid_t PidConsumer = (pid_t)__atomic_load_n(&pHdr->u32ConsumerPid, __ATOMIC_SEQ_CST);
+    return PidConsumer && kill(PidConsumer, 0) && errno == ESRCH;
+}
+
+
+/**
+ * Returns whether the given input specification refers to a shared-memory ring.
+ *
+ * @returns Flag whether the input is a shared-memory ring.
+ * @param   pszInput                The input specification.
+ */
+static uint8_t lpcDecShmIsShm(const char *pszInput)
+{
+    return !strncmp(pszInput, "shm:", sizeof("shm:") - 1);
+}
+
+
+/**
+ * Maps the shared-memory ring segment with the given name.
+ *
+ * @returns Status code.
+ * @param   pszName                 The segment name (without the shm: prefix).
+ * @param   fCreate                 Flag whether to create the segment for the producer, replacing an existing one.
+ * @param   cRecords                Number of records in the ring when creating.
+ * @param   ppHdr                   Where to store the mapped segment on success.
+ * @param   pcbMap                  Where to store the size of the mapping on success.
+ */
+static int lpcDecShmMap(const char *pszName, uint8_t fCreate, uint64_t cRecords, PLPCDECSHMHDR *ppHdr, size_t *pcbMap)
+{
+    char szPath[256];
+    if (   !*pszName
+        || strchr(pszName, '/')
+        || snprintf(&szPath[0], sizeof(szPath), LPC_DEC_SHM_DIR "%s", pszName) >= (int)sizeof(szPath))
+        return EINVAL;
+
+    int fd = open(&szPath[0], fCreate ? O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC : O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0)
+        return errno;
+
+    int rc = 0;
+    size_t cbMap = 0;
+    if (fCreate)
+    {
+        cbMap = sizeof(LPCDECSHMHDR) + cRecords * LPC_DEC_RECORD_SIZE;
+        if (ftruncate(fd, (off_t)cbMap) < 0)
+            rc = errno;
+    }
+    else
+    {
+        struct stat StShm;
+        if (fstat(fd, &StShm) < 0)
+            rc = errno;
+        else if ((size_t)StShm.st_size < sizeof(LPCDECSHMHDR))
+            rc = EINVAL;
+        else
+            cbMap = (size_t)StShm.st_size;
+    }
+
+    if (!rc)
+    {
+        void *pvMap = mmap(NULL, cbMap, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (pvMap != MAP_FAILED)
+        {
+            PLPCDECSHMHDR pHdr = (PLPCDECSHMHDR)pvMap;
+            if (fCreate)
+            {
+                pHdr->u32Version = LPC_DEC_SHM_VERSION;
+                pHdr->cbHdr      = sizeof(*pHdr);
+                pHdr->cbRing     = cRecords * LPC_DEC_RECORD_SIZE;
+                __atomic_thread_fence(__ATOMIC_RELEASE);
+                memcpy(&pHdr->achMagic[0], LPC_DEC_SHM_MAGIC, sizeof(pHdr->achMagic));
+            }
+            else
+            {
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (   memcmp(&pHdr->achMagic[0], LPC_DEC_SHM_MAGIC, sizeof(pHdr->achMagic))
+                    || pHdr->u32Version != LPC_DEC_SHM_VERSION
+                    || pHdr->cbHdr != sizeof(*pHdr)
+                    || !pHdr->cbRing
+                    || pHdr->cbRing % LPC_DEC_RECORD_SIZE
+                    || pHdr->cbRing > cbMap - sizeof(*pHdr))
+                    rc = EINVAL;
+            }
+
+            if (!rc)
+            {
+                *ppHdr  = pHdr;
+                *pcbMap = cbMap;
+            }
+            else
+                munmap(pvMap, cbMap);
+        }
+        else
+            rc = errno;
+    }
+
+    close(fd);
+    if (rc && fCreate)
+        unlink(&szPath[0]);
+    return rc;
+}
+
+
+/**
+ * Blocks until the followed file was modified or closed by the writer.
+ *
+ * @returns Status code.
+ * @param   pBufFile                The buffered file reader.
+ */
+static int lpcDecFileBufReaderFollowWait(PLPCDECFILEBUFREAD pBufFile)
+{
+    union
+    {
+        struct inotify_event    Evt;
+        uint8_t                 ab[4096];
+    } uBuf;
+
+    /* Get everything decoded so far out before going to sleep. */
+    fflush(NULL);
+
+    ssize_t cbEvts;
+    do
+        cbEvts = read(pBufFile->fdInotify, &uBuf, sizeof(uBuf));
+    while (cbEvts < 0 && errno == EINTR);
+    if (cbEvts <= 0)
+        return cbEvts < 0 ? errno : EIO;
+
+    ssize_t offEvt = 0;
+    while (offEvt < cbEvts)
+    {
+        const struct inotify_event *pEvt = (const struct inotify_event *)&uBuf.ab[offEvt];
+        if (pEvt->mask & (IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+            pBufFile->fWriterDone = 1;
+        offEvt += (ssize_t)(sizeof(*pEvt) + pEvt->len);
+    }
+
+    return 0;
+}
+
+
+/**
+ * Fills the buffer of the given buffered file reader from the file - PFNLPCDECBUFREADFILL.
+ */
+static int lpcDecFileBufReaderFill(PLPCDECFILEBUFREAD pBufFile, uint8_t *pbDst, size_t cbMax, size_t *pcbRead)
+{
+    for (;;)
+    {
+        size_t cbRead = fread(pbDst, 1, cbMax, pBufFile->pFile);
+        if (cbRead)
+        {
+            *pcbRead = cbRead;
+            return 0;
+        }
+        if (ferror(pBufFile->pFile))
+            return EIO;
+
+        /*
+         * When following, wait for the writer to append more and retry, the decoder state is kept by the caller.
+         * A writer closing the file gets one more read as it may have appended right before closing.
+         */
+        if (   !pBufFile->fFollow
+            || pBufFile->fWriterDone)
+            return -1;
+
+        clearerr(pBufFile->pFile);
+        int rc = lpcDecFileBufReaderFollowWait(pBufFile);
+        if (rc)
+            return rc;
+    }
+}
+
+
+/**
+ * Creates a new buffered file reader from the given filename.
+ *
+ * @returns Status code.
+ * @param   ppBufFile               Where to store the pointer to the buffered file reader on success.
+ * @param   pszFilename             The file to load.
+ * @param   fFollow                 Flag whether to wait for more data at the end of the file until the writer
+ *                                  closes it, the file may be empty initially then.
+ */
+static int lpcDecFileBufReaderCreate(PLPCDECFILEBUFREAD *ppBufFile, const char *pszFilename, uint8_t fFollow)
+{
+    int rc = 0;
+    FILE *pFile = fopen(pszFilename, "rb");
+    if (pFile)
+    {
+        PLPCDECFILEBUFREAD pBufFile = (PLPCDECFILEBUFREAD)calloc(1, sizeof(*pBufFile));
+        if (pBufFile)
+        {
+            pBufFile->pfnFill     = lpcDecFileBufReaderFill;
+            pBufFile->pFile       = pFile;
+            pBufFile->pSockIn     = NULL;
+            pBufFile->cbData      = 0;
+            pBufFile->offBuf      = 0;
+            pBufFile->fError      = 0;
+            pBufFile->fEos        = 0;
+            pBufFile->fFollow     = fFollow;
+            pBufFile->fWriterDone = 0;
+            pBufFile->fdInotify   = -1;
+
+            /* The watch must be in place before the first read so no append can go unnoticed. */
+            if (fFollow)
+            {
+                pBufFile->fdInotify = inotify_init1(IN_CLOEXEC);
+                if (   pBufFile->fdInotify < 0
+                    || inotify_add_watch(pBufFile->fdInotify, pszFilename,
+                                         IN_MODIFY | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF) < 0)
+                {
+                    rc = errno;
+                    if (pBufFile->fdInotify >= 0)
+                        close(pBufFile->fdInotify);
+                    free(pBufFile);
+                    fclose(pFile);
+                    return rc;
+                }
+            }
+
+            /* Read in the first chunk. */
+            size_t cbRead = fread(&pBufFile->abBuf[0], 1, sizeof(pBufFile->abBuf), pFile);
+            if (cbRead || fFollow)
+            {
+                pBufFile->cbData = cbRead;
+                *ppBufFile = pBufFile;
+                return 0;
+            }
+            else
+                rc = -1;
+
+            free(pBufFile);
+        }
+        else
+            rc = -1;
+
+        fclose(pFile);
+    }
+    else
+        rc = errno;
+
+    return rc;
+}
+
+
+/**
+ * Closes the given buffered file reader.
+ *
+ * @returns nothing.
+ * @param   pBufFile                The buffered file reader to close.
+ */
+static void lpcDecFileBufReaderClose(PLPCDECFILEBUFREAD pBufFile)
+{
+    if (pBufFile->fdInotify >= 0)
+        close(pBufFile->fdInotify);
+    if (pBufFile->pSockIn)
+        lpcDecSockInDestroy(pBufFile->pSockIn);
+    else
+        fclose(pBufFile->pFile);
+    free(pBufFile);
+}
+
+
+/**
+ * Returns whether the given buffered file reader has run into an error.
+ *
+ * @returns Flag whether the has run into an error.
+ * @param   pBufFile                The buffered file reader to check.
+ */
+static inline uint8_t lpcDecFileBufReaderHasError(PCLPCDECFILEBUFREAD pBufFile)
+{
+    return pBufFile->fError;
+}
+
+
+/**
+ * Returns whether the given buffered file reader has reached EOS.
+ *
+ * @returns Flag whether the has reached EOS.
+ * @param   pBufFile                The buffered file reader to check.
+ */
+static inline uint8_t lpcDecFileBufReaderHasEos(PCLPCDECFILEBUFREAD pBufFile)
+{
+    return pBufFile->fEos;
+}
+
+
+/**
+ * Ensures that there is enough data to read.
+ *
+ * @returns Status code.
+ * @param   pBufFile                The buffered file reader.
+ * @param   cbData                  Amount of bytes which should be available.
+ */
+static int lpcDecFileBufReaderEnsureData(PLPCDECFILEBUFREAD pBufFile, size_t cbData)
+{
+    if (pBufFile->offBuf + cbData <= pBufFile->cbData)
+        return 0;
+
+    /* Move all the remaining data to the front and fill up the free space. */
+    size_t cbRem = pBufFile->cbData - pBufFile->offBuf;
+    memmove(&pBufFile->abBuf[0], &pBufFile->abBuf[pBufFile->offBuf], cbRem);
+    pBufFile->cbData = cbRem;
+    pBufFile->offBuf = 0;
+
+    while (pBufFile->cbData < cbData)
+    {
+        size_t cbRead = 0;
+        int rc = pBufFile->pfnFill(pBufFile, &pBufFile->abBuf[pBufFile->cbData],
+                                   sizeof(pBufFile->abBuf) - pBufFile->cbData, &cbRead);
+        if (rc)
+        {
+            /* A truncated trailing record is treated as the end of the stream. */
+            if (rc != -1)
+                pBufFile->fError = 1;
+            pBufFile->fEos = 1;
+            return -1;
+        }
+
+        pBufFile->cbData += cbRead;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Writes out the buffered phase export data.
+ *
+ * @returns nothing, the export status is set on failure.
+ * @param   pVcd                    The phase export.
+ */
+static void lpcDecVcdFlush(PLPCDECVCD pVcd)
+{
+    if (   pVcd->cchBuf
+        && !pVcd->rc
+        && fwrite(&pVcd->achBuf[0], pVcd->cchBuf, 1, pVcd->pFile) != 1)
+        pVcd->rc = EIO;
+    pVcd->cchBuf = 0;
+}
+
+
+/**
+ * Appends a value change of the given variable to the phase export buffer.
+ *
+ * @returns nothing.
+ * @param   pVcd                    The phase export.
+ * @param   chId                    The identifier of the variable.
+ * @param   u32                     The new value.
+ * @param   cBits                   Width of the variable in bits.
+ */
+static void lpcDecVcdAppendValue(PLPCDECVCD pVcd, char chId, uint32_t u32, uint32_t cBits)
+{
+    char *pch = &pVcd->achBuf[pVcd->cchBuf];
+
+    if (cBits == 1)
+        *pch++ = u32 ? '1' : '0';
+    else
+    {
+        /* Vectors without leading zeros, b0 for zero. */
+        int iBit = 31;
+        while (iBit > 0 && !(u32 & (UINT32_C(1) << iBit)))
+            iBit--;
+        *pch++ = 'b';
+        for (; iBit >= 0; iBit--)
+            *pch++ = (u32 & (UINT32_C(1) << iBit)) ? '1' : '0';
+        *pch++ = ' ';
+    }
+    *pch++ = chId;
+    *pch++ = '\n';
+
+    pVcd->cchBuf = (size_t)(pch - &pVcd->achBuf[0]);
+}
+
+
+/**
+ * Records a phase transition of the decoder.
+ *
+ * The cycle type and direction are written when entering the address phase, the address and data when leaving
+ * their phases, so every variable changes at most once per cycle.
+ *
+ * @returns nothing.
+ * @param   pVcd                    The phase export.
+ * @param   pLpcDec                 The LPC decoder state.
+ * @param   enmStatePrev            The state left.
+ * @param   enmState                The state entered.
+ */
+static void lpcDecVcdPhase(PLPCDECVCD pVcd, PCLPCDEC pLpcDec, LPCDECSTATE enmStatePrev, LPCDECSTATE enmState)
+{
+    uint8_t fState = (uint8_t)enmState != pVcd->bState;
+    uint8_t fTyp   = enmState == LPCDECSTATE_ADDR && pLpcDec->bTyp != pVcd->bTyp;
+    uint8_t fDir   = enmState == LPCDECSTATE_ADDR && pLpcDec->fWrite != pVcd->fWrite;
+    uint8_t fAddr  = enmStatePrev == LPCDECSTATE_ADDR && pLpcDec->u32Addr != pVcd->u32Addr;
+    uint8_t fData  = enmStatePrev == LPCDECSTATE_DATA && pLpcDec->bData != pVcd->bData;
+    if (!(fState | fTyp | fDir | fAddr | fData))
+        return;
+
+    if (pVcd->cchBuf > sizeof(pVcd->achBuf) - LPC_DEC_VCD_CHANGE_MAX)
+        lpcDecVcdFlush(pVcd);
+
+    /* The export requires a sample rate so the times match the declared timescale. */
+    uint64_t uTime = lpcDecSeqNoToNs(pLpcDec->uSeqNoSample);
+    if (uTime != pVcd->uTimeLast)
+    {
+        char achTime[24];
+        char *pchTime = &achTime[sizeof(achTime)];
+        uint64_t u64 = uTime;
+        do
+        {
+            *--pchTime = (char)('0' + u64 % 10);
+            u64 /= 10;
+        } while (u64);
+
+        size_t cchTime = (size_t)(&achTime[sizeof(achTime)] - pchTime);
+        pVcd->achBuf[pVcd->cchBuf++] = '#';
+        memcpy(&pVcd->achBuf[pVcd->cchBuf], pchTime, cchTime);
+        pVcd->cchBuf += cchTime;
+        pVcd->achBuf[pVcd->cchBuf++] = '\n';
+        pVcd->uTimeLast = uTime;
+    }
+
+    if (fState)
+    {
+        pVcd->bState = (uint8_t)enmState;
+        lpcDecVcdAppendValue(pVcd, '!', pVcd->bState, 3);
+    }
+    if (fTyp)
+    {
+        pVcd->bTyp = pLpcDec->bTyp;
+        lpcDecVcdAppendValue(pVcd, '"', pVcd->bTyp, 2);
+    }
+    if (fDir)
+    {
+        pVcd->fWrite = pLpcDec->fWrite;
+        lpcDecVcdAppendValue(pVcd, '#', pVcd->fWrite, 1);
+    }
+    if (fAddr)
+    {
+        pVcd->u32Addr = pLpcDec->u32Addr;
+        lpcDecVcdAppendValue(pVcd, '$', pVcd->u32Addr, 32);
+    }
+    if (fData)
+    {
+        pVcd->bData = pLpcDec->bData;
+        lpcDecVcdAppendValue(pVcd, '%', pVcd->bData, 8);
+    }
+}
+
+
+/**
+ * Creates the phase export writing to the given file, the header is written right away.
+ *
+ * @returns Status code.
+ * @param   ppVcd                   Where to store the phase export on success.
+ * @param   pszFilename             The file to write.
+ */
+static int lpcDecVcdCreate(PLPCDECVCD *ppVcd, const char *pszFilename)
+{
+    PLPCDECVCD pVcd = (PLPCDECVCD)calloc(1, sizeof(*pVcd));
+    if (!pVcd)
+        return ENOMEM;
+
+    pVcd->pFile = fopen(pszFilename, "w");
+    if (!pVcd->pFile)
+    {
+        int rc = errno;
+        free(pVcd);
+        return rc;
+    }
+
+    pVcd->uTimeLast = UINT64_MAX;
+    pVcd->bState    = LPCDECSTATE_LFRAME_WAIT_ASSERTED;
+    int cch = snprintf(&pVcd->achBuf[0], sizeof(pVcd->achBuf),
+                       "$version lpc-dec $end\n"
+                       "$comment state: 1 idle, 2 START, 3 ADDR, 4 DATA, 5 TAR, 6 SYNC; "
+                       "type: 0 I/O, 1 Mem, 2 DMA; dir: 1 write $end\n"
+                       "$timescale 1 ns $end\n"
+                       "$scope module lpc $end\n"
+                       "$var wire 3 ! state $end\n"
+                       "$var wire 2 \" type $end\n"
+                       "$var wire 1 # dir $end\n"
+                       "$var wire 32 $ addr $end\n"
+                       "$var wire 8 %% data $end\n"
+                       "$upscope $end\n"
+                       "$enddefinitions $end\n"
+                       "$dumpvars\n"
+                       "b1 !\n"
+                       "b0 \"\n"
+                       "0#\n"
+                       "b0 $\n"
+                       "b0 %%\n"
+                       "$end\n");
+    pVcd->cchBuf = (size_t)cch;
+    *ppVcd = pVcd;
+    return 0;
+}
+
+
+/**
+ * Completes the phase export and frees it.
+ *
+ * @returns Status code.
+ * @param   pVcd                    The phase export.
+ */
+static int lpcDecVcdClose(PLPCDECVCD pVcd)
+{
+    lpcDecVcdFlush(pVcd);
+
+    int rc = pVcd->rc;
+    if (   fclose(pVcd->pFile)
+        && !rc)
+        rc = EIO;
+    free(pVcd);
+    return rc;
+}
+
+
+/**
+ * Resets the given LPC decoder state to the initial state waiting for LFRAME# to be asserted.
+ *
+ * @returns nothing.
+ * @param   pLpcDec                 The LPC decoder state.
+ */
+static void lpcDecStateReset(PLPCDEC pLpcDec)
+{
+    if (pLpcDec->pVcd)
+        lpcDecVcdPhase(pLpcDec->pVcd, pLpcDec, pLpcDec->aenmState[pLpcDec->idxState],
+                       LPCDECSTATE_LFRAME_WAIT_ASSERTED);
+
+    pLpcDec->idxState                     = 0;
+    pLpcDec->u32Addr                      = 0;
+    pLpcDec->bData                        = 0;
+    pLpcDec->iDataCycle                   = 0;
+    pLpcDec->cSyncWaits                   = 0;
+    pLpcDec->aenmState[pLpcDec->idxState] = LPCDECSTATE_LFRAME_WAIT_ASSERTED;
+    pLpcDec->u32States                    = LPC_DEC_STATES_AT(LPCDECSTATE_LFRAME_WAIT_ASSERTED, 0);
+}
+
+
+/**
+ * Initializes the given LPC state instance.
+ *
+ * @returns Status code.
+ * @param   pLpcDec                 The LPC decoder state to initialize.
+ * @param   u8BitClk                The bit number of the CLK signal in fed samples.
+ * @param   u8BitLFrame             The bit number of the LFRAME# signal in fed samples.
+ * @param   u8BitLad0               The bit number of the LAD[0] signal in fed samples.
+ * @param   u8BitLad1               The bit number of the LAD[1] signal in fed samples.
+ * @param   u8BitLad2               The bit number of the LAD[2] signal in fed samples.
+ * @param   u8BitLad3               The bit number of the LAD[3] signal in fed samples.
+ * @param   pfnCycle                The callback to call for every decoded cycle.
+ * @param   pvUser                  Opaque user data to pass to the callback.
+ */
+static int lpcDecStateInit(PLPCDEC pLpcDec, uint8_t u8BitClk, uint8_t u8BitLFrame,
+                           uint8_t u8BitLad0, uint8_t u8BitLad1, uint8_t u8BitLad2, uint8_t u8BitLad3,
+                           PFNLPCDECCYCLE pfnCycle, void *pvUser)
+{
+    pLpcDec->u8BitLClk    = u8BitClk;
+    pLpcDec->u8BitLFrame  = u8BitLFrame;
+    pLpcDec->u8BitLad0    = u8BitLad0;
+    pLpcDec->u8BitLad1    = u8BitLad1;
+    pLpcDec->u8BitLad2    = u8BitLad2;
+    pLpcDec->u8BitLad3    = u8BitLad3;
+    pLpcDec->fClkLast     = 0; /* We start with a low clock. */
+    pLpcDec->uSeqNoSample = 0;
+    pLpcDec->pVcd         = NULL;
+    pLpcDec->pfnCycle     = pfnCycle;
+    pLpcDec->pvUser       = pvUser;
+    pLpcDec->pOutMsg      = stderr;
+    lpcDecStateReset(pLpcDec);
+    return 0;
+}
+
+
+/**
+ * Extracts the LAD[3:0] from the given sample and returns them as a nibble in an 8bit unsigned integer.
+ */
+static inline uint8_t lpcDecStateLadExtractFromSample(PCLPCDEC pLpcDec, uint8_t bSample)
+{
+    return   ((bSample & (1 << pLpcDec->u8BitLad0)) >> pLpcDec->u8BitLad0)
+           | ((bSample & (1 << pLpcDec->u8BitLad1)) >> pLpcDec->u8BitLad1) << 1
+           | ((bSample & (1 << pLpcDec->u8BitLad2)) >> pLpcDec->u8BitLad2) << 2
+           | ((bSample & (1 << pLpcDec->u8BitLad3)) >> pLpcDec->u8BitLad3) << 3;
+}
+
+
+/**
+ * Renders the given packed state chain.
+ *
+ * @returns Pointer past the rendered chain.
+ * @param   pch                     Where to render the chain, must have room for LPC_DEC_STATES_STR_MAX characters.
+ * @param   u32States               The packed state chain (LPCDECCYCLE::u32States), must not be empty.
+ * @param   fJson                   Flag whether to render the chain as JSON array elements instead of text.
+ */
+static char *lpcDecStatesFmt(char *pch, uint32_t u32States, uint8_t fJson)
+{
+    size_t cchSep = fJson ? 1 : 4;
+
+    do
+    {
+        uint32_t idxState = u32States & LPC_DEC_STATES_MASK;
+        if (fJson)
+        {
+            memcpy(pch, g_aStateFrags[idxState].pszJson, g_aStateFrags[idxState].cchJson);
+            pch += g_aStateFrags[idxState].cchJson;
+        }
+        else
+        {
+            memcpy(pch, g_aStateFrags[idxState].pszText, g_aStateFrags[idxState].cchText);
+            pch += g_aStateFrags[idxState].cchText;
+        }
+        u32States >>= LPC_DEC_STATES_BITS;
+    } while (u32States);
+
+    /* Drop the separator following the last state. */
+    return pch - cchSep;
+}
+
+
+/**
+ * Hands the cycle currently decoded over to the consumer.
+ *
+ * @returns nothing.
+ * @param   pLpcDec                 The LPC decoder state.
+ * @param   fAbort                  Flag whether an abort was detected.
+ */
+static void lpcDecStateDump(PCLPCDEC pLpcDec, uint8_t fAbort)
+{
+    LPCDECCYCLE Cycle;
+
+    Cycle.uSeqNo    = pLpcDec->uSeqNoCycle;
+    Cycle.u32Addr   = pLpcDec->u32Addr;
+    Cycle.bTyp      = pLpcDec->bTyp;
+    Cycle.fWrite    = pLpcDec->fWrite;
+    Cycle.bData     = pLpcDec->bData;
+    Cycle.fAbort    = fAbort;
+    Cycle.u32States = pLpcDec->u32States;
+    pLpcDec->pfnCycle(pLpcDec, &Cycle, pLpcDec->pvUser);
+}
+
+
+/**
+ * Sets a new LPC deocder state.
+ *
+ * @returns nothing.
+ * @param   pLpcDec                 The LPC decoder state.
+ * @param   enmState                The new state to set.
+ */
+static void lpcDecStateSet(PLPCDEC pLpcDec, LPCDECSTATE enmState)
+{
+    if (pLpcDec->pVcd)
+        lpcDecVcdPhase(pLpcDec->pVcd, pLpcDec, pLpcDec->aenmState[pLpcDec->idxState], enmState);
+
+    pLpcDec->idxState++;
+    pLpcDec->aenmState[pLpcDec->idxState] = enmState;
+    pLpcDec->u32States |= LPC_DEC_STATES_AT(enmState, pLpcDec->idxState);
+}
+
+
+#ifdef LPC_DEC_STATE_THREADED
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wpedantic" /* Labels as values. */
+#endif
+/**
+ * Steps the state machine of the given decoder through the given ticks.
+ *
+ * This is the only implementation of the LPC protocol, every engine ends up here. The current state is kept in a
+ * local, the state chain in the decoder is only written for the output and the phase export.
+ *
+ * @returns nothing.
+ * @param   pLpcDec                 The LPC decoder state.
+ * @param   pauSeqNo                The sequence numbers of the ticks.
+ * @param   pbTicks                 The ticks (LAD[3:0] and LPC_DEC_TICK_LFRAME).
+ * @param   cTicks                  Number of ticks.
+ */
+static LPC_DEC_STATE_FN_ATTR void lpcDecStateTicksProcess(PLPCDEC pLpcDec, const uint64_t *pauSeqNo, const uint8_t *pbTicks,
+                                                           uint32_t cTicks)
+{
+#ifdef LPC_DEC_STATE_THREADED
+    static const void *s_apvStateHandlers[] =
+    {
+        &&LPCDECSTATE_INVALID_Handler,
+        &&LPCDECSTATE_LFRAME_WAIT_ASSERTED_Handler,
+        &&LPCDECSTATE_START_Handler,
+        &&LPCDECSTATE_ADDR_Handler,
+        &&LPCDECSTATE_DATA_Handler,
+        &&LPCDECSTATE_TAR_Handler,
+        &&LPCDECSTATE_SYNC_Handler
+    };
+#endif
+    LPCDECSTATE enmState = pLpcDec->aenmState[pLpcDec->idxState];
+    uint8_t     bTick;
+    uint8_t     bLad;
+
+    for (uint32_t idxTick = 0; idxTick < cTicks; idxTick++)
+    {
+        bTick = pbTicks[idxTick];
+        bLad  = bTick & LPC_DEC_TICK_LAD_MASK;
+        pLpcDec->uSeqNoSample = pauSeqNo[idxTick];
+
+        if (!(bTick & LPC_DEC_TICK_LFRAME))
+        {
+            LPC_DEC_STATE_LFRAME_ASSERTED()
+            if (   enmState != LPCDECSTATE_LFRAME_WAIT_ASSERTED
+                && enmState != LPCDECSTATE_START)
+                lpcDecStateDump(pLpcDec, 1 /*fAbort*/);
+            pLpcDec->bStartLast  = bLad;
+            pLpcDec->uSeqNoCycle = pauSeqNo[idxTick];
+            lpcDecStateReset(pLpcDec);
+            lpcDecStateSet(pLpcDec, LPCDECSTATE_START);
+            enmState = LPCDECSTATE_START;
+            LPC_DEC_STATE_NEXT();
+        }
+
+        LPC_DEC_STATE_DISPATCH(enmState);
+        LPC_DEC_STATE_CASE(LPCDECSTATE_LFRAME_WAIT_ASSERTED)
+            /* We are not in any target cycle currently so stop. */
+            LPC_DEC_STATE_NEXT();
+        LPC_DEC_STATE_CASE(LPCDECSTATE_START)
+            if (pLpcDec->bStartLast == LPC_DEC_START_TARGET_CYCLE)
+            {
+                /* New target cycle, LAD[3:0] contains type and direction. */
+                pLpcDec->bTyp    = LPC_DEC_CYC_TYPE_GET(bLad);
+                pLpcDec->fWrite  = !LPC_DEC_CYC_DIR_IS_READ(bLad);
+                pLpcDec->u32Addr = 0;
+                lpcDecStateSet(pLpcDec, LPCDECSTATE_ADDR);
+                enmState = LPCDECSTATE_ADDR;
+                if (pLpcDec->bTyp == LPC_DEC_CYC_TYPE_IO)
+                    pLpcDec->cAddrCycles = 4;
+                else if (pLpcDec->bTyp == LPC_DEC_CYC_TYPE_MEM)
+                    pLpcDec->cAddrCycles = 8;
+                else
+                {
+                    fprintf(pLpcDec->pOutMsg, "Encountered ILLEGAL/unsupported cycle type: %#x\n", pLpcDec->bTyp);
+                    lpcDecStateReset(pLpcDec);
+                    enmState = LPCDECSTATE_LFRAME_WAIT_ASSERTED;
+                }
+            }
+            else if (pLpcDec->bStartLast == LPC_DEC_START_ABORT)
+            {
+                lpcDecStateReset(pLpcDec);
+                enmState = LPCDECSTATE_LFRAME_WAIT_ASSERTED;
+            }
+            LPC_DEC_STATE_NEXT();
+        LPC_DEC_STATE_CASE(LPCDECSTATE_ADDR)
+            pLpcDec->cAddrCycles--;
+            pLpcDec->u32Addr |= bLad << (pLpcDec->cAddrCycles * 4);
+            if (pLpcDec->cAddrCycles)
+                LPC_DEC_STATE_NEXT();
+
+            if (pLpcDec->fWrite)
+            {
+                lpcDecStateSet(pLpcDec, LPCDECSTATE_DATA);
+                pLpcDec->cDataCycles = 2;
+                enmState = LPCDECSTATE_DATA;
+            }
+            else /* Reads have a turn around before. */
+            {
+                lpcDecStateSet(pLpcDec, LPCDECSTATE_TAR);
+                pLpcDec->cTarCycles = 2;
+                enmState = LPCDECSTATE_TAR;
+            }
+            LPC_DEC_STATE_NEXT();
+        LPC_DEC_STATE_CASE(LPCDECSTATE_DATA)
+            pLpcDec->bData |= bLad << (pLpcDec->iDataCycle * 4);
+            pLpcDec->iDataCycle++;
+            if (pLpcDec->iDataCycle == pLpcDec->cDataCycles)
+            {
+                lpcDecStateSet(pLpcDec, LPCDECSTATE_TAR);
+                pLpcDec->cTarCycles = 2;
+                enmState = LPCDECSTATE_TAR;
+            }
+            LPC_DEC_STATE_NEXT();
+        LPC_DEC_STATE_CASE(LPCDECSTATE_TAR)
+            pLpcDec->cTarCycles--;
+            if (pLpcDec->cTarCycles)
+                LPC_DEC_STATE_NEXT();
+
+            /* The first TAR follows the data for writes and the address for reads. */
+            if (pLpcDec->aenmState[pLpcDec->idxState - 1] == (pLpcDec->fWrite ? LPCDECSTATE_DATA : LPCDECSTATE_ADDR))
+            {
+                lpcDecStateSet(pLpcDec, LPCDECSTATE_SYNC);
+                enmState = LPCDECSTATE_SYNC;
+            }
+            else
+            {
+                lpcDecStateDump(pLpcDec, 0 /*fAbort*/);
+                lpcDecStateReset(pLpcDec); /* Second TAR phase in the cycle. */
+                enmState = LPCDECSTATE_LFRAME_WAIT_ASSERTED;
+            }
+            LPC_DEC_STATE_NEXT();
+        LPC_DEC_STATE_CASE(LPCDECSTATE_SYNC)
+            if (bLad)
+            {
+                if (pLpcDec->cSyncWaits < UINT8_MAX)
+                    pLpcDec->cSyncWaits++;
+            }
+            else if (pLpcDec->fWrite)
+            {
+                lpcDecStateSet(pLpcDec, LPCDECSTATE_TAR);
+                pLpcDec->cTarCycles = 2;
+                enmState = LPCDECSTATE_TAR;
+            }
+            else
+            {
+                lpcDecStateSet(pLpcDec, LPCDECSTATE_DATA);
+                pLpcDec->cDataCycles = 2;
+                enmState = LPCDECSTATE_DATA;
+            }
+            LPC_DEC_STATE_NEXT();
+        LPC_DEC_STATE_DEFAULT()
+            fprintf(pLpcDec->pOutMsg, "Unknown state %u\n", enmState);
+            LPC_DEC_STATE_NEXT();
+        LPC_DEC_STATE_DISPATCH_END()
+    }
+}
+#ifdef LPC_DEC_STATE_THREADED
+# pragma GCC diagnostic pop
+#endif
+
+
+/**
+ * Processes the given sample with the LPC decoder state given.
+ *
+ * @returns Status code.
+ * @param   pLpcDec                 The LPC decoder state.
+ * @param   uSeqNo                  Sequence number of the sample.
+ * @param   bSample                 The new sample to process.
+ */
+static int lpcDecStateSampleProcess(PLPCDEC pLpcDec, uint64_t uSeqNo, uint8_t bSample)
+{
+    /* Extract the clock and sample the other signals only on a falling edge. */
+    uint8_t fClk = !!(bSample & (1 << pLpcDec->u8BitLClk));
+    if (fClk == pLpcDec->fClkLast)
+        return 0;
+
+    if (   pLpcDec->fClkLast
+        && !fClk)
+    {
+        uint8_t bTick =   lpcDecStateLadExtractFromSample(pLpcDec, bSample)
+                        | (bSample & (1 << pLpcDec->u8BitLFrame) ? LPC_DEC_TICK_LFRAME : 0);
+        lpcDecStateTicksProcess(pLpcDec, &uSeqNo, &bTick, 1);
+    }
+
+    pLpcDec->fClkLast = fClk;
+    return 0;
+}
+
+
+/**
+ * Creates the clock tick decode engine for the signal layout of the given decoder.
+ *
+ * @returns Status code.
+ * @param   ppTicks                 Where to store the engine on success.
+ * @param   pLpcDec                 The initialized LPC decoder state the engine feeds.
+ * @param   fFastPath               Flag whether to decode target cycles straight from the ticks, if not every tick
+ *                                  steps the state machine.
+ */
+static int lpcDecTicksCreate(PLPCDECTICKS *ppTicks, PCLPCDEC pLpcDec, uint8_t fFastPath)
+{
+    PLPCDECTICKS pTicks = (PLPCDECTICKS)calloc(1, sizeof(*pTicks));
+    if (!pTicks)
+        return ENOMEM;
+
+    pTicks->fFastPath = fFastPath;
+#ifdef LPC_DEC_SEQ_CHECK_AVX2
+    pTicks->fSeqCheckAvx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+
+    for (uint32_t bSample = 0; bSample < 256; bSample++)
+        pTicks->abLut[bSample] = (uint8_t)(  lpcDecStateLadExtractFromSample(pLpcDec, (uint8_t)bSample)
+                                           | (bSample & (1 << pLpcDec->u8BitLFrame) ? LPC_DEC_TICK_LFRAME : 0)
+                                           | (bSample & (1 << pLpcDec->u8BitLClk) ? LPC_DEC_TICK_LUT_CLK : 0));
+
+    *ppTicks = pTicks;
+    return 0;
+}
+
+
+/**
+ * Returns the first tick at or after the given one with LFRAME# in the given state.
+ *
+ * @returns Tick index, cTicks if there is none.
+ * @param   pbTicks                 The ticks, padded by LPC_DEC_TICKS_PAD bytes.
+ * @param   idxTick                 The tick to start at.
+ * @param   cTicks                  Number of ticks.
+ * @param   fLFrame                 The LFRAME# state to look for, 0 for asserted, LPC_DEC_TICK_LFRAME for deasserted.
+ */
+static inline uint32_t lpcDecTicksScan(const uint8_t *pbTicks, uint32_t idxTick, uint32_t cTicks, uint8_t fLFrame)
+{
+    for (; idxTick < cTicks; idxTick += 16)
+    {
+#if defined(__SSE2__)
+        /* Move the LFRAME# bit up to the sign bit of every byte, the bits crossing over between bytes don't matter. */
+        __m128i Ticks = _mm_loadu_si128((const __m128i *)&pbTicks[idxTick]);
+        uint32_t fMask = (uint32_t)_mm_movemask_epi8(_mm_slli_epi16(Ticks, 3));
+        if (!fLFrame)
+            fMask = ~fMask & 0xffff;
+#else
+        uint64_t au64[2];
+        memcpy(&au64[0], &pbTicks[idxTick], sizeof(au64));
+        if (!fLFrame)
+        {
+            au64[0] = ~au64[0];
+            au64[1] = ~au64[1];
+        }
+        au64[0] &= UINT64_C(0x1010101010101010);
+        au64[1] &= UINT64_C(0x1010101010101010);
+        uint32_t fMask = 0;
+        for (uint32_t i = 0; i < 8; i++)
+            fMask |=   (uint32_t)((au64[0] >> (i * 8 + 4)) & 1) << i
+                     | (uint32_t)((au64[1] >> (i * 8 + 4)) & 1) << (i + 8);
+#endif
+        if (fMask)
+        {
+            idxTick += (uint32_t)__builtin_ctz(fMask);
+            return idxTick < cTicks ? idxTick : cTicks;
+        }
+    }
+
+    return cTicks;
+}
+
+
+/**
+ * Gathers the address nibbles of a cycle, most significant first, into the address.
+ *
+ * @returns The address.
+ * @param   pbTicks                 The address ticks, 8 ticks are read even for I/O cycles.
+ * @param   cNibbles                Number of address nibbles, 4 or 8.
+ */
+static inline uint32_t lpcDecTicksAddrGather(const uint8_t *pbTicks, uint32_t cNibbles)
+{
+    uint64_t u64;
+    memcpy(&u64, pbTicks, sizeof(u64));
+
+    /* Merge neighbouring nibbles into bytes, pack the bytes and swap them to have the first nibble on top. */
+    u64 &= UINT64_C(0x0f0f0f0f0f0f0f0f);
+    u64  = ((u64 << 4) | (u64 >> 8)) & UINT64_C(0x00ff00ff00ff00ff);
+    u64  = (u64 | (u64 >> 8)) & UINT64_C(0x0000ffff0000ffff);
+    uint32_t u32Addr = __builtin_bswap32((uint32_t)(u64 | (u64 >> 16)));
+    return cNibbles == 8 ? u32Addr : u32Addr >> 16;
+}
+
+
+/**
+ * Returns whether the state machine of the given decoder ignores all ticks until LFRAME# gets asserted again.
+ *
+ * @returns Flag whether the decoder is idle.
+ * @param   pLpcDec                 The LPC decoder state.
+ */
+static inline uint8_t lpcDecTicksDecIsIdle(PCLPCDEC pLpcDec)
+{
+    LPCDECSTATE enmState = pLpcDec->aenmState[pLpcDec->idxState];
+    return    enmState == LPCDECSTATE_LFRAME_WAIT_ASSERTED
+           || (   enmState == LPCDECSTATE_START
+               && pLpcDec->bStartLast != LPC_DEC_START_TARGET_CYCLE);
+}
+
+
+/**
+ * Decodes the target cycle starting at the given tick straight from the tick array.
+ *
+ * @returns Flag whether the cycle was decoded, if not it has to go through the state machine.
+ * @param   pTicks                  The clock tick decode engine.
+ * @param   pLpcDec                 The LPC decoder state, waiting for or in a START phase, left waiting.
+ * @param   idxStart                The START tick, the last one with LFRAME# asserted.
+ * @param   idxNext                 The next tick with LFRAME# asserted or the number of ticks.
+ * @param   pidxEnd                 Where to store the last tick of the cycle on success.
+ */
+static uint8_t lpcDecTicksCycleDecode(PLPCDECTICKS pTicks, PLPCDEC pLpcDec, uint32_t idxStart, uint32_t idxNext,
+                                      uint32_t *pidxEnd)
+{
+    static const uint32_t s_u32StatesRead =   LPC_DEC_STATES_AT(LPCDECSTATE_LFRAME_WAIT_ASSERTED, 0)
+                                            | LPC_DEC_STATES_AT(LPCDECSTATE_START, 1)
+                                            | LPC_DEC_STATES_AT(LPCDECSTATE_ADDR,  2)
+                                            | LPC_DEC_STATES_AT(LPCDECSTATE_TAR,   3)
+                                            | LPC_DEC_STATES_AT(LPCDECSTATE_SYNC,  4)
+                                            | LPC_DEC_STATES_AT(LPCDECSTATE_DATA,  5)
+                                            | LPC_DEC_STATES_AT(LPCDECSTATE_TAR,   6);
+    static const uint32_t s_u32StatesWrite =   LPC_DEC_STATES_AT(LPCDECSTATE_LFRAME_WAIT_ASSERTED, 0)
+                                             | LPC_DEC_STATES_AT(LPCDECSTATE_START, 1)
+                                             | LPC_DEC_STATES_AT(LPCDECSTATE_ADDR,  2)
+                                             | LPC_DEC_STATES_AT(LPCDECSTATE_DATA,  3)
+                                             | LPC_DEC_STATES_AT(LPCDECSTATE_TAR,   4)
+                                             | LPC_DEC_STATES_AT(LPCDECSTATE_SYNC,  5)
+                                             | LPC_DEC_STATES_AT(LPCDECSTATE_TAR,   6);
+    const uint8_t *pbTicks = &pTicks->abTicks[0];
+    uint32_t idxTick = idxStart + 1;
+
+    /* Anything but a complete I/O or memory target cycle is left to the state machine. */
+    if (   (pbTicks[idxStart] & LPC_DEC_TICK_LAD_MASK) != LPC_DEC_START_TARGET_CYCLE
+        || idxTick >= idxNext)
+        return 0;
+
+    uint8_t bTyp = LPC_DEC_CYC_TYPE_GET(pbTicks[idxTick]);
+    uint8_t fWrite = !LPC_DEC_CYC_DIR_IS_READ(pbTicks[idxTick]);
+    if (   bTyp != LPC_DEC_CYC_TYPE_IO
+        && bTyp != LPC_DEC_CYC_TYPE_MEM)
+        return 0;
+
+    uint32_t cAddrNibbles = bTyp == LPC_DEC_CYC_TYPE_IO ? 4 : 8;
+    uint32_t idxAddr = idxTick + 1;
+    uint32_t idxData = idxAddr + cAddrNibbles;
+    uint32_t idxSync = idxData + (fWrite ? 4 : 2); /* Writes have the data and TAR, reads only TAR before SYNC. */
+
+    /* Only the SYNC phase has a variable length. */
+    uint32_t idxSyncEnd = idxSync;
+    while (   idxSyncEnd < idxNext
+           && (pbTicks[idxSyncEnd] & LPC_DEC_TICK_LAD_MASK))
+        idxSyncEnd++;
+    if (!fWrite)
+        idxData = idxSyncEnd + 1;
+    uint32_t idxEnd = idxSyncEnd + (fWrite ? 2 : 4);
+    if (idxEnd >= idxNext)
+        return 0;
+
+    pLpcDec->bStartLast   = LPC_DEC_START_TARGET_CYCLE;
+    pLpcDec->uSeqNoCycle  = pTicks->auSeqNo[idxStart];
+    pLpcDec->uSeqNoSample = pTicks->auSeqNo[idxEnd];
+    pLpcDec->bTyp         = bTyp;
+    pLpcDec->fWrite       = fWrite;
+    pLpcDec->u32Addr      = lpcDecTicksAddrGather(&pbTicks[idxAddr], cAddrNibbles);
+    pLpcDec->bData        = (uint8_t)(  (pbTicks[idxData] & LPC_DEC_TICK_LAD_MASK)
+                                      | (pbTicks[idxData + 1] & LPC_DEC_TICK_LAD_MASK) << 4);
+    pLpcDec->cSyncWaits   = idxSyncEnd - idxSync < UINT8_MAX ? (uint8_t)(idxSyncEnd - idxSync) : UINT8_MAX;
+    pLpcDec->u32States    = fWrite ? s_u32StatesWrite : s_u32StatesRead;
+    lpcDecStateDump(pLpcDec, 0 /*fAbort*/);
+    lpcDecStateReset(pLpcDec);
+
+    *pidxEnd = idxEnd;
+    return 1;
+}
+
+
+/**
+ * Decodes the extracted ticks.
+ *
+ * @returns nothing.
+ * @param   pTicks                  The clock tick decode engine.
+ * @param   pLpcDec                 The LPC decoder state.
+ */
+static void lpcDecTicksDecode(PLPCDECTICKS pTicks, PLPCDEC pLpcDec)
+{
+    const uint8_t *pbTicks = &pTicks->abTicks[0];
+    uint32_t cTicks = pTicks->cTicks;
+    uint32_t idxTick = 0;
+
+    if (!pTicks->fFastPath)
+    {
+        lpcDecStateTicksProcess(pLpcDec, &pTicks->auSeqNo[0], pbTicks, cTicks);
+        idxTick = cTicks;
+    }
+
+    while (idxTick < cTicks)
+    {
+        uint32_t idxFrame = lpcDecTicksScan(pbTicks, idxTick, cTicks, 0 /*fLFrame*/);
+
+        /*
+         * A cycle the fast path couldn't decode runs through the state machine, it is done or gets aborted by the
+         * next LFRAME# assertion at the latest. The state machine also takes the assertion of an aborted cycle.
+         */
+        if (!lpcDecTicksDecIsIdle(pLpcDec))
+        {
+            lpcDecStateTicksProcess(pLpcDec, &pTicks->auSeqNo[idxTick], &pbTicks[idxTick], idxFrame - idxTick);
+            if (   idxFrame < cTicks
+                && pLpcDec->aenmState[pLpcDec->idxState] != LPCDECSTATE_LFRAME_WAIT_ASSERTED
+                && pLpcDec->aenmState[pLpcDec->idxState] != LPCDECSTATE_START)
+            {
+                lpcDecStateTicksProcess(pLpcDec, &pTicks->auSeqNo[idxFrame], &pbTicks[idxFrame], 1);
+                idxFrame++;
+            }
+        }
+        if (idxFrame >= cTicks)
+            break;
+
+        /* LFRAME# may be asserted for several clocks, the START value is the one of the last. */
+        uint32_t idxStart = lpcDecTicksScan(pbTicks, idxFrame, cTicks, LPC_DEC_TICK_LFRAME) - 1;
+        uint32_t idxNext = lpcDecTicksScan(pbTicks, idxStart + 1, cTicks, 0 /*fLFrame*/);
+        uint32_t idxEnd = 0;
+        if (lpcDecTicksCycleDecode(pTicks, pLpcDec, idxStart, idxNext, &idxEnd))
+            idxTick = idxEnd + 1;
+        else
+        {
+            lpcDecStateTicksProcess(pLpcDec, &pTicks->auSeqNo[idxFrame], &pbTicks[idxFrame], idxNext - idxFrame);
+            idxTick = idxNext;
+        }
+    }
+
+    pTicks->cTicks = 0;
+}
+
+
+/**
+ * Extracts the ticks of the given capture records, decoding them only whenever the tick array is full.
+ *
+ * @returns nothing.
+ * @param   pTicks                  The clock tick decode engine.
+ * @param   pLpcDec                 The LPC decoder state.
+ * @param   pbRecs                  The records.
+ * @param   cRecs                   Number of records.
+ */
+static void lpcDecTicksRecsExtract(PLPCDECTICKS pTicks, PLPCDEC pLpcDec, const uint8_t *pbRecs, size_t cRecs)
+{
+    uint8_t fClkLast = pLpcDec->fClkLast ? LPC_DEC_TICK_LUT_CLK : 0;
+
+    while (cRecs)
+    {
+        /* Every record is written as a tick, only falling edges advance. */
+        uint32_t cTicks = pTicks->cTicks;
+        while (   cRecs
+               && cTicks < LPC_DEC_TICKS_MAX)
+        {
+            uint8_t bTick = pTicks->abLut[pbRecs[sizeof(uint64_t)]];
+            memcpy(&pTicks->auSeqNo[cTicks], pbRecs, sizeof(uint64_t));
+            pTicks->abTicks[cTicks] = bTick & (LPC_DEC_TICK_LAD_MASK | LPC_DEC_TICK_LFRAME);
+            cTicks += fClkLast & ~bTick & LPC_DEC_TICK_LUT_CLK ? 1 : 0;
+            fClkLast = bTick & LPC_DEC_TICK_LUT_CLK;
+            pbRecs += LPC_DEC_RECORD_SIZE;
+            cRecs--;
+        }
+
+        pTicks->cTicks = cTicks;
+        if (cTicks == LPC_DEC_TICKS_MAX)
+            lpcDecTicksDecode(pTicks, pLpcDec);
+    }
+
+    pLpcDec->fClkLast = fClkLast ? 1 : 0;
+}
+
+
+/**
+ * Extracts the ticks of the given capture records and decodes them.
+ *
+ * @returns nothing.
+ * @param   pTicks                  The clock tick decode engine.
+ * @param   pLpcDec                 The LPC decoder state.
+ * @param   pbRecs                  The records.
+ * @param   cRecs                   Number of records.
+ */
+static void lpcDecTicksRecsDecode(PLPCDECTICKS pTicks, PLPCDEC pLpcDec, const uint8_t *pbRecs, size_t cRecs)
+{
+    lpcDecTicksRecsExtract(pTicks, pLpcDec, pbRecs, cRecs);
+    if (pTicks->cTicks)
+        lpcDecTicksDecode(pTicks, pLpcDec);
+}
+
+
+/**
+ * Returns the first of the given sequence numbers not following the one before it by 1 to the given maximum increment.
+ *
+ * @returns Index of the sequence number, cSeqNos if all are fine.
+ * @param   pau64SeqNo              The sequence numbers, preceded by the one of the record before the first.
+ * @param   cSeqNos                 Number of sequence numbers, not counting the preceding one.
+ * @param   uGapMax                 Largest increment accepted, at least 1.
+ */
+static size_t lpcDecSeqCheckScan(const uint64_t *pau64SeqNo, size_t cSeqNos, uint32_t uGapMax)
+{
+    for (size_t idxSeqNo = 0; idxSeqNo < cSeqNos; idxSeqNo++)
+    {
+        if (pau64SeqNo[idxSeqNo + 1] - pau64SeqNo[idxSeqNo] - 1 >= uGapMax)
+            return idxSeqNo;
+    }
+
+    return cSeqNos;
+}
+
+
+/*
+ * The vector variants below load the sequence numbers and the ones before them from the same array one element
+ * apart and check the increments as unsigned 64-bit values, which is exact for any maximum and catches sequence
+ * numbers going backwards as huge increments. The results are collected with movemask and only the last step with
+ * a bad increment is scanned one by one to locate it.
+ */
+#if defined(__SSE2__)
+/**
+ * Returns which of the given sequence numbers follow the previous ones by 1 to the maximum increment.
+ *
+ * The increment minus one less the maximum is negative exactly for the fine ones, unless the increment minus one
+ * is negative itself because the sequence number didn't increase.
+ *
+ * @returns Vector with the sign bits set for the fine elements.
+ * @param   pau64SeqNo              The sequence numbers, preceded by the ones of the records before.
+ * @param   GapMax                  The largest increment accepted in every element.
+ */
+static inline __m128i lpcDecSeqCheckOk2(const uint64_t *pau64SeqNo, __m128i GapMax)
+{
+    __m128i SeqNo     = _mm_loadu_si128((const __m128i *)&pau64SeqNo[1]);
+    __m128i SeqNoPrev = _mm_loadu_si128((const __m128i *)&pau64SeqNo[0]);
+    __m128i IncM1     = _mm_sub_epi64(_mm_sub_epi64(SeqNo, SeqNoPrev), _mm_set1_epi64x(1));
+    return _mm_andnot_si128(IncM1, _mm_sub_epi64(IncM1, GapMax));
+}
+
+
+/**
+ * Returns the first of the given sequence numbers not following the one before it by 1 to the given maximum
+ * increment, checking four per step with SSE2.
+ *
+ * @returns Index of the sequence number, cSeqNos if all are fine.
+ * @param   pau64SeqNo              The sequence numbers, preceded by the one of the record before the first.
+ * @param   cSeqNos                 Number of sequence numbers, not counting the preceding one.
+ * @param   uGapMax                 Largest increment accepted, at least 1.
+ */
+static size_t lpcDecSeqCheckFindSse2(const uint64_t *pau64SeqNo, size_t cSeqNos, uint32_t uGapMax)
+{
+    const __m128i GapMax = _mm_set1_epi64x(uGapMax);
+    size_t idxSeqNo = 0;
+
+    for (; idxSeqNo + 4 <= cSeqNos; idxSeqNo += 4)
+    {
+        __m128i Ok = _mm_and_si128(lpcDecSeqCheckOk2(&pau64SeqNo[idxSeqNo], GapMax),
+                                   lpcDecSeqCheckOk2(&pau64SeqNo[idxSeqNo + 2], GapMax));
+        if (_mm_movemask_pd(_mm_castsi128_pd(Ok)) != 0x3)
+            break;
+    }
+
+    return idxSeqNo + lpcDecSeqCheckScan(&pau64SeqNo[idxSeqNo], cSeqNos - idxSeqNo, uGapMax);
+}
+#endif
+
+
+#ifdef LPC_DEC_SEQ_CHECK_AVX2
+/**
+ * Returns which of the given sequence numbers follow the previous ones by 1 to the maximum increment.
+ *
+ * The increment minus one with its sign bit flipped is the increment plus INT64_MAX, comparing that as signed against
+ * the flipped maximum compares the increment minus one as unsigned.
+ *
+ * @returns Vector with all bits set for the fine elements.
+ * @param   pau64SeqNo              The sequence numbers, preceded by the ones of the records before.
+ * @param   GapMaxFlipped           The largest increment accepted with the sign bit flipped in every element.
+ */
+__attribute__((target("avx2")))
+static inline __m256i lpcDecSeqCheckOk4(const uint64_t *pau64SeqNo, __m256i GapMaxFlipped)
+{
+    __m256i SeqNo        = _mm256_loadu_si256((const __m256i *)&pau64SeqNo[1]);
+    __m256i SeqNoPrev    = _mm256_loadu_si256((const __m256i *)&pau64SeqNo[0]);
+    __m256i IncM1Flipped = _mm256_add_epi64(_mm256_sub_epi64(SeqNo, SeqNoPrev), _mm256_set1_epi64x(INT64_MAX));
+    return _mm256_cmpgt_epi64(GapMaxFlipped, IncM1Flipped);
+}
+
+
+/**
+ * Returns the first of the given sequence numbers not following the one before it by 1 to the given maximum
+ * increment, checking sixteen per step with AVX2.
+ *
+ * @returns Index of the sequence number, cSeqNos if all are fine.
+ * @param   pau64SeqNo              The sequence numbers, preceded by the one of the record before the first.
+ * @param   cSeqNos                 Number of sequence numbers, not counting the preceding one.
+ * @param   uGapMax                 Largest increment accepted, at least 1.
+ */
+__attribute__((target("avx2")))
+static size_t lpcDecSeqCheckFindAvx2(const uint64_t *pau64SeqNo, size_t cSeqNos, uint32_t uGapMax)
+{
+    const __m256i GapMaxFlipped = _mm256_set1_epi64x(INT64_MIN + (int64_t)uGapMax);
+    size_t idxSeqNo = 0;
+
+    for (; idxSeqNo + 16 <= cSeqNos; idxSeqNo += 16)
+    {
+        __m256i Ok01 = _mm256_and_si256(lpcDecSeqCheckOk4(&pau64SeqNo[idxSeqNo], GapMaxFlipped),
+                                        lpcDecSeqCheckOk4(&pau64SeqNo[idxSeqNo + 4], GapMaxFlipped));
+        __m256i Ok23 = _mm256_and_si256(lpcDecSeqCheckOk4(&pau64SeqNo[idxSeqNo + 8], GapMaxFlipped),
+                                        lpcDecSeqCheckOk4(&pau64SeqNo[idxSeqNo + 12], GapMaxFlipped));
+        if (_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_and_si256(Ok01, Ok23))) != 0xf)
+            break;
+    }
+
+    return idxSeqNo + lpcDecSeqCheckScan(&pau64SeqNo[idxSeqNo], cSeqNos - idxSeqNo, uGapMax);
+}
+#endif
+
+
+/**
+ * Returns the first record extracted last with a sequence number not following the one before it by 1 to the
+ * maximum increment, using the widest vector variant the CPU supports.
+ *
+ * @returns Record index, cRecs if all sequence numbers are fine.
+ * @param   pTicks                  The clock tick decode engine.
+ * @param   cRecs                   Number of records extracted.
+ */
+static size_t lpcDecSeqCheckFind(PCLPCDECTICKS pTicks, size_t cRecs)
+{
+#ifdef LPC_DEC_SEQ_CHECK_AVX2
+    if (pTicks->fSeqCheckAvx2)
+        return lpcDecSeqCheckFindAvx2(&pTicks->au64SeqNoChk[0], cRecs, pTicks->uSeqGapMax);
+#endif
+#if defined(__SSE2__)
+    return lpcDecSeqCheckFindSse2(&pTicks->au64SeqNoChk[0], cRecs, pTicks->uSeqGapMax);
+#else
+    return lpcDecSeqCheckScan(&pTicks->au64SeqNoChk[0], cRecs, pTicks->uSeqGapMax);
+#endif
+}
+
+
+/**
+ * Extracts the ticks of the given capture records up to the first sequence number anomaly.
+ *
+ * The sequence numbers of all records are stored in a row while extracting for the vector check. If it finds an
+ * anomaly the ticks are extracted again up to it, the tick array isn't committed before.
+ *
+ * @returns Number of records extracted, cRecs if all sequence numbers are fine.
+ * @param   pTicks                  The clock tick decode engine.
+ * @param   pLpcDec                 The LPC decoder state.
+ * @param   pbRecs                  The records.
+ * @param   cRecs                   Number of records, at most LPC_DEC_SEQ_CHECK_RECS and the room in the tick array.
+ */
+static size_t lpcDecTicksRecsExtractChecked(PLPCDECTICKS pTicks, PLPCDEC pLpcDec, const uint8_t *pbRecs, size_t cRecs)
+{
+    uint8_t fClkLast = pLpcDec->fClkLast ? LPC_DEC_TICK_LUT_CLK : 0;
+    uint32_t cTicks = pTicks->cTicks;
+
+    pTicks->au64SeqNoChk[0] = pTicks->uSeqNoLast;
+    for (size_t idxRec = 0; idxRec < cRecs; idxRec++)
+    {
+        const uint8_t *pbRec = &pbRecs[idxRec * LPC_DEC_RECORD_SIZE];
+        uint64_t uSeqNo;
+        memcpy(&uSeqNo, pbRec, sizeof(uSeqNo));
+        uint8_t bTick = pTicks->abLut[pbRec[sizeof(uint64_t)]];
+        pTicks->au64SeqNoChk[idxRec + 1] = uSeqNo;
+        pTicks->auSeqNo[cTicks] = uSeqNo;
+        pTicks->abTicks[cTicks] = bTick & (LPC_DEC_TICK_LAD_MASK | LPC_DEC_TICK_LFRAME);
+        cTicks += fClkLast & ~bTick & LPC_DEC_TICK_LUT_CLK ? 1 : 0;
+        fClkLast = bTick & LPC_DEC_TICK_LUT_CLK;
+    }
+
+    size_t cRecsOk = lpcDecSeqCheckFind(pTicks, cRecs);
+    if (cRecsOk == cRecs)
+    {
+        pTicks->cTicks    = cTicks;
+        pLpcDec->fClkLast = fClkLast ? 1 : 0;
+    }
+    else
+        lpcDecTicksRecsExtract(pTicks, pLpcDec, pbRecs, cRecsOk);
+
+    pTicks->uSeqNoLast = pTicks->au64SeqNoChk[cRecsOk];
+    return cRecsOk;
+}
+
+
+/**
+ * Creates the LCLK statistics.
+ *
+ * @returns Status code.
+ * @param   ppClkStats              Where to store the statistics on success.
+ * @param   cWindowSamples          Window length in samples for the per-window statistics, 0 for only the summary.
+ * @param   pOut                    The stream to write the per-window statistics to.
+ */
+static int lpcDecClkStatsCreate(PLPCDECCLKSTATS *ppClkStats, uint64_t cWindowSamples, FILE *pOut)
+{
+    PLPCDECCLKSTATS pClkStats = (PLPCDECCLKSTATS)calloc(1, sizeof(*pClkStats));
+    if (!pClkStats)
+        return ENOMEM;
+
+    pClkStats->pOut           = pOut;
+    pClkStats->cWindowSamples = cWindowSamples;
+    *ppClkStats = pClkStats;
+    return 0;
+}
+
+
+/**
+ * Destroys the given LCLK statistics.
+ *
+ * @returns nothing.
+ * @param   pClkStats               The statistics to destroy.
+ */
+static void lpcDecClkStatsDestroy(PLPCDECCLKSTATS pClkStats)
+{
+    free(pClkStats);
+}
+
+
+/**
+ * Adds the given value to the given accumulator.
+ *
+ * @returns nothing.
+ * @param   pAcc                    The accumulator.
+ * @param   dVal                    The value to add.
+ */
+static inline void lpcDecClkAccAdd(PLPCDECCLKACC pAcc, double dVal)
+{
+    if (!pAcc->cValues || dVal < pAcc->dMin)
+        pAcc->dMin = dVal;
+    if (!pAcc->cValues || dVal > pAcc->dMax)
+        pAcc->dMax = dVal;
+
+    /* Welford's online algorithm, stays accurate over long captures unlike summing up the squares. */
+    pAcc->cValues++;
+    double dDelta = dVal - pAcc->dMean;
+    pAcc->dMean += dDelta / (double)pAcc->cValues;
+    pAcc->dM2   += dDelta * (dVal - pAcc->dMean);
+}
+
+
+/**
+ * Writes the given accumulator as min/mean/max/stddev.
+ *
+ * @returns nothing.
+ * @param   pOut                    The stream to write to.
+ * @param   pszName                 Name of the measurement.
+ * @param   pAcc                    The accumulator.
+ * @param   dScale                  Factor to convert the values to the given unit.
+ * @param   pszUnit                 The unit.
+ */
+static void lpcDecClkAccDump(FILE *pOut, const char *pszName, PCLPCDECCLKACC pAcc, double dScale, const char *pszUnit)
+{
+    if (!pAcc->cValues)
+    {
+        fprintf(pOut, "%s -", pszName);
+        return;
+    }
+
+    fprintf(pOut, "%s min/mean/max/stddev %.3f/%.3f/%.3f/%.3f%s", pszName, pAcc->dMin * dScale, pAcc->dMean * dScale,
+            pAcc->dMax * dScale, sqrt(pAcc->dM2 / (double)pAcc->cValues) * dScale, pszUnit);
+}
+
+
+/**
+ * Writes the given LCLK measurements on a single line.
+ *
+ * @returns nothing.
+ * @param   pOut                    The stream to write to.
+ * @param   pMeas                   The measurements.
+ */
+static void lpcDecClkMeasDump(FILE *pOut, PCLPCDECCLKMEAS pMeas)
+{
+    /* Sample units are converted to nanoseconds when the sample rate is known. */
+    double dScale = g_uSampleRate ? 1000000000.0 / (double)g_uSampleRate : 1.0;
+    const char *pszUnit = g_uSampleRate ? "ns" : " samples";
+
+    fprintf(pOut, "%" PRIu64 " periods, ", pMeas->Period.cValues);
+    lpcDecClkAccDump(pOut, "period", &pMeas->Period, dScale, pszUnit);
+    fprintf(pOut, ", ");
+    lpcDecClkAccDump(pOut, "duty", &pMeas->Duty, 100.0, "%");
+    fprintf(pOut, ", ");
+    lpcDecClkAccDump(pOut, "jitter", &pMeas->Jitter, dScale, pszUnit);
+    fprintf(pOut, "\n");
+}
+
+
+/**
+ * Writes the statistics of the current window and starts a new one.
+ *
+ * @returns nothing.
+ * @param   pClkStats               The LCLK statistics.
+ * @param   uSeqNoWindow            Sequence number the new window starts at.
+ */
+static void lpcDecClkStatsWindowNext(PLPCDECCLKSTATS pClkStats, uint64_t uSeqNoWindow)
+{
+    if (g_uSampleRate)
+    {
+        uint64_t uNs = lpcDecSeqNoToNs(pClkStats->uSeqNoWindow);
+        fprintf(pClkStats->pOut, "LCLK %" PRIu64 ".%09" PRIu64 "s: ", uNs / UINT64_C(1000000000),
+                uNs % UINT64_C(1000000000));
+    }
+    else
+        fprintf(pClkStats->pOut, "LCLK %" PRIu64 ": ", pClkStats->uSeqNoWindow);
+    lpcDecClkMeasDump(pClkStats->pOut, &pClkStats->Window);
+
+    memset(&pClkStats->Window, 0, sizeof(pClkStats->Window));
+    pClkStats->uSeqNoWindow = uSeqNoWindow;
+}
+
+
+/**
+ * Processes a falling LCLK edge, completing a period.
+ *
+ * @returns nothing.
+ * @param   pClkStats               The LCLK statistics.
+ * @param   uSeqNo                  Sequence number of the edge.
+ */
+static void lpcDecClkStatsFall(PLPCDECCLKSTATS pClkStats, uint64_t uSeqNo)
+{
+    /* Sequence numbers going backwards start the measurement over. */
+    if (   !pClkStats->fFall
+        || !pClkStats->fRise
+        || pClkStats->uSeqNoRise <= pClkStats->uSeqNoFall
+        || uSeqNo <= pClkStats->uSeqNoRise)
+    {
+        pClkStats->uSeqNoFall  = uSeqNo;
+        pClkStats->fFall       = 1;
+        pClkStats->cPeriodLast = 0;
+        return;
+    }
+
+    if (pClkStats->cWindowSamples)
+    {
+        if (!pClkStats->fWindow)
+        {
+            pClkStats->uSeqNoWindow = uSeqNo;
+            pClkStats->fWindow      = 1;
+        }
+        else if (uSeqNo < pClkStats->uSeqNoWindow)
+            lpcDecClkStatsWindowNext(pClkStats, uSeqNo);
+        else if (uSeqNo - pClkStats->uSeqNoWindow >= pClkStats->cWindowSamples)
+            lpcDecClkStatsWindowNext(pClkStats,   pClkStats->uSeqNoWindow
+                                                + (uSeqNo - pClkStats->uSeqNoWindow) / pClkStats->cWindowSamples
+                                                * pClkStats->cWindowSamples);
+    }
+
+    uint64_t cPeriod = uSeqNo - pClkStats->uSeqNoFall;
+    double dDuty = (double)(uSeqNo - pClkStats->uSeqNoRise) / (double)cPeriod;
+    lpcDecClkAccAdd(&pClkStats->Total.Period, (double)cPeriod);
+    lpcDecClkAccAdd(&pClkStats->Total.Duty, dDuty);
+    if (pClkStats->cWindowSamples)
+    {
+        lpcDecClkAccAdd(&pClkStats->Window.Period, (double)cPeriod);
+        lpcDecClkAccAdd(&pClkStats->Window.Duty, dDuty);
+    }
+    if (pClkStats->cPeriodLast)
+    {
+        double dJitter = (double)cPeriod - (double)pClkStats->cPeriodLast;
+        lpcDecClkAccAdd(&pClkStats->Total.Jitter, dJitter);
+        if (pClkStats->cWindowSamples)
+            lpcDecClkAccAdd(&pClkStats->Window.Jitter, dJitter);
+    }
+    pClkStats->acPeriods[cPeriod < LPC_DEC_CLK_HIST_BINS ? cPeriod : LPC_DEC_CLK_HIST_BINS - 1]++;
+
+    pClkStats->cPeriodLast = cPeriod;
+    pClkStats->uSeqNoFall  = uSeqNo;
+}
+
+
+/**
+ * Feeds the LCLK edges of the given capture records to the statistics.
+ *
+ * @returns nothing.
+ * @param   pClkStats               The LCLK statistics.
+ * @param   pabLut                  The sample to tick lookup table of the decode engine.
+ * @param   pbRecs                  The records.
+ * @param   cRecs                   Number of records.
+ */
+static void lpcDecClkStatsRecs(PLPCDECCLKSTATS pClkStats, const uint8_t *pabLut, const uint8_t *pbRecs, size_t cRecs)
+{
+    uint8_t fClkLast = pClkStats->fClkLast;
+
+    if (!pClkStats->fClkValid && cRecs)
+    {
+        /* The first record only gives the level, it is no edge. */
+        fClkLast = pabLut[pbRecs[sizeof(uint64_t)]] & LPC_DEC_TICK_LUT_CLK;
+        pClkStats->fClkValid = 1;
+    }
+
+    for (size_t idxRec = 0; idxRec < cRecs; idxRec++, pbRecs += LPC_DEC_RECORD_SIZE)
+    {
+        uint8_t fClk = pabLut[pbRecs[sizeof(uint64_t)]] & LPC_DEC_TICK_LUT_CLK;
+        if (fClk == fClkLast)
+            continue;
+
+        uint64_t uSeqNo;
+        memcpy(&uSeqNo, pbRecs, sizeof(uSeqNo));
+        fClkLast = fClk;
+        if (fClk)
+        {
+            pClkStats->uSeqNoRise = uSeqNo;
+            pClkStats->fRise      = 1;
+        }
+        else
+            lpcDecClkStatsFall(pClkStats, uSeqNo);
+    }
+
+    pClkStats->fClkLast = fClkLast;
+}
+
+
+/**
+ * Writes the statistics of the last, incomplete window.
+ *
+ * @returns nothing.
+ * @param   pClkStats               The LCLK statistics.
+ */
+static void lpcDecClkStatsFlush(PLPCDECCLKSTATS pClkStats)
+{
+    if (pClkStats->Window.Period.cValues)
+        lpcDecClkStatsWindowNext(pClkStats, pClkStats->uSeqNoWindow);
+}
+
+
+/**
+ * Writes the LCLK statistics summary.
+ *
+ * @returns nothing.
+ * @param   pClkStats               The LCLK statistics.
+ * @param   pOut                    The stream to write to.
+ */
+static void lpcDecClkStatsDumpSummary(PCLPCDECCLKSTATS pClkStats, FILE *pOut)
+{
+    fprintf(pOut, "LCLK: ");
+    lpcDecClkMeasDump(pOut, &pClkStats->Total);
+    if (   g_uSampleRate
+        && pClkStats->Total.Period.cValues)
+        fprintf(pOut, "LCLK frequency: %.3fMHz\n", (double)g_uSampleRate / pClkStats->Total.Period.dMean / 1000000.0);
+
+    uint8_t fHist = 0;
+    for (uint32_t idxBin = 0; idxBin < LPC_DEC_CLK_HIST_BINS; idxBin++)
+    {
+        if (!pClkStats->acPeriods[idxBin])
+            continue;
+
+        if (!fHist)
+            fprintf(pOut, "LCLK period histogram:\n");
+        fHist = 1;
+
+        fprintf(pOut, "    %s%3u samples", idxBin == LPC_DEC_CLK_HIST_BINS - 1 ? ">=" : "", idxBin);
+        if (g_uSampleRate)
+            fprintf(pOut, " (%.3fns)", (double)idxBin * 1000000000.0 / (double)g_uSampleRate);
+        fprintf(pOut, ": %" PRIu64 "\n", pClkStats->acPeriods[idxBin]);
+    }
+}
+
+
+/**
+ * Decodes the given capture records with the clock tick decode engine, checking the sequence numbers if enabled.
+ *
+ * The ticks are extracted in blocks of LPC_DEC_SEQ_CHECK_RECS records which are checked right after with the vector
+ * check from the sequence numbers stored in a row on the way, so the records are only loaded once. The ticks are
+ * decoded when the tick array is about full, before an anomaly is reported and at the end.
+ *
+ * @returns nothing.
+ * @param   pTicks                  The clock tick decode engine.
+ * @param   pLpcDec                 The LPC decoder state.
+ * @param   pbRecs                  The records.
+ * @param   cRecs                   Number of records.
+ * @param   offRecs                 Offset of the records in the input for the anomaly reports.
+ */
+static void lpcDecTicksRecsProcess(PLPCDECTICKS pTicks, PLPCDEC pLpcDec, const uint8_t *pbRecs, size_t cRecs,
+                                   uint64_t offRecs)
+{
+    if (pTicks->pClkStats)
+        lpcDecClkStatsRecs(pTicks->pClkStats, &pTicks->abLut[0], pbRecs, cRecs);
+
+    if (!pTicks->uSeqGapMax)
+    {
+        lpcDecTicksRecsDecode(pTicks, pLpcDec, pbRecs, cRecs);
+        return;
+    }
+
+    if (!pTicks->fSeqNoLast && cRecs)
+    {
+        /* Let the very first record pass. */
+        memcpy(&pTicks->uSeqNoLast, pbRecs, sizeof(pTicks->uSeqNoLast));
+        pTicks->uSeqNoLast--;
+        pTicks->fSeqNoLast = 1;
+    }
+
+    while (cRecs)
+    {
+        /* Keep room for a whole block in the tick array, nothing may be decoded before the block was checked. */
+        if (pTicks->cTicks > LPC_DEC_TICKS_MAX - LPC_DEC_SEQ_CHECK_RECS)
+            lpcDecTicksDecode(pTicks, pLpcDec);
+
+        size_t cRecsBlock = cRecs < LPC_DEC_SEQ_CHECK_RECS ? cRecs : LPC_DEC_SEQ_CHECK_RECS;
+        size_t cRecsOk = lpcDecTicksRecsExtractChecked(pTicks, pLpcDec, pbRecs, cRecsBlock);
+        pbRecs  += cRecsOk * LPC_DEC_RECORD_SIZE;
+        offRecs += cRecsOk * LPC_DEC_RECORD_SIZE;
+        cRecs   -= cRecsOk;
+        if (cRecsOk == cRecsBlock)
+            continue;
+
+        /* Decode everything before the anomaly. */
+        lpcDecTicksDecode(pTicks, pLpcDec);
+
+        uint64_t uSeqNo;
+        memcpy(&uSeqNo, pbRecs, sizeof(uSeqNo));
+        if (uSeqNo <= pTicks->uSeqNoLast)
+        {
+            fprintf(stderr, "Sequence number not increasing at offset %#" PRIx64 ": %" PRIu64 " -> %" PRIu64 "\n",
+                    offRecs, pTicks->uSeqNoLast, uSeqNo);
+            pTicks->cSeqNonMono++;
+        }
+        else
+        {
+            fprintf(stderr, "Sequence number gap at offset %#" PRIx64 ": %" PRIu64 " -> %" PRIu64 "\n",
+                    offRecs, pTicks->uSeqNoLast, uSeqNo);
+            pTicks->cSeqGaps++;
+        }
+
+        /* Don't let a cycle span the discontinuity. */
+        if (pTicks->fSeqReset)
+            lpcDecStateReset(pLpcDec);
+
+        lpcDecTicksRecsExtract(pTicks, pLpcDec, pbRecs, 1);
+        pTicks->uSeqNoLast = uSeqNo;
+        pbRecs  += LPC_DEC_RECORD_SIZE;
+        offRecs += LPC_DEC_RECORD_SIZE;
+        cRecs--;
+    }
+
+    lpcDecTicksDecode(pTicks, pLpcDec);
+}
+
+
+/**
+ * Reports the number of sequence number anomalies found if there were any.
+ *
+ * @returns nothing.
+ * @param   pTicks                  The clock tick decode engine.
+ */
+static void lpcDecSeqCheckSummary(PCLPCDECTICKS pTicks)
+{
+    if (pTicks->cSeqGaps || pTicks->cSeqNonMono)
+        fprintf(stderr, "Sequence number check: %" PRIu64 " gaps, %" PRIu64 " not increasing\n",
+                pTicks->cSeqGaps, pTicks->cSeqNonMono);
+}
+
+
+/**
+ * Decodes the records from the given shared-memory ring in place until the producer signals the end.
+ *
+ * @returns Status code.
+ * @param   pszName                 The segment name (without the shm: prefix).
+ * @param   pLpcDec                 The initialized LPC decoder state.
+ * @param   pTicks                  The clock tick decode engine to use.
+ */
+static int lpcDecShmDecode(const char *pszName, PLPCDEC pLpcDec, PLPCDECTICKS pTicks)
+{
+    PLPCDECSHMHDR pHdr = NULL;
+    size_t cbMap = 0;
+    int rc = lpcDecShmMap(pszName, 0 /*fCreate*/, 0 /*cRecords*/, &pHdr, &cbMap);
+    if (rc)
+        return rc;
+
+    const uint8_t *pbRing = (const uint8_t *)pHdr + pHdr->cbHdr;
+    uint64_t cbRing  = pHdr->cbRing;
+    uint64_t offTail = __atomic_load_n(&pHdr->offTail, __ATOMIC_RELAXED);
+    __atomic_store_n(&pHdr->u32ConsumerPid, (uint32_t)getpid(), __ATOMIC_SEQ_CST);
+    for (;;)
+    {
+        uint64_t offHead = __atomic_load_n(&pHdr->offHead, __ATOMIC_ACQUIRE);
+        if (offHead == offTail)
+        {
+            /*
+             * The producer publishes the last records before setting the end flag, they may have arrived after
+             * the head was loaded above, so only stop if the head is still where it was.
+             */
+            if (__atomic_load_n(&pHdr->fEos, __ATOMIC_ACQUIRE))
+            {
+                if (__atomic_load_n(&pHdr->offHead, __ATOMIC_ACQUIRE) == offTail)
+                    break;
+                continue;
+            }
+
+            /* Re-check after announcing the wait so a publish in between can't be missed. */
+
+            uint32_t u32DataSeq = __atomic_load_n(&pHdr->u32DataSeq, __ATOMIC_SEQ_CST);
+            __atomic_store_n(&pHdr->fConsumerWaiting, 1, __ATOMIC_SEQ_CST);
+            if (   __atomic_load_n(&pHdr->offHead, __ATOMIC_SEQ_CST) == offTail
+                && !__atomic_load_n(&pHdr->fEos, __ATOMIC_SEQ_CST))
+            {
+                fflush(NULL); /* Get everything decoded so far out before going to sleep. */
+                lpcDecShmFutexWait(&pHdr->u32DataSeq, u32DataSeq);
+            }
+            __atomic_store_n(&pHdr->fConsumerWaiting, 0, __ATOMIC_SEQ_CST);
+            continue;
+        }
+
+        if (   offHead - offTail > cbRing
+            || (offHead - offTail) % LPC_DEC_RECORD_SIZE)
+        {
+            rc = EIO;
+            break;
+        }
+
+        /* Decode the contiguous part directly from the ring, handing back space regularly. */
+        uint64_t offRing = offTail % cbRing;
+        uint64_t cbChunk = offHead - offTail;
+        if (cbChunk > cbRing - offRing)
+            cbChunk = cbRing - offRing;
+        if (cbChunk > LPC_DEC_SHM_RELEASE_RECORDS * LPC_DEC_RECORD_SIZE)
+            cbChunk = LPC_DEC_SHM_RELEASE_RECORDS * LPC_DEC_RECORD_SIZE;
+
+        lpcDecTicksRecsProcess(pTicks, pLpcDec, &pbRing[offRing], (size_t)(cbChunk / LPC_DEC_RECORD_SIZE), offTail);
+
+        offTail += cbChunk;
+        __atomic_store_n(&pHdr->offTail, offTail, __ATOMIC_RELEASE);
+        lpcDecShmFutexSignal(&pHdr->u32SpaceSeq, &pHdr->fProducerWaiting);
+    }
+
+    /* Let the producer know nobody is going to free up space anymore, matters if we stop early. */
+    __atomic_store_n(&pHdr->fConsumerDone, 1, __ATOMIC_SEQ_CST);
+    lpcDecShmFutexSignal(&pHdr->u32SpaceSeq, &pHdr->fProducerWaiting);
+    munmap(pHdr, cbMap);
+    return rc;
+}
+
+
+/**
+ * Decodes the given capture file, feeding every decoded cycle to the given callback.
+ *
+ * @returns Status code.
+ * @param   pszFilename             The capture to decode, unix:<path> or tcp:<host>:<port> connect to a live
+ *                                  record stream and shm:<name> decodes a shared-memory ring instead.
+ * @param   pfnCycle                The callback to call for every decoded cycle.
+ * @param   pvUser                  Opaque user data to pass to the callback.
+ * @param   fFollow                 Flag whether to keep decoding data appended to the capture until the writer
+ *                                  closes it.
+ * @param   pVcd                    The phase export to feed, NULL if disabled.
+ * @param   pClkStats               The LCLK statistics to feed, NULL if disabled.
+ * @param   pOutMsg                 The stream to write decoder messages to.
+ */
+static int lpcDecDecodeFile(const char *pszFilename, PFNLPCDECCYCLE pfnCycle, void *pvUser, uint8_t fFollow,
+                            PLPCDECVCD pVcd, PLPCDECCLKSTATS pClkStats, FILE *pOutMsg)
+{
+    if (lpcDecShmIsShm(pszFilename))
+    {
+        LPCDEC LpcDec;
+        lpcDecStateInit(&LpcDec, 0, 1, 5, 4, 3, 2, pfnCycle, pvUser); /** @todo Make configurable */
+        LpcDec.pVcd    = pVcd;
+        LpcDec.pOutMsg = pOutMsg;
+
+        PLPCDECTICKS pTicks = NULL;
+        int rc = lpcDecTicksCreate(&pTicks, &LpcDec, g_enmEngine == LPCDECENGINE_TICK && !pVcd);
+        if (rc)
+            return rc;
+
+        pTicks->uSeqGapMax = g_uSeqGapMax;
+        pTicks->fSeqReset  = g_fSeqReset;
+        pTicks->pClkStats  = pClkStats;
+        rc = lpcDecShmDecode(pszFilename + sizeof("shm:") - 1, &LpcDec, pTicks);
+        lpcDecSeqCheckSummary(pTicks);
+        free(pTicks);
+        return rc;
+    }
+
+    PLPCDECFILEBUFREAD pBufFile = NULL;
+    int rc =   lpcDecSockAddrIsSock(pszFilename)
+             ? lpcDecSockBufReaderCreate(&pBufFile, pszFilename, g_fInputLossy, g_cMsInputStats)
+             : lpcDecFileBufReaderCreate(&pBufFile, pszFilename, fFollow);
+    if (!rc)
+    {
+        LPCDEC LpcDec;
+        lpcDecStateInit(&LpcDec, 0, 1, 5, 4, 3, 2, pfnCycle, pvUser); /** @todo Make configurable */
+        LpcDec.pVcd    = pVcd;
+        LpcDec.pOutMsg = pOutMsg;
+
+        /* The phase export needs every state change at its clock, only the state machine provides that. */
+        PLPCDECTICKS pTicks = NULL;
+        rc = lpcDecTicksCreate(&pTicks, &LpcDec, g_enmEngine == LPCDECENGINE_TICK && !pVcd);
+        if (!rc)
+        {
+            pTicks->uSeqGapMax = g_uSeqGapMax;
+            pTicks->fSeqReset  = g_fSeqReset;
+            pTicks->pClkStats  = pClkStats;
+        }
+
+        uint64_t offRecs = 0; /* Offset of the records received, dropped input isn't counted. */
+        while (!rc)
+        {
+            /* Decode all complete records in the buffer at once. */
+            if (lpcDecFileBufReaderEnsureData(pBufFile, LPC_DEC_RECORD_SIZE))
+                break;
+
+            /* Don't let a cycle span records lost in between. */
+            if (pBufFile->fDiscont)
+            {
+                lpcDecStateReset(&LpcDec);
+                pBufFile->fDiscont = 0;
+            }
+
+            size_t cRecs = (pBufFile->cbData - pBufFile->offBuf) / LPC_DEC_RECORD_SIZE;
+            lpcDecTicksRecsProcess(pTicks, &LpcDec, &pBufFile->abBuf[pBufFile->offBuf], cRecs, offRecs);
+            pBufFile->offBuf += (uint32_t)(cRecs * LPC_DEC_RECORD_SIZE);
+            offRecs          += cRecs * LPC_DEC_RECORD_SIZE;
+        }
+
+        if (pTicks)
+        {
+            lpcDecSeqCheckSummary(pTicks);
+            free(pTicks);
+        }
+        lpcDecFileBufReaderClose(pBufFile);
+    }
+
+    return rc;
+}
+
+
+/**
+ * Converts the given cycle type to a human readable string.
+ *
+ * @returns String of the given cycle type.
+ * @param   bTyp                    The cycle type (LPC_DEC_CYC_TYPE_XXX).
+ */
+static const char *lpcDecCycTypeToStr(uint8_t bTyp)
+{
+    switch (bTyp)
+    {
+        case LPC_DEC_CYC_TYPE_IO:
+            return "I/O";
+        case LPC_DEC_CYC_TYPE_MEM:
+            return "Mem";
+        case LPC_DEC_CYC_TYPE_DMA:
+            return "DMA";
+        case LPC_DEC_CYC_TYPE_RSVD:
+            return "RESERVED";
+        default:
+            break;
+    }
+
+    return "<INVALID>";
+}
+
+
+/**
+ * Appends the given fragment to a JSON Lines buffer.
+ *
+ * @returns Pointer past the appended fragment.
+ * @param   pch                     Where to append.
+ * @param   idxFrag                 The fragment to append (LPC_DEC_JSONL_FRAG_XXX).
+ */
+static inline char *lpcDecJsonlFrag(char *pch, uint32_t idxFrag)
+{
+    memcpy(pch, g_aJsonlFrags[idxFrag].psz, g_aJsonlFrags[idxFrag].cch);
+    return pch + g_aJsonlFrags[idxFrag].cch;
+}
+
+
+/**
+ * Appends the given unsigned integer in decimal to a JSON Lines buffer.
+ *
+ * @returns Pointer past the appended digits.
+ * @param   pch                     Where to append.
+ * @param   u64                     The value.
+ * @param   cDigitsMin              Minimum number of digits, padded with zeros.
+ */
+static inline char *lpcDecJsonlU64(char *pch, uint64_t u64, uint32_t cDigitsMin)
+{
+    char achTmp[24];
+    char *pchTmp = &achTmp[sizeof(achTmp)];
+
+    while (u64 >= 100)
+    {
+        pchTmp -= 2;
+        memcpy(pchTmp, &g_achDecPairs[(u64 % 100) * 2], 2);
+        u64 /= 100;
+    }
+    if (u64 >= 10)
+    {
+        pchTmp -= 2;
+        memcpy(pchTmp, &g_achDecPairs[u64 * 2], 2);
+    }
+    else
+        *--pchTmp = (char)('0' + u64);
+
+    while ((size_t)(&achTmp[sizeof(achTmp)] - pchTmp) < cDigitsMin)
+        *--pchTmp = '0';
+
+    size_t cch = (size_t)(&achTmp[sizeof(achTmp)] - pchTmp);
+    memcpy(pch, pchTmp, cch);
+    return pch + cch;
+}
+
+
+/**
+ * Dumps the given decoded cycle as a single JSON object line.
+ *
+ * @returns nothing.
+ * @param   pOut                    The stream to write to.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with (for the SYNC waits and the
+ *                                  state chain), NULL if the cycle doesn't come from a decoder.
+ * @param   pCycle                  The decoded cycle.
+ */
+static void lpcDecCycleDumpJsonl(FILE *pOut, PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle)
+{
+    char achLine[LPC_DEC_JSONL_LINE_MAX];
+    char *pch = &achLine[0];
+
+    pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_SEQ);
+    pch = lpcDecJsonlU64(pch, pCycle->uSeqNo, 1);
+
+    /* Seconds with nanosecond resolution, without going through floating point formatting. */
+    pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_TS);
+    if (g_uSampleRate)
+    {
+        uint64_t uNs = lpcDecSeqNoToNs(pCycle->uSeqNo);
+        pch = lpcDecJsonlU64(pch, uNs / UINT64_C(1000000000), 1);
+        *pch++ = '.';
+        pch = lpcDecJsonlU64(pch, uNs % UINT64_C(1000000000), 9);
+    }
+    else /* There is no time without a sample rate. */
+        pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_NULL);
+
+    pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_TYPE_FIRST + (pCycle->bTyp & 0x3));
+    pch = lpcDecJsonlFrag(pch, pCycle->fWrite ? LPC_DEC_JSONL_FRAG_DIR_WRITE : LPC_DEC_JSONL_FRAG_DIR_READ);
+
+    /* Memory addresses have 32 bits, I/O ports 16. */
+    pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_ADDR);
+    if (pCycle->bTyp == LPC_DEC_CYC_TYPE_MEM)
+    {
+        memcpy(pch,     &g_achHexPairs[((pCycle->u32Addr >> 24) & 0xff) * 2], 2);
+        memcpy(pch + 2, &g_achHexPairs[((pCycle->u32Addr >> 16) & 0xff) * 2], 2);
+        pch += 4;
+    }
+    memcpy(pch,     &g_achHexPairs[((pCycle->u32Addr >> 8) & 0xff) * 2], 2);
+    memcpy(pch + 2, &g_achHexPairs[(pCycle->u32Addr & 0xff) * 2], 2);
+    pch += 4;
+
+    pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_DATA);
+    memcpy(pch, &g_achHexPairs[pCycle->bData * 2], 2);
+    pch += 2;
+    pch = lpcDecJsonlFrag(pch, pCycle->fAbort ? LPC_DEC_JSONL_FRAG_ABORT_TRUE : LPC_DEC_JSONL_FRAG_ABORT_FALSE);
+
+    /* Cycles not coming from a decoder (the trigger pre-ring) have no SYNC waits, the key stays like for ts. */
+    pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_SYNC_WAITS);
+    if (pLpcDec)
+        pch = lpcDecJsonlU64(pch, pLpcDec->cSyncWaits, 1);
+    else
+        pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_NULL);
+
+    /* The rendered chain is at most LPC_DEC_STATES_STR_MAX characters, fits the line buffer easily. */
+    if (g_fVerbose && pCycle->u32States)
+    {
+        pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_STATES);
+        pch = lpcDecStatesFmt(pch, pCycle->u32States, 1 /*fJson*/);
+        pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_STATES_END);
+    }
+
+    pch = lpcDecJsonlFrag(pch, LPC_DEC_JSONL_FRAG_END);
+    fwrite(&achLine[0], 1, (size_t)(pch - &achLine[0]), pOut);
+}
+
+
+/**
+ * Reserves the given number of zeroed bytes in the flatbuffer.
+ *
+ * @returns Position of the reserved bytes, the builder status is set on failure.
+ * @param   pFb                     The flatbuffer builder.
+ * @param   cb                      Number of bytes to reserve.
+ * @param   cbAlign                 Alignment of the reserved bytes, power of two.
+ */
+static uint32_t lpcDecFbAlloc(PLPCDECFB pFb, uint32_t cb, uint32_t cbAlign)
+{
+    uint32_t cbPad = -pFb->cb & (cbAlign - 1);
+    if (pFb->cb + cbPad + cb > pFb->cbMax)
+    {
+        uint32_t cbMax = pFb->cbMax ? pFb->cbMax : LPC_DEC_ARROW_FB_SIZE_INIT;
+        while (pFb->cb + cbPad + cb > cbMax)
+            cbMax *= 2;
+
+        uint8_t *pbNew = (uint8_t *)realloc(pFb->pb, cbMax);
+        if (!pbNew)
+        {
+            pFb->rc = ENOMEM;
+            return 0;
+        }
+        pFb->pb    = pbNew;
+        pFb->cbMax = cbMax;
+    }
+
+    memset(&pFb->pb[pFb->cb], 0, cbPad + cb);
+    uint32_t off = pFb->cb + cbPad;
+    pFb->cb = off + cb;
+    return off;
+}
+
+
+/**
+ * Stores a little endian value in the flatbuffer.
+ *
+ * @returns nothing.
+ * @param   pFb                     The flatbuffer builder.
+ * @param   off                     Where to store the value.
+ * @param   u64                     The value.
+ * @param   cb                      Size of the value in bytes.
+ */
+static void lpcDecFbStore(PLPCDECFB pFb, uint32_t off, uint64_t u64, uint32_t cb)
+{
+    if (pFb->rc)
+        return;
+
+    for (uint32_t i = 0; i < cb; i++)
+        pFb->pb[off + i] = (uint8_t)(u64 >> (i * 8));
+}
+
+
+/**
+ * Points the given offset field at the given object.
+ *
+ * @returns nothing.
+ * @param   pFb                     The flatbuffer builder.
+ * @param   offRef                  Position of the offset field.
+ * @param   offObj                  Position of the referenced object, after the offset field.
+ */
+static void lpcDecFbRef(PLPCDECFB pFb, uint32_t offRef, uint32_t offObj)
+{
+    lpcDecFbStore(pFb, offRef, offObj - offRef, 4);
+}
+
+
+/**
+ * Starts a flatbuffer with the root table offset.
+ *
+ * @returns Position of the root table offset.
+ * @param   pFb                     The flatbuffer builder.
+ */
+static uint32_t lpcDecFbStart(PLPCDECFB pFb)
+{
+    pFb->cb = 0;
+    pFb->rc = 0;
+    return lpcDecFbAlloc(pFb, 4, 4);
+}
+
+
+/**
+ * Starts a table, the vtable is placed directly in front of it and the table is 8 byte aligned.
+ *
+ * @returns Position of the table.
+ * @param   pFb                     The flatbuffer builder.
+ * @param   cFields                 Number of field slots of the table.
+ */
+static uint32_t lpcDecFbTableBegin(PLPCDECFB pFb, uint32_t cFields)
+{
+    uint32_t cbVt = 4 + 2 * cFields;
+    lpcDecFbAlloc(pFb, 0, 2);
+    lpcDecFbAlloc(pFb, -(pFb->cb + cbVt) & 7, 1);
+
+    pFb->offVt    = lpcDecFbAlloc(pFb, cbVt, 2);
+    pFb->offTable = lpcDecFbAlloc(pFb, 4, 4);
+    lpcDecFbStore(pFb, pFb->offVt, cbVt, 2);
+    lpcDecFbStore(pFb, pFb->offTable, pFb->offTable - pFb->offVt, 4);
+    return pFb->offTable;
+}
+
+
+/**
+ * Adds a scalar field to the table being built.
+ *
+ * @returns Position of the field.
+ * @param   pFb                     The flatbuffer builder.
+ * @param   idxField                The field slot.
+ * @param   u64                     The value.
+ * @param   cb                      Size of the field in bytes.
+ */
+static uint32_t lpcDecFbField(PLPCDECFB pFb, uint32_t idxField, uint64_t u64, uint32_t cb)
+{
+    uint32_t off = lpcDecFbAlloc(pFb, cb, cb);
+    lpcDecFbStore(pFb, pFb->offVt + 4 + 2 * idxField, off - pFb->offTable, 2);
+    lpcDecFbStore(pFb, off, u64, cb);
+    return off;
+}
+
+
+/**
+ * Completes the table being built.
+ *
+ * @returns nothing.
+ * @param   pFb                     The flatbuffer builder.
+ */
+static void lpcDecFbTableEnd(PLPCDECFB pFb)
+{
+    lpcDecFbStore(pFb, pFb->offVt + 2, pFb->cb - pFb->offTable, 2);
+}
+
+
+/**
+ * Adds a vector, the elements are left zeroed for the caller to fill in.
+ *
+ * @returns Position of the vector, the elements follow the 4 byte length.
+ * @param   pFb                     The flatbuffer builder.
+ * @param   cElems                  Number of elements.
+ * @param   cbElem                  Size of an element.
+ * @param   cbAlign                 Alignment of the elements, at least 4.
+ */
+static uint32_t lpcDecFbVector(PLPCDECFB pFb, uint32_t cElems, uint32_t cbElem, uint32_t cbAlign)
+{
+    lpcDecFbAlloc(pFb, 0, 4);
+    lpcDecFbAlloc(pFb, -(pFb->cb + 4) & (cbAlign - 1), 1);
+
+    uint32_t off = lpcDecFbAlloc(pFb, 4 + cElems * cbElem, 4);
+    lpcDecFbStore(pFb, off, cElems, 4);
+    return off;
+}
+
+
+/**
+ * Adds a zero terminated string.
+ *
+ * @returns Position of the string.
+ * @param   pFb                     The flatbuffer builder.
+ * @param   psz                     The string.
+ */
+static uint32_t lpcDecFbString(PLPCDECFB pFb, const char *psz)
+{
+    uint32_t cch = (uint32_t)strlen(psz);
+    uint32_t off = lpcDecFbVector(pFb, cch + 1, 1, 4);
+    lpcDecFbStore(pFb, off, cch, 4);
+    if (!pFb->rc)
+        memcpy(&pFb->pb[off + 4], psz, cch);
+    return off;
+}
+
+
+/**
+ * Adds the schema of the cycle columns.
+ *
+ * @returns nothing.
+ * @param   pFb                     The flatbuffer builder.
+ * @param   offRef                  Position of the offset field referencing the schema.
+ */
+static void lpcDecArrowSchema(PLPCDECFB pFb, uint32_t offRef)
+{
+    static const struct
+    {
+        const char      *pszName;
+        /** Integer width in bits, 0 for booleans. */
+        uint32_t        cBits;
+    } s_aCols[LPC_DEC_ARROW_COLS] =
+    {
+        { "seq",     64 },
+        { "type",    8  },
+        { "dir",     8  },
+        { "address", 32 },
+        { "data",    8  },
+        { "abort",   0  }
+    };
+
+    lpcDecFbRef(pFb, offRef, lpcDecFbTableBegin(pFb, 2));
+    lpcDecFbField(pFb, 0, 0 /*Little*/, 2);
+    uint32_t offFieldsRef = lpcDecFbField(pFb, 1, 0, 4);
+    lpcDecFbTableEnd(pFb);
+
+    uint32_t offFields = lpcDecFbVector(pFb, LPC_DEC_ARROW_COLS, 4, 4);
+    lpcDecFbRef(pFb, offFieldsRef, offFields);
+    for (uint32_t i = 0; i < LPC_DEC_ARROW_COLS; i++)
+    {
+        lpcDecFbRef(pFb, offFields + 4 + 4 * i, lpcDecFbTableBegin(pFb, 6));
+        uint32_t offNameRef = lpcDecFbField(pFb, 0, 0, 4);
+        lpcDecFbField(pFb, 1, 0 /*nullable*/, 1);
+        lpcDecFbField(pFb, 2, s_aCols[i].cBits ? LPC_DEC_ARROW_TYPE_INT : LPC_DEC_ARROW_TYPE_BOOL, 1);
+        uint32_t offTypeRef = lpcDecFbField(pFb, 3, 0, 4);
+        uint32_t offChildrenRef = lpcDecFbField(pFb, 5, 0, 4);
+        lpcDecFbTableEnd(pFb);
+
+        lpcDecFbRef(pFb, offNameRef, lpcDecFbString(pFb, s_aCols[i].pszName));
+        lpcDecFbRef(pFb, offTypeRef, lpcDecFbTableBegin(pFb, 2));
+        if (s_aCols[i].cBits)
+        {
+            lpcDecFbField(pFb, 0, s_aCols[i].cBits, 4);
+            lpcDecFbField(pFb, 1, 0 /*is_signed*/, 1);
+        }
+        lpcDecFbTableEnd(pFb);
+
+        /* Readers insist on the children even for primitive types. */
+        lpcDecFbRef(pFb, offChildrenRef, lpcDecFbVector(pFb, 0, 4, 4));
+    }
+}
+
+
+/**
+ * Writes the given data to the Arrow output destination.
+ *
+ * @returns nothing, the writer status is set on failure.
+ * @param   pArrowOut               The Arrow output stream.
+ * @param   pv                      The data.
+ * @param   cb                      Number of bytes to write.
+ */
+static void lpcDecArrowOutWriteRaw(PLPCDECARROWOUT pArrowOut, const void *pv, size_t cb)
+{
+    if (   !pArrowOut->rc
+        && cb
+        && fwrite(pv, cb, 1, pArrowOut->pDst) != 1)
+        pArrowOut->rc = EIO;
+    pArrowOut->offFile += cb;
+}
+
+
+/**
+ * Writes the given column buffer padded to 8 bytes.
+ *
+ * @returns nothing, the writer status is set on failure.
+ * @param   pArrowOut               The Arrow output stream.
+ * @param   pv                      The buffer.
+ * @param   cb                      Size of the buffer.
+ */
+static void lpcDecArrowOutWriteBuf(PLPCDECARROWOUT pArrowOut, const void *pv, size_t cb)
+{
+    static const uint8_t s_abPad[8] = { 0 };
+
+    lpcDecArrowOutWriteRaw(pArrowOut, pv, cb);
+    lpcDecArrowOutWriteRaw(pArrowOut, &s_abPad[0], -cb & 7);
+}
+
+
+/**
+ * Writes the message held by the flatbuffer builder with its continuation and length prefix.
+ *
+ * @returns Size of the message metadata including the prefix.
+ * @param   pArrowOut               The Arrow output stream.
+ */
+static uint32_t lpcDecArrowOutWriteMsg(PLPCDECARROWOUT pArrowOut)
+{
+    PLPCDECFB pFb = &pArrowOut->Fb;
+
+    /* The body following the metadata needs 8 byte alignment. */
+    lpcDecFbAlloc(pFb, 0, 8);
+    if (pFb->rc)
+    {
+        pArrowOut->rc = pFb->rc;
+        return 0;
+    }
+
+    uint8_t abPrefix[8];
+    uint32_t u32Continuation = LPC_DEC_ARROW_CONTINUATION;
+    memcpy(&abPrefix[0], &u32Continuation, 4);
+    abPrefix[4] = (uint8_t)pFb->cb;
+    abPrefix[5] = (uint8_t)(pFb->cb >> 8);
+    abPrefix[6] = (uint8_t)(pFb->cb >> 16);
+    abPrefix[7] = (uint8_t)(pFb->cb >> 24);
+    lpcDecArrowOutWriteRaw(pArrowOut, &abPrefix[0], sizeof(abPrefix));
+    lpcDecArrowOutWriteRaw(pArrowOut, pFb->pb, pFb->cb);
+    return sizeof(abPrefix) + pFb->cb;
+}
+
+
+/**
+ * Writes the collected cycles as a record batch.
+ *
+ * @returns nothing, the writer status is set on failure.
+ * @param   pArrowOut               The Arrow output stream.
+ */
+static void lpcDecArrowOutFlush(PLPCDECARROWOUT pArrowOut)
+{
+    uint32_t cCycles = pArrowOut->cCycles;
+    const size_t acbCols[LPC_DEC_ARROW_COLS] =
+    {
+        cCycles * sizeof(uint64_t), cCycles, cCycles, cCycles * sizeof(uint32_t), cCycles, (cCycles + 7) / 8
+    };
+    const void *apvCols[LPC_DEC_ARROW_COLS] =
+    {
+        pArrowOut->pau64Seq, pArrowOut->pabType, pArrowOut->pabDir, pArrowOut->pau32Addr, pArrowOut->pabData,
+        pArrowOut->pbmAbort
+    };
+
+    if (pArrowOut->cBlocks == pArrowOut->cBlocksMax)
+    {
+        uint32_t cBlocksMax = pArrowOut->cBlocksMax ? pArrowOut->cBlocksMax * 2 : 64;
+        PLPCDECARROWBLOCK paBlocks = (PLPCDECARROWBLOCK)realloc(pArrowOut->paBlocks,
+                                                                cBlocksMax * sizeof(*paBlocks));
+        if (!paBlocks)
+        {
+            pArrowOut->rc = ENOMEM;
+            return;
+        }
+        pArrowOut->paBlocks   = paBlocks;
+        pArrowOut->cBlocksMax = cBlocksMax;
+    }
+
+    uint64_t cbBody = 0;
+    for (uint32_t i = 0; i < LPC_DEC_ARROW_COLS; i++)
+        cbBody += (acbCols[i] + 7) & ~(size_t)7;
+
+    PLPCDECFB pFb = &pArrowOut->Fb;
+    uint32_t offRootRef = lpcDecFbStart(pFb);
+    lpcDecFbRef(pFb, offRootRef, lpcDecFbTableBegin(pFb, 4));
+    lpcDecFbField(pFb, 0, LPC_DEC_ARROW_METADATA_V5, 2);
+    lpcDecFbField(pFb, 1, LPC_DEC_ARROW_HDR_RECORD_BATCH, 1);
+    uint32_t offHdrRef = lpcDecFbField(pFb, 2, 0, 4);
+    lpcDecFbField(pFb, 3, cbBody, 8);
+    lpcDecFbTableEnd(pFb);
+
+    lpcDecFbRef(pFb, offHdrRef, lpcDecFbTableBegin(pFb, 3));
+    lpcDecFbField(pFb, 0, cCycles, 8);
+    uint32_t offNodesRef = lpcDecFbField(pFb, 1, 0, 4);
+    uint32_t offBuffersRef = lpcDecFbField(pFb, 2, 0, 4);
+    lpcDecFbTableEnd(pFb);
+
+    /* FieldNode { length, null_count } per column. */
+    uint32_t offNodes = lpcDecFbVector(pFb, LPC_DEC_ARROW_COLS, 16, 8);
+    lpcDecFbRef(pFb, offNodesRef, offNodes);
+    for (uint32_t i = 0; i < LPC_DEC_ARROW_COLS; i++)
+        lpcDecFbStore(pFb, offNodes + 4 + 16 * i, cCycles, 8);
+
+    /* Buffer { offset, length } for the (empty) validity bitmap and the values of every column. */
+    uint32_t offBuffers = lpcDecFbVector(pFb, 2 * LPC_DEC_ARROW_COLS, 16, 8);
+    lpcDecFbRef(pFb, offBuffersRef, offBuffers);
+    uint64_t offBody = 0;
+    for (uint32_t i = 0; i < LPC_DEC_ARROW_COLS; i++)
+    {
+        lpcDecFbStore(pFb, offBuffers + 4 + 32 * i, offBody, 8);
+        lpcDecFbStore(pFb, offBuffers + 4 + 32 * i + 16, offBody, 8);
+        lpcDecFbStore(pFb, offBuffers + 4 + 32 * i + 24, acbCols[i], 8);
+        offBody += (acbCols[i] + 7) & ~(size_t)7;
+    }
+
+    PLPCDECARROWBLOCK pBlock = &pArrowOut->paBlocks[pArrowOut->cBlocks++];
+    pBlock->off    = pArrowOut->offFile;
+    pBlock->cbMeta = lpcDecArrowOutWriteMsg(pArrowOut);
+    pBlock->cbBody = cbBody;
+    for (uint32_t i = 0; i < LPC_DEC_ARROW_COLS; i++)
+        lpcDecArrowOutWriteBuf(pArrowOut, apvCols[i], acbCols[i]);
+
+    memset(pArrowOut->pbmAbort, 0, (pArrowOut->cBatchCycles + 7) / 8);
+    pArrowOut->cCycles = 0;
+}
+
+
+/**
+ * Adds the given cycle to the current record batch of the given Arrow output stream.
+ *
+ * The destination stream stays locked while adding, the triggered extraction and a sink writing to the standard
+ * output share the stream from different threads.
+ *
+ * @returns nothing, the writer status is set on failure.
+ * @param   pArrowOut               The Arrow output stream.
+ * @param   pCycle                  The cycle.
+ */
+static void lpcDecArrowOutCycleAdd(PLPCDECARROWOUT pArrowOut, PCLPCDECCYCLE pCycle)
+{
+    flockfile(pArrowOut->pDst);
+
+    uint32_t idx = pArrowOut->cCycles++;
+    pArrowOut->pau64Seq[idx]  = pCycle->uSeqNo;
+    pArrowOut->pabType[idx]   = pCycle->bTyp;
+    pArrowOut->pabDir[idx]    = pCycle->fWrite ? 1 : 0;
+    pArrowOut->pau32Addr[idx] = pCycle->u32Addr;
+    pArrowOut->pabData[idx]   = pCycle->bData;
+    if (pCycle->fAbort)
+        pArrowOut->pbmAbort[idx / 8] |= (uint8_t)(1 << (idx % 8));
+
+    if (pArrowOut->cCycles == pArrowOut->cBatchCycles)
+        lpcDecArrowOutFlush(pArrowOut);
+
+    funlockfile(pArrowOut->pDst);
+}
+
+
+/**
+ * Frees the given Arrow output stream.
+ *
+ * @returns nothing.
+ * @param   pArrowOut               The Arrow output stream.
+ */
+static void lpcDecArrowOutFree(PLPCDECARROWOUT pArrowOut)
+{
+    free(pArrowOut->Fb.pb);
+    free(pArrowOut->paBlocks);
+    free(pArrowOut->pau64Seq);
+    free(pArrowOut->pabType);
+    free(pArrowOut->pabDir);
+    free(pArrowOut->pau32Addr);
+    free(pArrowOut->pabData);
+    free(pArrowOut->pbmAbort);
+    free(pArrowOut);
+}
+
+
+/**
+ * Frees the given Arrow output stream once it is complete.
+ *
+ * @returns Status code of the writer.
+ * @param   pArrowOut               The Arrow output stream.
+ */
+static int lpcDecArrowOutRelease(PLPCDECARROWOUT pArrowOut)
+{
+    int rc = pArrowOut->rc;
+    lpcDecArrowOutFree(pArrowOut);
+    return rc;
+}
+
+
+/**
+ * Writes the last batch and the footer of the given Arrow output stream and frees it, the destination stream is
+ * left to the caller.
+ *
+ * @returns Status code of the writer.
+ * @param   pArrowOut               The Arrow output stream.
+ */
+static int lpcDecArrowOutClose(PLPCDECARROWOUT pArrowOut)
+{
+    if (pArrowOut->cCycles)
+        lpcDecArrowOutFlush(pArrowOut);
+
+    /* End of stream marker, then the footer locating the schema and record batches for random access. */
+    static const uint8_t s_abEos[8] = { 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00 };
+    lpcDecArrowOutWriteRaw(pArrowOut, &s_abEos[0], sizeof(s_abEos));
+    if (pArrowOut->fStream)
+        return lpcDecArrowOutRelease(pArrowOut);
+
+    PLPCDECFB pFb = &pArrowOut->Fb;
+    uint32_t offRootRef = lpcDecFbStart(pFb);
+    lpcDecFbRef(pFb, offRootRef, lpcDecFbTableBegin(pFb, 4));
+    lpcDecFbField(pFb, 0, LPC_DEC_ARROW_METADATA_V5, 2);
+    uint32_t offSchemaRef = lpcDecFbField(pFb, 1, 0, 4);
+    uint32_t offDictsRef = lpcDecFbField(pFb, 2, 0, 4);
+    uint32_t offBatchesRef = lpcDecFbField(pFb, 3, 0, 4);
+    lpcDecFbTableEnd(pFb);
+
+    lpcDecArrowSchema(pFb, offSchemaRef);
+    lpcDecFbRef(pFb, offDictsRef, lpcDecFbVector(pFb, 0, 24, 8));
+
+    /* Block { offset, metaDataLength, (padding), bodyLength }. */
+    uint32_t offBatches = lpcDecFbVector(pFb, pArrowOut->cBlocks, 24, 8);
+    lpcDecFbRef(pFb, offBatchesRef, offBatches);
+    for (uint32_t i = 0; i < pArrowOut->cBlocks; i++)
+    {
+        lpcDecFbStore(pFb, offBatches + 4 + 24 * i, pArrowOut->paBlocks[i].off, 8);
+        lpcDecFbStore(pFb, offBatches + 4 + 24 * i + 8, pArrowOut->paBlocks[i].cbMeta, 4);
+        lpcDecFbStore(pFb, offBatches + 4 + 24 * i + 16, pArrowOut->paBlocks[i].cbBody, 8);
+    }
+
+    if (!pFb->rc)
+    {
+        uint8_t abSize[4] = { (uint8_t)pFb->cb, (uint8_t)(pFb->cb >> 8), (uint8_t)(pFb->cb >> 16),
+                              (uint8_t)(pFb->cb >> 24) };
+        lpcDecArrowOutWriteRaw(pArrowOut, pFb->pb, pFb->cb);
+        lpcDecArrowOutWriteRaw(pArrowOut, &abSize[0], sizeof(abSize));
+        lpcDecArrowOutWriteRaw(pArrowOut, LPC_DEC_ARROW_MAGIC, LPC_DEC_ARROW_MAGIC_SIZE);
+    }
+    else if (!pArrowOut->rc)
+        pArrowOut->rc = pFb->rc;
+
+    return lpcDecArrowOutRelease(pArrowOut);
+}
+
+
+/**
+ * Opens an Arrow IPC file output stream writing to the given stream, the cycles are added with
+ * lpcDecArrowOutCycleAdd().
+ *
+ * @returns Status code.
+ * @param   pDst                    The stream to write the file to.
+ * @param   fStream                 Flag whether to write the IPC stream format (no file magic and footer) for
+ *                                  readers consuming a pipe.
+ * @param   cBatchCycles            Number of cycles per record batch.
+ * @param   ppArrowOut              Where to store the Arrow output stream on success.
+ */
+static int lpcDecArrowOutOpen(FILE *pDst, uint8_t fStream, uint32_t cBatchCycles, PLPCDECARROWOUT *ppArrowOut)
+{
+    PLPCDECARROWOUT pArrowOut = (PLPCDECARROWOUT)calloc(1, sizeof(*pArrowOut));
+    if (!pArrowOut)
+        return ENOMEM;
+
+    pArrowOut->pDst         = pDst;
+    pArrowOut->fStream      = fStream;
+    pArrowOut->cBatchCycles = cBatchCycles;
+    pArrowOut->pau64Seq     = (uint64_t *)malloc(cBatchCycles * sizeof(uint64_t));
+    pArrowOut->pabType      = (uint8_t *)malloc(cBatchCycles);
+    pArrowOut->pabDir       = (uint8_t *)malloc(cBatchCycles);
+    pArrowOut->pau32Addr    = (uint32_t *)malloc(cBatchCycles * sizeof(uint32_t));
+    pArrowOut->pabData      = (uint8_t *)malloc(cBatchCycles);
+    pArrowOut->pbmAbort     = (uint8_t *)calloc((cBatchCycles + 7) / 8, 1);
+    if (   !pArrowOut->pau64Seq
+        || !pArrowOut->pabType
+        || !pArrowOut->pabDir
+        || !pArrowOut->pau32Addr
+        || !pArrowOut->pabData
+        || !pArrowOut->pbmAbort)
+    {
+        lpcDecArrowOutFree(pArrowOut);
+        return ENOMEM;
+    }
+
+    /* The file magic followed by the schema message of the stream format. */
+    if (!fStream)
+        lpcDecArrowOutWriteRaw(pArrowOut, LPC_DEC_ARROW_MAGIC, sizeof(LPC_DEC_ARROW_MAGIC) - 1);
+
+    PLPCDECFB pFb = &pArrowOut->Fb;
+    uint32_t offRootRef = lpcDecFbStart(pFb);
+    lpcDecFbRef(pFb, offRootRef, lpcDecFbTableBegin(pFb, 4));
+    lpcDecFbField(pFb, 0, LPC_DEC_ARROW_METADATA_V5, 2);
+    lpcDecFbField(pFb, 1, LPC_DEC_ARROW_HDR_SCHEMA, 1);
+    uint32_t offHdrRef = lpcDecFbField(pFb, 2, 0, 4);
+    lpcDecFbField(pFb, 3, 0 /*bodyLength*/, 8);
+    lpcDecFbTableEnd(pFb);
+    lpcDecArrowSchema(pFb, offHdrRef);
+    lpcDecArrowOutWriteMsg(pArrowOut);
+    if (pArrowOut->rc)
+    {
+        int rc = pArrowOut->rc;
+        lpcDecArrowOutFree(pArrowOut);
+        return rc;
+    }
+
+    *ppArrowOut = pArrowOut;
+    return 0;
+}
+
+
+/**
+ * Stores the given 16-bit value in little endian at the given position.
+ *
+ * @returns Pointer past the stored value.
+ * @param   pb                      Where to store the value.
+ * @param   u16                     The value.
+ */
+static inline uint8_t *lpcDecPcapngU16(uint8_t *pb, uint16_t u16)
+{
+    pb[0] = (uint8_t)u16;
+    pb[1] = (uint8_t)(u16 >> 8);
+    return pb + 2;
+}
+
+
+/**
+ * Stores the given 32-bit value in little endian at the given position.
+ *
+ * @returns Pointer past the stored value.
+ * @param   pb                      Where to store the value.
+ * @param   u32                     The value.
+ */
+static inline uint8_t *lpcDecPcapngU32(uint8_t *pb, uint32_t u32)
+{
+    pb[0] = (uint8_t)u32;
+    pb[1] = (uint8_t)(u32 >> 8);
+    pb[2] = (uint8_t)(u32 >> 16);
+    pb[3] = (uint8_t)(u32 >> 24);
+    return pb + 4;
+}
+
+
+/**
+ * Stores the given block or record option padded to 32 bits at the given position.
+ *
+ * @returns Pointer past the stored option.
+ * @param   pb                      Where to store the option.
+ * @param   uCode                   The option code (LPC_DEC_PCAPNG_OPT_XXX).
+ * @param   pvData                  The option value.
+ * @param   cbData                  Size of the option value in bytes.
+ */
+static uint8_t *lpcDecPcapngOpt(uint8_t *pb, uint16_t uCode, const void *pvData, uint16_t cbData)
+{
+    pb = lpcDecPcapngU16(pb, uCode);
+    pb = lpcDecPcapngU16(pb, cbData);
+    memcpy(pb, pvData, cbData);
+    memset(pb + cbData, 0, (size_t)(-cbData & 3));
+    return pb + ((cbData + 3) & ~3);
+}
+
+
+/**
+ * Writes the section header and the LPC interface description blocks starting a pcapng stream.
+ *
+ * @returns nothing.
+ * @param   pOut                    The stream to write to.
+ */
+static void lpcDecPcapngHdrWrite(FILE *pOut)
+{
+    /* All fields in little endian, readers swap based on the byte order magic. */
+    uint8_t abHdr[LPC_DEC_PCAPNG_HDR_MAX];
+    uint8_t *pbShb = &abHdr[0];
+    uint8_t *pb = lpcDecPcapngU32(pbShb, LPC_DEC_PCAPNG_BLOCK_SHB);
+    pb = lpcDecPcapngU32(pb, 0); /* Filled in below. */
+    pb = lpcDecPcapngU32(pb, LPC_DEC_PCAPNG_BYTE_ORDER_MAGIC);
+    pb = lpcDecPcapngU16(pb, 1);
+    pb = lpcDecPcapngU16(pb, 0);
+    pb = lpcDecPcapngU32(pb, UINT32_MAX); /* Unknown section length. */
+    pb = lpcDecPcapngU32(pb, UINT32_MAX);
+    pb = lpcDecPcapngOpt(pb, LPC_DEC_PCAPNG_OPT_SHB_USERAPPL, "lpc-dec", 7);
+    pb = lpcDecPcapngOpt(pb, LPC_DEC_PCAPNG_OPT_END, NULL, 0);
+    uint32_t cbBlock = (uint32_t)(pb - pbShb) + 4;
+    lpcDecPcapngU32(pbShb + 4, cbBlock);
+    pb = lpcDecPcapngU32(pb, cbBlock);
+
+    /* The timestamps are in nanoseconds derived from the sample rate. */
+    static const uint8_t s_bTsResolNs = 9;
+    uint8_t *pbIdb = pb;
+    pb = lpcDecPcapngU32(pbIdb, LPC_DEC_PCAPNG_BLOCK_IDB);
+    pb = lpcDecPcapngU32(pb, 0); /* Filled in below. */
+    pb = lpcDecPcapngU16(pb, LPC_DEC_PCAPNG_LINKTYPE);
+    pb = lpcDecPcapngU16(pb, 0);
+    pb = lpcDecPcapngU32(pb, 0); /* No snap length limit. */
+    pb = lpcDecPcapngOpt(pb, LPC_DEC_PCAPNG_OPT_IF_NAME, "lpc", 3);
+    pb = lpcDecPcapngOpt(pb, LPC_DEC_PCAPNG_OPT_IF_DESCRIPTION, "LPC bus", 7);
+    pb = lpcDecPcapngOpt(pb, LPC_DEC_PCAPNG_OPT_IF_TSRESOL, &s_bTsResolNs, 1);
+    pb = lpcDecPcapngOpt(pb, LPC_DEC_PCAPNG_OPT_END, NULL, 0);
+    cbBlock = (uint32_t)(pb - pbIdb) + 4;
+    lpcDecPcapngU32(pbIdb + 4, cbBlock);
+    pb = lpcDecPcapngU32(pb, cbBlock);
+
+    fwrite(&abHdr[0], 1, (size_t)(pb - &abHdr[0]), pOut);
+}
+
+
+/**
+ * Prepares the given stream for dumping cycles in the selected output format.
+ *
+ * @returns Status code.
+ * @param   pOut                    The stream to prepare.
+ * @param   ppArrowOut              Where to store the Arrow output stream the cycles are added to instead of
+ *                                  dumping them, NULL for the other formats. It has to be closed with
+ *                                  lpcDecArrowOutClose() before pOut.
+ */
+static int lpcDecCycleDumpStart(FILE *pOut, PLPCDECARROWOUT *ppArrowOut)
+{
+    *ppArrowOut = NULL;
+    if (g_enmOutputFmt == LPCDECOUTFMT_PCAPNG)
+        lpcDecPcapngHdrWrite(pOut);
+    else if (g_enmOutputFmt == LPCDECOUTFMT_ARROW)
+        return lpcDecArrowOutOpen(pOut, g_fArrowStream, g_cArrowBatchCycles, ppArrowOut);
+
+    return 0;
+}
+
+
+/**
+ * Stores the given decoded cycle as an Enhanced Packet Block of LPC_DEC_PCAPNG_EPB_SIZE bytes.
+ *
+ * The packet holds the cycle record described in lpc-dec.lua: version, type, flags, SYNC waits, the address
+ * and sequence number in little endian and the data byte(s).
+ *
+ * @returns Pointer past the stored block.
+ * @param   pb                      Where to store the block.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with (for the SYNC waits), NULL if
+ *                                  the cycle doesn't come from a decoder.
+ * @param   pCycle                  The decoded cycle.
+ */
+static uint8_t *lpcDecCycleDumpPcapngBlock(uint8_t *pb, PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle)
+{
+    /* Without a sample rate the sequence numbers serve as nanoseconds to keep the cycles ordered. */
+    uint64_t uTsNs = g_uSampleRate ? lpcDecSeqNoToNs(pCycle->uSeqNo) : pCycle->uSeqNo;
+
+    pb = lpcDecPcapngU32(pb, LPC_DEC_PCAPNG_BLOCK_EPB);
+    pb = lpcDecPcapngU32(pb, LPC_DEC_PCAPNG_EPB_SIZE);
+    pb = lpcDecPcapngU32(pb, 0); /* Interface ID. */
+    pb = lpcDecPcapngU32(pb, (uint32_t)(uTsNs >> 32));
+    pb = lpcDecPcapngU32(pb, (uint32_t)uTsNs);
+    pb = lpcDecPcapngU32(pb, LPC_DEC_PCAPNG_REC_SIZE);
+    pb = lpcDecPcapngU32(pb, LPC_DEC_PCAPNG_REC_SIZE);
+
+    *pb++ = LPC_DEC_PCAPNG_REC_VERSION;
+    *pb++ = pCycle->bTyp;
+    *pb++ =   (pCycle->fWrite ? LPC_DEC_PCAPNG_REC_F_WRITE : 0)
+            | (pCycle->fAbort ? LPC_DEC_PCAPNG_REC_F_ABORT : 0);
+    *pb++ = pLpcDec ? (uint8_t)pLpcDec->cSyncWaits : LPC_DEC_PCAPNG_REC_SYNC_WAITS_UNKNOWN;
+    pb = lpcDecPcapngU32(pb, pCycle->u32Addr);
+    pb = lpcDecPcapngU32(pb, (uint32_t)pCycle->uSeqNo);
+    pb = lpcDecPcapngU32(pb, (uint32_t)(pCycle->uSeqNo >> 32));
+    *pb++ = pCycle->bData;
+    memset(pb, 0, (size_t)(-LPC_DEC_PCAPNG_REC_SIZE & 3));
+    pb += -LPC_DEC_PCAPNG_REC_SIZE & 3;
+
+    return lpcDecPcapngU32(pb, LPC_DEC_PCAPNG_EPB_SIZE);
+}
+
+
+/**
+ * Dumps the given decoded cycle in human readable form.
+ *
+ * Cycles in the Arrow format are added to the Arrow output stream with lpcDecArrowOutCycleAdd() instead.
+ *
+ * @returns nothing.
+ * @param   pOut                    The stream to write to.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with (for the SYNC waits),
+ *                                  NULL if the cycle doesn't come from a decoder.
+ * @param   pCycle                  The decoded cycle.
+ */
+static void lpcDecCycleDump(FILE *pOut, PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle)
+{
+    if (g_enmOutputFmt == LPCDECOUTFMT_JSONL)
+    {
+        lpcDecCycleDumpJsonl(pOut, pLpcDec, pCycle);
+        return;
+    }
+    if (g_enmOutputFmt == LPCDECOUTFMT_PCAPNG)
+    {
+        uint8_t abBlock[LPC_DEC_PCAPNG_EPB_SIZE];
+        lpcDecCycleDumpPcapngBlock(&abBlock[0], pLpcDec, pCycle);
+        fwrite(&abBlock[0], sizeof(abBlock), 1, pOut);
+        return;
+    }
+
+    const char *pszTyp = lpcDecCycTypeToStr(pCycle->bTyp);
+    const char *pszDir = pCycle->fWrite ? "Write" : "Read ";
+
+    fprintf(pOut, "%" PRIu64 ": %s %s 0x%04x: 0x%02x ", pCycle->uSeqNo, pszTyp, pszDir,
+                                                        pCycle->u32Addr, pCycle->bData);
+    if (g_fVerbose && pCycle->u32States)
+    {
+        /* Render the encountered state machine chain. */
+        char achStates[LPC_DEC_STATES_STR_MAX];
+        char *pch = lpcDecStatesFmt(&achStates[0], pCycle->u32States, 0 /*fJson*/);
+        fwrite(&achStates[0], 1, (size_t)(pch - &achStates[0]), pOut);
+        if (pCycle->fAbort)
+            fprintf(pOut, " -> <ABORT>");
+    }
+    else if (pCycle->fAbort)
+        fprintf(pOut, "<ABORT>");
+    fprintf(pOut, "\n");
+}
+
+
+/**
+ * Returns the normalized tuple of the given cycle used for comparing and matching cycles.
+ *
+ * @returns Normalized tuple, type, direction, abort, data and address packed without the sequence number.
+ * @param   pCycle                  The decoded cycle.
+ */
+static inline uint64_t lpcDecCycleKey(PCLPCDECCYCLE pCycle)
+{
+    return   (uint64_t)pCycle->bTyp
+           | ((uint64_t)pCycle->fWrite << 2)
+           | ((uint64_t)pCycle->fAbort << 3)
+           | ((uint64_t)pCycle->bData << 8)
+           | ((uint64_t)pCycle->u32Addr << 16);
+}
+
+
+/**
+ * Mixes the bits of the given value (splitmix64 finalizer).
+ *
+ * @returns Mixed value.
+ * @param   u64                     The value to mix.
+ */
+static inline uint64_t lpcDecHashMix(uint64_t u64)
+{
+    u64 ^= u64 >> 30;
+    u64 *= UINT64_C(0xbf58476d1ce4e5b9);
+    u64 ^= u64 >> 27;
+    u64 *= UINT64_C(0x94d049bb133111eb);
+    u64 ^= u64 >> 31;
+    return u64;
+}
+
+
+/**
+ * Creates a new index/data register pair post-decoder without any pairs configured.
+ *
+ * @returns Status code.
+ * @param   ppIdxDataDec            Where to store the pointer to the post-decoder on success.
+ * @param   pfnRec                  The default callback to call for every emitted record.
+ * @param   pvUser                  Opaque user data to pass to the callback.
+ */
+static int lpcDecIdxDataDecCreate(PLPCDECIDXDATADEC *ppIdxDataDec, PFNLPCDECIDXDATAREC pfnRec, void *pvUser)
+{
+    PLPCDECIDXDATADEC pIdxDataDec = (PLPCDECIDXDATADEC)calloc(1, sizeof(*pIdxDataDec));
+    if (!pIdxDataDec)
+        return ENOMEM;
+
+    pIdxDataDec->cPairs = 0;
+    pIdxDataDec->pfnRec = pfnRec;
+    pIdxDataDec->pvUser = pvUser;
+    *ppIdxDataDec = pIdxDataDec;
+    return 0;
+}
+
+
+/**
+ * Destroys the given index/data register pair post-decoder.
+ *
+ * @returns nothing.
+ * @param   pIdxDataDec             The post-decoder to destroy.
+ */
+static void lpcDecIdxDataDecDestroy(PLPCDECIDXDATADEC pIdxDataDec)
+{
+    free(pIdxDataDec);
+}
+
+
+/**
+ * Adds a new index/data register pair to the given post-decoder.
+ *
+ * @returns Status code.
+ * @param   pIdxDataDec             The post-decoder.
+ * @param   pszName                 Name of the register file, must stay valid for the lifetime of the post-decoder.
+ * @param   u16PortIdx              I/O port of the index register.
+ * @param   u16PortData             I/O port of the data register.
+ * @param   bIdxMask                Mask to apply to values written to the index register.
+ */
+static int lpcDecIdxDataDecAddPair(PLPCDECIDXDATADEC pIdxDataDec, const char *pszName,
+                                   uint16_t u16PortIdx, uint16_t u16PortData, uint8_t bIdxMask)
+{
+    if (   pIdxDataDec->cPairs == LPC_DEC_IDX_DATA_PAIRS_MAX
+        || u16PortIdx == u16PortData
+        || pIdxDataDec->abPortLookup[u16PortIdx]
+        || pIdxDataDec->abPortLookup[u16PortData])
+        return EINVAL;
+
+    PLPCDECIDXDATAPAIR pPair = &pIdxDataDec->aPairs[pIdxDataDec->cPairs];
+    pPair->pszName     = pszName;
+    pPair->u16PortIdx  = u16PortIdx;
+    pPair->u16PortData = u16PortData;
+    pPair->bIdxMask    = bIdxMask;
+    pPair->fIdxValid   = 0;
+    pPair->bIdx        = 0;
+    memset(&pPair->bmShadowValid[0], 0, sizeof(pPair->bmShadowValid));
+    memset(&pPair->abShadow[0], 0, sizeof(pPair->abShadow));
+    pPair->pfnRec      = pIdxDataDec->pfnRec;
+    pPair->pvUser      = pIdxDataDec->pvUser;
+
+    pIdxDataDec->cPairs++;
+    pIdxDataDec->abPortLookup[u16PortIdx]  = (uint8_t)(pIdxDataDec->cPairs << 1);
+    pIdxDataDec->abPortLookup[u16PortData] = (uint8_t)((pIdxDataDec->cPairs << 1) | 1);
+    return 0;
+}
+
+
+/**
+ * Adds an index/data register pair from the given command line specification.
+ *
+ * @returns Status code.
+ * @param   pIdxDataDec             The post-decoder.
+ * @param   pszSpec                 Either the name of a preset or <name>:<index port>:<data port>[:<index mask>].
+ *                                  Must stay valid for the lifetime of the post-decoder.
+ */
+static int lpcDecIdxDataDecAddPairFromSpec(PLPCDECIDXDATADEC pIdxDataDec, char *pszSpec)
+{
+    for (uint32_t i = 0; i < sizeof(g_aIdxDataPresets) / sizeof(g_aIdxDataPresets[0]); i++)
+    {
+        PCLPCDECIDXDATAPRESET pPreset = &g_aIdxDataPresets[i];
+        if (!strcmp(pPreset->pszPreset, pszSpec))
+            return lpcDecIdxDataDecAddPair(pIdxDataDec, pPreset->pszName, pPreset->u16PortIdx,
+                                           pPreset->u16PortData, pPreset->bIdxMask);
+    }
+
+    /* Custom pair, the name gets terminated in place. */
+    char *pszPortIdx = strchr(pszSpec, ':');
+    if (!pszPortIdx || pszPortIdx == pszSpec)
+        return EINVAL;
+    *pszPortIdx++ = '\0';
+
+    char *pszEnd = NULL;
+    unsigned long uPortIdx = strtoul(pszPortIdx, &pszEnd, 0);
+    if (*pszEnd != ':' || uPortIdx > UINT16_MAX)
+        return EINVAL;
+
+    unsigned long uPortData = strtoul(pszEnd + 1, &pszEnd, 0);
+    if ((*pszEnd != ':' && *pszEnd != '\0') || uPortData > UINT16_MAX)
+        return EINVAL;
+
+    unsigned long uIdxMask = 0xff;
+    if (*pszEnd == ':')
+    {
+        uIdxMask = strtoul(pszEnd + 1, &pszEnd, 0);
+        if (*pszEnd != '\0' || uIdxMask > UINT8_MAX)
+            return EINVAL;
+    }
+
+    return lpcDecIdxDataDecAddPair(pIdxDataDec, pszSpec, (uint16_t)uPortIdx, (uint16_t)uPortData, (uint8_t)uIdxMask);
+}
+
+
+/**
+ * Returns the register pair using the given I/O port as its index register.
+ *
+ * @returns Pointer to the register pair or NULL if not found.
+ * @param   pIdxDataDec             The post-decoder.
+ * @param   u16PortIdx              I/O port of the index register.
+ */
+static PLPCDECIDXDATAPAIR lpcDecIdxDataDecQueryPairByPort(PLPCDECIDXDATADEC pIdxDataDec, uint16_t u16PortIdx)
+{
+    uint8_t bLookup = pIdxDataDec->abPortLookup[u16PortIdx];
+    if (   !bLookup
+        || (bLookup & 1))
+        return NULL;
+
+    return &pIdxDataDec->aPairs[(bLookup >> 1) - 1];
+}
+
+
+/**
+ * Replaces the consumer of the records emitted for the given register pair.
+ *
+ * @returns nothing.
+ * @param   pPair                   The register pair.
+ * @param   pfnRec                  The callback to call for every emitted record.
+ * @param   pvUser                  Opaque user data to pass to the callback.
+ */
+static void lpcDecIdxDataPairSetConsumer(PLPCDECIDXDATAPAIR pPair, PFNLPCDECIDXDATAREC pfnRec, void *pvUser)
+{
+    pPair->pfnRec = pfnRec;
+    pPair->pvUser = pvUser;
+}
+
+
+/**
+ * Feeds a decoded cycle to the index/data register pair post-decoder.
+ *
+ * @returns nothing.
+ * @param   pIdxDataDec             The post-decoder.
+ * @param   pCycle                  The decoded cycle.
+ */
+static inline void lpcDecIdxDataDecProcess(PLPCDECIDXDATADEC pIdxDataDec, PCLPCDECCYCLE pCycle)
+{
+    if (   pCycle->bTyp != LPC_DEC_CYC_TYPE_IO
+        || pCycle->fAbort)
+        return;
+
+    uint8_t bLookup = pIdxDataDec->abPortLookup[pCycle->u32Addr & 0xffff];
+    if (!bLookup)
+        return;
+
+    PLPCDECIDXDATAPAIR pPair = &pIdxDataDec->aPairs[(bLookup >> 1) - 1];
+    LPCDECIDXDATAREC Rec;
+    Rec.uSeqNo = pCycle->uSeqNo;
+    Rec.pPair  = pPair;
+    Rec.fWrite = pCycle->fWrite;
+    Rec.bVal   = pCycle->bData;
+    if (!(bLookup & 1))
+    {
+        /* Reading back the index register has no effect on the shadow state. */
+        if (!pCycle->fWrite)
+            return;
+
+        pPair->bIdx      = pCycle->bData & pPair->bIdxMask;
+        pPair->fIdxValid = 1;
+        Rec.fIdx = 1;
+        Rec.bIdx = pPair->bIdx;
+    }
+    else
+    {
+        /* Data register access without a selected index can't be attributed. */
+        if (!pPair->fIdxValid)
+            return;
+
+        pPair->abShadow[pPair->bIdx] = pCycle->bData;
+        pPair->bmShadowValid[pPair->bIdx / 8] |= 1 << (pPair->bIdx % 8);
+        Rec.fIdx = 0;
+        Rec.bIdx = pPair->bIdx;
+    }
+
+    pPair->pfnRec(&Rec, pPair->pvUser);
+}
+
+
+/**
+ * Dumps the final shadow register files of all configured pairs.
+ *
+ * @returns nothing.
+ * @param   pIdxDataDec             The post-decoder.
+ * @param   pOut                    The stream to write to.
+ */
+static void lpcDecIdxDataDecDumpShadow(PCLPCDECIDXDATADEC pIdxDataDec, FILE *pOut)
+{
+    for (uint32_t i = 0; i < pIdxDataDec->cPairs; i++)
+    {
+        PCLPCDECIDXDATAPAIR pPair = &pIdxDataDec->aPairs[i];
+
+        /* Pairs taken over by a dedicated consumer are reported by that consumer. */
+        if (pPair->pfnRec != pIdxDataDec->pfnRec)
+            continue;
+
+        fprintf(pOut, "%s shadow registers (index 0x%02x, data 0x%02x):\n", pPair->pszName,
+                pPair->u16PortIdx, pPair->u16PortData);
+        for (uint32_t idx = 0; idx < 256; idx++)
+        {
+            if (pPair->bmShadowValid[idx / 8] & (1 << (idx % 8)))
+                fprintf(pOut, "    %s[0x%02x] = 0x%02x\n", pPair->pszName, idx, pPair->abShadow[idx]);
+        }
+    }
+}
+
+
+/**
+ * Checks whether the recent index register writes of the given Super I/O form a configuration mode entry key.
+ *
+ * @returns Pointer to the matching key or NULL if none matches.
+ * @param   pSioDec                 The Super I/O decoder state.
+ */
+static PCLPCDECSIOKEY lpcDecSioDecKeyMatch(PCLPCDECSIODEC pSioDec)
+{
+    for (uint32_t i = 0; i < sizeof(g_aSioKeys) / sizeof(g_aSioKeys[0]); i++)
+    {
+        PCLPCDECSIOKEY pKey = &g_aSioKeys[i];
+        if (pKey->cbKey > pSioDec->cKeyHist)
+            continue;
+
+        uint32_t u32Key = 0;
+        for (uint32_t idx = 0; idx < pKey->cbKey; idx++)
+            u32Key = (u32Key << 8) | pKey->abKey[idx];
+
+        uint32_t fMask = pKey->cbKey == 4 ? UINT32_MAX : (UINT32_C(1) << (pKey->cbKey * 8)) - 1;
+        if ((pSioDec->u32KeyHist & fMask) == u32Key)
+            return pKey;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Checks whether the recent index register writes of the given Super I/O could still become a longer entry key.
+ *
+ * @returns Flag whether a longer key starts with the recent index register writes.
+ * @param   pSioDec                 The Super I/O decoder state.
+ * @param   cbMin                   Minimum number of recent writes to consider, the size of the key which matched.
+ */
+static uint8_t lpcDecSioDecKeyIsPrefix(PCLPCDECSIODEC pSioDec, uint32_t cbMin)
+{
+    for (uint32_t i = 0; i < sizeof(g_aSioKeys) / sizeof(g_aSioKeys[0]); i++)
+    {
+        PCLPCDECSIOKEY pKey = &g_aSioKeys[i];
+        for (uint32_t cb = cbMin; cb < pKey->cbKey && cb <= pSioDec->cKeyHist; cb++)
+        {
+            uint32_t u32Prefix = 0;
+            for (uint32_t idx = 0; idx < cb; idx++)
+                u32Prefix = (u32Prefix << 8) | pKey->abKey[idx];
+
+            if ((pSioDec->u32KeyHist & ((UINT32_C(1) << (cb * 8)) - 1)) == u32Prefix)
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * Enters the configuration mode of the given Super I/O.
+ *
+ * @returns nothing.
+ * @param   pSioDec                 The Super I/O decoder state.
+ * @param   pKey                    The key used.
+ * @param   uSeqNo                  Sequence number of the index write completing the key.
+ */
+static void lpcDecSioDecEnter(PLPCDECSIODEC pSioDec, PCLPCDECSIOKEY pKey, uint64_t uSeqNo)
+{
+    pSioDec->cCfgEntries++;
+    pSioDec->pKey        = pKey;
+    pSioDec->pKeyLast    = pKey;
+    pSioDec->pKeyPending = NULL;
+    fprintf(pSioDec->pOut, "%" PRIu64 ": %s enter configuration mode (%s key)\n", uSeqNo,
+            pSioDec->pPair->pszName, pKey->pszVendor);
+}
+
+
+/**
+ * Index/data pair record callback reconstructing the Super I/O configuration space.
+ *
+ * @returns nothing.
+ * @param   pRec                    The record.
+ * @param   pvUser                  The Super I/O decoder state.
+ */
+static void lpcDecSioDecRec(PCLPCDECIDXDATAREC pRec, void *pvUser)
+{
+    PLPCDECSIODEC pSioDec = (PLPCDECSIODEC)pvUser;
+    const char *pszName = pSioDec->pPair->pszName;
+
+    /* Anything but the index write completing the longer key settles a pending key. */
+    if (   pSioDec->pKeyPending
+        && !pRec->fIdx)
+        lpcDecSioDecEnter(pSioDec, pSioDec->pKeyPending, pSioDec->uSeqNoPending);
+
+    if (pRec->fIdx)
+    {
+        pSioDec->u32KeyHist = (pSioDec->u32KeyHist << 8) | pRec->bVal;
+        if (pSioDec->cKeyHist < 4)
+            pSioDec->cKeyHist++;
+
+        /*
+         * A key which is a part of a longer one (the ITE key contains the SMSC one) only counts once the
+         * following index write shows the longer key isn't coming, so the entry is logged once with the right key.
+         */
+        PCLPCDECSIOKEY pKey = lpcDecSioDecKeyMatch(pSioDec);
+        if (pSioDec->pKeyPending)
+        {
+            if (   pKey
+                && pKey->cbKey > pSioDec->pKeyPending->cbKey)
+            {
+                lpcDecSioDecEnter(pSioDec, pKey, pRec->uSeqNo);
+                return;
+            }
+            lpcDecSioDecEnter(pSioDec, pSioDec->pKeyPending, pSioDec->uSeqNoPending);
+        }
+
+        /* Single byte keys are only honored outside of the configuration mode. */
+        if (   pKey
+            && !pSioDec->pKey)
+        {
+            if (lpcDecSioDecKeyIsPrefix(pSioDec, pKey->cbKey))
+            {
+                pSioDec->pKeyPending   = pKey;
+                pSioDec->uSeqNoPending = pRec->uSeqNo;
+            }
+            else
+                lpcDecSioDecEnter(pSioDec, pKey, pRec->uSeqNo);
+        }
+        else if (   pKey
+                 && pKey->cbKey > 1
+                 && pKey != pSioDec->pKey)
+        {
+            /* Already in the configuration mode, the other key only tells which chip this is. */
+            pSioDec->pKey     = pKey;
+            pSioDec->pKeyLast = pKey;
+        }
+        else if (   pSioDec->pKey
+                 && !pSioDec->pKey->fExitCfgCtrl
+                 && pRec->bVal == LPC_DEC_SIO_EXIT_KEY)
+        {
+            pSioDec->pKey = NULL;
+            fprintf(pSioDec->pOut, "%" PRIu64 ": %s exit configuration mode\n", pRec->uSeqNo, pszName);
+        }
+        return;
+    }
+
+    if (!pSioDec->pKey)
+    {
+        pSioDec->cAccessesOutsideCfg++;
+        return;
+    }
+
+    uint8_t fFlag = pRec->fWrite ? LPC_DEC_SIO_REG_F_WRITTEN : LPC_DEC_SIO_REG_F_READ;
+    const char *pszDir = pRec->fWrite ? "<-" : "->";
+    if (pRec->bIdx < LPC_DEC_SIO_REG_LDN_FIRST)
+    {
+        pSioDec->abGlobal[pRec->bIdx]       = pRec->bVal;
+        pSioDec->abGlobalFlags[pRec->bIdx] |= fFlag;
+
+        if (   pRec->fWrite
+            && pRec->bIdx == LPC_DEC_SIO_REG_LDN)
+        {
+            pSioDec->bLdn = pRec->bVal;
+            fprintf(pSioDec->pOut, "%" PRIu64 ": %s [0x%02x] %s 0x%02x (select LDN 0x%02x)\n", pRec->uSeqNo,
+                    pszName, pRec->bIdx, pszDir, pRec->bVal, pRec->bVal);
+        }
+        else
+            fprintf(pSioDec->pOut, "%" PRIu64 ": %s [0x%02x] %s 0x%02x\n", pRec->uSeqNo,
+                    pszName, pRec->bIdx, pszDir, pRec->bVal);
+
+        if (   pRec->fWrite
+            && pRec->bIdx == LPC_DEC_SIO_REG_ITE_CFG_CTRL
+            && pSioDec->pKey->fExitCfgCtrl
+            && (pRec->bVal & 0x2))
+        {
+            pSioDec->pKey = NULL;
+            fprintf(pSioDec->pOut, "%" PRIu64 ": %s exit configuration mode\n", pRec->uSeqNo, pszName);
+        }
+    }
+    else
+    {
+        uint32_t idxReg = pRec->bIdx - LPC_DEC_SIO_REG_LDN_FIRST;
+        pSioDec->aabLdn[pSioDec->bLdn][idxReg]       = pRec->bVal;
+        pSioDec->aabLdnFlags[pSioDec->bLdn][idxReg] |= fFlag;
+        fprintf(pSioDec->pOut, "%" PRIu64 ": %s LDN 0x%02x [0x%02x] %s 0x%02x\n", pRec->uSeqNo,
+                pszName, pSioDec->bLdn, pRec->bIdx, pszDir, pRec->bVal);
+    }
+}
+
+
+/**
+ * Dumps a single Super I/O shadow register.
+ *
+ * @returns nothing.
+ * @param   pOut                    The stream to write to.
+ * @param   bReg                    The register index.
+ * @param   bVal                    The register value.
+ * @param   fFlags                  The register flags (LPC_DEC_SIO_REG_F_XXX).
+ */
+static void lpcDecSioDecDumpReg(FILE *pOut, uint8_t bReg, uint8_t bVal, uint8_t fFlags)
+{
+    fprintf(pOut, "        [0x%02x] = 0x%02x%s\n", bReg, bVal,
+            (fFlags & LPC_DEC_SIO_REG_F_WRITTEN) ? "" : " (read)");
+}
+
+
+/**
+ * Dumps the final reconstructed Super I/O configuration space.
+ *
+ * @returns nothing.
+ * @param   pSioDec                 The Super I/O decoder state.
+ */
+static void lpcDecSioDecDumpConfig(PLPCDECSIODEC pSioDec)
+{
+    FILE *pOut = pSioDec->pOut;
+
+    /* The capture may end right after a key which could have become a longer one. */
+    if (pSioDec->pKeyPending)
+        lpcDecSioDecEnter(pSioDec, pSioDec->pKeyPending, pSioDec->uSeqNoPending);
+
+    fprintf(pOut, "%s configuration (entered %" PRIu64 " times, last key %s, %" PRIu64 " accesses outside configuration mode):\n",
+            pSioDec->pPair->pszName, pSioDec->cCfgEntries, pSioDec->pKeyLast ? pSioDec->pKeyLast->pszVendor : "<none>",
+            pSioDec->cAccessesOutsideCfg);
+
+    fprintf(pOut, "    Global:\n");
+    for (uint32_t idxReg = 0; idxReg < LPC_DEC_SIO_REG_LDN_FIRST; idxReg++)
+    {
+        if (pSioDec->abGlobalFlags[idxReg])
+            lpcDecSioDecDumpReg(pOut, (uint8_t)idxReg, pSioDec->abGlobal[idxReg], pSioDec->abGlobalFlags[idxReg]);
+    }
+
+    for (uint32_t idxLdn = 0; idxLdn < LPC_DEC_SIO_LDN_COUNT; idxLdn++)
+    {
+        uint8_t fHdr = 0;
+        for (uint32_t idxReg = 0; idxReg < LPC_DEC_SIO_LDN_REG_COUNT; idxReg++)
+        {
+            if (!pSioDec->aabLdnFlags[idxLdn][idxReg])
+                continue;
+
+            if (!fHdr)
+            {
+                fprintf(pOut, "    LDN 0x%02x:\n", idxLdn);
+                fHdr = 1;
+            }
+            lpcDecSioDecDumpReg(pOut, (uint8_t)(idxReg + LPC_DEC_SIO_REG_LDN_FIRST), pSioDec->aabLdn[idxLdn][idxReg],
+                                pSioDec->aabLdnFlags[idxLdn][idxReg]);
+        }
+    }
+}
+
+
+/**
+ * Creates a new IPMI KCS interface post-decoder.
+ *
+ * @returns Status code.
+ * @param   ppKcsDec                Where to store the pointer to the post-decoder on success.
+ * @param   u16PortData             I/O port of the KCS data register.
+ * @param   pOut                    The stream to log the message exchanges to.
+ */
+static int lpcDecKcsDecCreate(PLPCDECKCSDEC *ppKcsDec, uint16_t u16PortData, FILE *pOut)
+{
+    PLPCDECKCSDEC pKcsDec = (PLPCDECKCSDEC)calloc(1, sizeof(*pKcsDec));
+    if (!pKcsDec)
+        return ENOMEM;
+
+    pKcsDec->u16PortData = u16PortData;
+    pKcsDec->pOut        = pOut;
+    pKcsDec->enmPhase    = LPCDECKCSPHASE_IDLE;
+    pKcsDec->cSamplesMin = UINT64_MAX;
+    *ppKcsDec = pKcsDec;
+    return 0;
+}
+
+
+/**
+ * Destroys the given IPMI KCS interface post-decoder.
+ *
+ * @returns nothing.
+ * @param   pKcsDec                 The post-decoder to destroy.
+ */
+static void lpcDecKcsDecDestroy(PLPCDECKCSDEC pKcsDec)
+{
+    free(pKcsDec);
+}
+
+
+/**
+ * Appends the given bytes as hex to the line buffer of the KCS post-decoder.
+ *
+ * @returns New offset into the line buffer.
+ * @param   pKcsDec                 The post-decoder.
+ * @param   offLine                 Where to start appending.
+ * @param   pbData                  The bytes to append.
+ * @param   cbData                  Number of bytes to append.
+ */
+static size_t lpcDecKcsDecLineAppendHex(PLPCDECKCSDEC pKcsDec, size_t offLine, const uint8_t *pbData, uint32_t cbData)
+{
+    static const char s_achHex[] = "0123456789abcdef";
+
+    pKcsDec->achLine[offLine++] = '[';
+    for (uint32_t i = 0; i < cbData; i++)
+    {
+        if (i)
+            pKcsDec->achLine[offLine++] = ' ';
+        pKcsDec->achLine[offLine++] = s_achHex[pbData[i] >> 4];
+        pKcsDec->achLine[offLine++] = s_achHex[pbData[i] & 0xf];
+    }
+    pKcsDec->achLine[offLine++] = ']';
+    return offLine;
+}
+
+
+/**
+ * Logs the current message exchange of the KCS post-decoder and resets it.
+ *
+ * @returns nothing.
+ * @param   pKcsDec                 The post-decoder.
+ * @param   pszAbortReason          Why the exchange was aborted, NULL if it completed successfully.
+ * @param   uSeqNo                  Sequence number of the cycle completing or aborting the exchange.
+ */
+static void lpcDecKcsDecMsgLog(PLPCDECKCSDEC pKcsDec, const char *pszAbortReason, uint64_t uSeqNo)
+{
+    PLPCDECKCSMSG pMsg = &pKcsDec->Msg;
+    size_t cbLine = sizeof(pKcsDec->achLine);
+    size_t offLine = 0;
+
+    pMsg->uSeqNoEnd = uSeqNo;
+    uint64_t cSamples = pMsg->uSeqNoEnd - pMsg->uSeqNoStart;
+
+    offLine += (size_t)snprintf(&pKcsDec->achLine[offLine], cbLine - offLine, "%" PRIu64 ": KCS ", pMsg->uSeqNoStart);
+    if (pMsg->cbReq >= 2)
+    {
+        uint8_t bNetFn = pMsg->abReq[0] >> 2;
+        const char *pszNetFn =   (bNetFn >> 1) < sizeof(g_apszIpmiNetFn) / sizeof(g_apszIpmiNetFn[0])
+                               ? g_apszIpmiNetFn[bNetFn >> 1]
+                               : bNetFn >= 0x30 ? "OEM" : "Other";
+        offLine += (size_t)snprintf(&pKcsDec->achLine[offLine], cbLine - offLine, "NetFn 0x%02x (%s) Cmd 0x%02x ",
+                                    bNetFn, pszNetFn, pMsg->abReq[1]);
+    }
+    if (pMsg->cbRsp >= 3 && !pszAbortReason)
+        offLine += (size_t)snprintf(&pKcsDec->achLine[offLine], cbLine - offLine, "CC 0x%02x ", pMsg->abRsp[2]);
+
+    offLine += (size_t)snprintf(&pKcsDec->achLine[offLine], cbLine - offLine, "req ");
+    offLine = lpcDecKcsDecLineAppendHex(pKcsDec, offLine, &pMsg->abReq[0], pMsg->cbReq);
+    offLine += (size_t)snprintf(&pKcsDec->achLine[offLine], cbLine - offLine, " rsp ");
+    offLine = lpcDecKcsDecLineAppendHex(pKcsDec, offLine, &pMsg->abRsp[0], pMsg->cbRsp);
+
+    if (g_uSampleRate)
+        offLine += (size_t)snprintf(&pKcsDec->achLine[offLine], cbLine - offLine, " at %.9fs took %.3fus",
+                                    (double)pMsg->uSeqNoStart / (double)g_uSampleRate,
+                                    (double)cSamples * 1000000.0 / (double)g_uSampleRate);
+    else
+        offLine += (size_t)snprintf(&pKcsDec->achLine[offLine], cbLine - offLine, " took %" PRIu64 " samples", cSamples);
+
+    if (pMsg->fTruncated)
+        offLine += (size_t)snprintf(&pKcsDec->achLine[offLine], cbLine - offLine, " <TRUNCATED>");
+    if (pszAbortReason)
+        offLine += (size_t)snprintf(&pKcsDec->achLine[offLine], cbLine - offLine, " <ABORTED: %s>", pszAbortReason);
+    pKcsDec->achLine[offLine++] = '\n';
+    fwrite(&pKcsDec->achLine[0], 1, offLine, pKcsDec->pOut);
+
+    if (pszAbortReason)
+        pKcsDec->cMsgsAborted++;
+    else
+    {
+        pKcsDec->cMsgs++;
+        pKcsDec->cSamplesTotal += cSamples;
+        if (cSamples < pKcsDec->cSamplesMin)
+            pKcsDec->cSamplesMin = cSamples;
+        if (cSamples > pKcsDec->cSamplesMax)
+            pKcsDec->cSamplesMax = cSamples;
+    }
+
+    pKcsDec->enmPhase = LPCDECKCSPHASE_IDLE;
+}
+
+
+/**
+ * Appends a byte to the given message buffer.
+ *
+ * @returns nothing.
+ * @param   pMsg                    The message exchange.
+ * @param   pab                     The buffer to append to.
+ * @param   pcb                     The number of bytes in the buffer, updated on success.
+ * @param   bVal                    The byte to append.
+ */
+static inline void lpcDecKcsMsgAppend(PLPCDECKCSMSG pMsg, uint8_t *pab, uint32_t *pcb, uint8_t bVal)
+{
+    if (*pcb < LPC_DEC_KCS_MSG_MAX)
+        pab[(*pcb)++] = bVal;
+    else
+        pMsg->fTruncated = 1;
+}
+
+
+/**
+ * Feeds a decoded cycle to the IPMI KCS interface post-decoder.
+ *
+ * @returns nothing.
+ * @param   pKcsDec                 The post-decoder.
+ * @param   pCycle                  The decoded cycle.
+ */
+static void lpcDecKcsDecProcess(PLPCDECKCSDEC pKcsDec, PCLPCDECCYCLE pCycle)
+{
+    if (   pCycle->bTyp != LPC_DEC_CYC_TYPE_IO
+        || pCycle->fAbort
+        || pCycle->u32Addr - pKcsDec->u16PortData > 1)
+        return;
+
+    PLPCDECKCSMSG pMsg = &pKcsDec->Msg;
+    if (pCycle->u32Addr != pKcsDec->u16PortData)
+    {
+        /* Status/command register. */
+        if (!pCycle->fWrite)
+        {
+            pKcsDec->bStsLast  = pCycle->bData;
+            pKcsDec->fStsValid = 1;
+            if (   LPC_DEC_KCS_STS_STATE_GET(pCycle->bData) == LPC_DEC_KCS_STS_STATE_ERROR
+                && pKcsDec->enmPhase != LPCDECKCSPHASE_IDLE)
+                lpcDecKcsDecMsgLog(pKcsDec, "BMC in error state", pCycle->uSeqNo);
+            return;
+        }
+
+        switch (pCycle->bData)
+        {
+            case LPC_DEC_KCS_CTRL_WRITE_START:
+                if (pKcsDec->enmPhase != LPCDECKCSPHASE_IDLE)
+                    lpcDecKcsDecMsgLog(pKcsDec, "restarted", pCycle->uSeqNo);
+                pMsg->uSeqNoStart = pCycle->uSeqNo;
+                pMsg->uSeqNoReq   = pCycle->uSeqNo;
+                pMsg->uSeqNoEnd   = pCycle->uSeqNo;
+                pMsg->cbReq       = 0;
+                pMsg->cbRsp       = 0;
+                pMsg->fTruncated  = 0;
+                pKcsDec->enmPhase = LPCDECKCSPHASE_WRITE;
+                break;
+            case LPC_DEC_KCS_CTRL_WRITE_END:
+                if (pKcsDec->enmPhase == LPCDECKCSPHASE_WRITE)
+                    pKcsDec->enmPhase = LPCDECKCSPHASE_WRITE_END;
+                break;
+            case LPC_DEC_KCS_CTRL_GET_STATUS_ABORT:
+                if (pKcsDec->enmPhase != LPCDECKCSPHASE_IDLE)
+                    lpcDecKcsDecMsgLog(pKcsDec, "host abort", pCycle->uSeqNo);
+                break;
+            default:
+                break;
+        }
+        return;
+    }
+
+    /* Data register. */
+    switch (pKcsDec->enmPhase)
+    {
+        case LPCDECKCSPHASE_WRITE:
+            if (pCycle->fWrite)
+                lpcDecKcsMsgAppend(pMsg, &pMsg->abReq[0], &pMsg->cbReq, pCycle->bData);
+            break;
+        case LPCDECKCSPHASE_WRITE_END:
+            if (pCycle->fWrite)
+            {
+                lpcDecKcsMsgAppend(pMsg, &pMsg->abReq[0], &pMsg->cbReq, pCycle->bData);
+                pMsg->uSeqNoReq    = pCycle->uSeqNo;
+                pKcsDec->enmPhase  = LPCDECKCSPHASE_READ;
+                pKcsDec->fStsValid = 0;
+            }
+            break;
+        case LPCDECKCSPHASE_READ:
+            /* Writes are the READ control code acknowledging a byte, a read in IDLE_STATE is the final dummy byte. */
+            if (!pCycle->fWrite)
+            {
+                if (   pKcsDec->fStsValid
+                    && LPC_DEC_KCS_STS_STATE_GET(pKcsDec->bStsLast) == LPC_DEC_KCS_STS_STATE_IDLE)
+                    lpcDecKcsDecMsgLog(pKcsDec, NULL /*pszAbortReason*/, pCycle->uSeqNo);
+                else
+                    lpcDecKcsMsgAppend(pMsg, &pMsg->abRsp[0], &pMsg->cbRsp, pCycle->bData);
+            }
+            break;
+        case LPCDECKCSPHASE_IDLE:
+        default:
+            break;
+    }
+}
+
+
+/**
+ * Dumps the KCS message exchange statistics.
+ *
+ * @returns nothing.
+ * @param   pKcsDec                 The post-decoder.
+ */
+static void lpcDecKcsDecDumpSummary(PCLPCDECKCSDEC pKcsDec)
+{
+    fprintf(pKcsDec->pOut, "KCS (data 0x%04x): %" PRIu64 " message exchanges, %" PRIu64 " aborted",
+            pKcsDec->u16PortData, pKcsDec->cMsgs, pKcsDec->cMsgsAborted);
+    if (pKcsDec->cMsgs)
+    {
+        if (g_uSampleRate)
+            fprintf(pKcsDec->pOut, ", min/avg/max %.3f/%.3f/%.3fus, total %.3fus",
+                    (double)pKcsDec->cSamplesMin * 1000000.0 / (double)g_uSampleRate,
+                    (double)pKcsDec->cSamplesTotal * 1000000.0 / (double)g_uSampleRate / (double)pKcsDec->cMsgs,
+                    (double)pKcsDec->cSamplesMax * 1000000.0 / (double)g_uSampleRate,
+                    (double)pKcsDec->cSamplesTotal * 1000000.0 / (double)g_uSampleRate);
+        else
+            fprintf(pKcsDec->pOut, ", min/avg/max %" PRIu64 "/%" PRIu64 "/%" PRIu64 " samples, total %" PRIu64 " samples",
+                    pKcsDec->cSamplesMin, pKcsDec->cSamplesTotal / pKcsDec->cMsgs, pKcsDec->cSamplesMax,
+                    pKcsDec->cSamplesTotal);
+    }
+    fprintf(pKcsDec->pOut, "\n");
+}
+
+
+/**
+ * Creates a new empty value index builder.
+ *
+ * @returns Status code.
+ * @param   ppValIdx                Where to store the pointer to the builder on success.
+ */
+static int lpcDecValIdxBuildCreate(PLPCDECVALIDXBUILD *ppValIdx)
+{
+    PLPCDECVALIDXBUILD pValIdx = (PLPCDECVALIDXBUILD)calloc(1, sizeof(*pValIdx));
+    if (!pValIdx)
+        return ENOMEM;
+
+    pValIdx->cSlots  = 1024;
+    pValIdx->paSlots = (PLPCDECVALIDXBUILDADDR)calloc(pValIdx->cSlots, sizeof(*pValIdx->paSlots));
+    if (!pValIdx->paSlots)
+    {
+        free(pValIdx);
+        return ENOMEM;
+    }
+
+    *ppValIdx = pValIdx;
+    return 0;
+}
+
+
+/**
+ * Destroys the given value index builder.
+ *
+ * @returns nothing.
+ * @param   pValIdx                 The builder to destroy.
+ */
+static void lpcDecValIdxBuildDestroy(PLPCDECVALIDXBUILD pValIdx)
+{
+    for (uint32_t i = 0; i < pValIdx->cSlots; i++)
+    {
+        free(pValIdx->paSlots[i].pau64SeqNo);
+        free(pValIdx->paSlots[i].pabVal);
+    }
+    free(pValIdx->paSlots);
+    free(pValIdx);
+}
+
+
+/**
+ * Returns the hash table slot for the given key, either the one holding the key or the free one to insert it into.
+ *
+ * @returns Pointer to the slot.
+ * @param   paSlots                 The hash table.
+ * @param   cSlots                  Number of slots in the hash table, power of two.
+ * @param   u64Key                  The key to look for.
+ */
+static PLPCDECVALIDXBUILDADDR lpcDecValIdxBuildSlotGet(PLPCDECVALIDXBUILDADDR paSlots, uint32_t cSlots, uint64_t u64Key)
+{
+    uint32_t idxSlot = (uint32_t)((u64Key * UINT64_C(0x9e3779b97f4a7c15)) >> 32) & (cSlots - 1);
+    while (   paSlots[idxSlot].cEntriesMax
+           && paSlots[idxSlot].u64Key != u64Key)
+        idxSlot = (idxSlot + 1) & (cSlots - 1);
+
+    return &paSlots[idxSlot];
+}
+
+
+/**
+ * Doubles the hash table of the given value index builder.
+ *
+ * @returns Status code.
+ * @param   pValIdx                 The builder.
+ */
+static int lpcDecValIdxBuildGrow(PLPCDECVALIDXBUILD pValIdx)
+{
+    uint32_t cSlotsNew = pValIdx->cSlots * 2;
+    PLPCDECVALIDXBUILDADDR paSlotsNew = (PLPCDECVALIDXBUILDADDR)calloc(cSlotsNew, sizeof(*paSlotsNew));
+    if (!paSlotsNew)
+        return ENOMEM;
+
+    for (uint32_t i = 0; i < pValIdx->cSlots; i++)
+    {
+        if (pValIdx->paSlots[i].cEntriesMax)
+            *lpcDecValIdxBuildSlotGet(paSlotsNew, cSlotsNew, pValIdx->paSlots[i].u64Key) = pValIdx->paSlots[i];
+    }
+
+    free(pValIdx->paSlots);
+    pValIdx->paSlots = paSlotsNew;
+    pValIdx->cSlots  = cSlotsNew;
+    return 0;
+}
+
+
+/**
+ * Records a decoded cycle in the value index if it is a completed write.
+ *
+ * @returns nothing.
+ * @param   pValIdx                 The builder.
+ * @param   pCycle                  The decoded cycle.
+ */
+static void lpcDecValIdxBuildProcess(PLPCDECVALIDXBUILD pValIdx, PCLPCDECCYCLE pCycle)
+{
+    if (   !pCycle->fWrite
+        || pCycle->fAbort
+        || pValIdx->rcAlloc)
+        return;
+
+    uint64_t u64Key = LPC_DEC_VAL_IDX_KEY(pCycle->bTyp, pCycle->u32Addr);
+    PLPCDECVALIDXBUILDADDR pAddr = lpcDecValIdxBuildSlotGet(pValIdx->paSlots, pValIdx->cSlots, u64Key);
+    if (!pAddr->cEntriesMax)
+    {
+        /* New address, keep the load factor below 50%. */
+        if ((pValIdx->cAddrs + 1) * 2 > pValIdx->cSlots)
+        {
+            pValIdx->rcAlloc = lpcDecValIdxBuildGrow(pValIdx);
+            if (pValIdx->rcAlloc)
+                return;
+            pAddr = lpcDecValIdxBuildSlotGet(pValIdx->paSlots, pValIdx->cSlots, u64Key);
+        }
+
+        pAddr->pau64SeqNo = (uint64_t *)malloc(16 * sizeof(uint64_t));
+        pAddr->pabVal     = (uint8_t *)malloc(16);
+        if (!pAddr->pau64SeqNo || !pAddr->pabVal)
+        {
+            free(pAddr->pau64SeqNo);
+            free(pAddr->pabVal);
+            pAddr->pau64SeqNo = NULL;
+            pAddr->pabVal     = NULL;
+            pValIdx->rcAlloc = ENOMEM;
+            return;
+        }
+
+        pAddr->u64Key      = u64Key;
+        pAddr->cEntries    = 0;
+        pAddr->cEntriesMax = 16;
+        pValIdx->cAddrs++;
+    }
+    else if (pAddr->cEntries == pAddr->cEntriesMax)
+    {
+        uint64_t cEntriesMaxNew = pAddr->cEntriesMax * 2;
+        uint64_t *pau64SeqNoNew = (uint64_t *)realloc(pAddr->pau64SeqNo, cEntriesMaxNew * sizeof(uint64_t));
+        if (!pau64SeqNoNew)
+        {
+            pValIdx->rcAlloc = ENOMEM;
+            return;
+        }
+        pAddr->pau64SeqNo = pau64SeqNoNew;
+
+        uint8_t *pabValNew = (uint8_t *)realloc(pAddr->pabVal, cEntriesMaxNew);
+        if (!pabValNew)
+        {
+            pValIdx->rcAlloc = ENOMEM;
+            return;
+        }
+        pAddr->pabVal      = pabValNew;
+        pAddr->cEntriesMax = cEntriesMaxNew;
+    }
+
+    /* Cycles are decoded in order, so the history stays sorted by sequence number. */
+    pAddr->pau64SeqNo[pAddr->cEntries] = pCycle->uSeqNo;
+    pAddr->pabVal[pAddr->cEntries]     = pCycle->bData;
+    pAddr->cEntries++;
+    pValIdx->cEntries++;
+}
+
+
+/**
+ * Compares two value index builder slots by their key, for qsort().
+ *
+ * @returns Negative, zero or positive value like memcmp().
+ * @param   pv1                     Pointer to the first slot pointer.
+ * @param   pv2                     Pointer to the second slot pointer.
+ */
+static int lpcDecValIdxBuildAddrCmp(const void *pv1, const void *pv2)
+{
+    PCLPCDECVALIDXBUILDADDR pAddr1 = *(PCLPCDECVALIDXBUILDADDR const *)pv1;
+    PCLPCDECVALIDXBUILDADDR pAddr2 = *(PCLPCDECVALIDXBUILDADDR const *)pv2;
+
+    if (pAddr1->u64Key < pAddr2->u64Key)
+        return -1;
+    if (pAddr1->u64Key > pAddr2->u64Key)
+        return 1;
+    return 0;
+}
+
+
+/**
+ * Writes the value index to the given file.
+ *
+ * @returns Status code.
+ * @param   pValIdx                 The builder.
+ * @param   pszFilename             The file to write the index to.
+ */
+static int lpcDecValIdxBuildWrite(PLPCDECVALIDXBUILD pValIdx, const char *pszFilename)
+{
+    if (pValIdx->rcAlloc)
+        return pValIdx->rcAlloc;
+
+    PCLPCDECVALIDXBUILDADDR *papAddrs = (PCLPCDECVALIDXBUILDADDR *)calloc(pValIdx->cAddrs + 1, sizeof(*papAddrs));
+    if (!papAddrs)
+        return ENOMEM;
+
+    uint32_t cAddrs = 0;
+    for (uint32_t i = 0; i < pValIdx->cSlots; i++)
+    {
+        if (pValIdx->paSlots[i].cEntriesMax)
+            papAddrs[cAddrs++] = &pValIdx->paSlots[i];
+    }
+    qsort(papAddrs, cAddrs, sizeof(*papAddrs), lpcDecValIdxBuildAddrCmp);
+
+    int rc = 0;
+    FILE *pFile = fopen(pszFilename, "wb");
+    if (pFile)
+    {
+        LPCDECVALIDXHDR Hdr;
+        memset(&Hdr, 0, sizeof(Hdr));
+        memcpy(&Hdr.achMagic[0], LPC_DEC_VAL_IDX_MAGIC, sizeof(Hdr.achMagic));
+        Hdr.u32Version = LPC_DEC_VAL_IDX_VERSION;
+        Hdr.cAddrs     = cAddrs;
+        Hdr.cEntries   = pValIdx->cEntries;
+        if (fwrite(&Hdr, sizeof(Hdr), 1, pFile) != 1)
+            rc = EIO;
+
+        uint64_t idxFirst = 0;
+        for (uint32_t i = 0; i < cAddrs && !rc; i++)
+        {
+            LPCDECVALIDXADDR Addr;
+            memset(&Addr, 0, sizeof(Addr));
+            Addr.u32Addr  = (uint32_t)papAddrs[i]->u64Key;
+            Addr.bTyp     = (uint8_t)(papAddrs[i]->u64Key >> 32);
+            Addr.idxFirst = idxFirst;
+            Addr.cEntries = papAddrs[i]->cEntries;
+            if (fwrite(&Addr, sizeof(Addr), 1, pFile) != 1)
+                rc = EIO;
+            idxFirst += papAddrs[i]->cEntries;
+        }
+
+        for (uint32_t i = 0; i < cAddrs && !rc; i++)
+        {
+            if (fwrite(papAddrs[i]->pau64SeqNo, sizeof(uint64_t), papAddrs[i]->cEntries, pFile) != papAddrs[i]->cEntries)
+                rc = EIO;
+        }
+
+        for (uint32_t i = 0; i < cAddrs && !rc; i++)
+        {
+            if (fwrite(papAddrs[i]->pabVal, 1, papAddrs[i]->cEntries, pFile) != papAddrs[i]->cEntries)
+                rc = EIO;
+        }
+
+        if (fclose(pFile) && !rc)
+            rc = EIO;
+    }
+    else
+        rc = errno;
+
+    free(papAddrs);
+    return rc;
+}
+
+
+/**
+ * Returns the bit positions for the given address in a cycle store chunk bloom filter.
+ *
+ * @returns nothing.
+ * @param   u32Addr                 The address.
+ * @param   paidxBits               Where to store the three bit positions.
+ */
+static inline void lpcDecStoreBloomBits(uint32_t u32Addr, uint32_t *paidxBits)
+{
+    uint64_t u64Hash = ((uint64_t)u32Addr + 1) * UINT64_C(0x9e3779b97f4a7c15);
+
+    for (uint32_t i = 0; i < 3; i++)
+        paidxBits[i] = (uint32_t)(u64Hash >> (16 + i * 11)) & (LPC_DEC_STORE_BLOOM_BYTES * 8 - 1);
+}
+
+
+/**
+ * Frees all resources of the given cycle store writer.
+ *
+ * @returns nothing.
+ * @param   pWriter                 The writer to free.
+ */
+static void lpcDecStoreWriterFree(PLPCDECSTOREWRITER pWriter)
+{
+    if (pWriter->pFile)
+        fclose(pWriter->pFile);
+    free(pWriter->pau64SeqNo);
+    free(pWriter->pau32Addr);
+    free(pWriter->pabTypDir);
+    free(pWriter->pabData);
+    free(pWriter->pau32HashIdx);
+    free(pWriter->pau32Dict);
+    free(pWriter->pau16DictIdx);
+    free(pWriter->pbChunk);
+    free(pWriter->paChunks);
+    free(pWriter);
+}
+
+
+/**
+ * Creates a new cycle store writer.
+ *
+ * @returns Status code.
+ * @param   ppWriter                Where to store the pointer to the writer on success.
+ * @param   pszFilename             The store file to create.
+ * @param   cCyclesPerChunk         Maximum number of cycles per chunk.
+ */
+static int lpcDecStoreWriterCreate(PLPCDECSTOREWRITER *ppWriter, const char *pszFilename, uint32_t cCyclesPerChunk)
+{
+    PLPCDECSTOREWRITER pWriter = (PLPCDECSTOREWRITER)calloc(1, sizeof(*pWriter));
+    if (!pWriter)
+        return ENOMEM;
+
+    pWriter->cCyclesPerChunk = cCyclesPerChunk;
+    pWriter->cHashSlots      = 1;
+    while (pWriter->cHashSlots < 2 * cCyclesPerChunk)
+        pWriter->cHashSlots <<= 1;
+
+    pWriter->pau64SeqNo   = (uint64_t *)malloc(cCyclesPerChunk * sizeof(uint64_t));
+    pWriter->pau32Addr    = (uint32_t *)malloc(cCyclesPerChunk * sizeof(uint32_t));
+    pWriter->pabTypDir    = (uint8_t *)malloc(cCyclesPerChunk);
+    pWriter->pabData      = (uint8_t *)malloc(cCyclesPerChunk);
+    pWriter->pau32HashIdx = (uint32_t *)malloc(pWriter->cHashSlots * sizeof(uint32_t));
+    pWriter->pau32Dict    = (uint32_t *)malloc(cCyclesPerChunk * sizeof(uint32_t));
+    pWriter->pau16DictIdx = (uint16_t *)malloc(cCyclesPerChunk * sizeof(uint16_t));
+    /* Dictionary, 16bit indices, type/direction, data and worst case varints. */
+    pWriter->pbChunk      = (uint8_t *)malloc((size_t)cCyclesPerChunk * (4 + 2 + 1 + 1 + 10));
+    if (   !pWriter->pau64SeqNo
+        || !pWriter->pau32Addr
+        || !pWriter->pabTypDir
+        || !pWriter->pabData
+        || !pWriter->pau32HashIdx
+        || !pWriter->pau32Dict
+        || !pWriter->pau16DictIdx
+        || !pWriter->pbChunk)
+    {
+        lpcDecStoreWriterFree(pWriter);
+        return ENOMEM;
+    }
+
+    pWriter->pFile = fopen(pszFilename, "wb");
+    if (!pWriter->pFile)
+    {
+        int rc = errno;
+        lpcDecStoreWriterFree(pWriter);
+        return rc;
+    }
+
+    /* The header gets rewritten when closing the store. */
+    LPCDECSTOREHDR Hdr;
+    memset(&Hdr, 0, sizeof(Hdr));
+    if (fwrite(&Hdr, sizeof(Hdr), 1, pWriter->pFile) != 1)
+    {
+        lpcDecStoreWriterFree(pWriter);
+        return EIO;
+    }
+
+    pWriter->offChunkNext = sizeof(Hdr);
+    *ppWriter = pWriter;
+    return 0;
+}
+
+
+/**
+ * Encodes and writes the current chunk of the given cycle store writer.
+ *
+ * @returns Status code.
+ * @param   pWriter                 The writer.
+ */
+static int lpcDecStoreWriterChunkFlush(PLPCDECSTOREWRITER pWriter)
+{
+    uint32_t cCycles = pWriter->cCycles;
+    if (!cCycles)
+        return 0;
+
+    if (pWriter->cChunks == pWriter->cChunksMax)
+    {
+        uint64_t cChunksMaxNew = pWriter->cChunksMax ? pWriter->cChunksMax * 2 : 64;
+        PLPCDECSTORECHUNK paChunksNew = (PLPCDECSTORECHUNK)realloc(pWriter->paChunks, cChunksMaxNew * sizeof(*paChunksNew));
+        if (!paChunksNew)
+            return ENOMEM;
+        pWriter->paChunks   = paChunksNew;
+        pWriter->cChunksMax = cChunksMaxNew;
+    }
+
+    PLPCDECSTORECHUNK pChunk = &pWriter->paChunks[pWriter->cChunks];
+    memset(pChunk, 0, sizeof(*pChunk));
+    pChunk->offChunk    = pWriter->offChunkNext;
+    pChunk->uSeqNoFirst = pWriter->pau64SeqNo[0];
+    pChunk->uSeqNoLast  = pWriter->pau64SeqNo[cCycles - 1];
+    pChunk->cCycles     = cCycles;
+    pChunk->u32AddrMin  = UINT32_MAX;
+    pChunk->u32AddrMax  = 0;
+
+    /* Build the address dictionary and the summary. */
+    uint32_t cDict = 0;
+    memset(pWriter->pau32HashIdx, 0xff, pWriter->cHashSlots * sizeof(uint32_t));
+    for (uint32_t i = 0; i < cCycles; i++)
+    {
+        uint32_t u32Addr = pWriter->pau32Addr[i];
+        uint32_t idxSlot = (u32Addr * UINT32_C(0x9e3779b1)) & (pWriter->cHashSlots - 1);
+        while (   pWriter->pau32HashIdx[idxSlot] != UINT32_MAX
+               && pWriter->pau32Dict[pWriter->pau32HashIdx[idxSlot]] != u32Addr)
+            idxSlot = (idxSlot + 1) & (pWriter->cHashSlots - 1);
+
+        if (pWriter->pau32HashIdx[idxSlot] == UINT32_MAX)
+        {
+            uint32_t aidxBits[3];
+
+            pWriter->pau32HashIdx[idxSlot] = cDict;
+            pWriter->pau32Dict[cDict++]    = u32Addr;
+            lpcDecStoreBloomBits(u32Addr, &aidxBits[0]);
+            for (uint32_t idxBit = 0; idxBit < 3; idxBit++)
+                pChunk->abBloom[aidxBits[idxBit] / 8] |= 1 << (aidxBits[idxBit] % 8);
+            if (u32Addr < pChunk->u32AddrMin)
+                pChunk->u32AddrMin = u32Addr;
+            if (u32Addr > pChunk->u32AddrMax)
+                pChunk->u32AddrMax = u32Addr;
+        }
+
+        uint8_t bTypDir = pWriter->pabTypDir[i];
+        pWriter->pau16DictIdx[i] = (uint16_t)pWriter->pau32HashIdx[idxSlot];
+        pChunk->bmTypDir |= LPC_DEC_STORE_TYPDIR_BIT(bTypDir & LPC_DEC_STORE_TYPDIR_TYP_MASK,
+                                                     !!(bTypDir & LPC_DEC_STORE_TYPDIR_WRITE));
+        if (bTypDir & LPC_DEC_STORE_TYPDIR_ABORT)
+            pChunk->fAbort = 1;
+    }
+    pChunk->cDictAddrs = cDict;
+
+    /* Encode the columns. */
+    uint8_t *pb = pWriter->pbChunk;
+    memcpy(pb, pWriter->pau32Dict, cDict * sizeof(uint32_t));
+    pb += cDict * sizeof(uint32_t);
+    if (cDict <= 256)
+    {
+        for (uint32_t i = 0; i < cCycles; i++)
+            *pb++ = (uint8_t)pWriter->pau16DictIdx[i];
+    }
+    else
+    {
+        memcpy(pb, pWriter->pau16DictIdx, cCycles * sizeof(uint16_t));
+        pb += cCycles * sizeof(uint16_t);
+    }
+    memcpy(pb, pWriter->pabTypDir, cCycles);
+    pb += cCycles;
+    memcpy(pb, pWriter->pabData, cCycles);
+    pb += cCycles;
+
+    uint64_t uSeqNoPrev = pChunk->uSeqNoFirst;
+    for (uint32_t i = 0; i < cCycles; i++)
+    {
+        uint64_t uDelta = pWriter->pau64SeqNo[i] - uSeqNoPrev;
+        uSeqNoPrev = pWriter->pau64SeqNo[i];
+        while (uDelta >= 0x80)
+        {
+            *pb++ = (uint8_t)(uDelta | 0x80);
+            uDelta >>= 7;
+        }
+        *pb++ = (uint8_t)uDelta;
+    }
+
+    pChunk->cbChunk = (uint32_t)(pb - pWriter->pbChunk);
+    if (fwrite(pWriter->pbChunk, pChunk->cbChunk, 1, pWriter->pFile) != 1)
+        return EIO;
+
+    pWriter->offChunkNext += pChunk->cbChunk;
+    pWriter->cChunks++;
+    pWriter->cCycles = 0;
+    return 0;
+}
+
+
+/**
+ * Adds a decoded cycle to the given cycle store writer.
+ *
+ * @returns nothing.
+ * @param   pWriter                 The writer.
+ * @param   pCycle                  The decoded cycle.
+ */
+static void lpcDecStoreWriterAdd(PLPCDECSTOREWRITER pWriter, PCLPCDECCYCLE pCycle)
+{
+    if (pWriter->rc)
+        return;
+
+    uint32_t idx = pWriter->cCycles++;
+    pWriter->pau64SeqNo[idx] = pCycle->uSeqNo;
+    pWriter->pau32Addr[idx]  = pCycle->u32Addr;
+    pWriter->pabTypDir[idx]  =   (pCycle->bTyp & LPC_DEC_STORE_TYPDIR_TYP_MASK)
+                               | (pCycle->fWrite ? LPC_DEC_STORE_TYPDIR_WRITE : 0)
+                               | (pCycle->fAbort ? LPC_DEC_STORE_TYPDIR_ABORT : 0);
+    pWriter->pabData[idx]    = pCycle->bData;
+    pWriter->cCyclesTotal++;
+
+    if (pWriter->cCycles == pWriter->cCyclesPerChunk)
+        pWriter->rc = lpcDecStoreWriterChunkFlush(pWriter);
+}
+
+
+/**
+ * Finishes the store by writing the remaining cycles, the chunk directory and header and frees the writer.
+ *
+ * @returns Status code.
+ * @param   pWriter                 The writer, invalid afterwards.
+ */
+static int lpcDecStoreWriterClose(PLPCDECSTOREWRITER pWriter)
+{
+    int rc = pWriter->rc;
+    if (!rc)
+        rc = lpcDecStoreWriterChunkFlush(pWriter);
+    if (   !rc
+        && pWriter->cChunks
+        && fwrite(pWriter->paChunks, sizeof(*pWriter->paChunks), pWriter->cChunks, pWriter->pFile) != pWriter->cChunks)
+        rc = EIO;
+    if (!rc)
+    {
+        LPCDECSTOREHDR Hdr;
+        memset(&Hdr, 0, sizeof(Hdr));
+        memcpy(&Hdr.achMagic[0], LPC_DEC_STORE_MAGIC, sizeof(Hdr.achMagic));
+        Hdr.u32Version      = LPC_DEC_STORE_VERSION;
+        Hdr.cCyclesPerChunk = pWriter->cCyclesPerChunk;
+        Hdr.cCycles         = pWriter->cCyclesTotal;
+        Hdr.cChunks         = pWriter->cChunks;
+        Hdr.offDir          = pWriter->offChunkNext;
+        if (   fseek(pWriter->pFile, 0, SEEK_SET)
+            || fwrite(&Hdr, sizeof(Hdr), 1, pWriter->pFile) != 1)
+            rc = EIO;
+    }
+
+    if (fclose(pWriter->pFile) && !rc)
+        rc = EIO;
+    pWriter->pFile = NULL;
+    lpcDecStoreWriterFree(pWriter);
+    return rc;
+}
+
+
+/**
+ * Cycle callback adding the cycle to a cycle store.
+ *
+ * @returns nothing.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with.
+ * @param   pCycle                  The decoded cycle.
+ * @param   pvUser                  The cycle store writer.
+ */
+static void lpcDecStoreWriterCycle(PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle, void *pvUser)
+{
+    (void)pLpcDec;
+    lpcDecStoreWriterAdd((PLPCDECSTOREWRITER)pvUser, pCycle);
+}
+
+
+/**
+ * Checks whether the given chunk can contain cycles matching the filter, judging by its summary alone.
+ *
+ * @returns Flag whether the chunk needs to be read.
+ * @param   pChunk                  The chunk directory entry.
+ * @param   pFilter                 The filter.
+ */
+static uint8_t lpcDecStoreChunkMayMatch(PCLPCDECSTORECHUNK pChunk, PCLPCDECSTOREFILTER pFilter)
+{
+    if (   !(pChunk->bmTypDir & pFilter->bmTypDir)
+        || pChunk->u32AddrMax < pFilter->u32AddrFirst
+        || pChunk->u32AddrMin > pFilter->u32AddrLast
+        || pChunk->uSeqNoLast < pFilter->uSeqNoFirst
+        || pChunk->uSeqNoFirst > pFilter->uSeqNoLast)
+        return 0;
+
+    if (pFilter->u32AddrFirst == pFilter->u32AddrLast)
+    {
+        uint32_t aidxBits[3];
+        lpcDecStoreBloomBits(pFilter->u32AddrFirst, &aidxBits[0]);
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            if (!(pChunk->abBloom[aidxBits[i] / 8] & (1 << (aidxBits[i] % 8))))
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+/**
+ * Dumps or counts all cycles in the given store matching the filter.
+ *
+ * @returns Status code.
+ * @param   pszStore                The cycle store file.
+ * @param   pFilter                 The filter.
+ * @param   fCount                  Flag whether to only count the matching cycles instead of dumping them.
+ */
+static int lpcDecStoreQuery(const char *pszStore, PCLPCDECSTOREFILTER pFilter, uint8_t fCount)
+{
+    FILE *pFile = fopen(pszStore, "rb");
+    if (!pFile)
+        return errno;
+
+    int rc = 0;
+    LPCDECSTOREHDR Hdr;
+    PLPCDECSTORECHUNK paChunks = NULL;
+    uint8_t *pbChunk = NULL;
+    uint8_t *pafDictMatch = NULL;
+    if (   fread(&Hdr, sizeof(Hdr), 1, pFile) != 1
+        || memcmp(&Hdr.achMagic[0], LPC_DEC_STORE_MAGIC, sizeof(Hdr.achMagic))
+        || Hdr.u32Version != LPC_DEC_STORE_VERSION
+        || !Hdr.cCyclesPerChunk
+        || Hdr.cCyclesPerChunk > LPC_DEC_STORE_CHUNK_CYCLES_MAX)
+        rc = EINVAL;
+
+    if (   !rc
+        && Hdr.cChunks > SIZE_MAX / sizeof(*paChunks))
+        rc = EINVAL;
+
+    if (!rc && Hdr.cChunks)
+    {
+        paChunks     = (PLPCDECSTORECHUNK)malloc(Hdr.cChunks * sizeof(*paChunks));
+        pbChunk      = (uint8_t *)malloc((size_t)Hdr.cCyclesPerChunk * (4 + 2 + 1 + 1 + 10));
+        pafDictMatch = (uint8_t *)malloc(Hdr.cCyclesPerChunk);
+        if (!paChunks || !pbChunk || !pafDictMatch)
+            rc = ENOMEM;
+        else if (   fseeko(pFile, (off_t)Hdr.offDir, SEEK_SET)
+                 || fread(paChunks, sizeof(*paChunks), Hdr.cChunks, pFile) != Hdr.cChunks)
+            rc = EIO;
+    }
+
+    uint64_t cMatches = 0;
+    uint64_t cChunksRead = 0;
+    for (uint64_t idxChunk = 0; idxChunk < Hdr.cChunks && !rc; idxChunk++)
+    {
+        PCLPCDECSTORECHUNK pChunk = &paChunks[idxChunk];
+        if (!lpcDecStoreChunkMayMatch(pChunk, pFilter))
+            continue;
+
+        if (   pChunk->cCycles > Hdr.cCyclesPerChunk
+            || pChunk->cDictAddrs > pChunk->cCycles
+            || pChunk->cbChunk > Hdr.cCyclesPerChunk * (4 + 2 + 1 + 1 + 10))
+        {
+            rc = EINVAL;
+            break;
+        }
+
+        if (   fseeko(pFile, (off_t)pChunk->offChunk, SEEK_SET)
+            || fread(pbChunk, pChunk->cbChunk, 1, pFile) != 1)
+        {
+            rc = EIO;
+            break;
+        }
+        cChunksRead++;
+
+        /* The store may be damaged, the fixed size columns have to fit before the varint column. */
+        uint8_t fIdx16 = pChunk->cDictAddrs > 256;
+        uint64_t cbFixed =   (uint64_t)pChunk->cDictAddrs * sizeof(uint32_t)
+                           + (uint64_t)pChunk->cCycles * ((fIdx16 ? 2 : 1) + 1 + 1);
+        if (cbFixed > pChunk->cbChunk)
+        {
+            rc = EINVAL;
+            break;
+        }
+
+        /* Evaluate the address filter once per dictionary entry instead of once per cycle. */
+        const uint8_t *pb = pbChunk;
+        const uint8_t *pbEnd = pbChunk + pChunk->cbChunk;
+        uint8_t fAnyAddr = 0;
+        for (uint32_t i = 0; i < pChunk->cDictAddrs; i++)
+        {
+            uint32_t u32Addr;
+            memcpy(&u32Addr, pb + i * sizeof(uint32_t), sizeof(u32Addr));
+            pafDictMatch[i] = u32Addr >= pFilter->u32AddrFirst && u32Addr <= pFilter->u32AddrLast;
+            fAnyAddr |= pafDictMatch[i];
+        }
+        if (!fAnyAddr)
+            continue;
+
+        const uint8_t *pbDict = pb;
+        pb += pChunk->cDictAddrs * sizeof(uint32_t);
+        const uint8_t *pbIdx = pb;
+        pb += pChunk->cCycles * (fIdx16 ? 2 : 1);
+        const uint8_t *pbTypDir = pb;
+        pb += pChunk->cCycles;
+        const uint8_t *pbData = pb;
+        pb += pChunk->cCycles;
+
+        uint64_t uSeqNo = pChunk->uSeqNoFirst;
+        for (uint32_t i = 0; i < pChunk->cCycles && !rc; i++)
+        {
+            uint64_t uDelta = 0;
+            uint32_t cShift = 0;
+            while (   pb < pbEnd
+                   && (*pb & 0x80)
+                   && cShift < (LPC_DEC_STORE_VARINT_MAX - 1) * 7)
+            {
+                uDelta |= (uint64_t)(*pb++ & 0x7f) << cShift;
+                cShift += 7;
+            }
+            if (   pb == pbEnd
+                || (*pb & 0x80))
+            {
+                rc = EINVAL;
+                break;
+            }
+            uDelta |= (uint64_t)*pb++ << cShift;
+            uSeqNo += uDelta;
+
+            uint32_t idxDict = pbIdx[i];
+            if (fIdx16)
+            {
+                uint16_t u16Idx;
+                memcpy(&u16Idx, pbIdx + i * sizeof(uint16_t), sizeof(u16Idx));
+                idxDict = u16Idx;
+            }
+            if (idxDict >= pChunk->cDictAddrs)
+            {
+                rc = EINVAL;
+                break;
+            }
+
+            uint8_t bTypDir = pbTypDir[i];
+            if (   !pafDictMatch[idxDict]
+                || !(pFilter->bmTypDir & LPC_DEC_STORE_TYPDIR_BIT(bTypDir & LPC_DEC_STORE_TYPDIR_TYP_MASK,
+                                                                  !!(bTypDir & LPC_DEC_STORE_TYPDIR_WRITE)))
+                || uSeqNo < pFilter->uSeqNoFirst
+                || uSeqNo > pFilter->uSeqNoLast)
+                continue;
+
+            cMatches++;
+            if (!fCount)
+            {
+                LPCDECCYCLE Cycle;
+                Cycle.uSeqNo    = uSeqNo;
+                memcpy(&Cycle.u32Addr, pbDict + idxDict * sizeof(uint32_t), sizeof(Cycle.u32Addr));
+                Cycle.bTyp      = bTypDir & LPC_DEC_STORE_TYPDIR_TYP_MASK;
+                Cycle.fWrite    = !!(bTypDir & LPC_DEC_STORE_TYPDIR_WRITE);
+                Cycle.bData     = pbData[i];
+                Cycle.fAbort    = !!(bTypDir & LPC_DEC_STORE_TYPDIR_ABORT);
+                Cycle.u32States = 0; /* The store doesn't keep the state chain. */
+                lpcDecCycleDump(stdout, NULL /*pLpcDec*/, &Cycle);
+            }
+        }
+    }
+
+    if (!rc)
+    {
+        if (fCount)
+            printf("%" PRIu64 "\n", cMatches);
+        fprintf(stderr, "%" PRIu64 " matching cycles, %" PRIu64 " of %" PRIu64 " chunks read\n",
+                cMatches, cChunksRead, Hdr.cChunks);
+    }
+
+    free(pafDictMatch);
+    free(pbChunk);
+    free(paChunks);
+    fclose(pFile);
+    return rc;
+}
+
+
+/**
+ * Cycle callback collecting the cycles of one side of a capture diff.
+ *
+ * @returns nothing.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with.
+ * @param   pCycle                  The decoded cycle.
+ * @param   pvUser                  The diff side.
+ */
+static void lpcDecDiffSideCycle(PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle, void *pvUser)
+{
+    PLPCDECDIFFSIDE pSide = (PLPCDECDIFFSIDE)pvUser;
+    (void)pLpcDec;
+
+    if (pSide->rc)
+        return;
+
+    if (pSide->cCycles == pSide->cCyclesMax)
+    {
+        size_t cCyclesMaxNew = pSide->cCyclesMax ? pSide->cCyclesMax * 2 : 64 * 1024;
+        PLPCDECCYCLE paCyclesNew = (PLPCDECCYCLE)realloc(pSide->paCycles, cCyclesMaxNew * sizeof(*paCyclesNew));
+        if (!paCyclesNew)
+        {
+            pSide->rc = ENOMEM;
+            return;
+        }
+        pSide->paCycles = paCyclesNew;
+
+        uint64_t *pau64KeyNew = (uint64_t *)realloc(pSide->pau64Key, cCyclesMaxNew * sizeof(*pau64KeyNew));
+        if (!pau64KeyNew)
+        {
+            pSide->rc = ENOMEM;
+            return;
+        }
+        pSide->pau64Key   = pau64KeyNew;
+        pSide->cCyclesMax = cCyclesMaxNew;
+    }
+
+    pSide->paCycles[pSide->cCycles] = *pCycle;
+    pSide->pau64Key[pSide->cCycles] = lpcDecCycleKey(pCycle);
+    pSide->cCycles++;
+}
+
+
+/**
+ * Decoder thread for one side of a capture diff.
+ *
+ * @returns NULL.
+ * @param   pvUser                  The diff side.
+ */
+static void *lpcDecDiffSideWorker(void *pvUser)
+{
+    PLPCDECDIFFSIDE pSide = (PLPCDECDIFFSIDE)pvUser;
+
+    int rc = lpcDecDecodeFile(pSide->pszFilename, lpcDecDiffSideCycle, pSide, 0 /*fFollow*/, NULL /*pVcd*/,
+                              NULL /*pClkStats*/, stderr);
+    if (!pSide->rc)
+        pSide->rc = rc;
+    return NULL;
+}
+
+
+/**
+ * Dumps the pending differing span if there is one.
+ *
+ * @returns nothing.
+ * @param   pDiff                   The diff state.
+ */
+static void lpcDecDiffHunkFlush(PLPCDECDIFF pDiff)
+{
+    if (!pDiff->fHunk)
+        return;
+
+    pDiff->fHunk = 0;
+    pDiff->cHunks++;
+    pDiff->cOnlyA += pDiff->cHunkA;
+    pDiff->cOnlyB += pDiff->cHunkB;
+    if (pDiff->cHunks > pDiff->cHunksMax)
+        return;
+
+    PLPCDECDIFFSIDE pA = &pDiff->aSides[0];
+    PLPCDECDIFFSIDE pB = &pDiff->aSides[1];
+    if (pDiff->cHunks == 1)
+    {
+        fprintf(pDiff->pOut, "First divergence at A #%zu", pDiff->idxHunkA);
+        if (pDiff->idxHunkA < pA->cCycles)
+            fprintf(pDiff->pOut, " (seq %" PRIu64 ")", pA->paCycles[pDiff->idxHunkA].uSeqNo);
+        fprintf(pDiff->pOut, ", B #%zu", pDiff->idxHunkB);
+        if (pDiff->idxHunkB < pB->cCycles)
+            fprintf(pDiff->pOut, " (seq %" PRIu64 ")", pB->paCycles[pDiff->idxHunkB].uSeqNo);
+        fprintf(pDiff->pOut, "\n");
+    }
+
+    fprintf(pDiff->pOut, "@@ A #%zu,%zu B #%zu,%zu @@\n", pDiff->idxHunkA, pDiff->cHunkA,
+            pDiff->idxHunkB, pDiff->cHunkB);
+    for (uint32_t idxSide = 0; idxSide < 2; idxSide++)
+    {
+        PLPCDECDIFFSIDE pSide = &pDiff->aSides[idxSide];
+        size_t idxFirst = idxSide ? pDiff->idxHunkB : pDiff->idxHunkA;
+        size_t cCycles = idxSide ? pDiff->cHunkB : pDiff->cHunkA;
+        const char *pszPrefix = idxSide ? "+ " : "- ";
+
+        for (size_t i = 0; i < cCycles && i < pDiff->cLinesMax; i++)
+        {
+            fputs(pszPrefix, pDiff->pOut);
+            lpcDecCycleDump(pDiff->pOut, NULL /*pLpcDec*/, &pSide->paCycles[idxFirst + i]);
+        }
+        if (cCycles > pDiff->cLinesMax)
+            fprintf(pDiff->pOut, "%s... %zu more\n", pszPrefix, cCycles - pDiff->cLinesMax);
+    }
+}
+
+
+/**
+ * Records the next aligned span, spans must be recorded in order.
+ *
+ * @returns nothing.
+ * @param   pDiff                   The diff state.
+ * @param   idxA                    Start of the span in A.
+ * @param   cA                      Number of cycles in A.
+ * @param   idxB                    Start of the span in B.
+ * @param   cB                      Number of cycles in B.
+ * @param   fEqual                  Flag whether the span is equal in both, differing otherwise.
+ */
+static void lpcDecDiffEmit(PLPCDECDIFF pDiff, size_t idxA, size_t cA, size_t idxB, size_t cB, uint8_t fEqual)
+{
+    if (fEqual)
+    {
+        if (cA)
+            lpcDecDiffHunkFlush(pDiff);
+        return;
+    }
+
+    if (!cA && !cB)
+        return;
+
+    if (!pDiff->fHunk)
+    {
+        pDiff->fHunk    = 1;
+        pDiff->idxHunkA = idxA;
+        pDiff->cHunkA   = 0;
+        pDiff->idxHunkB = idxB;
+        pDiff->cHunkB   = 0;
+    }
+    pDiff->cHunkA += cA;
+    pDiff->cHunkB += cB;
+}
+
+
+/**
+ * Aligns the given spans with a classic LCS table, only used for small spans without anchors.
+ *
+ * @returns Status code.
+ * @param   pDiff                   The diff state.
+ * @param   idxA                    Start of the span in A.
+ * @param   cA                      Number of cycles in A.
+ * @param   idxB                    Start of the span in B.
+ * @param   cB                      Number of cycles in B.
+ */
+static int lpcDecDiffLcs(PLPCDECDIFF pDiff, size_t idxA, size_t cA, size_t idxB, size_t cB)
+{
+    const uint64_t *pau64KeyA = &pDiff->aSides[0].pau64Key[idxA];
+    const uint64_t *pau64KeyB = &pDiff->aSides[1].pau64Key[idxB];
+    size_t cCols = cB + 1;
+    uint32_t *pau32Lcs = (uint32_t *)calloc((cA + 1) * cCols, sizeof(uint32_t));
+    if (!pau32Lcs)
+        return ENOMEM;
+
+    /* Length of the LCS of the suffixes A[i..] and B[j..], so the walk below can emit in order. */
+    for (size_t i = cA; i-- > 0;)
+    {
+        for (size_t j = cB; j-- > 0;)
+        {
+            if (pau64KeyA[i] == pau64KeyB[j])
+                pau32Lcs[i * cCols + j] = pau32Lcs[(i + 1) * cCols + j + 1] + 1;
+            else
+            {
+                uint32_t cDown = pau32Lcs[(i + 1) * cCols + j];
+                uint32_t cRight = pau32Lcs[i * cCols + j + 1];
+                pau32Lcs[i * cCols + j] = cDown > cRight ? cDown : cRight;
+            }
+        }
+    }
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < cA && j < cB)
+    {
+        if (pau64KeyA[i] == pau64KeyB[j])
+        {
+            lpcDecDiffEmit(pDiff, idxA + i, 1, idxB + j, 1, 1 /*fEqual*/);
+            i++;
+            j++;
+        }
+        else if (pau32Lcs[(i + 1) * cCols + j] >= pau32Lcs[i * cCols + j + 1])
+        {
+            lpcDecDiffEmit(pDiff, idxA + i, 1, idxB + j, 0, 0 /*fEqual*/);
+            i++;
+        }
+        else
+        {
+            lpcDecDiffEmit(pDiff, idxA + i, 0, idxB + j, 1, 0 /*fEqual*/);
+            j++;
+        }
+    }
+    lpcDecDiffEmit(pDiff, idxA + i, cA - i, idxB + j, cB - j, 0 /*fEqual*/);
+
+    free(pau32Lcs);
+    return 0;
+}
+
+
+/**
+ * Returns the rolling hash of the cK cycles starting at the given position.
+ *
+ * @returns Rolling hash.
+ * @param   pau64Key                The normalized cycle tuples.
+ * @param   idx                     The start position.
+ * @param   cK                      Number of cycles.
+ */
+static inline uint64_t lpcDecDiffRollingInit(const uint64_t *pau64Key, size_t idx, uint32_t cK)
+{
+    uint64_t uHash = 0;
+    for (uint32_t i = 0; i < cK; i++)
+        uHash = uHash * LPC_DEC_DIFF_ROLLING_HASH_MUL + lpcDecHashMix(pau64Key[idx + i]);
+    return uHash;
+}
+
+
+/**
+ * Rolls the hash one cycle forward, from the window starting at idx to the one starting at idx + 1.
+ *
+ * @returns Rolling hash.
+ * @param   uHash                   The hash of the window starting at idx.
+ * @param   pau64Key                The normalized cycle tuples.
+ * @param   idx                     The start of the current window.
+ * @param   cK                      Number of cycles in the window.
+ * @param   uMulTop                 The multiplier of the oldest cycle in the window (ROLLING_HASH_MUL^(cK - 1)).
+ */
+static inline uint64_t lpcDecDiffRollingNext(uint64_t uHash, const uint64_t *pau64Key, size_t idx, uint32_t cK,
+                                             uint64_t uMulTop)
+{
+    uHash -= lpcDecHashMix(pau64Key[idx]) * uMulTop;
+    return uHash * LPC_DEC_DIFF_ROLLING_HASH_MUL + lpcDecHashMix(pau64Key[idx + cK]);
+}
+
+
+/**
+ * Looks up the anchor candidate hash table slot for the given hash.
+ *
+ * @returns Pointer to the slot holding the hash or the free slot to insert it into.
+ * @param   paAnchors               The hash table.
+ * @param   cSlots                  Number of slots, power of two.
+ * @param   uHash                   The hash to look for (non zero).
+ */
+static PLPCDECDIFFANCHOR lpcDecDiffAnchorSlotGet(PLPCDECDIFFANCHOR paAnchors, size_t cSlots, uint64_t uHash)
+{
+    size_t idxSlot = (size_t)lpcDecHashMix(uHash) & (cSlots - 1);
+    while (   paAnchors[idxSlot].uHash
+           && paAnchors[idxSlot].uHash != uHash)
+        idxSlot = (idxSlot + 1) & (cSlots - 1);
+    return &paAnchors[idxSlot];
+}
+
+
+/**
+ * Finds the chain of anchors to align the given spans with.
+ *
+ * Anchors are runs of cK cycles occuring exactly once in both spans. For large spans only the runs whose hash
+ * falls into a sample class are considered; as the class only depends on the content, both sides sample the
+ * same runs. The longest chain of anchors which is increasing in both spans is returned.
+ *
+ * @returns Status code.
+ * @param   pDiff                   The diff state.
+ * @param   a0                      Start of the span in A.
+ * @param   a1                      End of the span in A (exclusive).
+ * @param   b0                      Start of the span in B.
+ * @param   b1                      End of the span in B (exclusive).
+ * @param   cK                      Number of cycles per anchor.
+ * @param   ppaidxA                 Where to store the array of anchor positions in A, free with free().
+ * @param   ppaidxB                 Where to store the array of anchor positions in B, free with free().
+ * @param   pcAnchors               Where to store the number of anchors in the chain.
+ */
+static int lpcDecDiffAnchorsFind(PLPCDECDIFF pDiff, size_t a0, size_t a1, size_t b0, size_t b1, uint32_t cK,
+                                 size_t **ppaidxA, size_t **ppaidxB, size_t *pcAnchors)
+{
+    const uint64_t *pau64KeyA = pDiff->aSides[0].pau64Key;
+    const uint64_t *pau64KeyB = pDiff->aSides[1].pau64Key;
+
+    *ppaidxA   = NULL;
+    *ppaidxB   = NULL;
+    *pcAnchors = 0;
+    if (a1 - a0 < cK || b1 - b0 < cK)
+        return 0;
+
+    size_t cWndA = a1 - a0 - cK + 1;
+    size_t cWndB = b1 - b0 - cK + 1;
+    uint64_t uSample = (cWndA + cWndB) / LPC_DEC_DIFF_ANCHOR_SAMPLES_MAX + 1;
+    size_t cSlots = 1024;
+    while (cSlots < 4 * (cWndA / uSample + 1))
+        cSlots <<= 1;
+    size_t cSlotsUsedMax = cSlots / 4 * 3;
+
+    uint64_t uMulTop = 1;
+    for (uint32_t i = 1; i < cK; i++)
+        uMulTop *= LPC_DEC_DIFF_ROLLING_HASH_MUL;
+
+    PLPCDECDIFFANCHOR paAnchors = (PLPCDECDIFFANCHOR)calloc(cSlots, sizeof(*paAnchors));
+    if (!paAnchors)
+        return ENOMEM;
+
+    /* Count the sampled windows of A... */
+    size_t cSlotsUsed = 0;
+    uint64_t uHash = lpcDecDiffRollingInit(pau64KeyA, a0, cK);
+    for (size_t idx = a0; idx < a0 + cWndA; idx++)
+    {
+        if (idx != a0)
+            uHash = lpcDecDiffRollingNext(uHash, pau64KeyA, idx - 1, cK, uMulTop);
+
+        uint64_t uHashSlot = uHash ? uHash : 1;
+        if (lpcDecHashMix(uHashSlot ^ UINT64_C(0x5bd1e995)) % uSample)
+            continue;
+
+        PLPCDECDIFFANCHOR pAnchor = lpcDecDiffAnchorSlotGet(paAnchors, cSlots, uHashSlot);
+        if (!pAnchor->uHash)
+        {
+            if (cSlotsUsed == cSlotsUsedMax)
+                continue;
+            pAnchor->uHash = uHashSlot;
+            pAnchor->idxA  = idx;
+            cSlotsUsed++;
+        }
+        pAnchor->cA++;
+    }
+
+    /* ... and of B... */
+    uHash = lpcDecDiffRollingInit(pau64KeyB, b0, cK);
+    for (size_t idx = b0; idx < b0 + cWndB; idx++)
+    {
+        if (idx != b0)
+            uHash = lpcDecDiffRollingNext(uHash, pau64KeyB, idx - 1, cK, uMulTop);
+
+        uint64_t uHashSlot = uHash ? uHash : 1;
+        if (lpcDecHashMix(uHashSlot ^ UINT64_C(0x5bd1e995)) % uSample)
+            continue;
+
+        PLPCDECDIFFANCHOR pAnchor = lpcDecDiffAnchorSlotGet(paAnchors, cSlots, uHashSlot);
+        if (pAnchor->uHash)
+        {
+            if (!pAnchor->cB)
+                pAnchor->idxB = idx;
+            pAnchor->cB++;
+        }
+    }
+
+    /* ... and collect the unique ones in the order of A. */
+    size_t cCand = 0;
+    size_t cCandMax = 0;
+    size_t *paidxCandA = NULL;
+    size_t *paidxCandB = NULL;
+    int rc = 0;
+    for (size_t i = 0; i < cSlots; i++)
+    {
+        if (paAnchors[i].cA == 1 && paAnchors[i].cB == 1)
+            cCandMax++;
+    }
+
+    if (cCandMax)
+    {
+        paidxCandA = (size_t *)malloc(cCandMax * sizeof(size_t));
+        paidxCandB = (size_t *)malloc(cCandMax * sizeof(size_t));
+        if (paidxCandA && paidxCandB)
+        {
+            uHash = lpcDecDiffRollingInit(pau64KeyA, a0, cK);
+            for (size_t idx = a0; idx < a0 + cWndA; idx++)
+            {
+                if (idx != a0)
+                    uHash = lpcDecDiffRollingNext(uHash, pau64KeyA, idx - 1, cK, uMulTop);
+
+                uint64_t uHashSlot = uHash ? uHash : 1;
+                if (lpcDecHashMix(uHashSlot ^ UINT64_C(0x5bd1e995)) % uSample)
+                    continue;
+
+                PLPCDECDIFFANCHOR pAnchor = lpcDecDiffAnchorSlotGet(paAnchors, cSlots, uHashSlot);
+                if (   pAnchor->cA == 1
+                    && pAnchor->cB == 1
+                    && !memcmp(&pau64KeyA[idx], &pau64KeyB[pAnchor->idxB], cK * sizeof(uint64_t)))
+                {
+                    paidxCandA[cCand] = idx;
+                    paidxCandB[cCand] = pAnchor->idxB;
+                    cCand++;
+                }
+            }
+        }
+        else
+            rc = ENOMEM;
+    }
+    free(paAnchors);
+
+    /* Longest chain increasing in B (patience sorting). */
+    size_t *paidxTail = NULL;
+    size_t *paidxPrev = NULL;
+    if (!rc && cCand)
+    {
+        paidxTail = (size_t *)malloc(cCand * sizeof(size_t));
+        paidxPrev = (size_t *)malloc(cCand * sizeof(size_t));
+        if (paidxTail && paidxPrev)
+        {
+            size_t cTails = 0;
+            for (size_t i = 0; i < cCand; i++)
+            {
+                size_t idxLow = 0;
+                size_t idxHigh = cTails;
+                while (idxLow < idxHigh)
+                {
+                    size_t idxMid = idxLow + (idxHigh - idxLow) / 2;
+                    if (paidxCandB[paidxTail[idxMid]] < paidxCandB[i])
+                        idxLow = idxMid + 1;
+                    else
+                        idxHigh = idxMid;
+                }
+
+                paidxPrev[i] = idxLow ? paidxTail[idxLow - 1] : SIZE_MAX;
+                paidxTail[idxLow] = i;
+                if (idxLow == cTails)
+                    cTails++;
+            }
+
+            /* Walk the chain backwards, compacting it into the start of the candidate arrays. */
+            size_t idxCand = paidxTail[cTails - 1];
+            for (size_t i = cTails; i-- > 0;)
+            {
+                paidxTail[i] = idxCand;
+                idxCand = paidxPrev[idxCand];
+            }
+            for (size_t i = 0; i < cTails; i++)
+            {
+                paidxCandA[i] = paidxCandA[paidxTail[i]];
+                paidxCandB[i] = paidxCandB[paidxTail[i]];
+            }
+            cCand = cTails;
+        }
+        else
+            rc = ENOMEM;
+    }
+    free(paidxTail);
+    free(paidxPrev);
+
+    if (!rc)
+    {
+        *ppaidxA   = paidxCandA;
+        *ppaidxB   = paidxCandB;
+        *pcAnchors = cCand;
+    }
+    else
+    {
+        free(paidxCandA);
+        free(paidxCandB);
+    }
+    return rc;
+}
+
+
+/**
+ * Aligns the given spans of both captures, recording the equal and differing spans in order.
+ *
+ * @returns Status code.
+ * @param   pDiff                   The diff state.
+ * @param   a0                      Start of the span in A.
+ * @param   a1                      End of the span in A (exclusive).
+ * @param   b0                      Start of the span in B.
+ * @param   b1                      End of the span in B (exclusive).
+ * @param   cK                      Number of cycles per anchor.
+ * @param   uDepth                  Current recursion depth.
+ */
+static int lpcDecDiffAlign(PLPCDECDIFF pDiff, size_t a0, size_t a1, size_t b0, size_t b1, uint32_t cK, uint32_t uDepth)
+{
+    const uint64_t *pau64KeyA = pDiff->aSides[0].pau64Key;
+    const uint64_t *pau64KeyB = pDiff->aSides[1].pau64Key;
+
+    /* Strip the common prefix and suffix. */
+    size_t cPrefix = 0;
+    while (   a0 + cPrefix < a1
+           && b0 + cPrefix < b1
+           && pau64KeyA[a0 + cPrefix] == pau64KeyB[b0 + cPrefix])
+        cPrefix++;
+    lpcDecDiffEmit(pDiff, a0, cPrefix, b0, cPrefix, 1 /*fEqual*/);
+    a0 += cPrefix;
+    b0 += cPrefix;
+
+    size_t cSuffix = 0;
+    while (   a1 - cSuffix > a0
+           && b1 - cSuffix > b0
+           && pau64KeyA[a1 - cSuffix - 1] == pau64KeyB[b1 - cSuffix - 1])
+        cSuffix++;
+    a1 -= cSuffix;
+    b1 -= cSuffix;
+
+    int rc = 0;
+    if (a0 == a1 || b0 == b1)
+        lpcDecDiffEmit(pDiff, a0, a1 - a0, b0, b1 - b0, 0 /*fEqual*/);
+    else if ((a1 - a0) <= LPC_DEC_DIFF_LCS_CELLS_MAX / (b1 - b0))
+        rc = lpcDecDiffLcs(pDiff, a0, a1 - a0, b0, b1 - b0);
+    else if (uDepth >= LPC_DEC_DIFF_DEPTH_MAX)
+    {
+        lpcDecDiffEmit(pDiff, a0, a1 - a0, b0, b1 - b0, 0 /*fEqual*/);
+        pDiff->cUnaligned++;
+    }
+    else
+    {
+        size_t *paidxA = NULL;
+        size_t *paidxB = NULL;
+        size_t cAnchors = 0;
+        rc = lpcDecDiffAnchorsFind(pDiff, a0, a1, b0, b1, cK, &paidxA, &paidxB, &cAnchors);
+        if (!rc && !cAnchors)
+        {
+            /* Retry with single cycle anchors before giving up on aligning the span. */
+            if (cK > 1)
+                rc = lpcDecDiffAlign(pDiff, a0, a1, b0, b1, 1 /*cK*/, uDepth + 1);
+            else
+            {
+                lpcDecDiffEmit(pDiff, a0, a1 - a0, b0, b1 - b0, 0 /*fEqual*/);
+                pDiff->cUnaligned++;
+            }
+        }
+        else if (!rc)
+        {
+            size_t idxA = a0;
+            size_t idxB = b0;
+            for (size_t i = 0; i < cAnchors && !rc; i++)
+            {
+                size_t idxAnchorA = paidxA[i];
+                size_t idxAnchorB = paidxB[i];
+
+                /* Skip anchors swallowed by extending the previous one. */
+                if (idxAnchorA < idxA || idxAnchorB < idxB)
+                    continue;
+
+                while (   idxAnchorA > idxA
+                       && idxAnchorB > idxB
+                       && pau64KeyA[idxAnchorA - 1] == pau64KeyB[idxAnchorB - 1])
+                {
+                    idxAnchorA--;
+                    idxAnchorB--;
+                }
+
+                rc = lpcDecDiffAlign(pDiff, idxA, idxAnchorA, idxB, idxAnchorB, cK, uDepth + 1);
+
+                size_t cEqual = 0;
+                while (   idxAnchorA + cEqual < a1
+                       && idxAnchorB + cEqual < b1
+                       && pau64KeyA[idxAnchorA + cEqual] == pau64KeyB[idxAnchorB + cEqual])
+                    cEqual++;
+                lpcDecDiffEmit(pDiff, idxAnchorA, cEqual, idxAnchorB, cEqual, 1 /*fEqual*/);
+                idxA = idxAnchorA + cEqual;
+                idxB = idxAnchorB + cEqual;
+            }
+
+            if (!rc)
+                rc = lpcDecDiffAlign(pDiff, idxA, a1, idxB, b1, cK, uDepth + 1);
+        }
+
+        free(paidxA);
+        free(paidxB);
+    }
+
+    lpcDecDiffEmit(pDiff, a1, cSuffix, b1, cSuffix, 1 /*fEqual*/);
+    return rc;
+}
+
+
+/**
+ * Initializes the given sequence search hash table.
+ *
+ * @returns Status code.
+ * @param   pHtab                   The hash table to initialize.
+ * @param   cEntries                Number of entries to start with, power of two.
+ */
+static int lpcDecFindHtabInit(PLPCDECFINDHTAB pHtab, uint32_t cEntries)
+{
+    pHtab->paEntries = (PLPCDECFINDHTABENTRY)calloc(cEntries, sizeof(*pHtab->paEntries));
+    if (!pHtab->paEntries)
+        return ENOMEM;
+
+    pHtab->cEntries = cEntries;
+    pHtab->cUsed    = 0;
+    return 0;
+}
+
+
+/**
+ * Removes all entries from the given sequence search hash table.
+ *
+ * @returns nothing.
+ * @param   pHtab                   The hash table to reset.
+ */
+static void lpcDecFindHtabReset(PLPCDECFINDHTAB pHtab)
+{
+    memset(pHtab->paEntries, 0, pHtab->cEntries * sizeof(*pHtab->paEntries));
+    pHtab->cUsed = 0;
+}
+
+
+/**
+ * Returns the slot for the given key.
+ *
+ * @returns Pointer to the slot holding the key or the free slot to insert it into.
+ * @param   pHtab                   The hash table.
+ * @param   uKey                    The key to look for.
+ */
+static inline PLPCDECFINDHTABENTRY lpcDecFindHtabSlotGet(PCLPCDECFINDHTAB pHtab, uint64_t uKey)
+{
+    uint32_t idxSlot = (uint32_t)lpcDecHashMix(uKey) & (pHtab->cEntries - 1);
+    while (   pHtab->paEntries[idxSlot].fUsed
+           && pHtab->paEntries[idxSlot].uKey != uKey)
+        idxSlot = (idxSlot + 1) & (pHtab->cEntries - 1);
+    return &pHtab->paEntries[idxSlot];
+}
+
+
+/**
+ * Looks up the given key.
+ *
+ * @returns Flag whether the key was found.
+ * @param   pHtab                   The hash table.
+ * @param   uKey                    The key to look for.
+ * @param   puVal                   Where to store the value on success.
+ */
+static inline uint8_t lpcDecFindHtabGet(PCLPCDECFINDHTAB pHtab, uint64_t uKey, uint32_t *puVal)
+{
+    PLPCDECFINDHTABENTRY pEntry = lpcDecFindHtabSlotGet(pHtab, uKey);
+    if (!pEntry->fUsed)
+        return 0;
+
+    *puVal = pEntry->uVal;
+    return 1;
+}
+
+
+/**
+ * Inserts or updates the given key, growing the table as required.
+ *
+ * @returns Status code.
+ * @param   pHtab                   The hash table.
+ * @param   uKey                    The key.
+ * @param   uVal                    The value to associate with the key.
+ */
+static int lpcDecFindHtabPut(PLPCDECFINDHTAB pHtab, uint64_t uKey, uint32_t uVal)
+{
+    if ((pHtab->cUsed + 1) * 4 > pHtab->cEntries * 3)
+    {
+        LPCDECFINDHTAB HtabNew;
+        int rc = lpcDecFindHtabInit(&HtabNew, pHtab->cEntries * 2);
+        if (rc)
+            return rc;
+
+        for (uint32_t i = 0; i < pHtab->cEntries; i++)
+        {
+            if (pHtab->paEntries[i].fUsed)
+                *lpcDecFindHtabSlotGet(&HtabNew, pHtab->paEntries[i].uKey) = pHtab->paEntries[i];
+        }
+        HtabNew.cUsed = pHtab->cUsed;
+        free(pHtab->paEntries);
+        *pHtab = HtabNew;
+    }
+
+    PLPCDECFINDHTABENTRY pEntry = lpcDecFindHtabSlotGet(pHtab, uKey);
+    if (!pEntry->fUsed)
+    {
+        pEntry->fUsed = 1;
+        pEntry->uKey  = uKey;
+        pHtab->cUsed++;
+    }
+    pEntry->uVal = uVal;
+    return 0;
+}
+
+
+/**
+ * Creates a new cycle sequence search without any patterns.
+ *
+ * @returns Status code.
+ * @param   ppFind                  Where to store the pointer to the search state on success.
+ * @param   pOut                    The stream to write matches and the summary to.
+ * @param   pfnMatch                The callback for matches, NULL to write them to the output stream.
+ * @param   pvUser                  Opaque user data to pass to the callback.
+ */
+static int lpcDecFindCreate(PLPCDECFIND *ppFind, FILE *pOut, PFNLPCDECFINDMATCH pfnMatch, void *pvUser)
+{
+    PLPCDECFIND pFind = (PLPCDECFIND)calloc(1, sizeof(*pFind));
+    if (!pFind)
+        return ENOMEM;
+
+    pFind->pOut     = pOut;
+    pFind->pfnMatch = pfnMatch;
+    pFind->pvUser   = pvUser;
+    int rc = lpcDecFindHtabInit(&pFind->HtabToken, 1024);
+    if (!rc)
+        rc = lpcDecFindHtabInit(&pFind->HtabCycle, 4096);
+    if (!rc)
+        rc = lpcDecFindHtabInit(&pFind->HtabClass, 1024);
+    if (!rc)
+        rc = lpcDecFindHtabInit(&pFind->HtabState, 1024);
+    if (!rc)
+        rc = lpcDecFindHtabInit(&pFind->HtabTrans, 4096);
+    if (rc)
+    {
+        free(pFind->HtabToken.paEntries);
+        free(pFind->HtabCycle.paEntries);
+        free(pFind->HtabClass.paEntries);
+        free(pFind->HtabState.paEntries);
+        free(pFind);
+        return rc;
+    }
+
+    *ppFind = pFind;
+    return 0;
+}
+
+
+/**
+ * Destroys the given cycle sequence search.
+ *
+ * @returns nothing.
+ * @param   pFind                   The search state to destroy.
+ */
+static void lpcDecFindDestroy(PLPCDECFIND pFind)
+{
+    for (uint32_t i = 0; i < pFind->cPatterns; i++)
+        free(pFind->paPatterns[i].pszPattern);
+    free(pFind->paPatterns);
+    free(pFind->paTokens);
+    free(pFind->paPos);
+    free(pFind->pau64Classes);
+    free(pFind->paStates);
+    free(pFind->pau32Pool);
+    free(pFind->pau32Scratch);
+    free(pFind->HtabToken.paEntries);
+    free(pFind->HtabCycle.paEntries);
+    free(pFind->HtabClass.paEntries);
+    free(pFind->HtabState.paEntries);
+    free(pFind->HtabTrans.paEntries);
+    free(pFind);
+}
+
+
+/**
+ * Parses a single cycle token of a search pattern.
+ *
+ * A token is either '*' (any cycle), 'abort' (any aborted cycle) or <kind>[:<address>[=<data>]] with the kind
+ * being one of io, ior, iow, mem, memr or memw. Address and data are hexadecimal or '*'.
+ *
+ * @returns Status code.
+ * @param   pszToken                The token string.
+ * @param   pToken                  Where to store the parsed token.
+ */
+static int lpcDecFindTokenParse(const char *pszToken, PLPCDECFINDTOKEN pToken)
+{
+    static const struct
+    {
+        const char              *pszKind;
+        uint8_t                 bTyp;
+        uint8_t                 bDir;
+    } s_aKinds[] =
+    {
+        { "io",   LPC_DEC_CYC_TYPE_IO,  LPC_DEC_FIND_ANY      },
+        { "ior",  LPC_DEC_CYC_TYPE_IO,  LPC_DEC_CYC_DIR_READ  },
+        { "iow",  LPC_DEC_CYC_TYPE_IO,  LPC_DEC_CYC_DIR_WRITE },
+        { "mem",  LPC_DEC_CYC_TYPE_MEM, LPC_DEC_FIND_ANY      },
+        { "memr", LPC_DEC_CYC_TYPE_MEM, LPC_DEC_CYC_DIR_READ  },
+        { "memw", LPC_DEC_CYC_TYPE_MEM, LPC_DEC_CYC_DIR_WRITE }
+    };
+
+    memset(pToken, 0, sizeof(*pToken));
+    pToken->bTyp     = LPC_DEC_FIND_ANY;
+    pToken->bDir     = LPC_DEC_FIND_ANY;
+    pToken->bAbort   = LPC_DEC_FIND_ANY;
+    pToken->fAddrAny = 1;
+    pToken->fDataAny = 1;
+    if (!strcmp(pszToken, "*"))
+        return 0;
+    if (!strcmp(pszToken, "abort"))
+    {
+        pToken->bAbort = 1;
+        return 0;
+    }
+
+    size_t cchKind = strcspn(pszToken, ":");
+    uint32_t idxKind = 0;
+    while (   idxKind < sizeof(s_aKinds) / sizeof(s_aKinds[0])
+           && (   strlen(s_aKinds[idxKind].pszKind) != cchKind
+               || strncmp(s_aKinds[idxKind].pszKind, pszToken, cchKind)))
+        idxKind++;
+    if (idxKind == sizeof(s_aKinds) / sizeof(s_aKinds[0]))
+        return EINVAL;
+
+    pToken->bTyp   = s_aKinds[idxKind].bTyp;
+    pToken->bDir   = s_aKinds[idxKind].bDir;
+    pToken->bAbort = 0;
+
+    const char *psz = pszToken + cchKind;
+    if (*psz == '\0')
+        return 0;
+
+    psz++;
+    if (*psz == '*')
+        psz++;
+    else
+    {
+        char *pszEnd = NULL;
+        unsigned long long uAddr = strtoull(psz, &pszEnd, 16);
+        if (pszEnd == psz || uAddr > UINT32_MAX)
+            return EINVAL;
+        pToken->fAddrAny = 0;
+        pToken->u32Addr  = (uint32_t)uAddr;
+        psz = pszEnd;
+    }
+
+    if (*psz == '\0')
+        return 0;
+    if (*psz != '=')
+        return EINVAL;
+
+    psz++;
+    if (!strcmp(psz, "*"))
+        return 0;
+
+    char *pszEnd = NULL;
+    unsigned long uData = strtoul(psz, &pszEnd, 16);
+    if (pszEnd == psz || *pszEnd != '\0' || uData > UINT8_MAX)
+        return EINVAL;
+    pToken->fDataAny = 0;
+    pToken->bData    = (uint8_t)uData;
+    return 0;
+}
+
+
+/**
+ * Returns whether the given cycle matches the given token.
+ *
+ * @returns Flag whether the cycle matches.
+ * @param   pToken                  The token.
+ * @param   pCycle                  The decoded cycle.
+ */
+static inline uint8_t lpcDecFindTokenMatch(PCLPCDECFINDTOKEN pToken, PCLPCDECCYCLE pCycle)
+{
+    return    (pToken->bTyp == LPC_DEC_FIND_ANY || pToken->bTyp == pCycle->bTyp)
+           && (pToken->bDir == LPC_DEC_FIND_ANY || pToken->bDir == pCycle->fWrite)
+           && (pToken->bAbort == LPC_DEC_FIND_ANY || pToken->bAbort == pCycle->fAbort)
+           && (pToken->fAddrAny || pToken->u32Addr == pCycle->u32Addr)
+           && (pToken->fDataAny || pToken->bData == pCycle->bData);
+}
+
+
+/**
+ * Returns the index of the given token, adding it if it isn't known yet.
+ *
+ * @returns Status code.
+ * @param   pFind                   The search state.
+ * @param   pToken                  The token.
+ * @param   pidxToken               Where to store the index of the token on success.
+ */
+static int lpcDecFindTokenIntern(PLPCDECFIND pFind, PCLPCDECFINDTOKEN pToken, uint32_t *pidxToken)
+{
+    uint64_t uHash = lpcDecHashMix(  (uint64_t)pToken->bTyp
+                                   | ((uint64_t)pToken->bDir << 8)
+                                   | ((uint64_t)pToken->bAbort << 16)
+                                   | ((uint64_t)pToken->fAddrAny << 24)
+                                   | ((uint64_t)pToken->fDataAny << 32)
+                                   | ((uint64_t)pToken->bData << 40));
+    uHash = lpcDecHashMix(uHash ^ pToken->u32Addr);
+
+    uint32_t idxToken = 0;
+    uint8_t fFound = lpcDecFindHtabGet(&pFind->HtabToken, uHash, &idxToken);
+    if (fFound && !memcmp(&pFind->paTokens[idxToken], pToken, sizeof(*pToken)))
+    {
+        *pidxToken = idxToken;
+        return 0;
+    }
+
+    if (pFind->cTokens == pFind->cTokensMax)
+    {
+        uint32_t cTokensMaxNew = pFind->cTokensMax ? pFind->cTokensMax * 2 : 64;
+        PLPCDECFINDTOKEN paTokensNew = (PLPCDECFINDTOKEN)realloc(pFind->paTokens, cTokensMaxNew * sizeof(*paTokensNew));
+        if (!paTokensNew)
+            return ENOMEM;
+        pFind->paTokens   = paTokensNew;
+        pFind->cTokensMax = cTokensMaxNew;
+    }
+
+    /* A hash collision with a different token only costs a duplicate token. */
+    idxToken = pFind->cTokens++;
+    pFind->paTokens[idxToken] = *pToken;
+    *pidxToken = idxToken;
+    return fFound ? 0 : lpcDecFindHtabPut(&pFind->HtabToken, uHash, idxToken);
+}
+
+
+/**
+ * Adds a search pattern, a sequence of whitespace or comma separated cycle tokens.
+ *
+ * @returns Status code.
+ * @param   pFind                   The search state.
+ * @param   pszPattern              The pattern.
+ */
+static int lpcDecFindPatternAdd(PLPCDECFIND pFind, const char *pszPattern)
+{
+    if (pFind->fCompiled)
+        return EBUSY;
+
+    char *pszTokens = strdup(pszPattern);
+    if (!pszTokens)
+        return ENOMEM;
+
+    uint32_t aidxTokens[LPC_DEC_FIND_TOKENS_MAX];
+    uint32_t cTokens = 0;
+    char *pszSave = NULL;
+    int rc = 0;
+    for (char *pszToken = strtok_r(pszTokens, " \t,", &pszSave);
+         pszToken && !rc;
+         pszToken = strtok_r(NULL, " \t,", &pszSave))
+    {
+        LPCDECFINDTOKEN Token;
+        if (cTokens == LPC_DEC_FIND_TOKENS_MAX)
+            rc = EINVAL;
+        if (!rc)
+            rc = lpcDecFindTokenParse(pszToken, &Token);
+        if (!rc)
+            rc = lpcDecFindTokenIntern(pFind, &Token, &aidxTokens[cTokens++]);
+    }
+    free(pszTokens);
+    if (!rc && !cTokens)
+        rc = EINVAL;
+    if (rc)
+        return rc;
+
+    if (pFind->cPatterns == pFind->cPatternsMax)
+    {
+        uint32_t cPatternsMaxNew = pFind->cPatternsMax ? pFind->cPatternsMax * 2 : 16;
+        PLPCDECFINDPATTERN paPatternsNew = (PLPCDECFINDPATTERN)realloc(pFind->paPatterns,
+                                                                       cPatternsMaxNew * sizeof(*paPatternsNew));
+        if (!paPatternsNew)
+            return ENOMEM;
+        pFind->paPatterns   = paPatternsNew;
+        pFind->cPatternsMax = cPatternsMaxNew;
+    }
+
+    while (pFind->cPos + cTokens + 1 > pFind->cPosMax)
+    {
+        uint32_t cPosMaxNew = pFind->cPosMax ? pFind->cPosMax * 2 : 256;
+        PLPCDECFINDPOS paPosNew = (PLPCDECFINDPOS)realloc(pFind->paPos, cPosMaxNew * sizeof(*paPosNew));
+        if (!paPosNew)
+            return ENOMEM;
+        pFind->paPos   = paPosNew;
+        pFind->cPosMax = cPosMaxNew;
+    }
+
+    PLPCDECFINDPATTERN pPattern = &pFind->paPatterns[pFind->cPatterns];
+    pPattern->pszPattern = strdup(pszPattern);
+    if (!pPattern->pszPattern)
+        return ENOMEM;
+    pPattern->idxPosFirst = pFind->cPos;
+    pPattern->cTokens     = cTokens;
+    pPattern->cMatches    = 0;
+
+    for (uint32_t i = 0; i <= cTokens; i++)
+    {
+        pFind->paPos[pFind->cPos].idxToken   = i < cTokens ? aidxTokens[i] : UINT32_MAX;
+        pFind->paPos[pFind->cPos].idxPattern = pFind->cPatterns;
+        pFind->cPos++;
+    }
+
+    if (cTokens > pFind->cTokensPatternMax)
+        pFind->cTokensPatternMax = cTokens;
+    pFind->cPatterns++;
+    return 0;
+}
+
+
+/**
+ * Adds the search patterns from the given file, one per line, empty lines and lines starting with '#' are ignored.
+ *
+ * @returns Status code.
+ * @param   pFind                   The search state.
+ * @param   pszFilename             The file to read the patterns from.
+ * @param   piLine                  Where to store the line number of the offending pattern on failure,
+ *                                  0 if the file couldn't be read.
+ */
+static int lpcDecFindPatternAddFromFile(PLPCDECFIND pFind, const char *pszFilename, uint32_t *piLine)
+{
+    *piLine = 0;
+    FILE *pFile = fopen(pszFilename, "r");
+    if (!pFile)
+        return errno;
+
+    char *pszLine = NULL;
+    size_t cbLine = 0;
+    uint32_t iLine = 0;
+    int rc = 0;
+    while (!rc && getline(&pszLine, &cbLine, pFile) != -1)
+    {
+        iLine++;
+        pszLine[strcspn(pszLine, "\r\n")] = '\0';
+
+        const char *psz = pszLine + strspn(pszLine, " \t");
+        if (*psz == '\0' || *psz == '#')
+            continue;
+
+        rc = lpcDecFindPatternAdd(pFind, psz);
+        if (rc)
+            *piLine = iLine;
+    }
+
+    free(pszLine);
+    fclose(pFile);
+    return rc;
+}
+
+
+/**
+ * Returns the index of the automaton state with the given positions, adding it if it isn't known yet.
+ *
+ * @returns Status code.
+ * @param   pFind                   The search state.
+ * @param   pau32Pos                The sorted active positions of the state.
+ * @param   cPos                    Number of active positions.
+ * @param   pidxState               Where to store the index of the state on success.
+ */
+static int lpcDecFindStateIntern(PLPCDECFIND pFind, const uint32_t *pau32Pos, uint32_t cPos, uint32_t *pidxState)
+{
+    uint64_t uHash = cPos;
+    for (uint32_t i = 0; i < cPos; i++)
+        uHash = lpcDecHashMix(uHash + pau32Pos[i] + 1);
+
+    uint32_t idxState = 0;
+    uint8_t fFound = lpcDecFindHtabGet(&pFind->HtabState, uHash, &idxState);
+    if (   fFound
+        && pFind->paStates[idxState].cPos == cPos
+        && !memcmp(&pFind->pau32Pool[pFind->paStates[idxState].offPos], pau32Pos, cPos * sizeof(uint32_t)))
+    {
+        *pidxState = idxState;
+        return 0;
+    }
+
+    uint32_t cAccepts = 0;
+    for (uint32_t i = 0; i < cPos; i++)
+    {
+        if (pFind->paPos[pau32Pos[i]].idxToken == UINT32_MAX)
+            cAccepts++;
+    }
+
+    while (pFind->cPool + cPos + cAccepts > pFind->cPoolMax)
+    {
+        uint32_t cPoolMaxNew = pFind->cPoolMax ? pFind->cPoolMax * 2 : 4096;
+        uint32_t *pau32PoolNew = (uint32_t *)realloc(pFind->pau32Pool, cPoolMaxNew * sizeof(uint32_t));
+        if (!pau32PoolNew)
+            return ENOMEM;
+        pFind->pau32Pool = pau32PoolNew;
+        pFind->cPoolMax  = cPoolMaxNew;
+    }
+
+    if (pFind->cStates == pFind->cStatesMax)
+    {
+        uint32_t cStatesMaxNew = pFind->cStatesMax ? pFind->cStatesMax * 2 : 256;
+        PLPCDECFINDSTATE paStatesNew = (PLPCDECFINDSTATE)realloc(pFind->paStates, cStatesMaxNew * sizeof(*paStatesNew));
+        if (!paStatesNew)
+            return ENOMEM;
+        pFind->paStates   = paStatesNew;
+        pFind->cStatesMax = cStatesMaxNew;
+    }
+
+    /* A hash collision with a different state only costs a duplicate state. */
+    PLPCDECFINDSTATE pState = &pFind->paStates[pFind->cStates];
+    pState->offPos = pFind->cPool;
+    pState->cPos   = cPos;
+    memcpy(&pFind->pau32Pool[pFind->cPool], pau32Pos, cPos * sizeof(uint32_t));
+    pFind->cPool += cPos;
+
+    pState->offAccept = pFind->cPool;
+    pState->cAccepts  = cAccepts;
+    for (uint32_t i = 0; i < cPos; i++)
+    {
+        if (pFind->paPos[pau32Pos[i]].idxToken == UINT32_MAX)
+            pFind->pau32Pool[pFind->cPool++] = pFind->paPos[pau32Pos[i]].idxPattern;
+    }
+
+    idxState = pFind->cStates++;
+    *pidxState = idxState;
+    return fFound ? 0 : lpcDecFindHtabPut(&pFind->HtabState, uHash, idxState);
+}
+
+
+/**
+ * Returns the class of the given cycle, classifying it against all tokens if it wasn't seen before.
+ *
+ * @returns Status code.
+ * @param   pFind                   The search state.
+ * @param   pCycle                  The decoded cycle.
+ * @param   pidxClass               Where to store the class on success.
+ */
+static int lpcDecFindClassGet(PLPCDECFIND pFind, PCLPCDECCYCLE pCycle, uint32_t *pidxClass)
+{
+    uint64_t uKey = lpcDecCycleKey(pCycle);
+    if (lpcDecFindHtabGet(&pFind->HtabCycle, uKey, pidxClass))
+        return 0;
+
+    if (pFind->cClasses == pFind->cClassesMax)
+    {
+        uint32_t cClassesMaxNew = pFind->cClassesMax ? pFind->cClassesMax * 2 : 64;
+        uint64_t *pau64ClassesNew = (uint64_t *)realloc(pFind->pau64Classes,
+                                                        (size_t)cClassesMaxNew * pFind->cWordsClass * sizeof(uint64_t));
+        if (!pau64ClassesNew)
+            return ENOMEM;
+        pFind->pau64Classes = pau64ClassesNew;
+        pFind->cClassesMax  = cClassesMaxNew;
+    }
+
+    uint64_t *pau64Class = &pFind->pau64Classes[(size_t)pFind->cClasses * pFind->cWordsClass];
+    memset(pau64Class, 0, pFind->cWordsClass * sizeof(uint64_t));
+    for (uint32_t i = 0; i < pFind->cTokens; i++)
+    {
+        if (lpcDecFindTokenMatch(&pFind->paTokens[i], pCycle))
+            pau64Class[i / 64] |= UINT64_C(1) << (i % 64);
+    }
+
+    uint64_t uHash = pFind->cWordsClass;
+    for (uint32_t i = 0; i < pFind->cWordsClass; i++)
+        uHash = lpcDecHashMix(uHash ^ pau64Class[i]);
+
+    int rc = 0;
+    uint32_t idxClass = 0;
+    uint8_t fFound = lpcDecFindHtabGet(&pFind->HtabClass, uHash, &idxClass);
+    if (   !fFound
+        || memcmp(&pFind->pau64Classes[(size_t)idxClass * pFind->cWordsClass], pau64Class,
+                  pFind->cWordsClass * sizeof(uint64_t)))
+    {
+        idxClass = pFind->cClasses++;
+        if (!fFound)
+            rc = lpcDecFindHtabPut(&pFind->HtabClass, uHash, idxClass);
+    }
+
+    if (pFind->HtabCycle.cUsed >= LPC_DEC_FIND_CYCLE_CACHE_MAX)
+        lpcDecFindHtabReset(&pFind->HtabCycle);
+    if (!rc)
+        rc = lpcDecFindHtabPut(&pFind->HtabCycle, uKey, idxClass);
+
+    *pidxClass = idxClass;
+    return rc;
+}
+
+
+/**
+ * Compares two automaton positions, qsort() callback.
+ *
+ * @returns Comparison result.
+ * @param   pv1                     The first position.
+ * @param   pv2                     The second position.
+ */
+static int lpcDecFindPosCmp(const void *pv1, const void *pv2)
+{
+    uint32_t idxPos1 = *(const uint32_t *)pv1;
+    uint32_t idxPos2 = *(const uint32_t *)pv2;
+
+    return idxPos1 < idxPos2 ? -1 : idxPos1 > idxPos2 ? 1 : 0;
+}
+
+
+/**
+ * Returns the state the automaton moves to from the current one for a cycle of the given class,
+ * building the state if the transition wasn't taken before.
+ *
+ * @returns Status code.
+ * @param   pFind                   The search state.
+ * @param   idxClass                The class of the cycle.
+ * @param   pidxStateNext           Where to store the next state on success.
+ */
+static int lpcDecFindStep(PLPCDECFIND pFind, uint32_t idxClass, uint32_t *pidxStateNext)
+{
+    uint64_t uKeyTrans = ((uint64_t)pFind->idxStateCur << 32) | idxClass;
+    if (lpcDecFindHtabGet(&pFind->HtabTrans, uKeyTrans, pidxStateNext))
+        return 0;
+
+    const uint64_t *pau64Class = &pFind->pau64Classes[(size_t)idxClass * pFind->cWordsClass];
+    PCLPCDECFINDSTATE pState = &pFind->paStates[pFind->idxStateCur];
+    uint32_t cPosNew = 0;
+
+    /* Advance the active positions... */
+    for (uint32_t i = 0; i < pState->cPos; i++)
+    {
+        uint32_t idxPos = pFind->pau32Pool[pState->offPos + i];
+        uint32_t idxToken = pFind->paPos[idxPos].idxToken;
+        if (   idxToken != UINT32_MAX
+            && (pau64Class[idxToken / 64] & (UINT64_C(1) << (idxToken % 64))))
+            pFind->pau32Scratch[cPosNew++] = idxPos + 1;
+    }
+
+    /* ... and every pattern can start at any cycle. */
+    for (uint32_t i = 0; i < pFind->cPatterns; i++)
+    {
+        uint32_t idxPos = pFind->paPatterns[i].idxPosFirst;
+        uint32_t idxToken = pFind->paPos[idxPos].idxToken;
+        if (pau64Class[idxToken / 64] & (UINT64_C(1) << (idxToken % 64)))
+            pFind->pau32Scratch[cPosNew++] = idxPos + 1;
+    }
+    qsort(pFind->pau32Scratch, cPosNew, sizeof(uint32_t), lpcDecFindPosCmp);
+
+    /* Start over when the state cache grows too large, the current state is not needed anymore. */
+    uint8_t fFlush =    pFind->cStates >= LPC_DEC_FIND_STATES_MAX
+                     || pFind->cPool >= LPC_DEC_FIND_POOL_MAX;
+    if (fFlush)
+    {
+        pFind->cStates = 0;
+        pFind->cPool   = 0;
+        lpcDecFindHtabReset(&pFind->HtabState);
+        lpcDecFindHtabReset(&pFind->HtabTrans);
+        pFind->cFlushes++;
+    }
+
+    int rc = lpcDecFindStateIntern(pFind, pFind->pau32Scratch, cPosNew, pidxStateNext);
+    if (!rc && !fFlush)
+        rc = lpcDecFindHtabPut(&pFind->HtabTrans, uKeyTrans, *pidxStateNext);
+    return rc;
+}
+
+
+/**
+ * Sets up the automaton after all patterns were added.
+ *
+ * @returns Status code.
+ * @param   pFind                   The search state.
+ */
+static int lpcDecFindCompile(PLPCDECFIND pFind)
+{
+    pFind->cWordsClass  = (pFind->cTokens + 63) / 64;
+    pFind->pau32Scratch = (uint32_t *)malloc((pFind->cPos + 1) * sizeof(uint32_t));
+    if (!pFind->pau32Scratch)
+        return ENOMEM;
+
+    int rc = lpcDecFindStateIntern(pFind, NULL /*pau32Pos*/, 0 /*cPos*/, &pFind->idxStateCur);
+    if (!rc)
+        pFind->fCompiled = 1;
+    return rc;
+}
+
+
+/**
+ * Feeds the given cycle to the sequence search, reporting every pattern ending with it.
+ *
+ * @returns nothing.
+ * @param   pFind                   The search state.
+ * @param   pCycle                  The decoded cycle.
+ */
+static void lpcDecFindProcess(PLPCDECFIND pFind, PCLPCDECCYCLE pCycle)
+{
+    if (pFind->rc)
+        return;
+
+    int rc = 0;
+    if (!pFind->fCompiled)
+        rc = lpcDecFindCompile(pFind);
+
+    uint32_t idxClass = 0;
+    uint32_t idxState = 0;
+    if (!rc)
+        rc = lpcDecFindClassGet(pFind, pCycle, &idxClass);
+    if (!rc)
+        rc = lpcDecFindStep(pFind, idxClass, &idxState);
+    if (rc)
+    {
+        pFind->rc = rc;
+        return;
+    }
+
+    pFind->idxStateCur = idxState;
+    pFind->au64SeqNo[pFind->cCycles % LPC_DEC_FIND_TOKENS_MAX] = pCycle->uSeqNo;
+    pFind->cCycles++;
+
+    PCLPCDECFINDSTATE pState = &pFind->paStates[idxState];
+    for (uint32_t i = 0; i < pState->cAccepts; i++)
+    {
+        PLPCDECFINDPATTERN pPattern = &pFind->paPatterns[pFind->pau32Pool[pState->offAccept + i]];
+        uint64_t uSeqNoFirst = pFind->au64SeqNo[(pFind->cCycles - pPattern->cTokens) % LPC_DEC_FIND_TOKENS_MAX];
+
+        pPattern->cMatches++;
+        if (pFind->pfnMatch)
+            pFind->pfnMatch(pPattern, uSeqNoFirst, pCycle->uSeqNo, pFind->pvUser);
+        else
+            fprintf(pFind->pOut, "%" PRIu64 "-%" PRIu64 ": Match '%s'\n", uSeqNoFirst, pCycle->uSeqNo,
+                    pPattern->pszPattern);
+    }
+}
+
+
+/**
+ * Dumps the number of matches of every pattern.
+ *
+ * @returns nothing.
+ * @param   pFind                   The search state.
+ */
+static void lpcDecFindDumpSummary(PCLPCDECFIND pFind)
+{
+    fprintf(pFind->pOut, "Sequence search:\n");
+    for (uint32_t i = 0; i < pFind->cPatterns; i++)
+        fprintf(pFind->pOut, "    %" PRIu64 " matches: %s\n", pFind->paPatterns[i].cMatches,
+                pFind->paPatterns[i].pszPattern);
+    if (g_fVerbose)
+        fprintf(pFind->pOut, "    %u tokens, %u cycle classes, %u states, %u state cache flushes\n",
+                pFind->cTokens, pFind->cClasses, pFind->cStates, pFind->cFlushes);
+    if (pFind->rc)
+        fprintf(pFind->pOut, "    Search stopped early with %d\n", pFind->rc);
+}
+
+
+/**
+ * Search match callback arming the trigger for the current cycle.
+ *
+ * @returns nothing.
+ * @param   pPattern                The pattern which matched.
+ * @param   uSeqNoFirst             Sequence number of the first cycle of the match.
+ * @param   uSeqNoLast              Sequence number of the last cycle of the match.
+ * @param   pvUser                  The triggered extraction state.
+ */
+static void lpcDecTriggerMatch(PCLPCDECFINDPATTERN pPattern, uint64_t uSeqNoFirst, uint64_t uSeqNoLast, void *pvUser)
+{
+    PLPCDECTRIGGER pTrigger = (PLPCDECTRIGGER)pvUser;
+    (void)uSeqNoLast;
+
+    /* The first pattern wins if several end on the same cycle. */
+    if (!pTrigger->pPatternHit)
+    {
+        pTrigger->pPatternHit = pPattern;
+        pTrigger->uSeqNoHit   = uSeqNoFirst;
+    }
+}
+
+
+/**
+ * Creates a new triggered extraction without any trigger patterns.
+ *
+ * @returns Status code.
+ * @param   ppTrigger               Where to store the pointer to the triggered extraction state on success.
+ * @param   pOut                    The stream to write the windows to.
+ */
+static int lpcDecTriggerCreate(PLPCDECTRIGGER *ppTrigger, FILE *pOut)
+{
+    PLPCDECTRIGGER pTrigger = (PLPCDECTRIGGER)calloc(1, sizeof(*pTrigger));
+    if (!pTrigger)
+        return ENOMEM;
+
+    int rc = lpcDecFindCreate(&pTrigger->pFind, pOut, lpcDecTriggerMatch, pTrigger);
+    if (rc)
+    {
+        free(pTrigger);
+        return rc;
+    }
+
+    pTrigger->pOut     = pOut;
+    pTrigger->pOutText = pOut;
+    pTrigger->cPre     = LPC_DEC_TRIGGER_PRE_DEF;
+    pTrigger->cPost    = LPC_DEC_TRIGGER_POST_DEF;
+    *ppTrigger = pTrigger;
+    return 0;
+}
+
+
+/**
+ * Sets the window dumped around every trigger, allocating the ring for the cycles before it.
+ *
+ * @returns Status code.
+ * @param   pTrigger                The triggered extraction state.
+ * @param   cPre                    Number of cycles to dump before a trigger.
+ * @param   cPost                   Number of cycles to dump after a trigger.
+ */
+static int lpcDecTriggerSetWindow(PLPCDECTRIGGER pTrigger, uint32_t cPre, uint32_t cPost)
+{
+    free(pTrigger->paRing);
+    pTrigger->paRing = NULL;
+    pTrigger->cPre   = 0;
+    if (cPre)
+    {
+        pTrigger->paRing = (PLPCDECCYCLE)malloc((size_t)cPre * sizeof(*pTrigger->paRing));
+        if (!pTrigger->paRing)
+            return ENOMEM;
+    }
+
+    pTrigger->cPre  = cPre;
+    pTrigger->cPost = cPost;
+    return 0;
+}
+
+
+/**
+ * Destroys the given triggered extraction.
+ *
+ * @returns nothing.
+ * @param   pTrigger                The triggered extraction state to destroy.
+ */
+static void lpcDecTriggerDestroy(PLPCDECTRIGGER pTrigger)
+{
+    lpcDecFindDestroy(pTrigger->pFind);
+    free(pTrigger->paRing);
+    free(pTrigger);
+}
+
+
+/**
+ * Dumps the given cycle of a window in the output format.
+ *
+ * @returns nothing.
+ * @param   pTrigger                The triggered extraction state.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with, NULL if the cycle doesn't
+ *                                  come from a decoder.
+ * @param   pCycle                  The cycle.
+ */
+static void lpcDecTriggerCycleDump(PLPCDECTRIGGER pTrigger, PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle)
+{
+    if (pTrigger->pArrowOut)
+        lpcDecArrowOutCycleAdd(pTrigger->pArrowOut, pCycle);
+    else
+        lpcDecCycleDump(pTrigger->pOut, pLpcDec, pCycle);
+}
+
+
+/**
+ * Feeds the given cycle to the triggered extraction, the cycle is only remembered unless it is inside a window.
+ *
+ * @returns nothing.
+ * @param   pTrigger                The triggered extraction state.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with.
+ * @param   pCycle                  The decoded cycle.
+ */
+static void lpcDecTriggerProcess(PLPCDECTRIGGER pTrigger, PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle)
+{
+    pTrigger->pPatternHit = NULL;
+    lpcDecFindProcess(pTrigger->pFind, pCycle);
+    if (pTrigger->pPatternHit)
+    {
+        pTrigger->cTriggers++;
+        if (!pTrigger->cPostLeft)
+        {
+            pTrigger->cWindows++;
+            fprintf(pTrigger->pOutText, "--- Trigger '%s' at %" PRIu64 "-%" PRIu64 " ---\n",
+                    pTrigger->pPatternHit->pszPattern, pTrigger->uSeqNoHit, pCycle->uSeqNo);
+        }
+        else
+            fprintf(pTrigger->pOutText, "--- Trigger '%s' at %" PRIu64 "-%" PRIu64 " (extends the window) ---\n",
+                    pTrigger->pPatternHit->pszPattern, pTrigger->uSeqNoHit, pCycle->uSeqNo);
+
+        /* The ring is only ever filled outside of a window, so it holds exactly the cycles before the trigger. */
+        for (uint32_t i = 0; i < pTrigger->cRing; i++)
+            lpcDecTriggerCycleDump(pTrigger, NULL /*pLpcDec*/,
+                                   &pTrigger->paRing[(pTrigger->idxRingFirst + i) % pTrigger->cPre]);
+        pTrigger->idxRingFirst = 0;
+        pTrigger->cRing        = 0;
+
+        lpcDecTriggerCycleDump(pTrigger, pLpcDec, pCycle);
+        pTrigger->cPostLeft = pTrigger->cPost;
+    }
+    else if (pTrigger->cPostLeft)
+    {
+        lpcDecTriggerCycleDump(pTrigger, pLpcDec, pCycle);
+        pTrigger->cPostLeft--;
+    }
+    else if (pTrigger->cPre)
+    {
+        if (pTrigger->cRing < pTrigger->cPre)
+            pTrigger->paRing[(pTrigger->idxRingFirst + pTrigger->cRing++) % pTrigger->cPre] = *pCycle;
+        else
+        {
+            pTrigger->paRing[pTrigger->idxRingFirst] = *pCycle;
+            pTrigger->idxRingFirst = (pTrigger->idxRingFirst + 1) % pTrigger->cPre;
+        }
+    }
+}
+
+
+/**
+ * Dumps the number of triggers and windows.
+ *
+ * @returns nothing.
+ * @param   pTrigger                The triggered extraction state.
+ */
+static void lpcDecTriggerDumpSummary(PCLPCDECTRIGGER pTrigger)
+{
+    fprintf(pTrigger->pOutText, "--- %" PRIu64 " triggers in %" PRIu64 " windows ---\n", pTrigger->cTriggers,
+            pTrigger->cWindows);
+    if (pTrigger->pFind->rc)
+        fprintf(pTrigger->pOutText, "    Trigger search stopped early with %d\n", pTrigger->pFind->rc);
+}
+
+
+/**
+ * Loads the zstd library and resolves the used API.
+ *
+ * @returns Status code.
+ */
+static int lpcDecZstdLoad(void)
+{
+    LPCDECZSTDAPI Api;
+    const struct
+    {
+        const char      *pszSym;
+        void            *pvPfn;
+    } aSyms[] =
+    {
+        { "ZSTD_createCCtx",        &Api.pfnCreateCCtx       },
+        { "ZSTD_freeCCtx",          &Api.pfnFreeCCtx         },
+        { "ZSTD_CCtx_setParameter", &Api.pfnCCtxSetParameter },
+        { "ZSTD_compressStream2",   &Api.pfnCompressStream2  },
+        { "ZSTD_CStreamOutSize",    &Api.pfnCStreamOutSize   },
+        { "ZSTD_isError",           &Api.pfnIsError          }
+    };
+
+    if (g_Zstd.pfnCreateCCtx)
+        return 0;
+
+    void *hLib = dlopen(LPC_DEC_ZSTD_LIB, RTLD_NOW | RTLD_LOCAL);
+    if (!hLib)
+        return ENOENT;
+
+    for (uint32_t i = 0; i < sizeof(aSyms) / sizeof(aSyms[0]); i++)
+    {
+        void *pvSym = dlsym(hLib, aSyms[i].pszSym);
+        if (!pvSym)
+        {
+            dlclose(hLib);
+            return ENOENT;
+        }
+
+        /* POSIX guarantees that data and function pointers share the representation. */
+        memcpy(aSyms[i].pvPfn, &pvSym, sizeof(pvSym));
+    }
+
+    g_Zstd = Api;
+    return 0;
+}
+
+
+/**
+ * Parses a compression specification of the form zstd[:level].
+ *
+ * @returns Status code.
+ * @param   pszSpec                 The specification.
+ * @param   piLevel                 Where to store the compression level on success.
+ */
+static int lpcDecZstdSpecParse(const char *pszSpec, int *piLevel)
+{
+    if (!strcmp(pszSpec, "zstd"))
+    {
+        *piLevel = LPC_DEC_ZSTD_LEVEL_DEF;
+        return 0;
+    }
+    if (strncmp(pszSpec, "zstd:", sizeof("zstd:") - 1))
+        return EINVAL;
+
+    char *pszEnd = NULL;
+    long iLevel = strtol(pszSpec + sizeof("zstd:") - 1, &pszEnd, 10);
+    if (   *pszEnd != '\0'
+        || pszEnd == pszSpec + sizeof("zstd:") - 1
+        || iLevel < 1
+        || iLevel > LPC_DEC_ZSTD_LEVEL_MAX)
+        return EINVAL;
+
+    *piLevel = (int)iLevel;
+    return 0;
+}
+
+
+/**
+ * Compresses the given data and writes out everything zstd produced.
+ *
+ * @returns Status code.
+ * @param   pZstdOut                The compressed output stream.
+ * @param   pvData                  The data to compress.
+ * @param   cbData                  Number of bytes to compress.
+ * @param   iEndOp                  LPC_DEC_ZSTD_E_CONTINUE or LPC_DEC_ZSTD_E_END to finish the frame.
+ */
+static int lpcDecZstdOutCompress(PLPCDECZSTDOUT pZstdOut, const void *pvData, size_t cbData, int iEndOp)
+{
+    LPCDECZSTDINBUF InBuf;
+    InBuf.pv  = pvData;
+    InBuf.cb  = cbData;
+    InBuf.off = 0;
+
+    for (;;)
+    {
+        LPCDECZSTDOUTBUF OutBuf;
+        OutBuf.pv  = pZstdOut->pbOut;
+        OutBuf.cb  = pZstdOut->cbOut;
+        OutBuf.off = 0;
+
+        size_t cbLeft = g_Zstd.pfnCompressStream2(pZstdOut->pCCtx, &OutBuf, &InBuf, iEndOp);
+        if (g_Zstd.pfnIsError(cbLeft))
+            return EIO;
+        if (   OutBuf.off
+            && fwrite(pZstdOut->pbOut, 1, OutBuf.off, pZstdOut->pDst) != OutBuf.off)
+            return EIO;
+
+        if (  iEndOp == LPC_DEC_ZSTD_E_END
+            ? !cbLeft
+            : InBuf.off == InBuf.cb)
+            return 0;
+    }
+}
+
+
+/**
+ * Worker thread of a compressed output stream.
+ *
+ * @returns NULL.
+ * @param   pvUser                  The compressed output stream.
+ */
+static void *lpcDecZstdOutWorker(void *pvUser)
+{
+    PLPCDECZSTDOUT pZstdOut = (PLPCDECZSTDOUT)pvUser;
+    int rc = 0;
+
+    pthread_mutex_lock(&pZstdOut->Mtx);
+    for (;;)
+    {
+        while (   pZstdOut->cBlocksDone == pZstdOut->cBlocksQueued
+               && !pZstdOut->fEos)
+            pthread_cond_wait(&pZstdOut->CondFilled, &pZstdOut->Mtx);
+        if (pZstdOut->cBlocksDone == pZstdOut->cBlocksQueued)
+            break;
+
+        uint32_t idxBlock = (uint32_t)(pZstdOut->cBlocksDone % LPC_DEC_ZSTD_BLOCKS);
+        size_t cbBlock = pZstdOut->acbBlocks[idxBlock];
+        pthread_mutex_unlock(&pZstdOut->Mtx);
+
+        /* Keep consuming after an error so the writer never blocks. */
+        if (!rc)
+            rc = lpcDecZstdOutCompress(pZstdOut, &pZstdOut->pabBlocks[(size_t)idxBlock * LPC_DEC_ZSTD_BLOCK_SIZE],
+                                       cbBlock, LPC_DEC_ZSTD_E_CONTINUE);
+
+        pthread_mutex_lock(&pZstdOut->Mtx);
+        pZstdOut->cBlocksDone++;
+        pthread_cond_signal(&pZstdOut->CondFree);
+    }
+    pthread_mutex_unlock(&pZstdOut->Mtx);
+
+    if (!rc)
+        rc = lpcDecZstdOutCompress(pZstdOut, NULL, 0, LPC_DEC_ZSTD_E_END);
+    pZstdOut->rc = rc;
+    return NULL;
+}
+
+
+/**
+ * Queues the block being filled for compression and waits until the next slot is free.
+ *
+ * @returns nothing.
+ * @param   pZstdOut                The compressed output stream.
+ */
+static void lpcDecZstdOutQueue(PLPCDECZSTDOUT pZstdOut)
+{
+    pthread_mutex_lock(&pZstdOut->Mtx);
+    pZstdOut->acbBlocks[pZstdOut->cBlocksQueued % LPC_DEC_ZSTD_BLOCKS] = pZstdOut->cbCur;
+    pZstdOut->cBlocksQueued++;
+    pthread_cond_signal(&pZstdOut->CondFilled);
+    while (pZstdOut->cBlocksQueued - pZstdOut->cBlocksDone >= LPC_DEC_ZSTD_BLOCKS)
+        pthread_cond_wait(&pZstdOut->CondFree, &pZstdOut->Mtx);
+    pthread_mutex_unlock(&pZstdOut->Mtx);
+
+    pZstdOut->cbCur = 0;
+}
+
+
+/**
+ * Write callback of the compressed output stream for fopencookie().
+ */
+static ssize_t lpcDecZstdOutWrite(void *pvCookie, const char *pchBuf, size_t cbBuf)
+{
+    PLPCDECZSTDOUT pZstdOut = (PLPCDECZSTDOUT)pvCookie;
+    size_t cbLeft = cbBuf;
+
+    while (cbLeft)
+    {
+        if (pZstdOut->cbCur == LPC_DEC_ZSTD_BLOCK_SIZE)
+            lpcDecZstdOutQueue(pZstdOut);
+
+        size_t cbCopy = LPC_DEC_ZSTD_BLOCK_SIZE - pZstdOut->cbCur;
+        if (cbCopy > cbLeft)
+            cbCopy = cbLeft;
+
+        uint8_t *pbBlock = &pZstdOut->pabBlocks[(size_t)(pZstdOut->cBlocksQueued % LPC_DEC_ZSTD_BLOCKS)
+                                                * LPC_DEC_ZSTD_BLOCK_SIZE];
+        memcpy(&pbBlock[pZstdOut->cbCur], pchBuf, cbCopy);
+        pZstdOut->cbCur += cbCopy;
+        pchBuf += cbCopy;
+        cbLeft -= cbCopy;
+    }
+
+    return (ssize_t)cbBuf;
+}
+
+
+/**
+ * Frees the resources of the given compressed output stream, the worker must not be running.
+ *
+ * @returns nothing.
+ * @param   pZstdOut                The compressed output stream.
+ */
+static void lpcDecZstdOutFree(PLPCDECZSTDOUT pZstdOut)
+{
+    if (pZstdOut->pCCtx)
+        g_Zstd.pfnFreeCCtx(pZstdOut->pCCtx);
+    pthread_cond_destroy(&pZstdOut->CondFree);
+    pthread_cond_destroy(&pZstdOut->CondFilled);
+    pthread_mutex_destroy(&pZstdOut->Mtx);
+    free(pZstdOut->pbOut);
+    free(pZstdOut->pabBlocks);
+    free(pZstdOut);
+}
+
+
+/**
+ * Close callback of the compressed output stream for fopencookie(), finishes the frame.
+ */
+static int lpcDecZstdOutClose(void *pvCookie)
+{
+    PLPCDECZSTDOUT pZstdOut = (PLPCDECZSTDOUT)pvCookie;
+
+    if (pZstdOut->cbCur)
+        lpcDecZstdOutQueue(pZstdOut);
+
+    pthread_mutex_lock(&pZstdOut->Mtx);
+    pZstdOut->fEos = 1;
+    pthread_cond_signal(&pZstdOut->CondFilled);
+    pthread_mutex_unlock(&pZstdOut->Mtx);
+    pthread_join(pZstdOut->hThread, NULL);
+
+    int rc = pZstdOut->rc;
+    if (   (pZstdOut->fCloseDst ? fclose(pZstdOut->pDst) : fflush(pZstdOut->pDst))
+        && !rc)
+        rc = EIO;
+
+    lpcDecZstdOutFree(pZstdOut);
+    return rc ? EOF : 0;
+}
+
+
+/**
+ * Opens a stream compressing everything written to it with zstd on a worker thread.
+ *
+ * @returns Status code.
+ * @param   pDst                    The stream to write the compressed data to.
+ * @param   fCloseDst               Flag whether to close the destination stream when the returned stream is closed.
+ * @param   iLevel                  The compression level, zstd uses multiple threads from LPC_DEC_ZSTD_LEVEL_MT on.
+ * @param   ppFile                  Where to store the stream on success.
+ */
+static int lpcDecZstdOutOpen(FILE *pDst, uint8_t fCloseDst, int iLevel, FILE **ppFile)
+{
+    int rc = lpcDecZstdLoad();
+    if (rc)
+        return rc;
+
+    PLPCDECZSTDOUT pZstdOut = (PLPCDECZSTDOUT)calloc(1, sizeof(*pZstdOut));
+    if (!pZstdOut)
+        return ENOMEM;
+
+    pthread_mutex_init(&pZstdOut->Mtx, NULL);
+    pthread_cond_init(&pZstdOut->CondFilled, NULL);
+    pthread_cond_init(&pZstdOut->CondFree, NULL);
+    pZstdOut->pDst      = pDst;
+    pZstdOut->fCloseDst = fCloseDst;
+    pZstdOut->cbOut     = g_Zstd.pfnCStreamOutSize();
+    pZstdOut->pbOut     = (uint8_t *)malloc(pZstdOut->cbOut);
+    pZstdOut->pabBlocks = (uint8_t *)malloc((size_t)LPC_DEC_ZSTD_BLOCKS * LPC_DEC_ZSTD_BLOCK_SIZE);
+    pZstdOut->pCCtx     = g_Zstd.pfnCreateCCtx();
+    if (   !pZstdOut->pbOut
+        || !pZstdOut->pabBlocks
+        || !pZstdOut->pCCtx
+        || g_Zstd.pfnIsError(g_Zstd.pfnCCtxSetParameter(pZstdOut->pCCtx, LPC_DEC_ZSTD_C_COMPRESSION_LEVEL, iLevel)))
+    {
+        lpcDecZstdOutFree(pZstdOut);
+        return ENOMEM;
+    }
+
+    /* Libraries built without thread support refuse the worker count and compress on our worker only. */
+    if (iLevel >= LPC_DEC_ZSTD_LEVEL_MT)
+    {
+        long cCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (cCpus > LPC_DEC_ZSTD_WORKERS_MAX)
+            cCpus = LPC_DEC_ZSTD_WORKERS_MAX;
+        if (cCpus > 1)
+            g_Zstd.pfnCCtxSetParameter(pZstdOut->pCCtx, LPC_DEC_ZSTD_C_NB_WORKERS, (int)cCpus);
+    }
+
+    rc = pthread_create(&pZstdOut->hThread, NULL, lpcDecZstdOutWorker, pZstdOut);
+    if (rc)
+    {
+        lpcDecZstdOutFree(pZstdOut);
+        return rc;
+    }
+
+    cookie_io_functions_t IoFuncs;
+    memset(&IoFuncs, 0, sizeof(IoFuncs));
+    IoFuncs.write = lpcDecZstdOutWrite;
+    IoFuncs.close = lpcDecZstdOutClose;
+    FILE *pFile = fopencookie(pZstdOut, "w", IoFuncs);
+    if (!pFile)
+    {
+        pthread_mutex_lock(&pZstdOut->Mtx);
+        pZstdOut->fEos = 1;
+        pthread_cond_signal(&pZstdOut->CondFilled);
+        pthread_mutex_unlock(&pZstdOut->Mtx);
+        pthread_join(pZstdOut->hThread, NULL);
+        lpcDecZstdOutFree(pZstdOut);
+        return ENOMEM;
+    }
+
+    *ppFile = pFile;
+    return 0;
+}
+
+
+/**
+ * Loads the SQLite library and resolves the used API.
+ *
+ * @returns Status code.
+ */
+static int lpcDecSqliteLoad(void)
+{
+    LPCDECSQLITEAPI Api;
+    const struct
+    {
+        const char      *pszSym;
+        void            *pvPfn;
+    } aSyms[] =
+    {
+        { "sqlite3_open",       &Api.pfnOpen      },
+        { "sqlite3_close",      &Api.pfnClose     },
+        { "sqlite3_exec",       &Api.pfnExec      },
+        { "sqlite3_prepare_v2", &Api.pfnPrepareV2 },
+        { "sqlite3_bind_int64", &Api.pfnBindInt64 },
+        { "sqlite3_bind_text",  &Api.pfnBindText  },
+        { "sqlite3_step",       &Api.pfnStep      },
+        { "sqlite3_reset",      &Api.pfnReset     },
+        { "sqlite3_finalize",   &Api.pfnFinalize  },
+        { "sqlite3_errmsg",     &Api.pfnErrMsg    }
+    };
+
+    if (g_Sqlite.pfnOpen)
+        return 0;
+
+    void *hLib = dlopen(LPC_DEC_SQLITE_LIB, RTLD_NOW | RTLD_LOCAL);
+    if (!hLib)
+        return ENOENT;
+
+    for (uint32_t i = 0; i < sizeof(aSyms) / sizeof(aSyms[0]); i++)
+    {
+        void *pvSym = dlsym(hLib, aSyms[i].pszSym);
+        if (!pvSym)
+        {
+            dlclose(hLib);
+            return ENOENT;
+        }
+
+        memcpy(aSyms[i].pvPfn, &pvSym, sizeof(pvSym));
+    }
+
+    g_Sqlite = Api;
+    return 0;
+}
+
+
+/**
+ * Records the given SQLite status, the first failure is reported together with the SQLite error message.
+ *
+ * @returns nothing.
+ * @param   pSqliteOut              The SQLite database output.
+ * @param   rcSqlite                The SQLite status code.
+ * @param   rcSuccess               The status code indicating success.
+ */
+static void lpcDecSqliteOutCheck(PLPCDECSQLITEOUT pSqliteOut, int rcSqlite, int rcSuccess)
+{
+    if (   rcSqlite != rcSuccess
+        && !pSqliteOut->rc)
+    {
+        fprintf(stderr, "SQLite failed with %d: %s\n", rcSqlite, g_Sqlite.pfnErrMsg(pSqliteOut->pDb));
+        pSqliteOut->rc = EIO;
+    }
+}
+
+
+/**
+ * Executes the given SQL statements.
+ *
+ * @returns nothing, the output status is set on failure.
+ * @param   pSqliteOut              The SQLite database output.
+ * @param   pszSql                  The statements.
+ */
+static void lpcDecSqliteOutExec(PLPCDECSQLITEOUT pSqliteOut, const char *pszSql)
+{
+    if (!pSqliteOut->rc)
+        lpcDecSqliteOutCheck(pSqliteOut, g_Sqlite.pfnExec(pSqliteOut->pDb, pszSql, NULL, NULL, NULL),
+                             LPC_DEC_SQLITE_OK);
+}
+
+
+/**
+ * Runs the given prepared insert with the bound parameters, starting a new transaction every
+ * LPC_DEC_SQLITE_TXN_ROWS rows.
+ *
+ * @returns nothing, the output status is set on failure.
+ * @param   pSqliteOut              The SQLite database output.
+ * @param   pStmt                   The prepared insert.
+ */
+static void lpcDecSqliteOutInsert(PLPCDECSQLITEOUT pSqliteOut, void *pStmt)
+{
+    lpcDecSqliteOutCheck(pSqliteOut, g_Sqlite.pfnStep(pStmt), LPC_DEC_SQLITE_DONE);
+    g_Sqlite.pfnReset(pStmt);
+
+    if (++pSqliteOut->cRowsTxn == LPC_DEC_SQLITE_TXN_ROWS)
+    {
+        lpcDecSqliteOutExec(pSqliteOut, "COMMIT; BEGIN");
+        pSqliteOut->cRowsTxn = 0;
+    }
+}
+
+
+/**
+ * Inserts an index/data pair record, callback of the output's own index/data pair decoder.
+ *
+ * @returns nothing.
+ * @param   pRec                    The record.
+ * @param   pvUser                  The SQLite database output.
+ */
+static void lpcDecSqliteOutIdxDataRec(PCLPCDECIDXDATAREC pRec, void *pvUser)
+{
+    PLPCDECSQLITEOUT pSqliteOut = (PLPCDECSQLITEOUT)pvUser;
+    void *pStmt = pSqliteOut->pStmtIdxData;
+
+    g_Sqlite.pfnBindInt64(pStmt, 1, (int64_t)pRec->uSeqNo);
+    g_Sqlite.pfnBindText(pStmt, 2, pRec->pPair->pszName, -1, NULL /*SQLITE_STATIC*/);
+    g_Sqlite.pfnBindInt64(pStmt, 3, pRec->fIdx);
+    g_Sqlite.pfnBindInt64(pStmt, 4, pRec->fWrite);
+    g_Sqlite.pfnBindInt64(pStmt, 5, pRec->bIdx);
+    g_Sqlite.pfnBindInt64(pStmt, 6, pRec->bVal);
+    lpcDecSqliteOutInsert(pSqliteOut, pStmt);
+}
+
+
+/**
+ * Inserts the given cycle and the index/data pair records it causes.
+ *
+ * @returns nothing.
+ * @param   pSqliteOut              The SQLite database output.
+ * @param   pCycle                  The cycle.
+ */
+static void lpcDecSqliteOutAdd(PLPCDECSQLITEOUT pSqliteOut, PCLPCDECSINKCYCLE pCycle)
+{
+    if (pSqliteOut->rc)
+        return;
+
+    void *pStmt = pSqliteOut->pStmtCycle;
+    g_Sqlite.pfnBindInt64(pStmt, 1, (int64_t)pCycle->Cycle.uSeqNo);
+    g_Sqlite.pfnBindInt64(pStmt, 2, pCycle->Cycle.bTyp);
+    g_Sqlite.pfnBindInt64(pStmt, 3, pCycle->Cycle.fWrite);
+    g_Sqlite.pfnBindInt64(pStmt, 4, pCycle->Cycle.u32Addr);
+    g_Sqlite.pfnBindInt64(pStmt, 5, pCycle->Cycle.bData);
+    g_Sqlite.pfnBindInt64(pStmt, 6, pCycle->Cycle.fAbort);
+    g_Sqlite.pfnBindInt64(pStmt, 7, pCycle->cSyncWaits);
+    lpcDecSqliteOutInsert(pSqliteOut, pStmt);
+
+    if (pSqliteOut->pIdxDataDec)
+        lpcDecIdxDataDecProcess(pSqliteOut->pIdxDataDec, &pCycle->Cycle);
+}
+
+
+/**
+ * Completes the bulk load, creates the indexes and closes the database.
+ *
+ * @returns Status code.
+ * @param   pSqliteOut              The SQLite database output.
+ */
+static int lpcDecSqliteOutClose(PLPCDECSQLITEOUT pSqliteOut)
+{
+    /* Indexing once at the end is much cheaper than maintaining the indexes during the load. */
+    lpcDecSqliteOutExec(pSqliteOut, "COMMIT");
+    lpcDecSqliteOutExec(pSqliteOut,
+                        "CREATE INDEX cycles_seq ON cycles(seq);"
+                        "CREATE INDEX cycles_addr ON cycles(type, addr);"
+                        "CREATE INDEX idx_data_seq ON idx_data(seq);"
+                        "CREATE INDEX idx_data_reg ON idx_data(pair, idx)");
+
+    int rc = pSqliteOut->rc;
+    if (pSqliteOut->pStmtCycle)
+        g_Sqlite.pfnFinalize(pSqliteOut->pStmtCycle);
+    if (pSqliteOut->pStmtIdxData)
+        g_Sqlite.pfnFinalize(pSqliteOut->pStmtIdxData);
+    if (   g_Sqlite.pfnClose(pSqliteOut->pDb) != LPC_DEC_SQLITE_OK
+        && !rc)
+        rc = EIO;
+    if (pSqliteOut->pIdxDataDec)
+        lpcDecIdxDataDecDestroy(pSqliteOut->pIdxDataDec);
+    free(pSqliteOut);
+    return rc;
+}
+
+
+/**
+ * Creates a SQLite database output, replacing any existing database.
+ *
+ * @returns Status code.
+ * @param   ppSqliteOut             Where to store the SQLite database output on success.
+ * @param   pszFilename             The database file.
+ * @param   pIdxDataDec             The index/data pair decoder whose pairs are recorded in the idx_data table,
+ *                                  NULL if none are configured.
+ */
+static int lpcDecSqliteOutCreate(PLPCDECSQLITEOUT *ppSqliteOut, const char *pszFilename,
+                                 PCLPCDECIDXDATADEC pIdxDataDec)
+{
+    int rc = lpcDecSqliteLoad();
+    if (rc)
+        return rc;
+
+    PLPCDECSQLITEOUT pSqliteOut = (PLPCDECSQLITEOUT)calloc(1, sizeof(*pSqliteOut));
+    if (!pSqliteOut)
+        return ENOMEM;
+
+    /* The records are decoded on the output's thread with its own copy of the pairs. */
+    if (   pIdxDataDec
+        && pIdxDataDec->cPairs)
+    {
+        rc = lpcDecIdxDataDecCreate(&pSqliteOut->pIdxDataDec, lpcDecSqliteOutIdxDataRec, pSqliteOut);
+        for (uint32_t i = 0; i < pIdxDataDec->cPairs && !rc; i++)
+        {
+            PCLPCDECIDXDATAPAIR pPair = &pIdxDataDec->aPairs[i];
+            rc = lpcDecIdxDataDecAddPair(pSqliteOut->pIdxDataDec, pPair->pszName, pPair->u16PortIdx,
+                                         pPair->u16PortData, pPair->bIdxMask);
+        }
+        if (rc)
+        {
+            if (pSqliteOut->pIdxDataDec)
+                lpcDecIdxDataDecDestroy(pSqliteOut->pIdxDataDec);
+            free(pSqliteOut);
+            return rc;
+        }
+    }
+
+    if (   unlink(pszFilename)
+        && errno != ENOENT)
+        rc = errno;
+    else if (g_Sqlite.pfnOpen(pszFilename, &pSqliteOut->pDb) != LPC_DEC_SQLITE_OK)
+        rc = EIO;
+    if (rc)
+    {
+        if (pSqliteOut->pDb)
+            g_Sqlite.pfnClose(pSqliteOut->pDb);
+        if (pSqliteOut->pIdxDataDec)
+            lpcDecIdxDataDecDestroy(pSqliteOut->pIdxDataDec);
+        free(pSqliteOut);
+        return rc;
+    }
+
+    /* No rollback journal and no syncing, a failed load leaves a database to throw away anyway. */
+    lpcDecSqliteOutExec(pSqliteOut,
+                        "PRAGMA journal_mode=OFF;"
+                        "PRAGMA synchronous=OFF;"
+                        "CREATE TABLE cycles (seq INTEGER NOT NULL, type INTEGER NOT NULL, dir INTEGER NOT NULL,"
+                        " addr INTEGER NOT NULL, data INTEGER NOT NULL, abort INTEGER NOT NULL,"
+                        " sync_waits INTEGER NOT NULL);"
+                        "CREATE TABLE idx_data (seq INTEGER NOT NULL, pair TEXT NOT NULL, idx_write INTEGER NOT NULL,"
+                        " dir INTEGER NOT NULL, idx INTEGER NOT NULL, val INTEGER NOT NULL);"
+                        "BEGIN");
+    if (!pSqliteOut->rc)
+        lpcDecSqliteOutCheck(pSqliteOut,
+                             g_Sqlite.pfnPrepareV2(pSqliteOut->pDb, "INSERT INTO cycles VALUES (?, ?, ?, ?, ?, ?, ?)",
+                                                   -1, &pSqliteOut->pStmtCycle, NULL),
+                             LPC_DEC_SQLITE_OK);
+    if (!pSqliteOut->rc)
+        lpcDecSqliteOutCheck(pSqliteOut,
+                             g_Sqlite.pfnPrepareV2(pSqliteOut->pDb, "INSERT INTO idx_data VALUES (?, ?, ?, ?, ?, ?)",
+                                                   -1, &pSqliteOut->pStmtIdxData, NULL),
+                             LPC_DEC_SQLITE_OK);
+    if (pSqliteOut->rc)
+    {
+        rc = pSqliteOut->rc;
+        pSqliteOut->rc = EIO;
+        lpcDecSqliteOutClose(pSqliteOut);
+        return rc;
+    }
+
+    *ppSqliteOut = pSqliteOut;
+    return 0;
+}
+
+
+/**
+ * Parses the given --shard-by keys into the global shard configuration.
+ *
+ * @returns Status code.
+ * @param   pszSpec                 The comma separated keys, type, dir or addr-range.
+ */
+static int lpcDecShardByParse(const char *pszSpec)
+{
+    static const char *s_apszKeys[] = { "type", "dir", "addr-range" };
+    uint8_t afKeys[3] = { 0, 0, 0 };
+
+    while (*pszSpec)
+    {
+        size_t cchKey = strcspn(pszSpec, ",");
+        uint32_t idxKey = 0;
+        while (   idxKey < 3
+               && (   strlen(s_apszKeys[idxKey]) != cchKey
+                   || strncmp(pszSpec, s_apszKeys[idxKey], cchKey)))
+            idxKey++;
+        if (idxKey == 3)
+            return EINVAL;
+
+        afKeys[idxKey] = 1;
+        pszSpec += cchKey;
+        if (*pszSpec == ',')
+            pszSpec++;
+    }
+
+    if (!afKeys[0] && !afKeys[1] && !afKeys[2])
+        return EINVAL;
+
+    g_ShardCfg.fByType  = afKeys[0];
+    g_ShardCfg.fByDir   = afKeys[1];
+    g_ShardCfg.fByRange = afKeys[2];
+    return 0;
+}
+
+
+/**
+ * Adds an address range from the given specification to the global shard configuration.
+ *
+ * @returns Status code.
+ * @param   pszSpec                 The range specification, <name>:<io|mem>:<first hex address>-<last hex address>.
+ */
+static int lpcDecShardRangeAdd(const char *pszSpec)
+{
+    if (g_ShardCfg.cRanges == LPC_DEC_SHARD_RANGES_MAX)
+        return ENOSPC;
+
+    /* The name ends up in file names, keep it to the harmless characters. */
+    size_t cchName = strspn(pszSpec, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_.");
+    if (   !cchName
+        || cchName >= LPC_DEC_SHARD_RANGE_NAME_MAX
+        || pszSpec[cchName] != ':'
+        || (cchName == 5 && !strncmp(pszSpec, "other", 5)))
+        return EINVAL;
+
+    uint8_t bTyp;
+    const char *pszRange = &pszSpec[cchName + 1];
+    if (!strncmp(pszRange, "io:", 3))
+    {
+        bTyp = LPC_DEC_CYC_TYPE_IO;
+        pszRange += 3;
+    }
+    else if (!strncmp(pszRange, "mem:", 4))
+    {
+        bTyp = LPC_DEC_CYC_TYPE_MEM;
+        pszRange += 4;
+    }
+    else
+        return EINVAL;
+
+    char *pszEnd = NULL;
+    unsigned long long uFirst = strtoull(pszRange, &pszEnd, 16);
+    if (pszEnd == pszRange || *pszEnd != '-')
+        return EINVAL;
+    pszRange = pszEnd + 1;
+    unsigned long long uLast = strtoull(pszRange, &pszEnd, 16);
+    if (   pszEnd == pszRange
+        || *pszEnd != '\0'
+        || uFirst > uLast
+        || uLast > (bTyp == LPC_DEC_CYC_TYPE_IO ? 0xffff : UINT32_MAX))
+        return EINVAL;
+
+    LPCDECSHARDRANGE *pRange = &g_ShardCfg.aRanges[g_ShardCfg.cRanges++];
+    memcpy(&pRange->szName[0], pszSpec, cchName);
+    pRange->szName[cchName] = '\0';
+    pRange->bTyp         = bTyp;
+    pRange->u32AddrFirst = (uint32_t)uFirst;
+    pRange->u32AddrLast  = (uint32_t)uLast;
+    return 0;
+}
+
+
+/**
+ * Returns the number of shards the given configuration splits the cycles into.
+ *
+ * @returns Number of shards.
+ * @param   pCfg                    The shard configuration.
+ */
+static uint32_t lpcDecShardCount(PCLPCDECSHARDCFG pCfg)
+{
+    return   (pCfg->fByRange ? pCfg->cRanges + 1 : 1)
+           * (pCfg->fByDir   ? 2 : 1)
+           * (pCfg->fByType  ? 4 : 1);
+}
+
+
+/**
+ * Returns the shard the given cycle belongs to.
+ *
+ * The shard index is a mixed radix number with the range as the most and the type as the least significant digit,
+ * keys not sharded by have a single digit value.
+ *
+ * @returns Shard index.
+ * @param   pCfg                    The shard configuration.
+ * @param   pCycle                  The cycle.
+ */
+static uint32_t lpcDecShardIdx(PCLPCDECSHARDCFG pCfg, PCLPCDECCYCLE pCycle)
+{
+    uint32_t idxShard = 0;
+
+    if (pCfg->fByRange)
+    {
+        while (   idxShard < pCfg->cRanges
+               && (   pCfg->aRanges[idxShard].bTyp != pCycle->bTyp
+                   || pCycle->u32Addr < pCfg->aRanges[idxShard].u32AddrFirst
+                   || pCycle->u32Addr > pCfg->aRanges[idxShard].u32AddrLast))
+            idxShard++;
+    }
+    if (pCfg->fByDir)
+        idxShard = idxShard * 2 + (pCycle->fWrite ? 1 : 0);
+    if (pCfg->fByType)
+        idxShard = idxShard * 4 + (pCycle->bTyp & 0x3);
+    return idxShard;
+}
+
+
+/**
+ * Formats the name of the given shard, the names of its keys joined by -.
+ *
+ * @returns nothing.
+ * @param   pCfg                    The shard configuration.
+ * @param   idxShard                The shard index.
+ * @param   pszName                 Where to store the name.
+ * @param   cbName                  Size of the name buffer.
+ */
+static void lpcDecShardName(PCLPCDECSHARDCFG pCfg, uint32_t idxShard, char *pszName, size_t cbName)
+{
+    static const char *s_apszTypes[] = { "io", "mem", "dma", "rsvd" };
+    const char *pszType  = NULL;
+    const char *pszDir   = NULL;
+    const char *pszRange = NULL;
+
+    if (pCfg->fByType)
+    {
+        pszType = s_apszTypes[idxShard % 4];
+        idxShard /= 4;
+    }
+    if (pCfg->fByDir)
+    {
+        pszDir = idxShard % 2 ? "write" : "read";
+        idxShard /= 2;
+    }
+    if (pCfg->fByRange)
+        pszRange = idxShard < pCfg->cRanges ? &pCfg->aRanges[idxShard].szName[0] : "other";
+
+    snprintf(pszName, cbName, "%s%s%s%s%s",
+             pszType ? pszType : "",
+             pszType && (pszDir || pszRange) ? "-" : "",
+             pszDir ? pszDir : "",
+             pszDir && pszRange ? "-" : "",
+             pszRange ? pszRange : "");
+}
+
+
+/**
+ * Creates the given output file, compressing it if requested.
+ *
+ * @returns Status code.
+ * @param   pszPath                 The path of the file.
+ * @param   fBinary                 Flag whether the output is binary.
+ * @param   iZstdLevel              The zstd compression level, 0 for none.
+ * @param   ppOut                   Where to store the stream on success.
+ */
+static int lpcDecSinkFileOpen(const char *pszPath, uint8_t fBinary, int iZstdLevel, FILE **ppOut)
+{
+    FILE *pOut = fopen(pszPath, fBinary ? "wb" : "w");
+    if (!pOut)
+        return errno;
+
+    if (iZstdLevel)
+    {
+        FILE *pZstdOut = NULL;
+        int rc = lpcDecZstdOutOpen(pOut, 1 /*fCloseDst*/, iZstdLevel, &pZstdOut);
+        if (rc)
+        {
+            fclose(pOut);
+            return rc;
+        }
+        pOut = pZstdOut;
+    }
+
+    *ppOut = pOut;
+    return 0;
+}
+
+
+/**
+ * Opens the given shard of the given shard sink.
+ *
+ * @returns Status code.
+ * @param   pSink                   The shard sink.
+ * @param   idxShard                The shard index.
+ */
+static int lpcDecSinkShardOpen(PLPCDECSINK pSink, uint32_t idxShard)
+{
+    PLPCDECSHARD pShard = &pSink->paShards[idxShard];
+    char szName[3 * LPC_DEC_SHARD_RANGE_NAME_MAX];
+    char szPath[LPC_DEC_SHARD_PATH_MAX];
+
+    /* lpcDecSinksAdd() made sure the template has exactly one %s. */
+    lpcDecShardName(&g_ShardCfg, idxShard, &szName[0], sizeof(szName));
+    const char *pszSubst = strstr(pSink->pszPath, "%s");
+    if (snprintf(&szPath[0], sizeof(szPath), "%.*s%s%s", (int)(pszSubst - pSink->pszPath), pSink->pszPath,
+                 &szName[0], pszSubst + 2) >= (int)sizeof(szPath))
+        return ENAMETOOLONG;
+
+    pShard->pchBuf = (char *)malloc(LPC_DEC_SHARD_BUF_SIZE);
+    if (!pShard->pchBuf)
+        return ENOMEM;
+
+    FILE *pOut = NULL;
+    int rc = lpcDecSinkFileOpen(&szPath[0],
+                                g_enmOutputFmt == LPCDECOUTFMT_PCAPNG || g_enmOutputFmt == LPCDECOUTFMT_ARROW,
+                                pSink->iZstdLevel, &pOut);
+    if (!rc)
+    {
+        setvbuf(pOut, pShard->pchBuf, _IOFBF, LPC_DEC_SHARD_BUF_SIZE);
+        rc = lpcDecCycleDumpStart(pOut, &pShard->pArrowOut);
+        if (!rc)
+            pShard->pOut = pOut;
+        else
+            fclose(pOut);
+    }
+    if (rc)
+    {
+        free(pShard->pchBuf);
+        pShard->pchBuf = NULL;
+    }
+    return rc;
+}
+
+
+/**
+ * Recreates the decoder state the cycle dumpers look at from the given recorded cycle.
+ *
+ * @returns nothing.
+ * @param   pLpcDec                 The decoder state to fill in.
+ * @param   pCycle                  The recorded cycle.
+ */
+static void lpcDecSinkCycleDecState(PLPCDEC pLpcDec, PCLPCDECSINKCYCLE pCycle)
+{
+    /* The dumper only looks at the SYNC waits, the state chain is part of the cycle. */
+    pLpcDec->cSyncWaits = pCycle->cSyncWaits;
+}
+
+
+/**
+ * Serializes the given cycle into a binary cycle dump record, see LPC_DEC_SINK_BIN_REC_SIZE for the layout.
+ *
+ * @returns Pointer past the record.
+ * @param   pb                      Where to store the record.
+ * @param   pCycle                  The cycle.
+ */
+static uint8_t *lpcDecSinkBinRecord(uint8_t *pb, PCLPCDECCYCLE pCycle)
+{
+    pb = lpcDecPcapngU32(pb, (uint32_t)pCycle->uSeqNo);
+    pb = lpcDecPcapngU32(pb, (uint32_t)(pCycle->uSeqNo >> 32));
+    pb = lpcDecPcapngU32(pb, pCycle->u32Addr);
+    *pb++ = pCycle->bTyp;
+    *pb++ = pCycle->fWrite ? 1 : 0;
+    *pb++ = pCycle->bData;
+    *pb++ = pCycle->fAbort ? 1 : 0;
+    return lpcDecPcapngU32(pb, pCycle->u32States);
+}
+
+
+/**
+ * Writes the given batch to the given sink.
+ *
+ * @returns nothing.
+ * @param   pSink                   The sink.
+ * @param   pBatch                  The batch to process.
+ */
+static void lpcDecSinkProcess(PLPCDECSINK pSink, PCLPCDECSINKBATCH pBatch)
+{
+    switch (pSink->enmType)
+    {
+        case LPCDECSINKTYPE_TEXT:
+        {
+            LPCDEC LpcDec;
+            uint8_t *pbPcapng = pSink->pbPcapng;
+            for (uint32_t i = 0; i < pBatch->cCycles; i++)
+            {
+                PCLPCDECSINKCYCLE pCycle = &pBatch->aCycles[i];
+
+                lpcDecSinkCycleDecState(&LpcDec, pCycle);
+                if (pbPcapng)
+                    pbPcapng = lpcDecCycleDumpPcapngBlock(pbPcapng, &LpcDec, &pCycle->Cycle);
+                else if (pSink->pArrowOut)
+                    lpcDecArrowOutCycleAdd(pSink->pArrowOut, &pCycle->Cycle);
+                else
+                    lpcDecCycleDump(pSink->pOut, &LpcDec, &pCycle->Cycle);
+            }
+
+            /* The whole batch goes out in a single write. */
+            if (pbPcapng)
+                fwrite(pSink->pbPcapng, 1, (size_t)(pbPcapng - pSink->pbPcapng), pSink->pOut);
+            break;
+        }
+        case LPCDECSINKTYPE_BIN:
+        {
+            uint8_t *pb = pSink->pbBin;
+            for (uint32_t i = 0; i < pBatch->cCycles; i++)
+                pb = lpcDecSinkBinRecord(pb, &pBatch->aCycles[i].Cycle);
+            fwrite(pSink->pbBin, 1, (size_t)(pb - pSink->pbBin), pSink->pOut);
+            break;
+        }
+        case LPCDECSINKTYPE_STATS:
+        {
+            for (uint32_t i = 0; i < pBatch->cCycles; i++)
+            {
+                PCLPCDECCYCLE pCycle = &pBatch->aCycles[i].Cycle;
+                if (pCycle->uSeqNo < pSink->uSeqNoFirst)
+                    pSink->uSeqNoFirst = pCycle->uSeqNo;
+                if (pCycle->uSeqNo > pSink->uSeqNoLast)
+                    pSink->uSeqNoLast = pCycle->uSeqNo;
+                if (pCycle->fAbort)
+                {
+                    pSink->cAborts++;
+                    continue;
+                }
+
+                pSink->acCycles[pCycle->bTyp & 0x3][pCycle->fWrite ? 1 : 0]++;
+                if (pCycle->bTyp == LPC_DEC_CYC_TYPE_IO)
+                    pSink->pacIoPort[pCycle->u32Addr & 0xffff]++;
+            }
+            break;
+        }
+        case LPCDECSINKTYPE_STORE:
+        {
+            for (uint32_t i = 0; i < pBatch->cCycles; i++)
+                lpcDecStoreWriterAdd(pSink->pStore, &pBatch->aCycles[i].Cycle);
+            break;
+        }
+        case LPCDECSINKTYPE_SQLITE:
+        {
+            for (uint32_t i = 0; i < pBatch->cCycles; i++)
+                lpcDecSqliteOutAdd(pSink->pSqlite, &pBatch->aCycles[i]);
+            break;
+        }
+        case LPCDECSINKTYPE_SHARD:
+        {
+            LPCDEC LpcDec;
+            for (uint32_t i = 0; i < pBatch->cCycles && !pSink->rc; i++)
+            {
+                PCLPCDECSINKCYCLE pCycle = &pBatch->aCycles[i];
+                uint32_t idxShard = lpcDecShardIdx(&g_ShardCfg, &pCycle->Cycle);
+                PLPCDECSHARD pShard = &pSink->paShards[idxShard];
+                if (!pShard->pOut)
+                {
+                    int rc = lpcDecSinkShardOpen(pSink, idxShard);
+                    if (rc)
+                    {
+                        pSink->rc = rc;
+                        break;
+                    }
+                }
+
+                if (pShard->pArrowOut)
+                    lpcDecArrowOutCycleAdd(pShard->pArrowOut, &pCycle->Cycle);
+                else
+                {
+                    lpcDecSinkCycleDecState(&LpcDec, pCycle);
+                    lpcDecCycleDump(pShard->pOut, &LpcDec, &pCycle->Cycle);
+                }
+                pShard->cCycles++;
+                if (ferror(pShard->pOut))
+                    pSink->rc = EIO;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (   pSink->pOut
+        && ferror(pSink->pOut)
+        && !pSink->rc)
+        pSink->rc = EIO;
+}
+
+
+/**
+ * Worker thread of an output sink.
+ *
+ * @returns NULL.
+ * @param   pvUser                  The sink.
+ */
+static void *lpcDecSinkWorker(void *pvUser)
+{
+    PLPCDECSINK pSink = (PLPCDECSINK)pvUser;
+    PLPCDECSINKS pSinks = pSink->pSinks;
+
+    pthread_mutex_lock(&pSinks->Mtx);
+    for (;;)
+    {
+        while (   pSink->cBatchesDone == pSinks->cBatchesPublished
+               && !pSinks->fEos)
+            pthread_cond_wait(&pSinks->CondData, &pSinks->Mtx);
+        if (pSink->cBatchesDone == pSinks->cBatchesPublished)
+            break;
+
+        PLPCDECSINKBATCH pBatch = &pSinks->paBatches[pSink->cBatchesDone % (LPC_DEC_SINK_QUEUE_DEPTH + 1)];
+        pthread_mutex_unlock(&pSinks->Mtx);
+
+        lpcDecSinkProcess(pSink, pBatch);
+
+        pthread_mutex_lock(&pSinks->Mtx);
+        pSink->cBatchesDone++;
+        pBatch->cRefs--;
+        pthread_cond_signal(&pSinks->CondSpace);
+    }
+    pthread_mutex_unlock(&pSinks->Mtx);
+    return NULL;
+}
+
+
+/**
+ * Creates an empty set of output sinks.
+ *
+ * @returns Status code.
+ * @param   ppSinks                 Where to store the pointer to the sinks on success.
+ */
+static int lpcDecSinksCreate(PLPCDECSINKS *ppSinks)
+{
+    PLPCDECSINKS pSinks = (PLPCDECSINKS)calloc(1, sizeof(*pSinks));
+    if (!pSinks)
+        return ENOMEM;
+
+    pSinks->paBatches = (PLPCDECSINKBATCH)calloc(LPC_DEC_SINK_QUEUE_DEPTH + 1, sizeof(*pSinks->paBatches));
+    if (!pSinks->paBatches)
+    {
+        free(pSinks);
+        return ENOMEM;
+    }
+
+    pthread_mutex_init(&pSinks->Mtx, NULL);
+    pthread_cond_init(&pSinks->CondData, NULL);
+    pthread_cond_init(&pSinks->CondSpace, NULL);
+    pSinks->pCur = &pSinks->paBatches[0];
+    *ppSinks = pSinks;
+    return 0;
+}
+
+
+/**
+ * Adds a sink from the given specification, it is opened by lpcDecSinksStart().
+ *
+ * @returns Status code.
+ * @param   pSinks                  The sinks.
+ * @param   pszSpec                 The sink specification, <text|bin|stats|store|sqlite|shard>:<path>, - writes to the
+ *                                  output stream, the path of a shard output contains a single %s for the shard name.
+ */
+static int lpcDecSinksAdd(PLPCDECSINKS pSinks, const char *pszSpec)
+{
+    static const struct
+    {
+        const char      *pszType;
+        LPCDECSINKTYPE  enmType;
+    } s_aTypes[] =
+    {
+        { "text:",  LPCDECSINKTYPE_TEXT  },
+        { "bin:",   LPCDECSINKTYPE_BIN   },
+        { "stats:", LPCDECSINKTYPE_STATS },
+        { "store:", LPCDECSINKTYPE_STORE },
+        { "sqlite:", LPCDECSINKTYPE_SQLITE },
+        { "shard:", LPCDECSINKTYPE_SHARD }
+    };
+
+    if (pSinks->cSinks == LPC_DEC_SINKS_MAX)
+        return ENOSPC;
+
+    PLPCDECSINK pSink = &pSinks->aSinks[pSinks->cSinks];
+    for (uint32_t i = 0; i < sizeof(s_aTypes) / sizeof(s_aTypes[0]); i++)
+        if (!strncmp(pszSpec, s_aTypes[i].pszType, strlen(s_aTypes[i].pszType)))
+        {
+            pSink->enmType = s_aTypes[i].enmType;
+            pSink->pszPath = pszSpec + strlen(s_aTypes[i].pszType);
+            break;
+        }
+    if (   !pSink->pszPath
+        || !*pSink->pszPath
+        || (   (   pSink->enmType == LPCDECSINKTYPE_STORE
+                || pSink->enmType == LPCDECSINKTYPE_SQLITE
+                || pSink->enmType == LPCDECSINKTYPE_SHARD)
+            && !strcmp(pSink->pszPath, "-"))
+        || (   pSink->enmType == LPCDECSINKTYPE_SHARD
+            && (   !strstr(pSink->pszPath, "%s")
+                || strchr(pSink->pszPath, '%') != strstr(pSink->pszPath, "%s")
+                || strchr(strstr(pSink->pszPath, "%s") + 2, '%'))))
+    {
+        memset(pSink, 0, sizeof(*pSink));
+        return EINVAL;
+    }
+
+    pSink->pSinks      = pSinks;
+    pSink->pszSpec     = pszSpec;
+    pSink->uSeqNoFirst = UINT64_MAX;
+    pSinks->cSinks++;
+    return 0;
+}
+
+
+/**
+ * Opens the outputs of all sinks and starts their workers.
+ *
+ * @returns Status code, the failing sink is reported.
+ * @param   pSinks                  The sinks.
+ * @param   pOut                    The output stream used for sinks writing to -.
+ * @param   fOutStarted             Flag whether pOut was already prepared for dumping cycles.
+ * @param   pArrowOut               The Arrow output stream writing to pOut if it was started in the Arrow format,
+ *                                  NULL otherwise.
+ * @param   iZstdLevel              The zstd compression level for the text, bin and stats outputs, 0 for none.
+ * @param   pIdxDataDec             The index/data pair decoder whose pairs the SQLite outputs record, NULL if none.
+ */
+static int lpcDecSinksStart(PLPCDECSINKS pSinks, FILE *pOut, uint8_t fOutStarted, PLPCDECARROWOUT pArrowOut,
+                            int iZstdLevel, PCLPCDECIDXDATADEC pIdxDataDec)
+{
+    for (uint32_t i = 0; i < pSinks->cSinks; i++)
+    {
+        PLPCDECSINK pSink = &pSinks->aSinks[i];
+        int rc = 0;
+
+        if (pSink->enmType == LPCDECSINKTYPE_STORE)
+            rc = lpcDecStoreWriterCreate(&pSink->pStore, pSink->pszPath, LPC_DEC_STORE_CHUNK_CYCLES_DEF);
+        else if (pSink->enmType == LPCDECSINKTYPE_SQLITE)
+            rc = lpcDecSqliteOutCreate(&pSink->pSqlite, pSink->pszPath, pIdxDataDec);
+        else if (pSink->enmType == LPCDECSINKTYPE_SHARD)
+        {
+            /* The shards are opened by the worker when their first cycle arrives. */
+            pSink->iZstdLevel = iZstdLevel;
+            pSink->cShards    = lpcDecShardCount(&g_ShardCfg);
+            pSink->paShards   = (PLPCDECSHARD)calloc(pSink->cShards, sizeof(*pSink->paShards));
+            if (!pSink->paShards)
+                rc = ENOMEM;
+        }
+        else if (!strcmp(pSink->pszPath, "-"))
+            pSink->pOut = pOut;
+        else
+        {
+            rc = lpcDecSinkFileOpen(pSink->pszPath, pSink->enmType == LPCDECSINKTYPE_BIN, iZstdLevel, &pSink->pOut);
+            if (!rc)
+                pSink->fCloseOut = 1;
+        }
+
+        if (   !rc
+            && pSink->enmType == LPCDECSINKTYPE_BIN)
+        {
+            pSink->pbBin = (uint8_t *)malloc((size_t)LPC_DEC_SINK_BATCH_CYCLES * LPC_DEC_SINK_BIN_REC_SIZE);
+            if (!pSink->pbBin)
+                rc = ENOMEM;
+            else if (fwrite(LPC_DEC_SINK_BIN_MAGIC, sizeof(LPC_DEC_SINK_BIN_MAGIC) - 1, 1, pSink->pOut) != 1)
+                rc = EIO;
+        }
+        if (   !rc
+            && pSink->enmType == LPCDECSINKTYPE_TEXT
+            && g_enmOutputFmt == LPCDECOUTFMT_PCAPNG)
+        {
+            pSink->pbPcapng = (uint8_t *)malloc((size_t)LPC_DEC_SINK_BATCH_CYCLES * LPC_DEC_PCAPNG_EPB_SIZE);
+            if (!pSink->pbPcapng)
+                rc = ENOMEM;
+        }
+        if (   !rc
+            && pSink->enmType == LPCDECSINKTYPE_TEXT)
+        {
+            if (pSink->pOut != pOut || !fOutStarted)
+            {
+                rc = lpcDecCycleDumpStart(pSink->pOut, &pSink->pArrowOut);
+                if (   !rc
+                    && pSink->pOut == pOut)
+                {
+                    fOutStarted = 1;
+                    pArrowOut   = pSink->pArrowOut;
+                }
+            }
+            else
+            {
+                pSink->pArrowOut       = pArrowOut;
+                pSink->fArrowOutShared = 1;
+            }
+        }
+        if (   !rc
+            && pSink->enmType == LPCDECSINKTYPE_STATS)
+        {
+            pSink->pacIoPort = (uint64_t *)calloc(LPC_DEC_IO_PORT_COUNT, sizeof(*pSink->pacIoPort));
+            if (!pSink->pacIoPort)
+                rc = ENOMEM;
+        }
+        if (!rc)
+            rc = pthread_create(&pSink->hThread, NULL, lpcDecSinkWorker, pSink);
+        if (rc)
+        {
+            /* The sinks started so far are torn down by lpcDecSinksDestroy(). */
+            fprintf(stderr, "The output '%s' could not be created (%d)\n", pSink->pszSpec, rc);
+            free(pSink->pacIoPort);
+            pSink->pacIoPort = NULL;
+            free(pSink->pbPcapng);
+            pSink->pbPcapng = NULL;
+            free(pSink->pbBin);
+            pSink->pbBin = NULL;
+            free(pSink->paShards);
+            pSink->paShards = NULL;
+            if (pSink->pStore)
+                lpcDecStoreWriterClose(pSink->pStore);
+            if (pSink->pSqlite)
+                lpcDecSqliteOutClose(pSink->pSqlite);
+            if (pSink->fCloseOut && pSink->pOut)
+                fclose(pSink->pOut);
+            pSinks->cSinks = i;
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * Hands the current batch to all sinks and starts the next one, waiting for sinks which fell too far behind.
+ *
+ * @returns nothing.
+ * @param   pSinks                  The sinks.
+ */
+static void lpcDecSinksPublish(PLPCDECSINKS pSinks)
+{
+    pthread_mutex_lock(&pSinks->Mtx);
+    for (uint32_t i = 0; i < pSinks->cSinks; i++)
+    {
+        PLPCDECSINK pSink = &pSinks->aSinks[i];
+        if (pSinks->cBatchesPublished - pSink->cBatchesDone < LPC_DEC_SINK_QUEUE_DEPTH)
+            continue;
+
+        /* Waiting is the only lossless option, but make it visible. */
+        if (!pSink->cStalls)
+            fprintf(stderr, "Output '%s' can't keep up, the decoder waits for it\n", pSink->pszSpec);
+        pSink->cStalls++;
+        uint64_t nsStart = lpcDecNanoTs();
+        while (pSinks->cBatchesPublished - pSink->cBatchesDone >= LPC_DEC_SINK_QUEUE_DEPTH)
+            pthread_cond_wait(&pSinks->CondSpace, &pSinks->Mtx);
+        pSink->nsStalled += lpcDecNanoTs() - nsStart;
+    }
+
+    /* No sink lags more than the queue depth behind, so the next slot was processed by all of them. */
+    pSinks->pCur->cRefs = pSinks->cSinks;
+    pSinks->cBatchesPublished++;
+    pthread_cond_broadcast(&pSinks->CondData);
+    pthread_mutex_unlock(&pSinks->Mtx);
+
+    pSinks->pCur = &pSinks->paBatches[pSinks->cBatchesPublished % (LPC_DEC_SINK_QUEUE_DEPTH + 1)];
+    pSinks->pCur->cCycles = 0;
+}
+
+
+/**
+ * Adds the given decoded cycle to the current batch of the sinks.
+ *
+ * @returns nothing.
+ * @param   pSinks                  The sinks.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with, can be NULL.
+ * @param   pCycle                  The decoded cycle.
+ */
+static inline void lpcDecSinksCycle(PLPCDECSINKS pSinks, PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle)
+{
+    PLPCDECSINKCYCLE pSinkCycle = &pSinks->pCur->aCycles[pSinks->pCur->cCycles++];
+    pSinkCycle->Cycle      = *pCycle;
+    pSinkCycle->cSyncWaits = pLpcDec ? pLpcDec->cSyncWaits : 0;
+
+    if (pSinks->pCur->cCycles == LPC_DEC_SINK_BATCH_CYCLES)
+        lpcDecSinksPublish(pSinks);
+}
+
+
+/**
+ * Writes the summary of the given stats sink.
+ *
+ * @returns nothing.
+ * @param   pSink                   The stats sink.
+ * @param   pClkStats               The LCLK statistics to append, NULL if disabled.
+ */
+static void lpcDecSinkStatsDump(PCLPCDECSINK pSink, PCLPCDECCLKSTATS pClkStats)
+{
+    FILE *pOut = pSink->pOut;
+    uint64_t cCycles = pSink->cAborts;
+    for (uint32_t i = 0; i < 4; i++)
+        cCycles += pSink->acCycles[i][0] + pSink->acCycles[i][1];
+
+    fprintf(pOut, "Cycles: %" PRIu64 " (%" PRIu64 " aborted)\n", cCycles, pSink->cAborts);
+    if (cCycles)
+        fprintf(pOut, "Sequence numbers: %" PRIu64 " - %" PRIu64 "\n", pSink->uSeqNoFirst, pSink->uSeqNoLast);
+    for (uint8_t bTyp = 0; bTyp < 4; bTyp++)
+        if (pSink->acCycles[bTyp][0] || pSink->acCycles[bTyp][1])
+            fprintf(pOut, "%s: %" PRIu64 " reads, %" PRIu64 " writes\n", lpcDecCycTypeToStr(bTyp),
+                    pSink->acCycles[bTyp][0], pSink->acCycles[bTyp][1]);
+
+    /* Simple selection of the busiest ports, the list is short. */
+    uint32_t aidxTop[LPC_DEC_SINK_STATS_TOP_PORTS];
+    uint32_t cTop = 0;
+    for (uint32_t idxPort = 0; idxPort < LPC_DEC_IO_PORT_COUNT; idxPort++)
+    {
+        uint64_t cAccesses = pSink->pacIoPort[idxPort];
+        if (!cAccesses)
+            continue;
+
+        uint32_t idxIns = cTop;
+        while (idxIns > 0 && pSink->pacIoPort[aidxTop[idxIns - 1]] < cAccesses)
+            idxIns--;
+        if (idxIns == LPC_DEC_SINK_STATS_TOP_PORTS)
+            continue;
+
+        if (cTop < LPC_DEC_SINK_STATS_TOP_PORTS)
+            cTop++;
+        memmove(&aidxTop[idxIns + 1], &aidxTop[idxIns], (cTop - 1 - idxIns) * sizeof(aidxTop[0]));
+        aidxTop[idxIns] = idxPort;
+    }
+
+    if (cTop)
+        fprintf(pOut, "Busiest I/O ports:\n");
+    for (uint32_t i = 0; i < cTop; i++)
+        fprintf(pOut, "    0x%04x: %" PRIu64 "\n", aidxTop[i], pSink->pacIoPort[aidxTop[i]]);
+
+    if (pClkStats)
+        lpcDecClkStatsDumpSummary(pClkStats, pOut);
+}
+
+
+/**
+ * Flushes the remaining cycles to all sinks, waits for them to finish and destroys them.
+ *
+ * @returns Status code of the first failing sink.
+ * @param   pSinks                  The sinks.
+ */
+static int lpcDecSinksDestroy(PLPCDECSINKS pSinks)
+{
+    int rc = 0;
+
+    if (pSinks->pCur->cCycles)
+        lpcDecSinksPublish(pSinks);
+
+    pthread_mutex_lock(&pSinks->Mtx);
+    pSinks->fEos = 1;
+    pthread_cond_broadcast(&pSinks->CondData);
+    pthread_mutex_unlock(&pSinks->Mtx);
+
+    for (uint32_t i = 0; i < pSinks->cSinks; i++)
+    {
+        PLPCDECSINK pSink = &pSinks->aSinks[i];
+        pthread_join(pSink->hThread, NULL);
+
+        int rcSink = pSink->rc;
+        if (pSink->enmType == LPCDECSINKTYPE_STATS)
+            lpcDecSinkStatsDump(pSink, pSinks->pClkStats);
+        if (pSink->pStore)
+        {
+            int rc2 = lpcDecStoreWriterClose(pSink->pStore);
+            if (!rcSink)
+                rcSink = rc2;
+        }
+        if (pSink->pSqlite)
+        {
+            int rc2 = lpcDecSqliteOutClose(pSink->pSqlite);
+            if (!rcSink)
+                rcSink = rc2;
+        }
+        if (   pSink->pArrowOut
+            && !pSink->fArrowOutShared)
+        {
+            int rc2 = lpcDecArrowOutClose(pSink->pArrowOut);
+            if (!rcSink)
+                rcSink = rc2;
+        }
+        if (pSink->pOut)
+        {
+            if (   (pSink->fCloseOut ? fclose(pSink->pOut) : fflush(pSink->pOut))
+                && !rcSink)
+                rcSink = EIO;
+        }
+        for (uint32_t idxShard = 0; idxShard < pSink->cShards; idxShard++)
+        {
+            PLPCDECSHARD pShard = &pSink->paShards[idxShard];
+            if (!pShard->pOut)
+                continue;
+
+            if (pShard->pArrowOut)
+            {
+                int rc2 = lpcDecArrowOutClose(pShard->pArrowOut);
+                if (!rcSink)
+                    rcSink = rc2;
+            }
+            if (   fclose(pShard->pOut)
+                && !rcSink)
+                rcSink = EIO;
+            free(pShard->pchBuf);
+            if (g_fVerbose)
+            {
+                char szName[3 * LPC_DEC_SHARD_RANGE_NAME_MAX];
+                lpcDecShardName(&g_ShardCfg, idxShard, &szName[0], sizeof(szName));
+                fprintf(stderr, "Output '%s' shard %s: %" PRIu64 " cycles\n", pSink->pszSpec, &szName[0],
+                        pShard->cCycles);
+            }
+        }
+        if (rcSink)
+        {
+            fprintf(stderr, "Writing the output '%s' failed with %d\n", pSink->pszSpec, rcSink);
+            if (!rc)
+                rc = rcSink;
+        }
+        if (pSink->cStalls)
+            fprintf(stderr, "Output '%s' stalled the decoder %" PRIu64 " times for %.3f s\n", pSink->pszSpec,
+                    pSink->cStalls, (double)pSink->nsStalled / 1000000000.0);
+        free(pSink->pacIoPort);
+        free(pSink->pbPcapng);
+        free(pSink->pbBin);
+        free(pSink->paShards);
+    }
+
+    pthread_cond_destroy(&pSinks->CondSpace);
+    pthread_cond_destroy(&pSinks->CondData);
+    pthread_mutex_destroy(&pSinks->Mtx);
+    free(pSinks->paBatches);
+    free(pSinks);
+    return rc;
+}
+
+
+/**
+ * Index/data pair record callback writing the record to the output stream.
+ *
+ * @returns nothing.
+ * @param   pRec                    The record.
+ * @param   pvUser                  The decoding context.
+ */
+static void lpcDecCtxIdxDataRec(PCLPCDECIDXDATAREC pRec, void *pvUser)
+{
+    PLPCDECCTX pCtx = (PLPCDECCTX)pvUser;
+
+    if (!pRec->fIdx)
+        fprintf(pCtx->pOutText, "%" PRIu64 ": %s[0x%02x] %s 0x%02x\n", pRec->uSeqNo, pRec->pPair->pszName,
+                pRec->bIdx, pRec->fWrite ? "<-" : "->", pRec->bVal);
+}
+
+
+/**
+ * Ensures the index/data pair post-decoder of the given decoding context exists.
+ *
+ * @returns Status code.
+ * @param   pCtx                    The decoding context.
+ */
+static int lpcDecCtxIdxDataDecEnsure(PLPCDECCTX pCtx)
+{
+    if (pCtx->pIdxDataDec)
+        return 0;
+
+    return lpcDecIdxDataDecCreate(&pCtx->pIdxDataDec, lpcDecCtxIdxDataRec, pCtx);
+}
+
+
+/**
+ * Adds a Super I/O configuration space decoder to the given decoding context.
+ *
+ * @returns Status code, EEXIST if the port is already decoded.
+ * @param   pCtx                    The decoding context.
+ * @param   pszSpec                 Either the name of an index/data pair preset or the index register I/O port,
+ *                                  the data register is expected at the following port.
+ */
+static int lpcDecCtxSioAdd(PLPCDECCTX pCtx, const char *pszSpec)
+{
+    if (pCtx->cSioDecs == LPC_DEC_SIO_DEC_MAX)
+        return EINVAL;
+
+    int rc = lpcDecCtxIdxDataDecEnsure(pCtx);
+    if (rc)
+        return rc;
+
+    PCLPCDECIDXDATAPRESET pPreset = NULL;
+    for (uint32_t i = 0; i < sizeof(g_aIdxDataPresets) / sizeof(g_aIdxDataPresets[0]); i++)
+    {
+        if (!strcmp(g_aIdxDataPresets[i].pszPreset, pszSpec))
+        {
+            pPreset = &g_aIdxDataPresets[i];
+            break;
+        }
+    }
+
+    unsigned long uPortIdx = 0;
+    if (pPreset)
+        uPortIdx = pPreset->u16PortIdx;
+    else
+    {
+        char *pszEnd = NULL;
+        uPortIdx = strtoul(pszSpec, &pszEnd, 0);
+        if (*pszEnd != '\0' || uPortIdx >= UINT16_MAX)
+            return EINVAL;
+    }
+
+    PLPCDECIDXDATAPAIR pPair = lpcDecIdxDataDecQueryPairByPort(pCtx->pIdxDataDec, (uint16_t)uPortIdx);
+    if (!pPair)
+    {
+        if (pPreset)
+            rc = lpcDecIdxDataDecAddPair(pCtx->pIdxDataDec, pPreset->pszName, pPreset->u16PortIdx,
+                                         pPreset->u16PortData, pPreset->bIdxMask);
+        else
+        {
+            static const char *s_apszCustomNames[LPC_DEC_SIO_DEC_MAX] = { "SIO-0", "SIO-1", "SIO-2", "SIO-3" };
+            rc = lpcDecIdxDataDecAddPair(pCtx->pIdxDataDec, s_apszCustomNames[pCtx->cSioDecs],
+                                         (uint16_t)uPortIdx, (uint16_t)(uPortIdx + 1), 0xff);
+        }
+        if (rc)
+            return rc;
+
+        pPair = lpcDecIdxDataDecQueryPairByPort(pCtx->pIdxDataDec, (uint16_t)uPortIdx);
+    }
+
+    /* A second decoder would take the pair over from the first one. */
+    for (uint32_t i = 0; i < pCtx->cSioDecs; i++)
+    {
+        if (pCtx->apSioDec[i]->pPair == pPair)
+            return EEXIST;
+    }
+
+    PLPCDECSIODEC pSioDec = (PLPCDECSIODEC)calloc(1, sizeof(*pSioDec));
+    if (!pSioDec)
+        return ENOMEM;
+
+    pSioDec->pPair = pPair;
+    pSioDec->pOut  = pCtx->pOutText;
+    pSioDec->pKey  = NULL;
+    lpcDecIdxDataPairSetConsumer(pPair, lpcDecSioDecRec, pSioDec);
+    pCtx->apSioDec[pCtx->cSioDecs++] = pSioDec;
+    return 0;
+}
+
+
+/**
+ * Cycle callback writing the cycle to the output stream and feeding it to the enabled post-decoders.
+ *
+ * @returns nothing.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with.
+ * @param   pCycle                  The decoded cycle.
+ * @param   pvUser                  The decoding context.
+ */
+static void lpcDecCtxCycle(PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle, void *pvUser)
+{
+    PLPCDECCTX pCtx = (PLPCDECCTX)pvUser;
+
+    if (pCtx->pTrigger)
+        lpcDecTriggerProcess(pCtx->pTrigger, pLpcDec, pCycle);
+    else if (pCtx->pArrowOut)
+        lpcDecArrowOutCycleAdd(pCtx->pArrowOut, pCycle);
+    else if (!pCtx->pSinks)
+        lpcDecCycleDump(pCtx->pOut, pLpcDec, pCycle);
+    if (pCtx->pSinks)
+        lpcDecSinksCycle(pCtx->pSinks, pLpcDec, pCycle);
+    if (pCtx->pIdxDataDec)
+        lpcDecIdxDataDecProcess(pCtx->pIdxDataDec, pCycle);
+    if (pCtx->pKcsDec)
+        lpcDecKcsDecProcess(pCtx->pKcsDec, pCycle);
+    if (pCtx->pValIdx)
+        lpcDecValIdxBuildProcess(pCtx->pValIdx, pCycle);
+    if (pCtx->pFind)
+        lpcDecFindProcess(pCtx->pFind, pCycle);
+}
+
+
+/**
+ * Parses a cycle type given on the command line.
+ *
+ * @returns Status code.
+ * @param   pszTyp                  The cycle type string (io or mem).
+ * @param   pbTyp                   Where to store the cycle type on success.
+ */
+static int lpcDecCycTypeParse(const char *pszTyp, uint8_t *pbTyp)
+{
+    if (!strcmp(pszTyp, "io"))
+        *pbTyp = LPC_DEC_CYC_TYPE_IO;
+    else if (!strcmp(pszTyp, "mem"))
+        *pbTyp = LPC_DEC_CYC_TYPE_MEM;
+    else
+        return EINVAL;
+
+    return 0;
+}
+
+
+/**
+ * Looks up the value of an address in the given value index.
+ *
+ * @returns Process exit code.
+ * @param   pszIndex                The value index file.
+ * @param   bTyp                    Cycle type of the address.
+ * @param   u32Addr                 The address to look up.
+ * @param   fAt                     Flag whether to return the value at the given sequence number,
+ *                                  all writes to the address are listed otherwise.
+ * @param   uSeqNoAt                The sequence number to return the value at.
+ */
+static int lpcDecValIdxQuery(const char *pszIndex, uint8_t bTyp, uint32_t u32Addr, uint8_t fAt, uint64_t uSeqNoAt)
+{
+    int fd = open(pszIndex, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "The file '%s' could not be opened\n", pszIndex);
+        return 1;
+    }
+
+    struct stat StatBuf;
+    void *pvMap = MAP_FAILED;
+    if (!fstat(fd, &StatBuf) && (size_t)StatBuf.st_size >= sizeof(LPCDECVALIDXHDR))
+        pvMap = mmap(NULL, (size_t)StatBuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pvMap == MAP_FAILED)
+    {
+        fprintf(stderr, "The file '%s' could not be mapped\n", pszIndex);
+        return 1;
+    }
+
+    int rcExit = 1;
+    size_t cbFile = (size_t)StatBuf.st_size;
+    size_t cbArrays = cbFile - sizeof(LPCDECVALIDXHDR);
+    PCLPCDECVALIDXHDR pHdr = (PCLPCDECVALIDXHDR)pvMap;
+
+    /* The counts come from the file, each term is checked against its size before multiplying. */
+    if (   !memcmp(&pHdr->achMagic[0], LPC_DEC_VAL_IDX_MAGIC, sizeof(pHdr->achMagic))
+        && pHdr->u32Version == LPC_DEC_VAL_IDX_VERSION
+        && pHdr->cAddrs <= cbArrays / sizeof(LPCDECVALIDXADDR)
+        && pHdr->cEntries <=   (cbArrays - pHdr->cAddrs * sizeof(LPCDECVALIDXADDR))
+                             / (sizeof(uint64_t) + sizeof(uint8_t))
+        && cbArrays ==   pHdr->cAddrs * sizeof(LPCDECVALIDXADDR)
+                       + pHdr->cEntries * (sizeof(uint64_t) + sizeof(uint8_t)))
+    {
+        PCLPCDECVALIDXADDR paAddrs = (PCLPCDECVALIDXADDR)(pHdr + 1);
+        const uint64_t *pau64SeqNo = (const uint64_t *)&paAddrs[pHdr->cAddrs];
+        const uint8_t *pabVal = (const uint8_t *)&pau64SeqNo[pHdr->cEntries];
+
+        /* Binary search for the address... */
+        uint64_t u64Key = LPC_DEC_VAL_IDX_KEY(bTyp, u32Addr);
+        uint32_t idxLow = 0;
+        uint32_t idxHigh = pHdr->cAddrs;
+        while (idxLow < idxHigh)
+        {
+            uint32_t idxMid = idxLow + (idxHigh - idxLow) / 2;
+            if (LPC_DEC_VAL_IDX_KEY(paAddrs[idxMid].bTyp, paAddrs[idxMid].u32Addr) < u64Key)
+                idxLow = idxMid + 1;
+            else
+                idxHigh = idxMid;
+        }
+
+        PCLPCDECVALIDXADDR pAddr = NULL;
+        if (   idxLow < pHdr->cAddrs
+            && LPC_DEC_VAL_IDX_KEY(paAddrs[idxLow].bTyp, paAddrs[idxLow].u32Addr) == u64Key
+            && paAddrs[idxLow].idxFirst <= pHdr->cEntries
+            && paAddrs[idxLow].cEntries <= pHdr->cEntries - paAddrs[idxLow].idxFirst)
+            pAddr = &paAddrs[idxLow];
+
+        const char *pszTyp = lpcDecCycTypeToStr(bTyp);
+        rcExit = 0;
+        if (!pAddr)
+            printf("%s 0x%04x: <never written>\n", pszTyp, u32Addr);
+        else if (!fAt)
+        {
+            for (uint64_t i = pAddr->idxFirst; i < pAddr->idxFirst + pAddr->cEntries; i++)
+                printf("%" PRIu64 ": %s 0x%04x <- 0x%02x\n", pau64SeqNo[i], pszTyp, u32Addr, pabVal[i]);
+        }
+        else
+        {
+            /* ... and then for the last write at or before the given sequence number. */
+            uint64_t idxWrLow = pAddr->idxFirst;
+            uint64_t idxWrHigh = pAddr->idxFirst + pAddr->cEntries;
+            while (idxWrLow < idxWrHigh)
+            {
+                uint64_t idxMid = idxWrLow + (idxWrHigh - idxWrLow) / 2;
+                if (pau64SeqNo[idxMid] <= uSeqNoAt)
+                    idxWrLow = idxMid + 1;
+                else
+                    idxWrHigh = idxMid;
+            }
+
+            if (idxWrLow == pAddr->idxFirst)
+                printf("%s 0x%04x at %" PRIu64 ": <not written yet>\n", pszTyp, u32Addr, uSeqNoAt);
+            else
+                printf("%s 0x%04x at %" PRIu64 ": 0x%02x (written at %" PRIu64 ")\n", pszTyp, u32Addr, uSeqNoAt,
+                       pabVal[idxWrLow - 1], pau64SeqNo[idxWrLow - 1]);
+        }
+    }
+    else
+        fprintf(stderr, "The file '%s' is not a valid value index\n", pszIndex);
+
+    munmap(pvMap, cbFile);
+    return rcExit;
+}
+
+
+
+/**
+ * The query command, looks up values in a value index or cycles in a cycle store without re-decoding the capture.
+ *
+ * @returns Process exit code.
+ * @param   argc                    Number of arguments, the first one being the command name.
+ * @param   argv                    The arguments.
+ */
+static int lpcDecCmdQuery(int argc, char *argv[])
+{
+    int ch = 0;
+    int idxOption = 0;
+    const char *pszIndex = NULL;
+    const char *pszStore = NULL;
+    uint8_t fAt = 0;
+    uint64_t uSeqNoAt = 0;
+    uint8_t fAddr = 0;
+    uint8_t fCount = 0;
+    uint8_t fTyp = 0;
+    uint8_t bTyp = LPC_DEC_CYC_TYPE_IO;
+    uint8_t bmDir = 0x3;
+    LPCDECSTOREFILTER Filter;
+
+    Filter.u32AddrFirst = 0;
+    Filter.u32AddrLast  = UINT32_MAX;
+    Filter.bmTypDir     = 0xff;
+    Filter.uSeqNoFirst  = 0;
+    Filter.uSeqNoLast   = UINT64_MAX;
+
+    while ((ch = getopt_long (argc, argv, "Hx:a:A:t:s:d:f:T:c", &g_aOptionsQuery[0], &idxOption)) != -1)
+    {
+        switch (ch)
+        {
+            case 'h':
+            case 'H':
+                printf("%s: Looks up values in a value index created with --value-index or cycles in a cycle store\n"
+                       "created with the index command\n"
+                       "    --index <path/to/value/index>\n"
+                       "        --addr <address>\n"
+                       "        --type <io|mem> Cycle type of the address, defaults to io\n"
+                       "        --at <sequence number> Returns the value the address held at the given point,\n"
+                       "            lists all writes to the address if omitted\n"
+                       "    --store <path/to/cycle/store>\n"
+                       "        --addr <address>[-<last address>] Only cycles accessing the given address (range)\n"
+                       "        --type <io|mem> Only cycles of the given type\n"
+                       "        --dir <read|write> Only cycles in the given direction\n"
+                       "        --from <sequence number> / --to <sequence number> Only cycles in the given range\n"
+                       "        --count Only print the number of matching cycles\n",
+                       argv[0]);
+                return 0;
+            case 'x':
+                pszIndex = optarg;
+                break;
+            case 's':
+                pszStore = optarg;
+                break;
+            case 'a':
+            case 'f':
+            case 'T':
+            {
+                char *pszEnd = NULL;
+                uint64_t uSeqNo = strtoull(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0')
+                {
+                    fprintf(stderr, "Invalid sequence number: %s\n", optarg);
+                    return 1;
+                }
+                if (ch == 'a')
+                {
+                    uSeqNoAt = uSeqNo;
+                    fAt = 1;
+                }
+                else if (ch == 'f')
+                    Filter.uSeqNoFirst = uSeqNo;
+                else
+                    Filter.uSeqNoLast = uSeqNo;
+                break;
+            }
+            case 'A':
+            {
+                char *pszEnd = NULL;
+                unsigned long long uAddr = strtoull(optarg, &pszEnd, 0);
+                unsigned long long uAddrLast = uAddr;
+                if (*pszEnd == '-')
+                    uAddrLast = strtoull(pszEnd + 1, &pszEnd, 0);
+                if (*pszEnd != '\0' || uAddr > UINT32_MAX || uAddrLast > UINT32_MAX || uAddrLast < uAddr)
+                {
+                    fprintf(stderr, "Invalid address: %s\n", optarg);
+                    return 1;
+                }
+                Filter.u32AddrFirst = (uint32_t)uAddr;
+                Filter.u32AddrLast  = (uint32_t)uAddrLast;
+                fAddr = 1;
+                break;
+            }
+            case 't':
+                if (lpcDecCycTypeParse(optarg, &bTyp))
+                {
+                    fprintf(stderr, "Invalid cycle type: %s\n", optarg);
+                    return 1;
+                }
+                fTyp = 1;
+                break;
+            case 'd':
+                if (!strcmp(optarg, "read"))
+                    bmDir = 0x1;
+                else if (!strcmp(optarg, "write"))
+                    bmDir = 0x2;
+                else
+                {
+                    fprintf(stderr, "Invalid direction: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'c':
+                fCount = 1;
+                break;
+
+            default:
+                fprintf(stderr, "Unrecognised option: -%c\n", optopt);
+                return 1;
+        }
+    }
+
+    if (pszStore)
+    {
+        Filter.bmTypDir = 0;
+        for (uint8_t bTypCur = 0; bTypCur <= LPC_DEC_CYC_TYPE_RSVD; bTypCur++)
+        {
+            if (!fTyp || bTypCur == bTyp)
+                Filter.bmTypDir |= (uint8_t)(bmDir << (bTypCur << 1));
+        }
+
+        int rc = lpcDecStoreQuery(pszStore, &Filter, fCount);
+        if (rc)
+        {
+            fprintf(stderr, "Querying the cycle store '%s' failed with %d\n", pszStore, rc);
+            return 1;
+        }
+        return 0;
+    }
+
+    if (   !pszIndex
+        || !fAddr
+        || Filter.u32AddrFirst != Filter.u32AddrLast)
+    {
+        fprintf(stderr, "Either a cycle store or a value index and a single address are required!\n");
+        return 1;
+    }
+
+    return lpcDecValIdxQuery(pszIndex, bTyp, Filter.u32AddrFirst, fAt, uSeqNoAt);
+}
+
+
+/**
+ * The index command, decodes a capture once into a columnar cycle store for the query command.
+ *
+ * @returns Process exit code.
+ * @param   argc                    Number of arguments, the first one being the command name.
+ * @param   argv                    The arguments.
+ */
+static int lpcDecCmdIndex(int argc, char *argv[])
+{
+    int ch = 0;
+    int idxOption = 0;
+    const char *pszFilename = NULL;
+    const char *pszStore = NULL;
+    uint32_t cCyclesPerChunk = LPC_DEC_STORE_CHUNK_CYCLES_DEF;
+
+    while ((ch = getopt_long (argc, argv, "Hi:o:c:", &g_aOptionsIndex[0], &idxOption)) != -1)
+    {
+        switch (ch)
+        {
+            case 'h':
+            case 'H':
+                printf("%s: Decodes a capture into a columnar cycle store for the query command\n"
+                       "    --input <path/to/saleae/capture>\n"
+                       "    --store <path/to/cycle/store>\n"
+                       "    --chunk-size <cycles> Number of cycles per chunk, defaults to %u\n",
+                       argv[0], LPC_DEC_STORE_CHUNK_CYCLES_DEF);
+                return 0;
+            case 'i':
+                pszFilename = optarg;
+                break;
+            case 'o':
+                pszStore = optarg;
+                break;
+            case 'c':
+            {
+                char *pszEnd = NULL;
+                unsigned long uChunk = strtoul(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0' || !uChunk || uChunk > LPC_DEC_STORE_CHUNK_CYCLES_MAX)
+                {
+                    fprintf(stderr, "Invalid chunk size: %s\n", optarg);
+                    return 1;
+                }
+                cCyclesPerChunk = (uint32_t)uChunk;
+                break;
+            }
+
+            default:
+                fprintf(stderr, "Unrecognised option: -%c\n", optopt);
+                return 1;
+        }
+    }
+
+    if (!pszFilename || !pszStore)
+    {
+        fprintf(stderr, "A filepath to the capture and the cycle store are required!\n");
+        return 1;
+    }
+
+    PLPCDECSTOREWRITER pWriter = NULL;
+    int rc = lpcDecStoreWriterCreate(&pWriter, pszStore, cCyclesPerChunk);
+    if (rc)
+    {
+        fprintf(stderr, "Creating the cycle store '%s' failed with %d\n", pszStore, rc);
+        return 1;
+    }
+
+    rc = lpcDecDecodeFile(pszFilename, lpcDecStoreWriterCycle, pWriter, 0 /*fFollow*/, NULL /*pVcd*/,
+                          NULL /*pClkStats*/, stderr);
+    if (rc)
+        fprintf(stderr, "The file '%s' could not be opened\n", pszFilename);
+
+    uint64_t cCycles = pWriter->cCyclesTotal;
+    uint64_t cbStore = pWriter->offChunkNext;
+    int rc2 = lpcDecStoreWriterClose(pWriter);
+    if (rc2)
+    {
+        fprintf(stderr, "Writing the cycle store '%s' failed with %d\n", pszStore, rc2);
+        return 1;
+    }
+
+    if (!rc)
+        printf("%" PRIu64 " cycles stored in %" PRIu64 " bytes\n", cCycles, cbStore);
+    return rc ? 1 : 0;
+}
+
+/**
+ * The diff command, decodes two captures concurrently and reports where their cycles diverge.
+ *
+ * @returns Process exit code, 0 if the captures are equal, 1 if they differ and 2 on error.
+ * @param   argc                    Number of arguments, the first one being the command name.
+ * @param   argv                    The arguments.
+ */
+static int lpcDecCmdDiff(int argc, char *argv[])
+{
+    int ch = 0;
+    int idxOption = 0;
+    LPCDECDIFF Diff;
+
+    memset(&Diff, 0, sizeof(Diff));
+    Diff.pOut      = stdout;
+    Diff.cLinesMax = 16;
+    Diff.cHunksMax = 100;
+
+    while ((ch = getopt_long (argc, argv, "Hm:l:", &g_aOptionsDiff[0], &idxOption)) != -1)
+    {
+        switch (ch)
+        {
+            case 'h':
+            case 'H':
+                printf("%s: Compares the decoded cycles of two captures ignoring timing\n"
+                       "    %s [options] <path/to/capture/a> <path/to/capture/b>\n"
+                       "    --max-hunks <count> Maximum number of differing spans to dump, defaults to 100\n"
+                       "    --max-lines <count> Maximum number of cycles to dump per side of a span, defaults to 16\n",
+                       argv[0], argv[0]);
+                return 0;
+            case 'm':
+            case 'l':
+            {
+                char *pszEnd = NULL;
+                unsigned long long uVal = strtoull(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0' || (ch == 'l' && uVal > UINT32_MAX))
+                {
+                    fprintf(stderr, "Invalid value: %s\n", optarg);
+                    return 2;
+                }
+                if (ch == 'm')
+                    Diff.cHunksMax = uVal;
+                else
+                    Diff.cLinesMax = (uint32_t)uVal;
+                break;
+            }
+
+            default:
+                fprintf(stderr, "Unrecognised option: -%c\n", optopt);
+                return 2;
+        }
+    }
+
+    if (argc - optind != 2)
+    {
+        fprintf(stderr, "Exactly two captures are required!\n");
+        return 2;
+    }
+
+    Diff.aSides[0].pszFilename = argv[optind];
+    Diff.aSides[1].pszFilename = argv[optind + 1];
+
+    /* Decode both sides concurrently. */
+    uint8_t afStarted[2] = { 0, 0 };
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        if (!pthread_create(&Diff.aSides[i].hThread, NULL, lpcDecDiffSideWorker, &Diff.aSides[i]))
+            afStarted[i] = 1;
+        else
+            lpcDecDiffSideWorker(&Diff.aSides[i]);
+    }
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        if (afStarted[i])
+            pthread_join(Diff.aSides[i].hThread, NULL);
+    }
+
+    int rcExit = 2;
+    if (!Diff.aSides[0].rc && !Diff.aSides[1].rc)
+    {
+        fprintf(Diff.pOut, "A: %s (%zu cycles)\nB: %s (%zu cycles)\n", Diff.aSides[0].pszFilename,
+                Diff.aSides[0].cCycles, Diff.aSides[1].pszFilename, Diff.aSides[1].cCycles);
+
+        int rc = lpcDecDiffAlign(&Diff, 0, Diff.aSides[0].cCycles, 0, Diff.aSides[1].cCycles,
+                                 LPC_DEC_DIFF_ANCHOR_CYCLES, 0 /*uDepth*/);
+        lpcDecDiffHunkFlush(&Diff);
+        if (!rc)
+        {
+            if (!Diff.cHunks)
+            {
+                fprintf(Diff.pOut, "No differences\n");
+                rcExit = 0;
+            }
+            else
+            {
+                fprintf(Diff.pOut, "%" PRIu64 " differing spans, %" PRIu64 " cycles only in A, %" PRIu64 " cycles only in B",
+                        Diff.cHunks, Diff.cOnlyA, Diff.cOnlyB);
+                if (Diff.cUnaligned)
+                    fprintf(Diff.pOut, " (%" PRIu64 " spans too large to align)", Diff.cUnaligned);
+                fprintf(Diff.pOut, "\n");
+                rcExit = 1;
+            }
+        }
+        else
+            fprintf(stderr, "Aligning the captures failed with %d\n", rc);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            if (Diff.aSides[i].rc)
+                fprintf(stderr, "Decoding '%s' failed with %d\n", Diff.aSides[i].pszFilename, Diff.aSides[i].rc);
+        }
+    }
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        free(Diff.aSides[i].paCycles);
+        free(Diff.aSides[i].pau64Key);
+    }
+    return rcExit;
+}
+
+
+/**
+ * Reads the given records of a batch capture, limiting the number of concurrent reads per device.
+ *
+ * @returns Status code.
+ * @param   pBatch                  The batch decoding state.
+ * @param   pFile                   The capture to read from.
+ * @param   pbBuf                   Where to store the records.
+ * @param   idxRec                  Index of the first record to read.
+ * @param   cRecs                   Number of records to read.
+ */
+static int lpcDecBatchRead(PLPCDECBATCH pBatch, PLPCDECBATCHFILE pFile, uint8_t *pbBuf, uint64_t idxRec, uint64_t cRecs)
+{
+    PLPCDECBATCHDEV pDev = &pBatch->paDevs[pFile->idxDev];
+
+    pthread_mutex_lock(&pBatch->Mtx);
+    while (pDev->cReads >= pBatch->cReadsPerDevMax)
+        pthread_cond_wait(&pBatch->CondDev, &pBatch->Mtx);
+    pDev->cReads++;
+    pthread_mutex_unlock(&pBatch->Mtx);
+
+    int rc = 0;
+    size_t cbLeft = cRecs * LPC_DEC_RECORD_SIZE;
+    off_t offRead = (off_t)(idxRec * LPC_DEC_RECORD_SIZE);
+    while (cbLeft)
+    {
+        ssize_t cbRead = pread(pFile->fd, pbBuf, cbLeft, offRead);
+        if (cbRead < 0 && errno == EINTR)
+            continue;
+        if (cbRead <= 0)
+        {
+            rc = cbRead < 0 ? errno : EIO;
+            break;
+        }
+
+        pbBuf   += cbRead;
+        offRead += cbRead;
+        cbLeft  -= (size_t)cbRead;
+    }
+
+    pthread_mutex_lock(&pBatch->Mtx);
+    pDev->cReads--;
+    pthread_cond_broadcast(&pBatch->CondDev);
+    pthread_mutex_unlock(&pBatch->Mtx);
+    return rc;
+}
+
+
+/**
+ * Cycle callback dumping the cycles started inside the chunk being decoded.
+ *
+ * @returns nothing.
+ * @param   pLpcDec                 The LPC decoder state the cycle was decoded with.
+ * @param   pCycle                  The decoded cycle.
+ * @param   pvUser                  The batch chunk.
+ */
+static void lpcDecBatchCycle(PCLPCDEC pLpcDec, PCLPCDECCYCLE pCycle, void *pvUser)
+{
+    PLPCDECBATCHCHUNK pChunk = (PLPCDECBATCHCHUNK)pvUser;
+
+    if (   pCycle->uSeqNo < pChunk->uSeqNoFirst
+        || pCycle->uSeqNo >= pChunk->uSeqNoEnd)
+        return;
+
+    pChunk->cCycles++;
+    if (pCycle->fAbort)
+        pChunk->cAborts++;
+    lpcDecCycleDump(pChunk->pOut, pLpcDec, pCycle);
+}
+
+
+/**
+ * Decodes the given chunk of a batch capture.
+ *
+ * A cycle belongs to the chunk its start sequence number falls into. The decoder starts without knowing the bus
+ * state at the first record of the chunk, which is fine as it only picks up cycles at their start, and keeps going
+ * past the last record until the last cycle started inside the chunk is complete.
+ *
+ * @returns Status code.
+ * @param   pWorker                 The worker decoding the chunk.
+ * @param   pFile                   The capture the chunk belongs to.
+ * @param   pChunk                  The chunk to decode.
+ */
+static int lpcDecBatchChunkDecode(PLPCDECBATCHWORKER pWorker, PLPCDECBATCHFILE pFile, PLPCDECBATCHCHUNK pChunk)
+{
+    PLPCDECBATCH pBatch = pWorker->pBatch;
+    uint8_t *pbBuf = pWorker->pbBuf;
+    uint64_t idxRec = pChunk->idxRecFirst;
+    uint64_t idxRecEnd = pChunk->idxRecFirst + pChunk->cRecords;
+    LPCDEC LpcDec;
+    int rc = 0;
+
+    lpcDecStateInit(&LpcDec, 0, 1, 5, 4, 3, 2, lpcDecBatchCycle, pChunk); /** @todo Make configurable */
+
+    pChunk->uSeqNoFirst = 0;
+    pChunk->uSeqNoEnd   = UINT64_MAX;
+    if (idxRec)
+    {
+        /* Take the clock level from the previous record so a falling edge on the first record is not missed. */
+        rc = lpcDecBatchRead(pBatch, pFile, pbBuf, idxRec - 1, 2);
+        if (!rc)
+        {
+            LpcDec.fClkLast = !!(pbBuf[LPC_DEC_RECORD_SIZE - 1] & (1 << LpcDec.u8BitLClk));
+            memcpy(&pChunk->uSeqNoFirst, &pbBuf[LPC_DEC_RECORD_SIZE], sizeof(uint64_t));
+        }
+    }
+    if (!rc && idxRecEnd < pFile->cRecords)
+    {
+        rc = lpcDecBatchRead(pBatch, pFile, pbBuf, idxRecEnd, 1);
+        if (!rc)
+            memcpy(&pChunk->uSeqNoEnd, pbBuf, sizeof(uint64_t));
+    }
+    if (rc)
+        return rc;
+
+    pChunk->pOut = open_memstream(&pChunk->pszOut, &pChunk->cchOut);
+    if (!pChunk->pOut)
+        return errno;
+
+    /* The decoder messages go in between the cycles like for a sequential decode. */
+    LpcDec.pOutMsg = pChunk->pOut;
+
+    uint8_t fDone = 0;
+    while (   !rc
+           && !fDone
+           && idxRec < pFile->cRecords)
+    {
+        /* Past the end of the chunk only small reads are done, the cycle in progress ends soon. */
+        uint64_t cRecs = idxRec < idxRecEnd ? idxRecEnd - idxRec : LPC_DEC_BATCH_OVERRUN_RECORDS;
+        if (cRecs > LPC_DEC_BATCH_READ_RECORDS)
+            cRecs = LPC_DEC_BATCH_READ_RECORDS;
+        if (cRecs > pFile->cRecords - idxRec)
+            cRecs = pFile->cRecords - idxRec;
+
+        rc = lpcDecBatchRead(pBatch, pFile, pbBuf, idxRec, cRecs);
+        for (uint64_t i = 0; i < cRecs && !rc; i++)
+        {
+            if (   idxRec + i >= idxRecEnd
+                && (   LpcDec.aenmState[LpcDec.idxState] == LPCDECSTATE_LFRAME_WAIT_ASSERTED
+                    || LpcDec.uSeqNoCycle >= pChunk->uSeqNoEnd))
+            {
+                fDone = 1;
+                break;
+            }
+
+            uint64_t uSeqNo;
+            memcpy(&uSeqNo, &pbBuf[i * LPC_DEC_RECORD_SIZE], sizeof(uint64_t));
+            rc = lpcDecStateSampleProcess(&LpcDec, uSeqNo, pbBuf[i * LPC_DEC_RECORD_SIZE + sizeof(uint64_t)]);
+        }
+        idxRec += cRecs;
+    }
+
+    if (fclose(pChunk->pOut) && !rc)
+        rc = ENOMEM;
+    pChunk->pOut = NULL;
+    return rc;
+}
+
+
+/**
+ * Writes the output of a completely decoded batch capture and releases the chunk buffers.
+ *
+ * @returns nothing.
+ * @param   pFile                   The capture.
+ */
+static void lpcDecBatchFileFinish(PLPCDECBATCHFILE pFile)
+{
+    close(pFile->fd);
+    pFile->fd = -1;
+
+    for (uint32_t i = 0; i < pFile->cChunks; i++)
+    {
+        if (pFile->paChunks[i].rc && !pFile->rc)
+            pFile->rc = pFile->paChunks[i].rc;
+        pFile->cCycles += pFile->paChunks[i].cCycles;
+        pFile->cAborts += pFile->paChunks[i].cAborts;
+    }
+
+    if (!pFile->rc)
+    {
+        FILE *pOut = fopen(pFile->pszOut, "w");
+        if (pOut)
+        {
+            for (uint32_t i = 0; i < pFile->cChunks; i++)
+                fwrite(pFile->paChunks[i].pszOut, 1, pFile->paChunks[i].cchOut, pOut);
+            if (ferror(pOut))
+                pFile->rc = EIO;
+            if (fclose(pOut) && !pFile->rc)
+                pFile->rc = EIO;
+        }
+        else
+            pFile->rc = errno;
+    }
+
+    for (uint32_t i = 0; i < pFile->cChunks; i++)
+    {
+        free(pFile->paChunks[i].pszOut);
+        pFile->paChunks[i].pszOut = NULL;
+    }
+}
+
+
+/**
+ * Returns the next work item for the given worker, stealing from the other workers when its own queue ran dry.
+ *
+ * @returns Flag whether a work item was returned, no work is left otherwise.
+ * @param   pWorker                 The worker.
+ * @param   pItem                   Where to store the work item.
+ */
+static uint8_t lpcDecBatchItemGet(PLPCDECBATCHWORKER pWorker, PLPCDECBATCHITEM pItem)
+{
+    PLPCDECBATCH pBatch = pWorker->pBatch;
+
+    /* The own queue is worked from the head so captures finish roughly in order and release their buffers... */
+    pthread_mutex_lock(&pWorker->MtxQueue);
+    if (pWorker->idxHead < pWorker->idxTail)
+    {
+        *pItem = pWorker->paItems[pWorker->idxHead++];
+        pthread_mutex_unlock(&pWorker->MtxQueue);
+        return 1;
+    }
+    pthread_mutex_unlock(&pWorker->MtxQueue);
+
+    /* ... while thieves take from the tail, the work the owner would get to last. */
+    uint32_t idxSelf = (uint32_t)(pWorker - pBatch->paWorkers);
+    for (uint32_t i = 1; i < pBatch->cWorkers; i++)
+    {
+        PLPCDECBATCHWORKER pVictim = &pBatch->paWorkers[(idxSelf + i) % pBatch->cWorkers];
+
+        pthread_mutex_lock(&pVictim->MtxQueue);
+        if (pVictim->idxHead < pVictim->idxTail)
+        {
+            *pItem = pVictim->paItems[--pVictim->idxTail];
+            pthread_mutex_unlock(&pVictim->MtxQueue);
+            pWorker->cSteals++;
+            return 1;
+        }
+        pthread_mutex_unlock(&pVictim->MtxQueue);
+    }
+
+    return 0;
+}
+
+
+/**
+ * Batch worker thread.
+ *
+ * @returns NULL.
+ * @param   pvUser                  The worker.
+ */
+static void *lpcDecBatchWorker(void *pvUser)
+{
+    PLPCDECBATCHWORKER pWorker = (PLPCDECBATCHWORKER)pvUser;
+    PLPCDECBATCH pBatch = pWorker->pBatch;
+    LPCDECBATCHITEM Item;
+
+    while (lpcDecBatchItemGet(pWorker, &Item))
+    {
+        PLPCDECBATCHFILE pFile = &pBatch->paFiles[Item.idxFile];
+        PLPCDECBATCHCHUNK pChunk = &pFile->paChunks[Item.idxChunk];
+
+        pChunk->rc = lpcDecBatchChunkDecode(pWorker, pFile, pChunk);
+        pWorker->cItems++;
+
+        pthread_mutex_lock(&pBatch->Mtx);
+        uint8_t fLast = ++pFile->cChunksDone == pFile->cChunks;
+        pthread_mutex_unlock(&pBatch->Mtx);
+        if (fLast)
+            lpcDecBatchFileFinish(pFile);
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Returns the output filename for the given batch capture.
+ *
+ * @returns Output filename to free with free(), NULL if out of memory.
+ * @param   pszFilename             The capture file.
+ * @param   pszOutDir               The output directory, NULL to write the output next to the capture.
+ */
+static char *lpcDecBatchOutNameCreate(const char *pszFilename, const char *pszOutDir)
+{
+    const char *pszBase = pszFilename;
+    if (pszOutDir)
+    {
+        const char *pszSlash = strrchr(pszFilename, '/');
+        if (pszSlash)
+            pszBase = pszSlash + 1;
+    }
+
+    size_t cchOut = (pszOutDir ? strlen(pszOutDir) + 1 : 0) + strlen(pszBase) + sizeof(".txt");
+    char *pszOut = (char *)malloc(cchOut);
+    if (pszOut)
+        snprintf(pszOut, cchOut, "%s%s%s.txt", pszOutDir ? pszOutDir : "", pszOutDir ? "/" : "", pszBase);
+    return pszOut;
+}
+
+
+/**
+ * The batch command, decodes many captures concurrently into one output file each.
+ *
+ * @returns Process exit code, 0 if all captures were decoded successfully.
+ * @param   argc                    Number of arguments, the first one being the command name.
+ * @param   argv                    The arguments.
+ */
+static int lpcDecCmdBatch(int argc, char *argv[])
+{
+    int ch = 0;
+    int idxOption = 0;
+    const char *pszOutDir = NULL;
+    long cWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t cReadsPerDevMax = LPC_DEC_BATCH_IO_PER_DEV_DEF;
+    uint64_t cbChunk = LPC_DEC_BATCH_CHUNK_SIZE_DEF;
+    LPCDECBATCH Batch;
+
+    while ((ch = getopt_long (argc, argv, "Hj:d:c:o:", &g_aOptionsBatch[0], &idxOption)) != -1)
+    {
+        switch (ch)
+        {
+            case 'h':
+            case 'H':
+                printf("%s: Decodes many captures concurrently, writing the cycles of every capture to <capture>.txt\n"
+                       "    %s [options] <path/to/capture>...\n"
+                       "    --jobs <count> Number of worker threads, defaults to the number of CPUs\n"
+                       "    --io-per-device <count> Maximum number of concurrent reads per device, defaults to %u\n"
+                       "    --chunk-size <bytes>[K|M|G] Captures larger than this are split and decoded in parallel,\n"
+                       "        defaults to 64M\n"
+                       "    --out-dir <path/to/dir> Writes the outputs to the given directory instead, the capture\n"
+                       "        basenames must be unique\n",
+                       argv[0], argv[0], LPC_DEC_BATCH_IO_PER_DEV_DEF);
+                return 0;
+            case 'j':
+            case 'd':
+            {
+                char *pszEnd = NULL;
+                unsigned long uVal = strtoul(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0' || !uVal || (ch == 'j' && uVal > LPC_DEC_BATCH_WORKERS_MAX) || uVal > UINT32_MAX)
+                {
+                    fprintf(stderr, "Invalid count: %s\n", optarg);
+                    return 1;
+                }
+                if (ch == 'j')
+                    cWorkers = (long)uVal;
+                else
+                    cReadsPerDevMax = (uint32_t)uVal;
+                break;
+            }
+            case 'c':
+            {
+                char *pszEnd = NULL;
+                cbChunk = strtoull(optarg, &pszEnd, 0);
+                if (*pszEnd == 'K')
+                    cbChunk *= 1024;
+                else if (*pszEnd == 'M')
+                    cbChunk *= 1024 * 1024;
+                else if (*pszEnd == 'G')
+                    cbChunk *= 1024 * 1024 * 1024;
+                if (*pszEnd != '\0')
+                    pszEnd++;
+                if (*pszEnd != '\0' || cbChunk < LPC_DEC_RECORD_SIZE)
+                {
+                    fprintf(stderr, "Invalid chunk size: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'o':
+                pszOutDir = optarg;
+                break;
+
+            default:
+                fprintf(stderr, "Unrecognised option: -%c\n", optopt);
+                return 1;
+        }
+    }
+
+    if (optind == argc)
+    {
+        fprintf(stderr, "At least one capture is required!\n");
+        return 1;
+    }
+    if (cWorkers < 1)
+        cWorkers = 1;
+    else if (cWorkers > LPC_DEC_BATCH_WORKERS_MAX)
+        cWorkers = LPC_DEC_BATCH_WORKERS_MAX;
+
+    memset(&Batch, 0, sizeof(Batch));
+    pthread_mutex_init(&Batch.Mtx, NULL);
+    pthread_cond_init(&Batch.CondDev, NULL);
+    Batch.cReadsPerDevMax = cReadsPerDevMax;
+    Batch.cFiles          = (uint32_t)(argc - optind);
+    Batch.paFiles         = (PLPCDECBATCHFILE)calloc(Batch.cFiles, sizeof(*Batch.paFiles));
+    Batch.paDevs          = (PLPCDECBATCHDEV)calloc(Batch.cFiles, sizeof(*Batch.paDevs));
+    Batch.cWorkers        = (uint32_t)cWorkers;
+    Batch.paWorkers       = (PLPCDECBATCHWORKER)calloc(Batch.cWorkers, sizeof(*Batch.paWorkers));
+    if (!Batch.paFiles || !Batch.paDevs || !Batch.paWorkers)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    struct timespec TsStart;
+    clock_gettime(CLOCK_MONOTONIC, &TsStart);
+
+    /* Open all captures and split them into chunks. */
+    uint64_t cRecsPerChunk = cbChunk / LPC_DEC_RECORD_SIZE;
+    uint64_t cbTotal = 0;
+    uint32_t cItems = 0;
+    for (uint32_t i = 0; i < Batch.cFiles; i++)
+    {
+        PLPCDECBATCHFILE pFile = &Batch.paFiles[i];
+        struct stat StatBuf;
+
+        pFile->pszFilename = argv[optind + i];
+        pFile->fd          = open(pFile->pszFilename, O_RDONLY);
+        if (pFile->fd < 0 || fstat(pFile->fd, &StatBuf))
+        {
+            pFile->rc = errno;
+            if (pFile->fd >= 0)
+                close(pFile->fd);
+            pFile->fd = -1;
+            continue;
+        }
+
+        uint32_t idxDev = 0;
+        while (idxDev < Batch.cDevs && Batch.paDevs[idxDev].idDev != StatBuf.st_dev)
+            idxDev++;
+        if (idxDev == Batch.cDevs)
+            Batch.paDevs[Batch.cDevs++].idDev = StatBuf.st_dev;
+
+        pFile->idxDev   = idxDev;
+        pFile->cRecords = (uint64_t)StatBuf.st_size / LPC_DEC_RECORD_SIZE;
+        pFile->cChunks  = pFile->cRecords ? (uint32_t)((pFile->cRecords + cRecsPerChunk - 1) / cRecsPerChunk) : 1;
+        pFile->paChunks = (PLPCDECBATCHCHUNK)calloc(pFile->cChunks, sizeof(*pFile->paChunks));
+        pFile->pszOut   = lpcDecBatchOutNameCreate(pFile->pszFilename, pszOutDir);
+        if (!pFile->paChunks || !pFile->pszOut)
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+
+        for (uint32_t idxChunk = 0; idxChunk < pFile->cChunks; idxChunk++)
+        {
+            pFile->paChunks[idxChunk].idxRecFirst = idxChunk * cRecsPerChunk;
+            pFile->paChunks[idxChunk].cRecords    = idxChunk < pFile->cChunks - 1
+                                                  ? cRecsPerChunk
+                                                  : pFile->cRecords - idxChunk * cRecsPerChunk;
+        }
+        cbTotal += pFile->cRecords * LPC_DEC_RECORD_SIZE;
+        cItems  += pFile->cChunks;
+    }
+
+    /* Deal the chunks out to the workers round robin, stealing evens out whatever imbalance remains. */
+    for (uint32_t i = 0; i < Batch.cWorkers; i++)
+    {
+        PLPCDECBATCHWORKER pWorker = &Batch.paWorkers[i];
+
+        pWorker->pBatch  = &Batch;
+        pWorker->paItems = (PLPCDECBATCHITEM)malloc((cItems / Batch.cWorkers + 1) * sizeof(*pWorker->paItems));
+        pWorker->pbBuf   = (uint8_t *)malloc(LPC_DEC_BATCH_READ_RECORDS * LPC_DEC_RECORD_SIZE);
+        if (!pWorker->paItems || !pWorker->pbBuf)
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        pthread_mutex_init(&pWorker->MtxQueue, NULL);
+    }
+
+    uint32_t idxItem = 0;
+    for (uint32_t i = 0; i < Batch.cFiles; i++)
+    {
+        if (Batch.paFiles[i].fd < 0)
+            continue;
+
+        for (uint32_t idxChunk = 0; idxChunk < Batch.paFiles[i].cChunks; idxChunk++, idxItem++)
+        {
+            PLPCDECBATCHWORKER pWorker = &Batch.paWorkers[idxItem % Batch.cWorkers];
+            pWorker->paItems[pWorker->idxTail].idxFile  = i;
+            pWorker->paItems[pWorker->idxTail].idxChunk = idxChunk;
+            pWorker->idxTail++;
+        }
+    }
+
+    uint32_t cStarted = 0;
+    for (uint32_t i = 1; i < Batch.cWorkers; i++)
+    {
+        if (pthread_create(&Batch.paWorkers[i].hThread, NULL, lpcDecBatchWorker, &Batch.paWorkers[i]))
+            break;
+        cStarted++;
+    }
+    lpcDecBatchWorker(&Batch.paWorkers[0]); /* The main thread works as well and steals from workers which failed to start. */
+    for (uint32_t i = 1; i <= cStarted; i++)
+        pthread_join(Batch.paWorkers[i].hThread, NULL);
+
+    struct timespec TsEnd;
+    clock_gettime(CLOCK_MONOTONIC, &TsEnd);
+    double dSecs = (double)(TsEnd.tv_sec - TsStart.tv_sec) + (double)(TsEnd.tv_nsec - TsStart.tv_nsec) / 1000000000.0;
+
+    /* The aggregated summary. */
+    uint32_t cFailed = 0;
+    uint64_t cCycles = 0;
+    uint64_t cAborts = 0;
+    uint64_t cSteals = 0;
+    for (uint32_t i = 0; i < Batch.cFiles; i++)
+    {
+        PLPCDECBATCHFILE pFile = &Batch.paFiles[i];
+        if (!pFile->rc)
+            printf("%s: %" PRIu64 " records, %" PRIu64 " cycles (%" PRIu64 " aborted), %u chunks -> %s\n",
+                   pFile->pszFilename, pFile->cRecords, pFile->cCycles, pFile->cAborts, pFile->cChunks, pFile->pszOut);
+        else
+        {
+            printf("%s: FAILED with %d\n", pFile->pszFilename, pFile->rc);
+            cFailed++;
+        }
+        cCycles += pFile->cCycles;
+        cAborts += pFile->cAborts;
+        free(pFile->paChunks);
+        free(pFile->pszOut);
+    }
+    for (uint32_t i = 0; i < Batch.cWorkers; i++)
+    {
+        cSteals += Batch.paWorkers[i].cSteals;
+        pthread_mutex_destroy(&Batch.paWorkers[i].MtxQueue);
+        free(Batch.paWorkers[i].paItems);
+        free(Batch.paWorkers[i].pbBuf);
+    }
+
+    printf("%u captures (%u failed), %u chunks on %u devices, %" PRIu64 " cycles (%" PRIu64 " aborted)\n"
+           "%u workers, %" PRIu64 " chunks stolen, %.3f s, %.1f MiB/s\n",
+           Batch.cFiles, cFailed, cItems, Batch.cDevs, cCycles, cAborts, Batch.cWorkers, cSteals, dSecs,
+           dSecs > 0.0 ? (double)cbTotal / (1024.0 * 1024.0) / dSecs : 0.0);
+
+    free(Batch.paFiles);
+    free(Batch.paDevs);
+    free(Batch.paWorkers);
+    pthread_cond_destroy(&Batch.CondDev);
+    pthread_mutex_destroy(&Batch.Mtx);
+    return cFailed ? 1 : 0;
+}
+
+
+/**
+ * Sends the given data completely over the given socket.
+ *
+ * @returns Status code.
+ * @param   fdSock                  The socket to send to.
+ * @param   pbData                  The data to send.
+ * @param   cbData                  Number of bytes to send.
+ */
+static int lpcDecSockSendAll(int fdSock, const uint8_t *pbData, size_t cbData)
+{
+    while (cbData)
+    {
+        ssize_t cbSent = send(fdSock, pbData, cbData, MSG_NOSIGNAL);
+        if (cbSent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+
+        pbData += cbSent;
+        cbData -= (size_t)cbSent;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Waits until the given records are due when replaying at the given sample rate.
+ *
+ * @returns nothing.
+ * @param   pbRecs                  The records about to be sent.
+ * @param   cRecs                   Number of records.
+ * @param   uSampleRate             The sample rate in Hz, 0 to send as fast as possible.
+ * @param   nsStart                 Monotonic timestamp in nanoseconds the replay started at.
+ * @param   puSeqNoFirst            Where the sequence number of the first record replayed is stored, UINT64_MAX
+ *                                  before the first call.
+ * @param   pcLate                  Where to count the number of times the records were already overdue.
+ */
+static void lpcDecReplayPace(const uint8_t *pbRecs, size_t cRecs, uint64_t uSampleRate, uint64_t nsStart,
+                             uint64_t *puSeqNoFirst, uint64_t *pcLate)
+{
+    if (!uSampleRate)
+        return;
+
+    /* The records are due when the last sample would have been captured. */
+    uint64_t uSeqNoLast;
+    memcpy(&uSeqNoLast, &pbRecs[(cRecs - 1) * LPC_DEC_RECORD_SIZE], sizeof(uSeqNoLast));
+    if (*puSeqNoFirst == UINT64_MAX)
+        memcpy(puSeqNoFirst, &pbRecs[0], sizeof(*puSeqNoFirst));
+
+    uint64_t cSamples = uSeqNoLast - *puSeqNoFirst;
+    uint64_t nsDue =   nsStart + (cSamples / uSampleRate) * UINT64_C(1000000000)
+                     + (cSamples % uSampleRate) * UINT64_C(1000000000) / uSampleRate;
+    if (nsDue > lpcDecNanoTs())
+    {
+        struct timespec TsDue;
+        TsDue.tv_sec  = (time_t)(nsDue / UINT64_C(1000000000));
+        TsDue.tv_nsec = (long)(nsDue % UINT64_C(1000000000));
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &TsDue, NULL) == EINTR)
+            ;
+    }
+    else
+        (*pcLate)++;
+}
+
+
+/**
+ * Prints the summary of a replay.
+ *
+ * @returns nothing.
+ * @param   cRecs                   Number of records replayed.
+ * @param   nsStart                 Monotonic timestamp in nanoseconds the replay started at.
+ * @param   cLate                   Number of times the records were already overdue.
+ */
+static void lpcDecReplaySummary(uint64_t cRecs, uint64_t nsStart, uint64_t cLate)
+{
+    double dSecs = (double)(lpcDecNanoTs() - nsStart) / 1000000000.0;
+    fprintf(stderr, "%" PRIu64 " records sent in %.3f s (%.1f MiB/s), %" PRIu64 " chunks behind schedule\n",
+            cRecs, dSecs, dSecs > 0.0 ? (double)(cRecs * LPC_DEC_RECORD_SIZE) / (1024.0 * 1024.0) / dSecs : 0.0,
+            cLate);
+}
+
+
+/**
+ * Streams the given capture to the first client connecting to the given socket address.
+ *
+ * @returns Process exit code.
+ * @param   pFile                   The capture to replay.
+ * @param   pszListen               The address to listen on.
+ * @param   uSampleRate             The sample rate to pace the records at, 0 to send as fast as possible.
+ */
+static int lpcDecReplaySock(FILE *pFile, const char *pszListen, uint64_t uSampleRate)
+{
+    struct sockaddr_storage Addr;
+    socklen_t cbAddr = 0;
+    if (lpcDecSockAddrParse(pszListen, 1 /*fPassive*/, &Addr, &cbAddr))
+    {
+        fprintf(stderr, "Invalid socket address: %s\n", pszListen);
+        return 1;
+    }
+
+    uint8_t *pbBuf = (uint8_t *)malloc(LPC_DEC_REPLAY_CHUNK_RECORDS * LPC_DEC_RECORD_SIZE);
+    int fdListen = socket(Addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (!pbBuf || fdListen < 0)
+    {
+        fprintf(stderr, "Creating the socket failed with %d\n", pbBuf ? errno : ENOMEM);
+        if (fdListen >= 0)
+            close(fdListen);
+        free(pbBuf);
+        return 1;
+    }
+
+    int fReuse = 1;
+    setsockopt(fdListen, SOL_SOCKET, SO_REUSEADDR, &fReuse, sizeof(fReuse));
+
+    /* Stale unix sockets from an earlier run are replaced. */
+    struct stat StUn;
+    if (   Addr.ss_family == AF_UNIX
+        && !stat(((struct sockaddr_un *)&Addr)->sun_path, &StUn)
+        && S_ISSOCK(StUn.st_mode))
+        unlink(((struct sockaddr_un *)&Addr)->sun_path);
+
+    int fdSock = -1;
+    if (   bind(fdListen, (struct sockaddr *)&Addr, cbAddr) < 0
+        || listen(fdListen, 1) < 0)
+        fprintf(stderr, "Listening on '%s' failed with %d\n", pszListen, errno);
+    else
+    {
+        fprintf(stderr, "Waiting for a connection on '%s'\n", pszListen);
+        do
+            fdSock = accept4(fdListen, NULL, NULL, SOCK_CLOEXEC);
+        while (fdSock < 0 && errno == EINTR);
+        if (fdSock < 0)
+            fprintf(stderr, "Accepting a connection failed with %d\n", errno);
+    }
+
+    int rc = fdSock < 0 ? 1 : 0;
+    uint64_t cRecs = 0;
+    uint64_t cLate = 0;
+    uint64_t uSeqNoFirst = UINT64_MAX;
+    uint64_t nsStart = lpcDecNanoTs();
+    while (!rc)
+    {
+        size_t cRecsRead = fread(pbBuf, LPC_DEC_RECORD_SIZE, LPC_DEC_REPLAY_CHUNK_RECORDS, pFile);
+        if (!cRecsRead)
+            break;
+
+        lpcDecReplayPace(pbBuf, cRecsRead, uSampleRate, nsStart, &uSeqNoFirst, &cLate);
+        int rcSend = lpcDecSockSendAll(fdSock, pbBuf, cRecsRead * LPC_DEC_RECORD_SIZE);
+        if (rcSend)
+        {
+            fprintf(stderr, "Sending to the decoder failed with %d\n", rcSend);
+            rc = 1;
+        }
+        cRecs += cRecsRead;
+    }
+
+    if (fdSock >= 0)
+    {
+        lpcDecReplaySummary(cRecs, nsStart, cLate);
+        close(fdSock);
+    }
+    if (Addr.ss_family == AF_UNIX)
+        unlink(((struct sockaddr_un *)&Addr)->sun_path);
+    close(fdListen);
+    free(pbBuf);
+    return rc;
+}
+
+
+/**
+ * Replays the given capture into a newly created shared-memory ring, reading the records directly into the ring.
+ *
+ * @returns Process exit code.
+ * @param   pFile                   The capture to replay.
+ * @param   pszName                 The name of the ring segment to create.
+ * @param   uSampleRate             The sample rate to pace the records at, 0 to write as fast as possible.
+ */
+static int lpcDecReplayShm(FILE *pFile, const char *pszName, uint64_t uSampleRate)
+{
+    PLPCDECSHMHDR pHdr = NULL;
+    size_t cbMap = 0;
+    int rc = lpcDecShmMap(pszName, 1 /*fCreate*/, LPC_DEC_SHM_RING_RECORDS_DEF, &pHdr, &cbMap);
+    if (rc)
+    {
+        fprintf(stderr, "Creating the shared-memory ring '%s' failed with %d\n", pszName, rc);
+        return 1;
+    }
+
+    fprintf(stderr, "Writing to the shared-memory ring '%s'\n", pszName);
+
+    uint8_t *pbRing = (uint8_t *)pHdr + pHdr->cbHdr;
+    uint64_t cbRing = pHdr->cbRing;
+    uint64_t offHead = 0;
+    uint64_t cRecs = 0;
+    uint64_t cLate = 0;
+    uint64_t uSeqNoFirst = UINT64_MAX;
+    uint64_t nsStart = lpcDecNanoTs();
+    for (;;)
+    {
+        /* Wait for the decoder to free up space, the wait times out regularly to notice a decoder which went away. */
+        uint64_t offTail = __atomic_load_n(&pHdr->offTail, __ATOMIC_ACQUIRE);
+        if (offHead - offTail == cbRing)
+        {
+            if (lpcDecShmConsumerIsGone(pHdr))
+            {
+                fprintf(stderr, "The decoder stopped before reading all records\n");
+                rc = 1;
+                break;
+            }
+
+            uint32_t u32SpaceSeq = __atomic_load_n(&pHdr->u32SpaceSeq, __ATOMIC_SEQ_CST);
+            __atomic_store_n(&pHdr->fProducerWaiting, 1, __ATOMIC_SEQ_CST);
+            if (offHead - __atomic_load_n(&pHdr->offTail, __ATOMIC_SEQ_CST) == cbRing)
+                lpcDecShmFutexWait(&pHdr->u32SpaceSeq, u32SpaceSeq);
+            __atomic_store_n(&pHdr->fProducerWaiting, 0, __ATOMIC_SEQ_CST);
+            continue;
+        }
+
+        uint64_t offRing = offHead % cbRing;
+        uint64_t cbFree = cbRing - (offHead - offTail);
+        if (cbFree > cbRing - offRing)
+            cbFree = cbRing - offRing;
+        size_t cRecsMax = (size_t)(cbFree / LPC_DEC_RECORD_SIZE);
+        if (cRecsMax > LPC_DEC_REPLAY_CHUNK_RECORDS)
+            cRecsMax = LPC_DEC_REPLAY_CHUNK_RECORDS;
+
+        size_t cRecsRead = fread(&pbRing[offRing], LPC_DEC_RECORD_SIZE, cRecsMax, pFile);
+        if (!cRecsRead)
+            break;
+
+        lpcDecReplayPace(&pbRing[offRing], cRecsRead, uSampleRate, nsStart, &uSeqNoFirst, &cLate);
+        offHead += cRecsRead * LPC_DEC_RECORD_SIZE;
+        __atomic_store_n(&pHdr->offHead, offHead, __ATOMIC_RELEASE);
+        lpcDecShmFutexSignal(&pHdr->u32DataSeq, &pHdr->fConsumerWaiting);
+        cRecs += cRecsRead;
+    }
+
+    __atomic_store_n(&pHdr->fEos, 1, __ATOMIC_RELEASE);
+    lpcDecShmFutexSignal(&pHdr->u32DataSeq, &pHdr->fConsumerWaiting);
+    lpcDecReplaySummary(cRecs, nsStart, cLate);
+
+    /*
+     * Keep the segment around until the decoder caught up, it keeps its own mapping afterwards. A decoder which
+     * stopped or exited early won't catch up anymore.
+     */
+    while (!rc)
+    {
+        uint32_t u32SpaceSeq = __atomic_load_n(&pHdr->u32SpaceSeq, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&pHdr->offTail, __ATOMIC_SEQ_CST) == offHead)
+            break;
+        if (lpcDecShmConsumerIsGone(pHdr))
+        {
+            fprintf(stderr, "The decoder stopped before reading all records\n");
+            rc = 1;
+            break;
+        }
+        __atomic_store_n(&pHdr->fProducerWaiting, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&pHdr->offTail, __ATOMIC_SEQ_CST) != offHead)
+            lpcDecShmFutexWait(&pHdr->u32SpaceSeq, u32SpaceSeq);
+        __atomic_store_n(&pHdr->fProducerWaiting, 0, __ATOMIC_SEQ_CST);
+    }
+
+    char szPath[256];
+    snprintf(&szPath[0], sizeof(szPath), LPC_DEC_SHM_DIR "%s", pszName);
+    unlink(&szPath[0]);
+    munmap(pHdr, cbMap);
+    return rc;
+}
+
+
+/**
+ * The replay command, streams a capture to the decoder paced by the sample sequence numbers.
+ *
+ * @returns Process exit code.
+ * @param   argc                    Number of arguments.
+ * @param   argv                    The arguments, starting with the command name.
+ */
+static int lpcDecCmdReplay(int argc, char *argv[])
+{
+    int ch = 0;
+    int idxOption = 0;
+    const char *pszFilename = NULL;
+    const char *pszListen = NULL;
+    const char *pszShm = NULL;
+    uint64_t uSampleRate = 0;
+
+    while ((ch = getopt_long (argc, argv, "Hi:l:m:r:", &g_aOptionsReplay[0], &idxOption)) != -1)
+    {
+        switch (ch)
+        {
+            case 'h':
+            case 'H':
+                printf("%s: Streams a capture to the decoder for testing the live inputs\n"
+                       "    --input <path/to/saleae/capture>\n"
+                       "    --listen <unix:<path>|tcp:<host>:<port>>\n"
+                       "        Address to wait for the decoder connecting on\n"
+                       "    --shm <name>\n"
+                       "        Creates the shared-memory ring /dev/shm/<name> and writes the records into it instead,\n"
+                       "        decode with --input shm:<name>\n"
+                       "    --sample-rate <Hz>\n"
+                       "        Paces the records by their sequence numbers at the given sample rate,\n"
+                       "        sends as fast as possible when not given\n",
+                       argv[0]);
+                return 0;
+            case 'i':
+                pszFilename = optarg;
+                break;
+            case 'l':
+                pszListen = optarg;
+                break;
+            case 'm':
+                pszShm = optarg;
+                break;
+            case 'r':
+            {
+                char *pszEnd = NULL;
+                uSampleRate = strtoull(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0' || !uSampleRate)
+                {
+                    fprintf(stderr, "Invalid sample rate: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            default:
+                fprintf(stderr, "Unrecognised option: -%c\n", optopt);
+                return 1;
+        }
+    }
+
+    if (!pszFilename || !pszListen == !pszShm)
+    {
+        fprintf(stderr, "The capture and either the address to listen on or the ring name are required!\n");
+        return 1;
+    }
+
+    FILE *pFile = fopen(pszFilename, "rb");
+    if (!pFile)
+    {
+        fprintf(stderr, "The file '%s' could not be opened\n", pszFilename);
+        return 1;
+    }
+
+    int rcExit = pszShm ? lpcDecReplayShm(pFile, pszShm, uSampleRate) : lpcDecReplaySock(pFile, pszListen, uSampleRate);
+    fclose(pFile);
+    return rcExit;
+}
+
+
+int main(int argc, char *argv[])
+{
+    int ch = 0;
+    int idxOption = 0;
+    const char *pszFilename = NULL;
+    const char *pszSioOut = NULL;
+    const char *pszKcsLog = NULL;
+    const char *pszValIdx = NULL;
+    const char *pszFindLog = NULL;
+    const char *pszVcd = NULL;
+    const char *pszClkLog = NULL;
+    uint8_t fClkStats = 0;
+    uint64_t cClkWindowSamples = 0;
+    uint8_t fFollow = 0;
+    uint64_t uTriggerPre = UINT64_MAX;
+    uint64_t uTriggerPost = UINT64_MAX;
+    unsigned long uKcsPort = 0;
+    int iZstdLevel = 0;
+    FILE *pZstdOut = NULL;
+    LPCDECCTX Ctx;
+
+    if (argc > 1 && !strcmp(argv[1], "query"))
+        return lpcDecCmdQuery(argc - 1, &argv[1]);
+    if (argc > 1 && !strcmp(argv[1], "index"))
+        return lpcDecCmdIndex(argc - 1, &argv[1]);
+    if (argc > 1 && !strcmp(argv[1], "diff"))
+        return lpcDecCmdDiff(argc - 1, &argv[1]);
+    if (argc > 1 && !strcmp(argv[1], "batch"))
+        return lpcDecCmdBatch(argc - 1, &argv[1]);
+    if (argc > 1 && !strcmp(argv[1], "replay"))
+        return lpcDecCmdReplay(argc - 1, &argv[1]);
+
+    memset(&Ctx, 0, sizeof(Ctx));
+    Ctx.pOut        = stdout;
+    Ctx.pOutText    = stdout;
+    Ctx.pIdxDataDec = NULL;
+    Ctx.cSioDecs    = 0;
+
+    while ((ch = getopt_long (argc, argv, "Hvi:p:s:S:k:K:r:x:f:F:t:b:a:wlI:o:z:O:V:B:R:E:q:Qc:C:", &g_aOptions[0], &idxOption)) != -1)
+    {
+        switch (ch)
+        {
+            case 'h':
+            case 'H':
+                printf("%s: Low Pin Count Bus protocol decoder\n"
+                       "    %s index --help for decoding a capture into a cycle store\n"
+                       "    %s query --help for looking up values in a value index or cycle store\n"
+                       "    %s diff --help for comparing the cycles of two captures\n"
+                       "    %s batch --help for decoding many captures concurrently\n"
+                       "    %s replay --help for streaming a capture to a live input\n"
+                       "    --input <path/to/saleae/capture|unix:<path>|tcp:<host>:<port>|shm:<name>>\n"
+                       "        Decodes the given capture, connects to a live record stream or decodes the records\n"
+                       "        of a shared-memory ring in place\n"
+                       "    --follow Keeps decoding data appended to the capture until the writer closes it\n"
+                       "    --input-lossy Drops data instead of throttling a live stream when the decoder falls behind\n"
+                       "    --input-stats <ms>\n"
+                       "        Interval of the live stream lag reports on stderr, defaults to 1000, 0 disables them\n"
+                       "    --verbose Dumps more information for each cycle like the state transitions encountered\n"
+                       "    --seq-check <max gap>\n"
+                       "        Reports records with a sequence number not above the previous one or more than the given\n"
+                       "        gap above it, with their input offset, on stderr\n"
+                       "    --seq-check-reset Resets the decoder at the anomalies found by --seq-check\n"
+                       "    --clock-stats <window samples>\n"
+                       "        Gathers LCLK period, duty cycle and jitter statistics with a period histogram, the summary\n"
+                       "        goes to the stats outputs or the output, a window other than 0 also writes the statistics\n"
+                       "        of every window of that many samples\n"
+                       "    --clock-log <path/to/log>\n"
+                       "        Writes the per-window LCLK statistics to the given file instead\n"
+                       "    --engine <tick|state>\n"
+                       "        Decode engine, tick (default) decodes I/O and memory cycles from the extracted clock ticks\n"
+                       "        at fixed offsets, state steps the state machine for every clock like --export-vcd does\n"
+                       "    --output <text|bin|stats|store|sqlite|shard>:<path|->\n"
+                       "        Writes the decoded cycles to the given output instead of stdout, can be given multiple times.\n"
+                       "        All outputs are written in the same pass, each on its own thread, sqlite loads the cycles\n"
+                       "        and the --pair records into the cycles and idx_data tables, shard writes text outputs split\n"
+                       "        by --shard-by to the path with its %%s replaced by the shard name, e.g. io-write\n"
+                       "    --shard-by <type|dir|addr-range>[,...]\n"
+                       "        Keys the shard output splits the cycles by\n"
+                       "    --shard-range <name>:<io|mem>:<first hex address>-<last hex address>\n"
+                       "        Address range for --shard-by addr-range, can be given multiple times, the first matching\n"
+                       "        range wins and cycles outside all ranges go to the shard named other\n",
+                       argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+                fputs("    --output-format <text|jsonl|pcapng|arrow[-stream][:<cycles per batch>]>\n"
+                      "        Format of the cycles on stdout and in text outputs, jsonl writes one JSON object per cycle\n"
+                      "        (seq, ts, type, dir, addr, data, abort, sync_waits and the states with --verbose),\n"
+                      "        pcapng one packet per cycle timestamped from --sample-rate (see lpc-dec.lua for Wireshark)\n"
+                      "        and arrow an Arrow IPC file (seq, type, dir, address, data, abort columns) with record\n"
+                      "        batches of 65536 cycles by default, arrow-stream the Arrow IPC stream format for readers on a\n"
+                      "        pipe, jsonl and the binary formats move the post-decoder output to stderr\n"
+                      "    --output-compress zstd[:<level>]\n"
+                      "        Compresses stdout and the text, bin and stats outputs on a worker thread, the level\n"
+                      "        defaults to 3, zstd uses multiple threads from level 10 on\n"
+                      "    --export-vcd <path/to/vcd>\n"
+                      "        Writes the decoder phases, cycle type, direction, address and data as a value change dump\n"
+                      "        for waveform viewers, timed from --sample-rate which has to be given as well\n"
+                      "    --pair <cmos|cmos-ext|sio-2e|sio-4e|<name>:<index port>:<data port>[:<index mask>]>\n"
+                      "        Decodes accesses to the given index/data register pair, can be given multiple times\n"
+                      "    --sio <sio-2e|sio-4e|<index port>>\n"
+                      "        Reconstructs the Super I/O configuration space accessed through the given ports\n"
+                      "    --sio-out <path/to/log>\n"
+                      "        Writes the Super I/O configuration log and final configuration to the given file instead\n"
+                      "    --kcs <data port>\n"
+                      "        Reassembles IPMI KCS message exchanges, the data port is usually 0xca2\n"
+                      "    --kcs-log <path/to/log>\n"
+                      "        Writes the IPMI KCS message exchanges to the given file instead\n"
+                      "    --sample-rate <Hz>\n"
+                      "        Sample rate of the capture, used to convert sequence numbers into time\n"
+                      "    --value-index <path/to/index>\n"
+                      "        Records every write in a value index for the query command\n"
+                      "    --find <pattern|@path/to/patterns>\n"
+                      "        Reports every occurrence of the given cycle sequence, can be given multiple times.\n"
+                      "        A pattern is a list of cycle tokens: * (any cycle), abort or\n"
+                      "        <io|ior|iow|mem|memr|memw>[:<hex address|*>[=<hex data|*>]], e.g. \"iow:70=8b ior:71\"\n"
+                      "    --find-log <path/to/log>\n"
+                      "        Writes the sequence search matches to the given file instead\n"
+                      "    --trigger <pattern|@path/to/patterns>\n"
+                      "        Only dumps the cycles around occurrences of the given cycle sequence (same syntax as --find),\n"
+                      "        can be given multiple times\n"
+                      "    --pre <count> / --post <count>\n"
+                      "        Number of cycles to dump before/after a trigger, defaults to 16 each\n",
+                      stdout);
+                return 0;
+            case 'v':
+                g_fVerbose = 1;
+                break;
+            case 'i':
+                pszFilename = optarg;
+                break;
+            case 'w':
+                fFollow = 1;
+                break;
+            case 'l':
+                g_fInputLossy = 1;
+                break;
+            case 'o':
+            {
+                int rc = 0;
+                if (!Ctx.pSinks)
+                    rc = lpcDecSinksCreate(&Ctx.pSinks);
+                if (rc)
+                {
+                    fprintf(stderr, "Creating the outputs failed with %d\n", rc);
+                    return 1;
+                }
+
+                rc = lpcDecSinksAdd(Ctx.pSinks, optarg);
+                if (rc)
+                {
+                    fprintf(stderr, "Invalid output: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'V':
+                pszVcd = optarg;
+                break;
+            case 'E':
+                if (!strcmp(optarg, "tick"))
+                    g_enmEngine = LPCDECENGINE_TICK;
+                else if (!strcmp(optarg, "state"))
+                    g_enmEngine = LPCDECENGINE_STATE;
+                else
+                {
+                    fprintf(stderr, "Invalid decode engine: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'q':
+            {
+                char *pszEnd = NULL;
+                unsigned long uVal = strtoul(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0' || !uVal || uVal > UINT32_MAX)
+                {
+                    fprintf(stderr, "Invalid sequence number gap: %s\n", optarg);
+                    return 1;
+                }
+                g_uSeqGapMax = (uint32_t)uVal;
+                break;
+            }
+            case 'Q':
+                g_fSeqReset = 1;
+                break;
+            case 'c':
+            {
+                char *pszEnd = NULL;
+                cClkWindowSamples = strtoull(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0')
+                {
+                    fprintf(stderr, "Invalid LCLK statistics window: %s\n", optarg);
+                    return 1;
+                }
+                fClkStats = 1;
+                break;
+            }
+            case 'C':
+                pszClkLog = optarg;
+                break;
+            case 'B':
+            {
+                int rc = lpcDecShardByParse(optarg);
+                if (rc)
+                {
+                    fprintf(stderr, "Invalid shard keys: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'R':
+            {
+                int rc = lpcDecShardRangeAdd(optarg);
+                if (rc)
+                {
+                    fprintf(stderr, "Invalid or too many shard address ranges: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'O':
+                if (!strcmp(optarg, "jsonl"))
+                    g_enmOutputFmt = LPCDECOUTFMT_JSONL;
+                else if (!strcmp(optarg, "pcapng"))
+                    g_enmOutputFmt = LPCDECOUTFMT_PCAPNG;
+                else if (!strncmp(optarg, "arrow", 5) && (optarg[5] == '\0' || optarg[5] == ':' || optarg[5] == '-'))
+                {
+                    const char *pszBatch = &optarg[5];
+                    g_enmOutputFmt = LPCDECOUTFMT_ARROW;
+                    g_fArrowStream = 0;
+                    if (!strncmp(pszBatch, "-stream", 7))
+                    {
+                        g_fArrowStream = 1;
+                        pszBatch += 7;
+                    }
+                    if (*pszBatch == ':')
+                    {
+                        char *pszEnd = NULL;
+                        unsigned long cCycles = strtoul(pszBatch + 1, &pszEnd, 10);
+                        if (   *pszEnd != '\0'
+                            || !cCycles
+                            || cCycles > LPC_DEC_ARROW_BATCH_CYCLES_MAX)
+                        {
+                            fprintf(stderr, "Invalid Arrow batch size: %s\n", pszBatch + 1);
+                            return 1;
+                        }
+                        g_cArrowBatchCycles = (uint32_t)cCycles;
+                    }
+                    else if (*pszBatch != '\0')
+                    {
+                        fprintf(stderr, "Invalid output format: %s\n", optarg);
+                        return 1;
+                    }
+                }
+                else if (!strcmp(optarg, "text"))
+                    g_enmOutputFmt = LPCDECOUTFMT_TEXT;
+                else
+                {
+                    fprintf(stderr, "Invalid output format: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'z':
+            {
+                int rc = lpcDecZstdSpecParse(optarg, &iZstdLevel);
+                if (rc)
+                {
+                    fprintf(stderr, "Invalid compression: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'I':
+            {
+                char *pszEnd = NULL;
+                unsigned long uVal = strtoul(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0' || uVal > UINT32_MAX)
+                {
+                    fprintf(stderr, "Invalid report interval: %s\n", optarg);
+                    return 1;
+                }
+                g_cMsInputStats = (uint32_t)uVal;
+                break;
+            }
+            case 'p':
+            {
+                int rc = lpcDecCtxIdxDataDecEnsure(&Ctx);
+                if (rc)
+                {
+                    fprintf(stderr, "Creating the index/data pair decoder failed with %d\n", rc);
+                    return 1;
+                }
+
+                rc = lpcDecIdxDataDecAddPairFromSpec(Ctx.pIdxDataDec, optarg);
+                if (rc)
+                {
+                    fprintf(stderr, "Invalid or conflicting index/data register pair: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 's':
+            {
+                int rc = lpcDecCtxSioAdd(&Ctx, optarg);
+                if (rc == EEXIST)
+                {
+                    fprintf(stderr, "The Super I/O at %s is already decoded\n", optarg);
+                    return 1;
+                }
+                if (rc)
+                {
+                    fprintf(stderr, "Invalid Super I/O configuration port: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'S':
+                pszSioOut = optarg;
+                break;
+            case 'k':
+            {
+                char *pszEnd = NULL;
+                uKcsPort = strtoul(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0' || !uKcsPort || uKcsPort >= UINT16_MAX)
+                {
+                    fprintf(stderr, "Invalid KCS data port: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'K':
+                pszKcsLog = optarg;
+                break;
+            case 'x':
+                pszValIdx = optarg;
+                break;
+            case 'f':
+            {
+                int rc = 0;
+                if (!Ctx.pFind)
+                    rc = lpcDecFindCreate(&Ctx.pFind, Ctx.pOutText, NULL /*pfnMatch*/, NULL /*pvUser*/);
+                if (rc)
+                {
+                    fprintf(stderr, "Creating the sequence search failed with %d\n", rc);
+                    return 1;
+                }
+
+                if (optarg[0] == '@')
+                {
+                    uint32_t iLine = 0;
+                    rc = lpcDecFindPatternAddFromFile(Ctx.pFind, &optarg[1], &iLine);
+                    if (rc && iLine)
+                        fprintf(stderr, "Invalid search pattern in '%s' line %u\n", &optarg[1], iLine);
+                    else if (rc)
+                        fprintf(stderr, "The file '%s' could not be read\n", &optarg[1]);
+                }
+                else
+                {
+                    rc = lpcDecFindPatternAdd(Ctx.pFind, optarg);
+                    if (rc)
+                        fprintf(stderr, "Invalid search pattern: %s\n", optarg);
+                }
+                if (rc)
+                    return 1;
+                break;
+            }
+            case 'F':
+                pszFindLog = optarg;
+                break;
+            case 't':
+            {
+                int rc = 0;
+                if (!Ctx.pTrigger)
+                    rc = lpcDecTriggerCreate(&Ctx.pTrigger, Ctx.pOut);
+                if (rc)
+                {
+                    fprintf(stderr, "Creating the trigger failed with %d\n", rc);
+                    return 1;
+                }
+
+                if (optarg[0] == '@')
+                {
+                    uint32_t iLine = 0;
+                    rc = lpcDecFindPatternAddFromFile(Ctx.pTrigger->pFind, &optarg[1], &iLine);
+                    if (rc && iLine)
+                        fprintf(stderr, "Invalid trigger pattern in '%s' line %u\n", &optarg[1], iLine);
+                    else if (rc)
+                        fprintf(stderr, "The file '%s' could not be read\n", &optarg[1]);
+                }
+                else
+                {
+                    rc = lpcDecFindPatternAdd(Ctx.pTrigger->pFind, optarg);
+                    if (rc)
+                        fprintf(stderr, "Invalid trigger pattern: %s\n", optarg);
+                }
+                if (rc)
+                    return 1;
+                break;
+            }
+            case 'b':
+            case 'a':
+            {
+                char *pszEnd = NULL;
+                unsigned long uVal = strtoul(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0' || uVal > (ch == 'b' ? LPC_DEC_TRIGGER_PRE_MAX : UINT32_MAX))
+                {
+                    fprintf(stderr, "Invalid cycle count: %s\n", optarg);
+                    return 1;
+                }
+                if (ch == 'b')
+                    uTriggerPre = uVal;
+                else
+                    uTriggerPost = uVal;
+                break;
+            }
+            case 'r':
+            {
+                char *pszEnd = NULL;
+                g_uSampleRate = strtoull(optarg, &pszEnd, 0);
+                if (*pszEnd != '\0' || !g_uSampleRate)
+                {
+                    fprintf(stderr, "Invalid sample rate: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            default:
+                fprintf(stderr, "Unrecognised option: -%c\n", optopt);
+                return 1;
+        }
+    }
+
+    if (!pszFilename)
+    {
+        fprintf(stderr, "A filepath to the capture is required!\n");
+        return 1;
+    }
+    if (   fFollow
+        && (   lpcDecSockAddrIsSock(pszFilename)
+            || lpcDecShmIsShm(pszFilename)))
+    {
+        fprintf(stderr, "--follow only applies to capture files\n");
+        return 1;
+    }
+
+    uint8_t fShardOut = 0;
+    for (uint32_t i = 0; Ctx.pSinks && i < Ctx.pSinks->cSinks; i++)
+        if (Ctx.pSinks->aSinks[i].enmType == LPCDECSINKTYPE_SHARD)
+            fShardOut = 1;
+    if (fShardOut != (g_ShardCfg.fByType || g_ShardCfg.fByDir || g_ShardCfg.fByRange))
+    {
+        fprintf(stderr, "--shard-by and a shard output go together\n");
+        return 1;
+    }
+    if (g_ShardCfg.fByRange != (g_ShardCfg.cRanges > 0))
+    {
+        fprintf(stderr, "--shard-by addr-range and --shard-range go together\n");
+        return 1;
+    }
+    if (g_fSeqReset && !g_uSeqGapMax)
+    {
+        fprintf(stderr, "--seq-check-reset requires --seq-check\n");
+        return 1;
+    }
+    if (pszVcd && !g_uSampleRate)
+    {
+        fprintf(stderr, "--export-vcd requires --sample-rate to time the value changes\n");
+        return 1;
+    }
+
+    if (iZstdLevel)
+    {
+        int rc = lpcDecZstdOutOpen(stdout, 0 /*fCloseDst*/, iZstdLevel, &pZstdOut);
+        if (rc)
+        {
+            fprintf(stderr, "Setting up the compression failed with %d, is %s installed?\n", rc, LPC_DEC_ZSTD_LIB);
+            return 1;
+        }
+        Ctx.pOut = pZstdOut;
+    }
+
+    /*
+     * Everything set up so far writes to stdout directly, binary cycles leave no room for text there and
+     * JSONL consumers expect one JSON object per line.
+     */
+    Ctx.pOutText = g_enmOutputFmt == LPCDECOUTFMT_TEXT ? Ctx.pOut : stderr;
+
+    uint8_t fOutStarted = !Ctx.pSinks || Ctx.pTrigger;
+    if (fOutStarted)
+    {
+        int rc = lpcDecCycleDumpStart(Ctx.pOut, &Ctx.pArrowOut);
+        if (rc)
+        {
+            fprintf(stderr, "Setting up the output failed with %d\n", rc);
+            return 1;
+        }
+    }
+
+    for (uint32_t i = 0; i < Ctx.cSioDecs; i++)
+        Ctx.apSioDec[i]->pOut = Ctx.pOutText;
+    if (Ctx.pFind)
+        Ctx.pFind->pOut = Ctx.pOutText;
+    if (Ctx.pTrigger)
+    {
+        Ctx.pTrigger->pOut        = Ctx.pOut;
+        Ctx.pTrigger->pArrowOut   = Ctx.pArrowOut;
+        Ctx.pTrigger->pOutText    = Ctx.pOutText;
+        Ctx.pTrigger->pFind->pOut = Ctx.pOutText;
+    }
+
+    if (   Ctx.pSinks
+        && lpcDecSinksStart(Ctx.pSinks, Ctx.pOut, fOutStarted, Ctx.pArrowOut, iZstdLevel, Ctx.pIdxDataDec))
+        return 1;
+
+    FILE *pSioOut = NULL;
+    if (pszSioOut)
+    {
+        pSioOut = fopen(pszSioOut, "w");
+        if (!pSioOut)
+        {
+            fprintf(stderr, "The file '%s' could not be created\n", pszSioOut);
+            return 1;
+        }
+
+        for (uint32_t i = 0; i < Ctx.cSioDecs; i++)
+            Ctx.apSioDec[i]->pOut = pSioOut;
+    }
+
+    FILE *pKcsLog = NULL;
+    if (pszKcsLog)
+    {
+        pKcsLog = fopen(pszKcsLog, "w");
+        if (!pKcsLog)
+        {
+            fprintf(stderr, "The file '%s' could not be created\n", pszKcsLog);
+            return 1;
+        }
+    }
+
+    if (   uKcsPort
+        || pKcsLog)
+    {
+        int rc = lpcDecKcsDecCreate(&Ctx.pKcsDec, uKcsPort ? (uint16_t)uKcsPort : LPC_DEC_KCS_PORT_DEFAULT,
+                                    pKcsLog ? pKcsLog : Ctx.pOutText);
+        if (rc)
+        {
+            fprintf(stderr, "Creating the KCS decoder failed with %d\n", rc);
+            return 1;
+        }
+    }
+
+    if (pszValIdx)
+    {
+        int rc = lpcDecValIdxBuildCreate(&Ctx.pValIdx);
+        if (rc)
+        {
+            fprintf(stderr, "Creating the value index failed with %d\n", rc);
+            return 1;
+        }
+    }
+
+    if (   (uTriggerPre != UINT64_MAX || uTriggerPost != UINT64_MAX)
+        && !Ctx.pTrigger)
+    {
+        fprintf(stderr, "--pre/--post require at least one --trigger pattern\n");
+        return 1;
+    }
+    if (Ctx.pTrigger)
+    {
+        uint32_t cPre  = uTriggerPre  != UINT64_MAX ? (uint32_t)uTriggerPre  : Ctx.pTrigger->cPre;
+        uint32_t cPost = uTriggerPost != UINT64_MAX ? (uint32_t)uTriggerPost : Ctx.pTrigger->cPost;
+        int rc = lpcDecTriggerSetWindow(Ctx.pTrigger, cPre, cPost);
+        if (rc)
+        {
+            fprintf(stderr, "Allocating the ring for %u cycles before a trigger failed with %d\n", cPre, rc);
+            return 1;
+        }
+    }
+
+    FILE *pFindLog = NULL;
+    if (pszFindLog)
+    {
+        if (!Ctx.pFind)
+        {
+            fprintf(stderr, "--find-log requires at least one --find pattern\n");
+            return 1;
+        }
+
+        pFindLog = fopen(pszFindLog, "w");
+        if (!pFindLog)
+        {
+            fprintf(stderr, "The file '%s' could not be created\n", pszFindLog);
+            return 1;
+        }
+        Ctx.pFind->pOut = pFindLog;
+    }
+
+    if (pszClkLog && !cClkWindowSamples)
+    {
+        fprintf(stderr, "--clock-log requires a --clock-stats window\n");
+        return 1;
+    }
+
+    FILE *pClkLog = NULL;
+    if (pszClkLog)
+    {
+        pClkLog = fopen(pszClkLog, "w");
+        if (!pClkLog)
+        {
+            fprintf(stderr, "The file '%s' could not be created\n", pszClkLog);
+            return 1;
+        }
+    }
+
+    /* The summary is appended to the stats outputs, without any it goes to the output. */
+    uint8_t fClkStatsOut = 0;
+    if (fClkStats)
+    {
+        int rc = lpcDecClkStatsCreate(&Ctx.pClkStats, cClkWindowSamples, pClkLog ? pClkLog : Ctx.pOutText);
+        if (rc)
+        {
+            fprintf(stderr, "Creating the LCLK statistics failed with %d\n", rc);
+            return 1;
+        }
+
+        for (uint32_t i = 0; Ctx.pSinks && i < Ctx.pSinks->cSinks; i++)
+            if (Ctx.pSinks->aSinks[i].enmType == LPCDECSINKTYPE_STATS)
+                fClkStatsOut = 1;
+        if (fClkStatsOut)
+            Ctx.pSinks->pClkStats = Ctx.pClkStats;
+    }
+
+    PLPCDECVCD pVcd = NULL;
+    if (pszVcd)
+    {
+        int rc = lpcDecVcdCreate(&pVcd, pszVcd);
+        if (rc)
+        {
+            fprintf(stderr, "The file '%s' could not be created\n", pszVcd);
+            return 1;
+        }
+    }
+
+    int rc = lpcDecDecodeFile(pszFilename, lpcDecCtxCycle, &Ctx, fFollow, pVcd, Ctx.pClkStats, Ctx.pOutText);
+    if (Ctx.pClkStats)
+        lpcDecClkStatsFlush(Ctx.pClkStats);
+    if (pVcd)
+    {
+        int rc2 = lpcDecVcdClose(pVcd);
+        if (rc2)
+            fprintf(stderr, "Writing the phase export to '%s' failed with %d\n", pszVcd, rc2);
+    }
+    if (Ctx.pSinks)
+    {
+        /* Completes the outputs before any summary gets written to stdout. */
+        lpcDecSinksDestroy(Ctx.pSinks);
+        Ctx.pSinks = NULL;
+    }
+    if (!rc)
+    {
+        if (Ctx.pIdxDataDec)
+            lpcDecIdxDataDecDumpShadow(Ctx.pIdxDataDec, Ctx.pOutText);
+        for (uint32_t i = 0; i < Ctx.cSioDecs; i++)
+            lpcDecSioDecDumpConfig(Ctx.apSioDec[i]);
+        if (Ctx.pKcsDec)
+            lpcDecKcsDecDumpSummary(Ctx.pKcsDec);
+        if (Ctx.pValIdx)
+        {
+            int rc2 = lpcDecValIdxBuildWrite(Ctx.pValIdx, pszValIdx);
+            if (rc2)
+                fprintf(stderr, "Writing the value index to '%s' failed with %d\n", pszValIdx, rc2);
+        }
+        if (Ctx.pFind)
+            lpcDecFindDumpSummary(Ctx.pFind);
+        if (Ctx.pTrigger)
+            lpcDecTriggerDumpSummary(Ctx.pTrigger);
+        if (   Ctx.pClkStats
+            && !fClkStatsOut)
+            lpcDecClkStatsDumpSummary(Ctx.pClkStats, Ctx.pOutText);
+    }
+    else
+        fprintf(stderr, "The input '%s' could not be opened\n", pszFilename);
+
+    for (uint32_t i = 0; i < Ctx.cSioDecs; i++)
+        free(Ctx.apSioDec[i]);
+    if (Ctx.pIdxDataDec)
+        lpcDecIdxDataDecDestroy(Ctx.pIdxDataDec);
+    if (Ctx.pKcsDec)
+        lpcDecKcsDecDestroy(Ctx.pKcsDec);
+    if (Ctx.pValIdx)
+        lpcDecValIdxBuildDestroy(Ctx.pValIdx);
+    if (Ctx.pFind)
+        lpcDecFindDestroy(Ctx.pFind);
+    if (Ctx.pTrigger)
+        lpcDecTriggerDestroy(Ctx.pTrigger);
+    if (Ctx.pClkStats)
+        lpcDecClkStatsDestroy(Ctx.pClkStats);
+    if (pSioOut)
+        fclose(pSioOut);
+    if (pKcsLog)
+        fclose(pKcsLog);
+    if (pFindLog)
+        fclose(pFindLog);
+    if (pClkLog)
+        fclose(pClkLog);
+    if (   Ctx.pArrowOut
+        && (   lpcDecArrowOutClose(Ctx.pArrowOut)
+            || fflush(Ctx.pOut)))
+    {
+        fprintf(stderr, "Writing the output failed\n");
+        return 1;
+    }
+    if (   pZstdOut
+        && fclose(pZstdOut))
+    {
+        fprintf(stderr, "Writing the compressed output failed\n");
+        return 1;
+    }
 
     return 0;
 }
@@ -0,0 +1,87 @@
+-- @file
+-- lpc-dec - Wireshark dissector for the cycles written by lpc-dec --output-format pcapng.
+--
+-- Copy to the Wireshark personal plugins folder or load with: wireshark -X lua_script:lpc-dec.lua capture.pcapng
+
+--
+-- Copyright (C) 2020 Alexander Eichner <alexander.eichner@campus.tu-berlin.de>
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, version 3.
+--
+-- This program is distributed in the hope that it will be useful, but
+-- WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+-- General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program. If not, see <http://www.gnu.org/licenses/>.
+--
+
+-- Cycle record (version 1), all fields little endian:
+--   0  u8   version
+--   1  u8   cycle type (0 I/O, 1 memory, 2 DMA, 3 reserved)
+--   2  u8   flags (0x1 write, 0x2 aborted)
+--   3  u8   SYNC wait states, 0xff if unknown
+--   4  u32  address
+--   8  u64  sequence number of the capture sample
+--   16 u8[] data, one byte per cycle
+
+local lpc = Proto("lpc", "Low Pin Count Bus")
+
+local cycle_types = { [0] = "I/O", [1] = "Mem", [2] = "DMA", [3] = "RESERVED" }
+
+local f_version    = ProtoField.uint8("lpc.version", "Version", base.DEC)
+local f_type       = ProtoField.uint8("lpc.type", "Cycle type", base.DEC, cycle_types)
+local f_flags      = ProtoField.uint8("lpc.flags", "Flags", base.HEX)
+local f_write      = ProtoField.bool("lpc.write", "Write", 8, { "Write", "Read" }, 0x1)
+local f_abort      = ProtoField.bool("lpc.abort", "Aborted", 8, nil, 0x2)
+local f_sync_waits = ProtoField.uint8("lpc.sync_waits", "SYNC wait states", base.DEC, { [0xff] = "Unknown" })
+local f_addr       = ProtoField.uint32("lpc.addr", "Address", base.HEX)
+local f_seq        = ProtoField.uint64("lpc.seq", "Sequence number", base.DEC)
+local f_data       = ProtoField.bytes("lpc.data", "Data")
+
+lpc.fields = { f_version, f_type, f_flags, f_write, f_abort, f_sync_waits, f_addr, f_seq, f_data }
+
+function lpc.dissector(tvb, pinfo, tree)
+    if tvb:len() < 16 or tvb(0, 1):uint() ~= 1 then
+        return 0
+    end
+
+    local typ = tvb(1, 1):uint()
+    local flags = tvb(2, 1):uint()
+    local addr = tvb(4, 4):le_uint()
+    local dir = bit.band(flags, 0x1) ~= 0 and "Write" or "Read"
+
+    pinfo.cols.protocol = "LPC"
+    if typ == 1 then
+        pinfo.cols.info = string.format("%s %s 0x%08x", cycle_types[typ], dir, addr)
+    else
+        pinfo.cols.info = string.format("%s %s 0x%04x", cycle_types[typ], dir, addr)
+    end
+    if tvb:len() > 16 then
+        pinfo.cols.info:append(": 0x" .. tvb(16):bytes():tohex(true))
+    end
+    if bit.band(flags, 0x2) ~= 0 then
+        pinfo.cols.info:append(" (aborted)")
+    end
+
+    local subtree = tree:add(lpc, tvb(), "Low Pin Count Bus cycle")
+    subtree:add(f_version, tvb(0, 1))
+    subtree:add(f_type, tvb(1, 1))
+    local flagtree = subtree:add(f_flags, tvb(2, 1))
+    flagtree:add(f_write, tvb(2, 1))
+    flagtree:add(f_abort, tvb(2, 1))
+    subtree:add(f_sync_waits, tvb(3, 1))
+    subtree:add_le(f_addr, tvb(4, 4))
+    subtree:add_le(f_seq, tvb(8, 8))
+    if tvb:len() > 16 then
+        subtree:add(f_data, tvb(16))
+    end
+
+    return tvb:len()
+end
+
+-- lpc-dec writes the LPC interface with LINKTYPE_USER0.
+DissectorTable.get("wtap_encap"):add(wtap.USER0, lpc)